@@ -310,96 +310,151 @@ Zf(comp_encode)(
 	const int16_t *x, unsigned logn)
 {
 	uint8_t *buf;
-	size_t n, u, v;
-	uint32_t acc;
+	size_t n, u, v, len;
+	uint64_t acc;
 	unsigned acc_len;
 
 	n = (size_t)1 << logn;
 	buf = out;
 
 	/*
-	 * Make sure that all values are within the -2047..+2047 range.
+	 * Make sure that all values are within the -2047..+2047 range,
+	 * and compute the encoded length: each value uses 9 bits, plus
+	 * its absolute value divided by 128.
 	 */
+	len = 9 * n;
 	for (u = 0; u < n; u ++) {
+		uint32_t t, s;
+
 		if (x[u] < -2047 || x[u] > +2047) {
 			return 0;
 		}
+		t = (uint32_t)(int32_t)x[u];
+		s = t >> 31;
+		len += ((t ^ -s) + s) >> 7;
+	}
+	len = (len + 7) >> 3;
+	if (buf == NULL) {
+		return len;
+	}
+	if (len > max_out_len) {
+		return 0;
 	}
 
+	/*
+	 * Pending bits are the top acc_len bits of acc (at most 7
+	 * between values). Each value is the sign bit, the low 7 bits of
+	 * the absolute value, then h zeros and a one, where h is the
+	 * absolute value divided by 128; since the absolute value is at
+	 * most 2047, h is at most 15, thus a value adds at most 24 bits.
+	 * When at least eight bytes of the encoding remain to be written,
+	 * all 64 bits of acc are written, and the position advances by
+	 * the number of full bytes; this avoids data-dependent branches.
+	 * The last bytes are written one at a time, so that nothing is
+	 * written after the encoded data.
+	 */
 	acc = 0;
 	acc_len = 0;
 	v = 0;
 	for (u = 0; u < n; u ++) {
-		int t;
-		unsigned w;
-
-		/*
-		 * Get sign and absolute value of next integer; push the
-		 * sign bit.
-		 */
-		acc <<= 1;
-		t = x[u];
-		if (t < 0) {
-			t = -t;
-			acc |= 1;
-		}
-		w = (unsigned)t;
-
-		/*
-		 * Push the low 7 bits of the absolute value.
-		 */
-		acc <<= 7;
-		acc |= w & 127u;
-		w >>= 7;
-
-		/*
-		 * We pushed exactly 8 bits.
-		 */
-		acc_len += 8;
-
-		/*
-		 * Push as many zeros as necessary, then a one. Since the
-		 * absolute value is at most 2047, w can only range up to
-		 * 15 at this point, thus we will add at most 16 bits
-		 * here. With the 8 bits above and possibly up to 7 bits
-		 * from previous iterations, we may go up to 31 bits, which
-		 * will fit in the accumulator, which is an uint32_t.
-		 */
-		acc <<= (w + 1);
-		acc |= 1;
-		acc_len += w + 1;
-
-		/*
-		 * Produce all full bytes.
-		 */
-		while (acc_len >= 8) {
-			acc_len -= 8;
-			if (buf != NULL) {
-				if (v >= max_out_len) {
-					return 0;
-				}
-				buf[v] = (uint8_t)(acc >> acc_len);
+		uint32_t t, s, w, h;
+
+		t = (uint32_t)(int32_t)x[u];
+		s = t >> 31;
+		w = (t ^ -s) + s;
+		h = w >> 7;
+		acc |= ((((uint64_t)((s << 7) | (w & 127)) << (h + 1)) | 1)
+			<< (55 - h - acc_len));
+		acc_len += h + 9;
+
+		if (len - v >= 8) {
+			buf[v + 0] = (uint8_t)(acc >> 56);
+			buf[v + 1] = (uint8_t)(acc >> 48);
+			buf[v + 2] = (uint8_t)(acc >> 40);
+			buf[v + 3] = (uint8_t)(acc >> 32);
+			buf[v + 4] = (uint8_t)(acc >> 24);
+			buf[v + 5] = (uint8_t)(acc >> 16);
+			buf[v + 6] = (uint8_t)(acc >> 8);
+			buf[v + 7] = (uint8_t)acc;
+			v += acc_len >> 3;
+		} else {
+			while (acc_len >= 8) {
+				buf[v ++] = (uint8_t)(acc >> 56);
+				acc <<= 8;
+				acc_len -= 8;
 			}
-			v ++;
+			continue;
 		}
+		acc <<= acc_len & ~7u;
+		acc_len &= 7;
 	}
 
 	/*
 	 * Flush remaining bits (if any).
 	 */
 	if (acc_len > 0) {
-		if (buf != NULL) {
-			if (v >= max_out_len) {
-				return 0;
-			}
-			buf[v] = (uint8_t)(acc << (8 - acc_len));
-		}
-		v ++;
+		buf[v ++] = (uint8_t)(acc >> 56);
 	}
 
 	return v;
 }
 
+/*
+ * Number of leading zeros in a non-zero 64-bit value.
+ */
+static inline unsigned
+comp_clz64(uint64_t x)
+{
+#if defined __GNUC__ || defined __clang__
+	return (unsigned)__builtin_clzll(x);
+#else
+	unsigned r, m;
+
+	r = 0;
+	m = -(uint32_t)((x >> 32) == 0) & 32;
+	r += m;
+	x <<= m;
+	m = -(uint32_t)((x >> 48) == 0) & 16;
+	r += m;
+	x <<= m;
+	m = -(uint32_t)((x >> 56) == 0) & 8;
+	r += m;
+	x <<= m;
+	m = -(uint32_t)((x >> 60) == 0) & 4;
+	r += m;
+	x <<= m;
+	m = -(uint32_t)((x >> 62) == 0) & 2;
+	r += m;
+	x <<= m;
+	r += (unsigned)((x >> 63) == 0);
+	return r;
+#endif
+}
+
+/*
+ * Decode one value from the top 24 bits of w into *x, subtract the
+ * number of bits it uses from *avail, and return w shifted by that
+ * number. A value is the sign bit, the low 7 bits of the absolute
+ * value, then h zeros and a one, with h <= 15 since the absolute value
+ * is at most 2047. The one is found with a single count of leading
+ * zeros; a sentinel bit makes that count 16 if the 16 bits that follow
+ * the first 8 are all zero. In that case, or if the value is "-0",
+ * *err is set to 1 (at most 25 bits are then consumed).
+ */
+static inline uint64_t
+comp_decode_one(int16_t *x, uint64_t w, unsigned *avail, uint32_t *err)
+{
+	uint32_t s, m, h;
+
+	h = comp_clz64((w << 8) | ((uint64_t)1 << 47));
+	s = (uint32_t)(w >> 63);
+	m = ((uint32_t)(w >> 56) & 127) + (h << 7);
+	*err |= (h >> 4) | (s & ((m - 1) >> 31));
+	*x = (int16_t)(int32_t)((m ^ -s) + s);
+	*avail -= h + 9;
+	return (w << 9) << h;
+}
+
 /* see inner.h */
 size_t
 Zf(comp_decode)(
@@ -407,65 +462,74 @@ Zf(comp_decode)(
 	const void *in, size_t max_in_len)
 {
 	const uint8_t *buf;
-	size_t n, u, v;
-	uint32_t acc;
-	unsigned acc_len;
+	size_t n, u, v, bp, pos;
+	uint64_t w;
+	unsigned avail;
+	uint32_t err;
 
 	n = (size_t)1 << logn;
 	buf = in;
-	acc = 0;
-	acc_len = 0;
-	v = 0;
-	for (u = 0; u < n; u ++) {
-		unsigned b, s, m;
 
-		/*
-		 * Get next eight bits: sign and low seven bits of the
-		 * absolute value.
-		 */
-		if (v >= max_in_len) {
-			return 0;
-		}
-		acc = (acc << 8) | (uint32_t)buf[v ++];
-		b = acc >> acc_len;
-		s = b & 128;
-		m = b & 127;
+	/*
+	 * Each value uses at most 24 bits, hence bytes beyond 3*n are
+	 * never read.
+	 */
+	if (max_in_len > 3 * n) {
+		max_in_len = 3 * n;
+	}
 
-		/*
-		 * Get next bits until a 1 is reached.
-		 */
-		for (;;) {
-			if (acc_len == 0) {
-				if (v >= max_in_len) {
-					return 0;
+	/*
+	 * The next input bits are the top 'avail' bits of w; bp is the
+	 * index of the next byte to load. A refill loads the eight bytes
+	 * at bp and counts the whole bytes that fit, for at least 57 bits,
+	 * which is enough for two values (n is even); bits of w below
+	 * 'avail' are the following input bits, which the next refill
+	 * ORs again. Beyond the end of the input, zeros are loaded. Errors
+	 * are accumulated in err and checked at the end, so that the loop
+	 * has no data-dependent branch.
+	 *
+	 * The one that ends a value is never one of the zeros beyond the
+	 * end of the input; thus, if no error is reported, all decoded
+	 * bits are input bits.
+	 */
+	w = 0;
+	avail = 0;
+	bp = 0;
+	err = 0;
+	for (u = 0; u < n; u += 2) {
+		if (bp + 8 <= max_in_len) {
+			w |= (((uint64_t)buf[bp + 0] << 56)
+				| ((uint64_t)buf[bp + 1] << 48)
+				| ((uint64_t)buf[bp + 2] << 40)
+				| ((uint64_t)buf[bp + 3] << 32)
+				| ((uint64_t)buf[bp + 4] << 24)
+				| ((uint64_t)buf[bp + 5] << 16)
+				| ((uint64_t)buf[bp + 6] << 8)
+				| (uint64_t)buf[bp + 7]) >> avail;
+			bp += (63 - avail) >> 3;
+			avail |= 56;
+		} else {
+			while (avail <= 56) {
+				if (bp < max_in_len) {
+					w |= (uint64_t)buf[bp] << (56 - avail);
 				}
-				acc = (acc << 8) | (uint32_t)buf[v ++];
-				acc_len = 8;
-			}
-			acc_len --;
-			if (((acc >> acc_len) & 1) != 0) {
-				break;
-			}
-			m += 128;
-			if (m > 2047) {
-				return 0;
+				bp ++;
+				avail += 8;
 			}
 		}
-
-		/*
-		 * "-0" is forbidden.
-		 */
-		if (s && m == 0) {
-			return 0;
-		}
-
-		x[u] = (int16_t)(s ? -(int)m : (int)m);
+		w = comp_decode_one(&x[u], w, &avail, &err);
+		w = comp_decode_one(&x[u + 1], w, &avail, &err);
+	}
+	if (err) {
+		return 0;
 	}
 
 	/*
 	 * Unused bits in the last byte must be zero.
 	 */
-	if ((acc & ((1u << acc_len) - 1u)) != 0) {
+	pos = (bp << 3) - avail;
+	v = (pos + 7) >> 3;
+	if ((pos & 7) != 0 && (buf[v - 1] & (0xFF >> (pos & 7))) != 0) {
 		return 0;
 	}
 
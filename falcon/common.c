@@ -68,84 +68,138 @@ Zf(hash_to_point_vartime)(
 
 /* see inner.h */
 void
-Zf(hash_to_point_ct)(
+Zf(hash_to_point_vartime_x4)(
 	inner_shake256_context *sc,
-	uint16_t *x, unsigned logn, uint8_t *tmp)
+	uint16_t *x, unsigned logn)
 {
 	/*
-	 * Each 16-bit sample is a value in 0..65535. The value is
-	 * kept if it falls in 0..61444 (because 61445 = 5*12289)
-	 * and rejected otherwise; thus, each sample has probability
-	 * about 0.93758 of being selected.
-	 *
-	 * We want to oversample enough to be sure that we will
-	 * have enough values with probability at least 1 - 2^(-256).
-	 * Depending on degree N, this leads to the following
-	 * required oversampling:
-	 *
-	 *   logn     n  oversampling
-	 *     1      2     65
-	 *     2      4     67
-	 *     3      8     71
-	 *     4     16     77
-	 *     5     32     86
-	 *     6     64    100
-	 *     7    128    122
-	 *     8    256    154
-	 *     9    512    205
-	 *    10   1024    287
-	 *
-	 * If logn >= 7, then the provided temporary buffer is large
-	 * enough. Otherwise, we use a stack buffer of 63 entries
-	 * (i.e. 126 bytes) for the values that do not fit in tmp[].
+	 * The four outputs are squeezed by 136-byte blocks (68 samples)
+	 * in lockstep, until all four points are complete.
 	 */
+	size_t n, u[4];
+	int i, done;
+	uint8_t buf[4 * 136];
+
+	n = (size_t)1 << logn;
+	for (i = 0; i < 4; i ++) {
+		u[i] = 0;
+	}
+	do {
+		Zf(i_shake256_extract_x4)(sc, buf, 136);
+		done = 1;
+		for (i = 0; i < 4; i ++) {
+			const uint8_t *b;
+			uint16_t *xi;
+			size_t v;
+
+			b = buf + i * 136;
+			xi = x + (i << logn);
+			for (v = 0; v < 136 && u[i] < n; v += 2) {
+				uint32_t w;
+
+				w = ((unsigned)b[v] << 8) | (unsigned)b[v + 1];
+				if (w < 61445) {
+					while (w >= 12289) {
+						w -= 12289;
+					}
+					xi[u[i] ++] = (uint16_t)w;
+				}
+			}
+			if (u[i] < n) {
+				done = 0;
+			}
+		}
+	} while (!done);
+}
+
+/*
+ * Each 16-bit sample is a value in 0..65535. The value is
+ * kept if it falls in 0..61444 (because 61445 = 5*12289)
+ * and rejected otherwise; thus, each sample has probability
+ * about 0.93758 of being selected.
+ *
+ * We want to oversample enough to be sure that we will
+ * have enough values with probability at least 1 - 2^(-256).
+ * Depending on degree N, this leads to the following
+ * required oversampling:
+ *
+ *   logn     n  oversampling
+ *     1      2     65
+ *     2      4     67
+ *     3      8     71
+ *     4     16     77
+ *     5     32     86
+ *     6     64    100
+ *     7    128    122
+ *     8    256    154
+ *     9    512    205
+ *    10   1024    287
+ *
+ * If logn >= 7, then the provided temporary buffer is large
+ * enough. Otherwise, we use a stack buffer of 63 entries
+ * (i.e. 126 bytes) for the values that do not fit in tmp[].
+ */
+static const uint16_t hash_overtab[] = {
+	0, /* unused */
+	65,
+	67,
+	71,
+	77,
+	86,
+	100,
+	122,
+	154,
+	205,
+	287
+};
+
+/*
+ * Reduce a 16-bit sample modulo q, in constant time. Rejected values
+ * are set to 0xFFFF.
+ */
+static inline uint16_t
+hash_reduce_ct(const uint8_t *buf)
+{
+	uint32_t w, wr;
 
-	static const uint16_t overtab[] = {
-		0, /* unused */
-		65,
-		67,
-		71,
-		77,
-		86,
-		100,
-		122,
-		154,
-		205,
-		287
-	};
+	w = ((uint32_t)buf[0] << 8) | (uint32_t)buf[1];
+	wr = w - ((uint32_t)24578 & (((w - 24578) >> 31) - 1));
+	wr = wr - ((uint32_t)24578 & (((wr - 24578) >> 31) - 1));
+	wr = wr - ((uint32_t)12289 & (((wr - 12289) >> 31) - 1));
+	wr |= ((w - 61445) >> 31) - 1;
+	return (uint16_t)wr;
+}
 
+/*
+ * Store reduced sample number u: values 0..n-1 go to x[], values
+ * n..2*n-1 go to tt1[], values 2*n and later go to tt2[].
+ */
+static inline void
+hash_store_ct(uint16_t *x, uint16_t *tt1, uint16_t *tt2,
+	unsigned n, unsigned u, uint16_t wr)
+{
+	if (u < n) {
+		x[u] = wr;
+	} else if (u < (n << 1)) {
+		tt1[u - n] = wr;
+	} else {
+		tt2[u - (n << 1)] = wr;
+	}
+}
+
+/*
+ * Squeeze out the invalid values from the m = n + hash_overtab[logn]
+ * samples spread over x[], tt1[] and tt2[].
+ */
+static void
+hash_squeeze_ct(uint16_t *x, uint16_t *tt1, uint16_t *tt2, unsigned logn)
+{
 	unsigned n, n2, u, m, p, over;
-	uint16_t *tt1, tt2[63];
 
-	/*
-	 * We first generate m 16-bit value. Values 0..n-1 go to x[].
-	 * Values n..2*n-1 go to tt1[]. Values 2*n and later go to tt2[].
-	 * We also reduce modulo q the values; rejected values are set
-	 * to 0xFFFF.
-	 */
 	n = 1U << logn;
 	n2 = n << 1;
-	over = overtab[logn];
+	over = hash_overtab[logn];
 	m = n + over;
-	tt1 = (uint16_t *)tmp;
-	for (u = 0; u < m; u ++) {
-		uint8_t buf[2];
-		uint32_t w, wr;
-
-		inner_shake256_extract(sc, buf, sizeof buf);
-		w = ((uint32_t)buf[0] << 8) | (uint32_t)buf[1];
-		wr = w - ((uint32_t)24578 & (((w - 24578) >> 31) - 1));
-		wr = wr - ((uint32_t)24578 & (((wr - 24578) >> 31) - 1));
-		wr = wr - ((uint32_t)12289 & (((wr - 12289) >> 31) - 1));
-		wr |= ((w - 61445) >> 31) - 1;
-		if (u < n) {
-			x[u] = (uint16_t)wr;
-		} else if (u < n2) {
-			tt1[u - n] = (uint16_t)wr;
-		} else {
-			tt2[u - n2] = (uint16_t)wr;
-		}
-	}
 
 	/*
 	 * Now we must "squeeze out" the invalid values. We do this in
@@ -233,6 +287,76 @@ Zf(hash_to_point_ct)(
 	}
 }
 
+/* see inner.h */
+void
+Zf(hash_to_point_ct)(
+	inner_shake256_context *sc,
+	uint16_t *x, unsigned logn, uint8_t *tmp)
+{
+	unsigned n, u, m;
+	uint16_t *tt1, tt2[63];
+
+	/*
+	 * We first generate m 16-bit value, reduced modulo q (rejected
+	 * values are set to 0xFFFF); then we squeeze out the rejected
+	 * values.
+	 */
+	n = 1U << logn;
+	m = n + hash_overtab[logn];
+	tt1 = (uint16_t *)tmp;
+	for (u = 0; u < m; u ++) {
+		uint8_t buf[2];
+
+		inner_shake256_extract(sc, buf, sizeof buf);
+		hash_store_ct(x, tt1, tt2, n, u, hash_reduce_ct(buf));
+	}
+	hash_squeeze_ct(x, tt1, tt2, logn);
+}
+
+/* see inner.h */
+void
+Zf(hash_to_point_x4)(
+	inner_shake256_context *sc,
+	uint16_t *x, unsigned logn, uint8_t *tmp)
+{
+	/*
+	 * SHAKE256 output is squeezed by chunks of 68 samples (i.e.
+	 * one 136-byte block) per context.
+	 */
+	unsigned n, u, m;
+	int i;
+	uint16_t *tt1, tt2[4][63];
+	uint8_t buf[4 * 136];
+
+	n = 1U << logn;
+	m = n + hash_overtab[logn];
+	tt1 = (uint16_t *)tmp;
+	for (u = 0; u < m;) {
+		unsigned k, v;
+
+		k = m - u;
+		if (k > 68) {
+			k = 68;
+		}
+		Zf(i_shake256_extract_x4)(sc, buf, (size_t)k << 1);
+		for (i = 0; i < 4; i ++) {
+			const uint8_t *b;
+
+			b = buf + (size_t)i * (k << 1);
+			for (v = 0; v < k; v ++) {
+				hash_store_ct(x + ((size_t)i << logn),
+					tt1 + ((size_t)i << logn), tt2[i],
+					n, u + v, hash_reduce_ct(b + (v << 1)));
+			}
+		}
+		u += k;
+	}
+	for (i = 0; i < 4; i ++) {
+		hash_squeeze_ct(x + ((size_t)i << logn),
+			tt1 + ((size_t)i << logn), tt2[i], logn);
+	}
+}
+
 /*
  * Acceptance bound for the (squared) l2-norm of the signature depends
  * on the degree. This array is indexed by logn (1 to 10). These bounds
@@ -287,6 +411,14 @@ Zf(is_short)(
 int
 Zf(is_short_half)(
 	uint32_t sqn, const int16_t *s2, unsigned logn)
+{
+	return Zf(is_short_half_norm)(sqn, s2, logn, NULL);
+}
+
+/* see inner.h */
+int
+Zf(is_short_half_norm)(
+	uint32_t sqn, const int16_t *s2, unsigned logn, uint32_t *sqnorm)
 {
 	size_t n, u;
 	uint32_t ng;
@@ -301,6 +433,8 @@ Zf(is_short_half)(
 		ng |= sqn;
 	}
 	sqn |= -(ng >> 31);
-
+	if (sqnorm != NULL) {
+		*sqnorm = sqn;
+	}
 	return sqn <= l2bound[logn];
 }
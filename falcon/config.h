@@ -83,8 +83,15 @@
  * expected results indicates a lack of the desired determinism;
  * however, agreement does not prove determinism for all possible
  * inputs.
+ *
+ * The native implementation can still be selected from the command
+ * line (-DFALCON_FPNATIVE=1), e.g. to benchmark both implementations
+ * (tests/speed) or to compare their outputs (tests/test_deterministic);
+ * such builds are not meant for production use.
  */
+#if !defined FALCON_FPEMU && !defined FALCON_FPNATIVE
 #define FALCON_FPEMU  1
+#endif
 
 
 /*
@@ -114,7 +121,9 @@
  * FALCON_FPEMU above; here it is made explicit as a defensive
  * measure.)
  */
+#if defined FALCON_FPEMU && FALCON_FPEMU && !defined FALCON_FPNATIVE
 #define FALCON_FPNATIVE  0
+#endif
 
 
 /*
@@ -195,6 +204,121 @@
 #define FALCON_FMA  0
 
 
+/*
+ * Runtime-selected AVX2 code for integer-only routines: if enabled,
+ * then some routines that work purely over integers (e.g. the NTT
+ * modulo q used for signature verification, and the NTT and big
+ * integer reductions modulo small primes used by the NTRU solver in
+ * key pair generation) get an extra AVX2
+ * implementation, which is used only if the CPU reports AVX2 support
+ * at runtime. These implementations are bit-exact with the portable
+ * code, and do not touch native floating-point values, so this setting
+ * has no bearing on determinism (unlike FALCON_AVX2 above). This
+ * includes the batched additions and multiplications of the emulated
+ * floating-point code (FALCON_FPEMU), which are computed with the same
+ * integer operations as the scalar functions.
+ *
+ * This is supported only on x86 with GCC or Clang, where it is enabled
+ * by default; define this variable to 0 to disable it.
+ *
+#define FALCON_AVX2_RUNTIME   1
+ */
+
+/*
+ * Runtime selection of the floating-point implementation: if enabled
+ * (in a FALCON_FPEMU build), then the library also contains a second
+ * copy of the key pair generation and signing code, which uses the
+ * native 'double' type (see fpnative.c; its symbols use the
+ * FALCON_FPNATIVE_PREFIX prefix instead of FALCON_PREFIX). The
+ * emulated code remains in use until the application explicitly
+ * selects the native code with falcon_fp_select(), which first checks
+ * with a known-answer test that the native code reproduces the output
+ * of the emulated code exactly on the current platform. The native
+ * code is much faster, but see the warning on FALCON_FPEMU above.
+ *
+ * This is supported only on 64-bit x86 and ARM with GCC or Clang,
+ * where it is enabled by default; define this variable to 0 to
+ * disable it.
+ *
+#define FALCON_FP_DISPATCH   1
+ */
+
+/*
+ * Bit-exact native floating-point: if enabled along with
+ * FALCON_FPNATIVE, then the native code uses the same fixed-point
+ * computation of exp(-x) as the emulated code, instead of a faster
+ * floating-point polynomial evaluation. The emulated and native
+ * implementations then compute exactly the same keys and signatures,
+ * provided that the platform follows IEEE-754 binary64 rules (with
+ * "round-to-nearest" and without extra precision, i.e. not the 387 FPU)
+ * and that floating-point contractions (fused multiply-add) are not
+ * used. This is always enabled for the native copy of the code used
+ * with FALCON_FP_DISPATCH.
+ *
+#define FALCON_FPNATIVE_EXACT   1
+ */
+
+/*
+ * Use POSIX threads in the batch functions of the deterministic mode
+ * (e.g. falcon_det1024_vct_eval_batch()), which then spread their work
+ * over a pool of worker threads. Applications must then link with
+ * -lpthread (or equivalent). When disabled, the batch functions run
+ * sequentially in the calling thread. If not defined explicitly, this
+ * is enabled on Unix-like systems.
+ *
+#define FALCON_THREADS   1
+ */
+
+/*
+ * Cache the per-prime constants and NTT tables used by the NTRU solver
+ * in key pair generation. The cache is a static read-only table of
+ * about 40 kB, filled on first use and shared by all threads; bulk
+ * key generation then skips the recomputation of these tables for
+ * every key. This does not change the generated keys. If not defined
+ * explicitly, this is enabled with GCC and Clang (which provide the
+ * atomic operations needed for thread safety), and when FALCON_THREADS
+ * is disabled.
+ *
+#define FALCON_KG_CACHE   1
+ */
+
+/*
+ * Define the emulated floating-point addition, multiplication, division
+ * and square root (FALCON_FPEMU) as static inline functions in every
+ * translation unit (header fpremu.h), instead of out-of-line functions
+ * in fpr.c. This lets the compiler inline them in the FFT and sampling
+ * code, which makes signing and key pair generation faster, at the
+ * cost of larger code. Output is not affected. This option is ignored
+ * with FALCON_ASM_CORTEXM4. Default is 0; the "all_unity" Makefile
+ * target gets the same inlining by compiling the core as a single unit
+ * (unity.c).
+ *
+#define FALCON_FPEMU_INLINE   1
+ */
+
+/*
+ * Count, in each sampler context, the base samples drawn by SamplerZ,
+ * the zero samples rejected by the base sampler, and the candidates
+ * tried and accepted by SamplerZ, so that rejection rates can be
+ * measured; signing also reports the counters of each attempt through
+ * Zf(sampler_stats_hook) (see inner.h). This is meant for analysis and
+ * benchmarks, and does not change the output. Default is 0.
+ *
+#define FALCON_SAMPLER_STATS   1
+ */
+
+/*
+ * Size of the buffer of the ChaCha20 PRNG used by the Gaussian sampler,
+ * in units of 512 bytes (the output of one round of eight ChaCha20
+ * instances). A refill computes all the blocks at once, so that the
+ * ChaCha20 code runs over longer batches and the sampler checks for an
+ * empty buffer less often; the AVX-512 implementation then also
+ * computes two blocks at a time. The PRNG output stream does not depend
+ * on this setting, but each PRNG instance is larger. Default is 4.
+ *
+#define FALCON_PRNG_BLOCKS   4
+ */
+
 /*
  * Assert that the platform uses little-endian encoding. If enabled,
  * then encoding and decoding of aligned multibyte values will be
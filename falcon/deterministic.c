@@ -5,20 +5,39 @@
 #include "inner.h"
 #include "deterministic.h"
 
-#define FALCON_DET1024_TMPSIZE_KEYGEN FALCON_TMPSIZE_KEYGEN(FALCON_DET1024_LOGN)
-#define FALCON_DET1024_TMPSIZE_SIGNDYN FALCON_TMPSIZE_SIGNDYN(FALCON_DET1024_LOGN)
-#define FALCON_DET1024_TMPSIZE_VERIFY FALCON_TMPSIZE_VERIFY(FALCON_DET1024_LOGN) 
+#if FALCON_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#define FALCON_DET1024_TMPSIZE_EXPANDPRIV FALCON_TMPSIZE_EXPANDPRIV(FALCON_DET1024_LOGN)
 #define FALCON_DET1024_SALTED_SIG_COMPRESSED_MAXSIZE FALCON_SIG_COMPRESSED_MAXSIZE(FALCON_DET1024_LOGN)
 #define FALCON_DET1024_SALTED_SIG_CT_SIZE FALCON_SIG_CT_SIZE(FALCON_DET1024_LOGN)
 
 
 int falcon_det1024_keygen(shake256_context *rng, void *privkey, void *pubkey) {
-	uint8_t tmpkg[FALCON_DET1024_TMPSIZE_KEYGEN];
+	falcon_det1024_sign_ctx ctx;
+
+	return falcon_det1024_keygen_ctx(&ctx, rng, privkey, pubkey);
+}
+
+int falcon_det1024_keygen_ctx(falcon_det1024_sign_ctx *ctx,
+        shake256_context *rng, void *privkey, void *pubkey) {
 
 	return falcon_keygen_make(rng, FALCON_DET1024_LOGN,
 		privkey, FALCON_DET1024_PRIVKEY_SIZE,
 		pubkey, FALCON_DET1024_PUBKEY_SIZE,
-		tmpkg, FALCON_DET1024_TMPSIZE_KEYGEN);
+		ctx->tmp, sizeof ctx->tmp);
+}
+
+int falcon_det1024_keygen_pool(const falcon_thread_pool *pool,
+        void *tmp, size_t tmp_len,
+        shake256_context *rng, void *privkey, void *pubkey) {
+
+	return falcon_keygen_make_pool(rng, FALCON_DET1024_LOGN,
+		privkey, FALCON_DET1024_PRIVKEY_SIZE,
+		pubkey, FALCON_DET1024_PUBKEY_SIZE,
+		tmp, tmp_len, pool);
 }
 
 // Domain separator used to construct the fixed versioned salt string.
@@ -31,51 +50,381 @@ void falcon_det1024_write_salt(uint8_t dst[40], uint8_t salt_version) {
 	memcpy(dst+2, falcon_det1024_salt_rest, 38);
 }
 
-int falcon_det1024_sign_compressed(void *sig, size_t *sig_len,
+// Initialize the signing contexts: detrng receives
+// SHAKE(logn || privkey || data), set to output mode, and hd receives
+// SHAKE(salt || data), still in input mode, with the current salt
+// (also written in salt[]).
+static void falcon_det1024_sign_start(shake256_context *detrng,
+        shake256_context *hd, uint8_t salt[40],
+        const void *privkey, const void *data, size_t data_len) {
+
+	uint8_t logn[1] = {FALCON_DET1024_LOGN};
+
+	shake256_init(detrng);
+	shake256_inject(detrng, logn, 1);
+	shake256_inject(detrng, privkey, FALCON_DET1024_PRIVKEY_SIZE);
+	shake256_inject(detrng, data, data_len);
+	shake256_flip(detrng);
+
+	falcon_det1024_write_salt(salt, FALCON_DET1024_CURRENT_SALT_VERSION);
+
+	shake256_init(hd);
+	shake256_inject(hd, salt, 40);
+	shake256_inject(hd, data, data_len);
+}
+
+// Transform a salted compressed signature to unsalted format.
+static void falcon_det1024_unsalt_compressed(void *sig, size_t *sig_len,
+        const uint8_t *saltedsig, size_t saltedsig_len) {
+
+	uint8_t *sigbytes = sig;
+	sigbytes[0] = saltedsig[0] | 0x80;
+	sigbytes[1] = FALCON_DET1024_CURRENT_SALT_VERSION;
+	memcpy(sigbytes+2, saltedsig+41, saltedsig_len-41);
+
+	*sig_len = saltedsig_len-40+1;
+}
+
+int falcon_det1024_sign_compressed_with_norm(void *sig, size_t *sig_len,
+        uint32_t *sqnorm, const void *privkey, const void *data, size_t data_len) {
+
+	falcon_det1024_sign_ctx ctx;
+
+	return falcon_det1024_sign_compressed_ctx(&ctx, sig, sig_len, sqnorm,
+		privkey, data, data_len);
+}
+
+int falcon_det1024_sign_compressed_ctx(falcon_det1024_sign_ctx *ctx,
+        void *sig, size_t *sig_len, uint32_t *sqnorm,
         const void *privkey, const void *data, size_t data_len) {
 
 	shake256_context detrng;
 	shake256_context hd;
-	uint8_t tmpsd[FALCON_DET1024_TMPSIZE_SIGNDYN];
-	uint8_t logn[1] = {FALCON_DET1024_LOGN};
 	uint8_t salt[40];
+	size_t saltedsig_len = sizeof ctx->salted_sig;
+
+	if (falcon_get_logn(privkey, FALCON_DET1024_PRIVKEY_SIZE) != FALCON_DET1024_LOGN) {
+		return FALCON_ERR_FORMAT;
+	}
+
+	falcon_det1024_sign_start(&detrng, &hd, salt, privkey, data, data_len);
+
+	int r = Zf(sign_dyn_finish_norm)((inner_shake256_context *)&detrng,
+		ctx->salted_sig, &saltedsig_len, FALCON_SIG_COMPRESSED, sqnorm,
+		privkey, FALCON_DET1024_PRIVKEY_SIZE,
+		(inner_shake256_context *)&hd, salt,
+		ctx->tmp, sizeof ctx->tmp);
+	if (r != 0) {
+		return r;
+	}
+
+	falcon_det1024_unsalt_compressed(sig, sig_len, ctx->salted_sig, saltedsig_len);
+	return 0;
+}
+
+int falcon_det1024_expand_privkey(falcon_det1024_expanded_privkey *expanded_privkey,
+        const void *privkey) {
 
-	size_t saltedsig_len = FALCON_DET1024_SALTED_SIG_COMPRESSED_MAXSIZE;
-	uint8_t saltedsig[FALCON_DET1024_SALTED_SIG_COMPRESSED_MAXSIZE];
+	uint8_t tmpep[FALCON_DET1024_TMPSIZE_EXPANDPRIV];
 
 	if (falcon_get_logn(privkey, FALCON_DET1024_PRIVKEY_SIZE) != FALCON_DET1024_LOGN) {
 		return FALCON_ERR_FORMAT;
 	}
 
-	// SHAKE(logn || privkey || data), set to output mode.
-	shake256_init(&detrng);
-	shake256_inject(&detrng, logn, 1);
-	shake256_inject(&detrng, privkey, FALCON_DET1024_PRIVKEY_SIZE);
-	shake256_inject(&detrng, data, data_len);
-	shake256_flip(&detrng);
+	// The deterministic RNG is seeded from the encoded private key,
+	// so it is kept along with the expanded key.
+	memcpy(expanded_privkey->privkey, privkey, FALCON_DET1024_PRIVKEY_SIZE);
+	return falcon_expand_privkey(expanded_privkey->expanded_key,
+		FALCON_DET1024_EXPANDEDKEY_SIZE,
+		privkey, FALCON_DET1024_PRIVKEY_SIZE,
+		tmpep, FALCON_DET1024_TMPSIZE_EXPANDPRIV);
+}
 
-	falcon_det1024_write_salt(salt, FALCON_DET1024_CURRENT_SALT_VERSION);
+int falcon_det1024_sign_compressed_tree(void *sig, size_t *sig_len,
+        const falcon_det1024_expanded_privkey *expanded_privkey,
+        const void *data, size_t data_len) {
 
-	// SHAKE(salt || data), still in input mode.
-	shake256_init(&hd);
-	shake256_inject(&hd, salt, 40);
-	shake256_inject(&hd, data, data_len);
+	falcon_det1024_sign_ctx ctx;
 
-	int r = falcon_sign_dyn_finish(&detrng, saltedsig, &saltedsig_len,
-		FALCON_SIG_COMPRESSED, privkey, FALCON_DET1024_PRIVKEY_SIZE,
-		&hd, salt, tmpsd, FALCON_DET1024_TMPSIZE_SIGNDYN);
+	return falcon_det1024_sign_compressed_tree_ctx(&ctx, sig, sig_len,
+		expanded_privkey, data, data_len);
+}
+
+int falcon_det1024_sign_compressed_tree_ctx(falcon_det1024_sign_ctx *ctx,
+        void *sig, size_t *sig_len,
+        const falcon_det1024_expanded_privkey *expanded_privkey,
+        const void *data, size_t data_len) {
+	return falcon_det1024_sign_compressed_tree_with_norm_ctx(ctx,
+		sig, sig_len, NULL, expanded_privkey, data, data_len);
+}
+
+int falcon_det1024_sign_compressed_tree_with_norm_ctx(falcon_det1024_sign_ctx *ctx,
+        void *sig, size_t *sig_len, uint32_t *sqnorm,
+        const falcon_det1024_expanded_privkey *expanded_privkey,
+        const void *data, size_t data_len) {
+
+	shake256_context detrng;
+	shake256_context hd;
+	uint8_t salt[40];
+	size_t saltedsig_len = sizeof ctx->salted_sig;
+
+	if (*(const uint8_t *)expanded_privkey->expanded_key != FALCON_DET1024_LOGN) {
+		return FALCON_ERR_FORMAT;
+	}
+
+	falcon_det1024_sign_start(&detrng, &hd, salt,
+		expanded_privkey->privkey, data, data_len);
+
+	int r = Zf(sign_tree_finish_norm)((inner_shake256_context *)&detrng,
+		ctx->salted_sig, &saltedsig_len, FALCON_SIG_COMPRESSED, sqnorm,
+		expanded_privkey->expanded_key,
+		(inner_shake256_context *)&hd, salt,
+		ctx->tmp, sizeof ctx->tmp);
 	if (r != 0) {
 		return r;
 	}
 
-        // Transform the salted signature to unsalted format.
-	uint8_t *sigbytes = sig;
-	sigbytes[0] = saltedsig[0] | 0x80;
-	sigbytes[1] = FALCON_DET1024_CURRENT_SALT_VERSION;
-	memcpy(sigbytes+2, saltedsig+41, saltedsig_len-41);
+	falcon_det1024_unsalt_compressed(sig, sig_len, ctx->salted_sig, saltedsig_len);
+	return 0;
+}
 
-	*sig_len = saltedsig_len-40+1;
+int falcon_det1024_sign_compressed(void *sig, size_t *sig_len,
+        const void *privkey, const void *data, size_t data_len) {
+	return falcon_det1024_sign_compressed_with_norm(sig, sig_len, NULL,
+		privkey, data, data_len);
+}
+
+int falcon_det1024_vct_eval(void *sig, size_t *sig_len,
+        uint32_t *sqnorm, int *selected, const void *privkey,
+        const void *data, size_t data_len, uint32_t threshold) {
+
+	int r;
+
+	r = falcon_det1024_sign_compressed_with_norm(sig, sig_len, sqnorm,
+		privkey, data, data_len);
+	if (r != 0) {
+		return r;
+	}
+	*selected = *sqnorm < threshold;
+	return 0;
+}
+
+// Work queue of the batch functions: workers take job indices from a
+// shared counter. With GCC/Clang this is a lock-free atomic increment;
+// otherwise the counter is protected by a mutex. Each job only writes
+// its own output slot, so results do not depend on scheduling.
+#ifndef FALCON_DET1024_QUEUE_ATOMIC
+#if FALCON_THREADS && (defined __GNUC__ || defined __clang__)
+#define FALCON_DET1024_QUEUE_ATOMIC 1
+#else
+#define FALCON_DET1024_QUEUE_ATOMIC 0
+#endif
+#endif
+
+typedef struct {
+	size_t next;
+	size_t count;
+#if FALCON_THREADS && !FALCON_DET1024_QUEUE_ATOMIC
+	pthread_mutex_t lock;
+#endif
+} falcon_det1024_queue;
+
+// Get the next job index, or count if all jobs have been taken.
+static size_t falcon_det1024_queue_take(falcon_det1024_queue *q) {
+	size_t u;
+
+#if FALCON_DET1024_QUEUE_ATOMIC
+	u = __atomic_fetch_add(&q->next, 1, __ATOMIC_RELAXED);
+#else
+#if FALCON_THREADS
+	pthread_mutex_lock(&q->lock);
+#endif
+	u = q->next;
+	if (u < q->count) {
+		q->next ++;
+	}
+#if FALCON_THREADS
+	pthread_mutex_unlock(&q->lock);
+#endif
+#endif
+	return u < q->count ? u : q->count;
+}
+
+// Run worker(job) on nthreads threads (including the calling thread;
+// 0 means one per online CPU, capped at FALCON_DET1024_MAX_THREADS and
+// at the number of jobs). The job structure must start with its
+// falcon_det1024_queue.
+static int falcon_det1024_run_workers(void *(*worker)(void *), void *job,
+        unsigned nthreads) {
+
+	falcon_det1024_queue *q = job;
+
+	q->next = 0;
+#if FALCON_THREADS
+	{
+		pthread_t th[FALCON_DET1024_MAX_THREADS];
+		unsigned t, started;
+
+		if (nthreads == 0) {
+			long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+
+			nthreads = ncpu > 0 ? (unsigned)ncpu : 1;
+		}
+		if (nthreads > FALCON_DET1024_MAX_THREADS) {
+			nthreads = FALCON_DET1024_MAX_THREADS;
+		}
+		if (nthreads > q->count) {
+			nthreads = (unsigned)q->count;
+		}
+#if !FALCON_DET1024_QUEUE_ATOMIC
+		if (pthread_mutex_init(&q->lock, NULL) != 0) {
+			return FALCON_ERR_INTERNAL;
+		}
+#endif
+
+		// The calling thread is one of the workers. If a thread
+		// cannot be created, the remaining ones (at least the
+		// calling thread) simply take over its share of the work.
+		started = 0;
+		for (t = 1; t < nthreads; t ++) {
+			if (pthread_create(&th[started], NULL, worker, job) != 0) {
+				break;
+			}
+			started ++;
+		}
+		worker(job);
+		for (t = 0; t < started; t ++) {
+			pthread_join(th[t], NULL);
+		}
+#if !FALCON_DET1024_QUEUE_ATOMIC
+		pthread_mutex_destroy(&q->lock);
+#endif
+	}
+#else
+	(void)nthreads;
+	worker(job);
+#endif
+	return 0;
+}
+
+// Shared state of a falcon_det1024_vct_eval_batch() call.
+typedef struct {
+	falcon_det1024_queue queue;
+	falcon_det1024_vct_result *results;
+	const uint8_t *privkeys;
+	const void *data;
+	size_t data_len;
+	uint32_t threshold;
+} falcon_det1024_vct_job;
+
+static void *falcon_det1024_vct_worker(void *arg) {
+	falcon_det1024_vct_job *job = arg;
+	falcon_det1024_sign_ctx ctx;
+
+	for (;;) {
+		falcon_det1024_vct_result *res;
+		size_t u;
+
+		u = falcon_det1024_queue_take(&job->queue);
+		if (u >= job->queue.count) {
+			return NULL;
+		}
+		res = &job->results[u];
+		res->selected = 0;
+		res->sqnorm = 0;
+		res->sig_len = 0;
+		res->status = falcon_det1024_sign_compressed_ctx(&ctx,
+			res->sig, &res->sig_len, &res->sqnorm,
+			job->privkeys + u * FALCON_DET1024_PRIVKEY_SIZE,
+			job->data, job->data_len);
+		if (res->status == 0) {
+			res->selected = res->sqnorm < job->threshold;
+		}
+	}
+}
+
+int falcon_det1024_vct_eval_batch(falcon_det1024_vct_result *results,
+        const void *privkeys, size_t count,
+        const void *data, size_t data_len, uint32_t threshold,
+        unsigned nthreads) {
+
+	falcon_det1024_vct_job job;
+	size_t u;
+	int r;
+
+	job.queue.count = count;
+	job.results = results;
+	job.privkeys = privkeys;
+	job.data = data;
+	job.data_len = data_len;
+	job.threshold = threshold;
+
+	r = falcon_det1024_run_workers(falcon_det1024_vct_worker, &job, nthreads);
+	if (r != 0) {
+		return r;
+	}
+	for (u = 0; u < count; u ++) {
+		if (results[u].status != 0) {
+			return results[u].status;
+		}
+	}
+	return 0;
+}
+
+// Shared state of a falcon_det1024_keygen_batch() call.
+typedef struct {
+	falcon_det1024_queue queue;
+	uint8_t *privkeys;
+	uint8_t *pubkeys;
+	int *status;
+	const void *const *seeds;
+	const size_t *seed_lens;
+} falcon_det1024_keygen_job;
+
+static void *falcon_det1024_keygen_worker(void *arg) {
+	falcon_det1024_keygen_job *job = arg;
+	falcon_det1024_sign_ctx ctx;
+
+	for (;;) {
+		shake256_context rng;
+		size_t u;
+
+		u = falcon_det1024_queue_take(&job->queue);
+		if (u >= job->queue.count) {
+			return NULL;
+		}
+		shake256_init_prng_from_seed(&rng,
+			job->seeds[u], job->seed_lens[u]);
+		job->status[u] = falcon_det1024_keygen_ctx(&ctx, &rng,
+			job->privkeys + u * FALCON_DET1024_PRIVKEY_SIZE,
+			job->pubkeys + u * FALCON_DET1024_PUBKEY_SIZE);
+	}
+}
+
+int falcon_det1024_keygen_batch(void *privkeys, void *pubkeys, int *status,
+        const void *const *seeds, const size_t *seed_lens, size_t count,
+        unsigned nthreads) {
+
+	falcon_det1024_keygen_job job;
+	size_t u;
+	int r;
+
+	job.queue.count = count;
+	job.privkeys = privkeys;
+	job.pubkeys = pubkeys;
+	job.status = status;
+	job.seeds = seeds;
+	job.seed_lens = seed_lens;
 
+	r = falcon_det1024_run_workers(falcon_det1024_keygen_worker, &job, nthreads);
+	if (r != 0) {
+		return r;
+	}
+	for (u = 0; u < count; u ++) {
+		if (status[u] != 0) {
+			return status[u];
+		}
+	}
 	return 0;
 }
 
@@ -121,8 +470,15 @@ void falcon_det1024_resalt(uint8_t *salted_sig,
 int falcon_det1024_verify_compressed(const void *sig, size_t sig_len,
         const void *pubkey, const void *data, size_t data_len) {
 
-	uint8_t tmpvv[FALCON_DET1024_TMPSIZE_VERIFY];
-	uint8_t salted_sig[FALCON_DET1024_SALTED_SIG_COMPRESSED_MAXSIZE];
+	falcon_det1024_verify_ctx ctx;
+
+	return falcon_det1024_verify_compressed_ctx(&ctx, sig, sig_len,
+		pubkey, data, data_len);
+}
+
+int falcon_det1024_verify_compressed_ctx(falcon_det1024_verify_ctx *ctx,
+        const void *sig, size_t sig_len,
+        const void *pubkey, const void *data, size_t data_len) {
 
 	if (sig_len < 2) {
 		return FALCON_ERR_BADSIG;
@@ -140,28 +496,262 @@ int falcon_det1024_verify_compressed(const void *sig, size_t sig_len,
 	}
 
 
-	falcon_det1024_resalt(salted_sig, sig, sig_len);
+	falcon_det1024_resalt(ctx->salted_sig, sig, sig_len);
 
-	return falcon_verify(salted_sig, salted_sig_len, FALCON_SIG_COMPRESSED,
+	return falcon_verify(ctx->salted_sig, salted_sig_len, FALCON_SIG_COMPRESSED,
 		pubkey, FALCON_DET1024_PUBKEY_SIZE, data, data_len,
-		tmpvv, FALCON_DET1024_TMPSIZE_VERIFY);
+		ctx->tmp, sizeof ctx->tmp);
 }
 
 int falcon_det1024_verify_ct(const void *sig,
         const void *pubkey, const void *data, size_t data_len) {
 
-	uint8_t tmpvv[FALCON_DET1024_TMPSIZE_VERIFY];
-	uint8_t salted_sig[FALCON_DET1024_SALTED_SIG_CT_SIZE];
+	falcon_det1024_verify_ctx ctx;
+
+	return falcon_det1024_verify_ct_ctx(&ctx, sig, pubkey, data, data_len);
+}
+
+int falcon_det1024_verify_ct_ctx(falcon_det1024_verify_ctx *ctx,
+        const void *sig,
+        const void *pubkey, const void *data, size_t data_len) {
 
 	if (((uint8_t*)sig)[0] != FALCON_DET1024_SIG_CT_HEADER) {
 		return FALCON_ERR_BADSIG;
 	}
 
-	falcon_det1024_resalt(salted_sig, sig, FALCON_DET1024_SIG_CT_SIZE);
+	falcon_det1024_resalt(ctx->salted_sig, sig, FALCON_DET1024_SIG_CT_SIZE);
 
-	return falcon_verify(salted_sig, FALCON_DET1024_SALTED_SIG_CT_SIZE, FALCON_SIG_CT,
+	return falcon_verify(ctx->salted_sig, FALCON_DET1024_SALTED_SIG_CT_SIZE, FALCON_SIG_CT,
 		pubkey, FALCON_DET1024_PUBKEY_SIZE, data, data_len,
-		tmpvv, FALCON_DET1024_TMPSIZE_VERIFY);
+		ctx->tmp, sizeof ctx->tmp);
+}
+
+// Decode a det1024 public key into h[] and convert it to NTT +
+// Montgomery representation, as expected by Zf(verify_raw).
+static int falcon_det1024_decode_pubkey_ntt(uint16_t *h, const void *pubkey) {
+	if (((const uint8_t*)pubkey)[0] != 0x00 + FALCON_DET1024_LOGN) {
+		return FALCON_ERR_FORMAT;
+	}
+	if (Zf(modq_decode)(h, FALCON_DET1024_LOGN, (const uint8_t*)pubkey + 1, FALCON_DET1024_PUBKEY_SIZE - 1)
+		!= FALCON_DET1024_PUBKEY_SIZE - 1)
+	{
+		return FALCON_ERR_FORMAT;
+	}
+	Zf(to_ntt_monty)(h, FALCON_DET1024_LOGN);
+	return 0;
+}
+
+// Decode a compressed det1024 signature into sv[] and initialize hd
+// with SHAKE(salt || data), flipped and ready for hashing to a point.
+// This performs the same signature checks as
+// falcon_det1024_verify_compressed() (which goes through
+// falcon_verify_finish()).
+static int falcon_det1024_decode_compressed(int16_t *sv, shake256_context *hd,
+        const void *sig, size_t sig_len, const void *data, size_t data_len) {
+
+	const uint8_t *sigbytes = sig;
+	uint8_t salt[40];
+	size_t v;
+
+	if (sig_len < 2) {
+		return FALCON_ERR_BADSIG;
+	}
+
+	if (sigbytes[0] != FALCON_DET1024_SIG_COMPRESSED_HEADER) {
+		return FALCON_ERR_BADSIG;
+	}
+
+	if (sig_len + 40 - 1 > FALCON_DET1024_SALTED_SIG_COMPRESSED_MAXSIZE) {
+		return FALCON_ERR_BADSIG;
+	}
+
+	// The encoded s2 must use all remaining bytes (no padding).
+	v = Zf(comp_decode)(sv, FALCON_DET1024_LOGN, sigbytes + 2, sig_len - 2);
+	if (v == 0 || v != sig_len - 2) {
+		return FALCON_ERR_FORMAT;
+	}
+
+	// SHAKE(salt || data) with the salt version from the signature.
+	falcon_det1024_write_salt(salt, sigbytes[1]);
+	shake256_init(hd);
+	shake256_inject(hd, salt, 40);
+	shake256_inject(hd, data, data_len);
+	shake256_flip(hd);
+	return 0;
+}
+
+// Verify a compressed det1024 signature against a public key h[] that
+// is already in NTT + Montgomery representation. This performs the
+// same checks as falcon_det1024_verify_compressed(), minus the public
+// key decoding.
+// tmp[] must have room for 3*2^logn 16-bit words.
+static int falcon_det1024_verify_compressed_ntt(const void *sig, size_t sig_len,
+        const uint16_t *h, const void *data, size_t data_len, uint16_t *tmp) {
+
+	uint16_t *hm = tmp;
+	int16_t *sv = (int16_t *)(hm + (1 << FALCON_DET1024_LOGN));
+	shake256_context hd;
+	int r;
+
+	r = falcon_det1024_decode_compressed(sv, &hd, sig, sig_len, data, data_len);
+	if (r != 0) {
+		return r;
+	}
+	Zf(hash_to_point_vartime)((inner_shake256_context *)&hd, hm, FALCON_DET1024_LOGN);
+
+	if (!Zf(verify_raw)(hm, sv, h, FALCON_DET1024_LOGN, (uint8_t *)(sv + (1 << FALCON_DET1024_LOGN)))) {
+		return FALCON_ERR_BADSIG;
+	}
+	return 0;
+}
+
+// Verify a CT-format det1024 signature against a public key h[] that
+// is already in NTT + Montgomery representation. tmp[] must have room
+// for 3*2^logn 16-bit words.
+static int falcon_det1024_verify_ct_ntt(const void *sig,
+        const uint16_t *h, const void *data, size_t data_len, uint16_t *tmp) {
+
+	const uint8_t *sigbytes = sig;
+	uint16_t *hm = tmp;
+	int16_t *sv = (int16_t *)(hm + (1 << FALCON_DET1024_LOGN));
+	uint8_t salt[40];
+	shake256_context hd;
+	size_t v;
+
+	if (sigbytes[0] != FALCON_DET1024_SIG_CT_HEADER) {
+		return FALCON_ERR_BADSIG;
+	}
+
+	v = Zf(trim_i16_decode)(sv, FALCON_DET1024_LOGN, Zf(max_sig_bits)[FALCON_DET1024_LOGN],
+		sigbytes + 2, FALCON_DET1024_SIG_CT_SIZE - 2);
+	if (v != FALCON_DET1024_SIG_CT_SIZE - 2) {
+		return FALCON_ERR_FORMAT;
+	}
+
+	falcon_det1024_write_salt(salt, sigbytes[1]);
+	shake256_init(&hd);
+	shake256_inject(&hd, salt, 40);
+	shake256_inject(&hd, data, data_len);
+	shake256_flip(&hd);
+	Zf(hash_to_point_ct)((inner_shake256_context *)&hd, hm, FALCON_DET1024_LOGN,
+		(uint8_t *)(sv + (1 << FALCON_DET1024_LOGN)));
+
+	if (!Zf(verify_raw)(hm, sv, h, FALCON_DET1024_LOGN, (uint8_t *)(sv + (1 << FALCON_DET1024_LOGN)))) {
+		return FALCON_ERR_BADSIG;
+	}
+	return 0;
+}
+
+int falcon_det1024_expand_pubkey(falcon_det1024_expanded_pubkey *expanded_pubkey,
+        const void *pubkey) {
+	return falcon_det1024_decode_pubkey_ntt(expanded_pubkey->h, pubkey);
+}
+
+int falcon_det1024_verify_compressed_expanded(const void *sig, size_t sig_len,
+        const falcon_det1024_expanded_pubkey *expanded_pubkey,
+        const void *data, size_t data_len) {
+
+	uint16_t tmp[3 << FALCON_DET1024_LOGN];
+
+	return falcon_det1024_verify_compressed_ntt(sig, sig_len,
+		expanded_pubkey->h, data, data_len, tmp);
+}
+
+int falcon_det1024_verify_ct_expanded(const void *sig,
+        const falcon_det1024_expanded_pubkey *expanded_pubkey,
+        const void *data, size_t data_len) {
+
+	uint16_t tmp[3 << FALCON_DET1024_LOGN];
+
+	return falcon_det1024_verify_ct_ntt(sig,
+		expanded_pubkey->h, data, data_len, tmp);
+}
+
+int falcon_det1024_verify_batch_expanded(int *results,
+        const void *const *sigs, const size_t *sig_lens,
+        const falcon_det1024_expanded_pubkey *expanded_pubkey,
+        const void *const *data, const size_t *data_lens, size_t count) {
+
+	uint16_t hm[4 << FALCON_DET1024_LOGN];
+	int16_t sv[4 << FALCON_DET1024_LOGN];
+	uint16_t tmp[1 << FALCON_DET1024_LOGN];
+	shake256_context hd[4];
+	size_t u, k, w;
+	int r[4], ret;
+
+	// Signatures are processed in groups of four: the four messages
+	// are hashed to points together (the SHAKE256 outputs are
+	// squeezed in parallel), then each signature is checked with
+	// Zf(verify_raw). Slots for rejected signatures (and for the
+	// padding of the last group) hash an empty input, so that all
+	// four SHAKE256 contexts stay in lockstep. The buffers are reused
+	// for every group so that they stay hot in cache across the
+	// whole batch. Running the NTTs of the four signatures layer by
+	// layer side by side was measured to bring no gain: hashing
+	// dominates the cost of a verification.
+	ret = 0;
+	for (u = 0; u < count; u += w) {
+		w = count - u;
+		if (w > 4) {
+			w = 4;
+		}
+		for (k = 0; k < 4; k ++) {
+			r[k] = FALCON_ERR_BADARG;
+			if (k < w) {
+				r[k] = falcon_det1024_decode_compressed(
+					sv + (k << FALCON_DET1024_LOGN), &hd[k],
+					sigs[u + k], sig_lens[u + k],
+					data[u + k], data_lens[u + k]);
+			}
+			if (r[k] != 0) {
+				shake256_init(&hd[k]);
+				shake256_flip(&hd[k]);
+			}
+		}
+		Zf(hash_to_point_vartime_x4)((inner_shake256_context *)hd, hm,
+			FALCON_DET1024_LOGN);
+		for (k = 0; k < w; k ++) {
+			if (r[k] == 0 && !Zf(verify_raw)(
+				hm + (k << FALCON_DET1024_LOGN),
+				sv + (k << FALCON_DET1024_LOGN),
+				expanded_pubkey->h, FALCON_DET1024_LOGN,
+				(uint8_t *)tmp))
+			{
+				r[k] = FALCON_ERR_BADSIG;
+			}
+			if (results != NULL) {
+				results[u + k] = r[k];
+			}
+			if (ret == 0) {
+				ret = r[k];
+			}
+		}
+	}
+	return ret;
+}
+
+int falcon_det1024_verify_batch(int *results,
+        const void *const *sigs, const size_t *sig_lens,
+        const void *pubkey,
+        const void *const *data, const size_t *data_lens, size_t count) {
+
+	falcon_det1024_expanded_pubkey epk;
+	size_t u;
+	int r;
+
+	// The public key is decoded and converted to NTT form only once
+	// for the whole batch.
+	r = falcon_det1024_expand_pubkey(&epk, pubkey);
+	if (r != 0) {
+		if (results != NULL) {
+			for (u = 0; u < count; u ++) {
+				results[u] = r;
+			}
+		}
+		return r;
+	}
+	return falcon_det1024_verify_batch_expanded(results, sigs, sig_lens,
+		&epk, data, data_lens, count);
 }
 
 int falcon_det1024_get_salt_version(const void* sig) {
@@ -196,6 +786,23 @@ void falcon_det1024_hash_to_point_coeffs(uint16_t *c, const void *data, size_t d
 	Zf(hash_to_point_ct)((inner_shake256_context *)&ctx, c, FALCON_DET1024_LOGN, tmp);
 }
 
+void falcon_det1024_hash_to_point_coeffs_x4(uint16_t *c,
+        const void *const *data, const size_t *data_lens, uint8_t salt_version) {
+	uint8_t salt[40];
+	shake256_context ctx[4];
+	uint16_t tmp[4 << FALCON_DET1024_LOGN];
+	int i;
+
+	falcon_det1024_write_salt(salt, salt_version);
+	for (i = 0; i < 4; i ++) {
+		shake256_init(&ctx[i]);
+		shake256_inject(&ctx[i], salt, 40);
+		shake256_inject(&ctx[i], data[i], data_lens[i]);
+		shake256_flip(&ctx[i]);
+	}
+	Zf(hash_to_point_x4)((inner_shake256_context *)ctx, c, FALCON_DET1024_LOGN, (uint8_t *)tmp);
+}
+
 int falcon_det1024_s2_coeffs(int16_t *s2, const void* sig) {
 	unsigned logn = FALCON_DET1024_LOGN;
 
@@ -12,6 +12,7 @@ extern "C" {
 #define FALCON_DET1024_LOGN 10
 #define FALCON_DET1024_PUBKEY_SIZE FALCON_PUBKEY_SIZE(FALCON_DET1024_LOGN)
 #define FALCON_DET1024_PRIVKEY_SIZE FALCON_PRIVKEY_SIZE(FALCON_DET1024_LOGN)
+#define FALCON_DET1024_EXPANDEDKEY_SIZE FALCON_EXPANDEDKEY_SIZE(FALCON_DET1024_LOGN)
 
 // Replace the 40 byte salt (nonce) with a single byte representing
 // the salt version:
@@ -27,6 +28,31 @@ extern "C" {
 // (input-output) changes to the signing algorithm.
 #define FALCON_DET1024_CURRENT_SALT_VERSION 0
 
+/*
+ * Reusable workspace for det1024 key pair generation and signing. The
+ * *_ctx() functions use it as scratch space, instead of the large
+ * (about 80 kB) temporary buffers that the other functions put on the
+ * stack; a workspace can thus be allocated once (e.g. per thread) and
+ * reused for many calls, but it must not be used by two calls at the
+ * same time. tmp[] is 64-bit aligned, as required for floating-point
+ * values; the library does not use sig[], which is room for the
+ * output signature (e.g. for language bindings that copy it out).
+ */
+typedef struct {
+	uint64_t tmp[(FALCON_TMPSIZE_SIGNDYN(FALCON_DET1024_LOGN) + 7) / 8];
+	uint8_t salted_sig[FALCON_SIG_COMPRESSED_MAXSIZE(FALCON_DET1024_LOGN)];
+	uint8_t sig[FALCON_DET1024_SIG_COMPRESSED_MAXSIZE];
+} falcon_det1024_sign_ctx;
+
+/*
+ * Reusable workspace for det1024 signature verification, with the same
+ * usage rules as falcon_det1024_sign_ctx.
+ */
+typedef struct {
+	uint64_t tmp[(FALCON_TMPSIZE_VERIFY(FALCON_DET1024_LOGN) + 7) / 8];
+	uint8_t salted_sig[FALCON_SIG_CT_SIZE(FALCON_DET1024_LOGN)];
+} falcon_det1024_verify_ctx;
+
 /*
  * Generate a keypair (for Falcon parameter n=1024).
  *
@@ -45,6 +71,26 @@ extern "C" {
  */
 int falcon_det1024_keygen(shake256_context *rng, void *privkey, void *pubkey);
 
+/*
+ * Same as falcon_det1024_keygen(), using the workspace *ctx.
+ */
+int falcon_det1024_keygen_ctx(falcon_det1024_sign_ctx *ctx,
+	shake256_context *rng, void *privkey, void *pubkey);
+
+/*
+ * Same as falcon_det1024_keygen(), with the NTRU equation solving
+ * spread over the tasks of the caller-supplied thread pool (see
+ * falcon_keygen_make_pool()); the key pair is the same for the same
+ * rng state. tmp[] (of length tmp_len bytes) must have size at least
+ * FALCON_DET1024_TMPSIZE_KEYGEN_POOL(pool->nthreads).
+ */
+#define FALCON_DET1024_TMPSIZE_KEYGEN_POOL(nthreads) \
+	FALCON_TMPSIZE_KEYGEN_POOL(FALCON_DET1024_LOGN, nthreads)
+
+int falcon_det1024_keygen_pool(const falcon_thread_pool *pool,
+	void *tmp, size_t tmp_len,
+	shake256_context *rng, void *privkey, void *pubkey);
+
 /*
  * Deterministically sign the data provided in buffer data[] (of
  * length data_len bytes), using the private key held in privkey[] (of
@@ -69,6 +115,165 @@ int falcon_det1024_keygen(shake256_context *rng, void *privkey, void *pubkey);
 int falcon_det1024_sign_compressed(void *sig, size_t *sig_len,
 	const void *privkey, const void *data, size_t data_len);
 
+/*
+ * Same as falcon_det1024_sign_compressed(), but also write the
+ * aggregate squared norm of the signature vector (s1,s2) into *sqnorm
+ * (if sqnorm is not NULL). This is the norm the signer computes for
+ * its own acceptance test, so it is obtained without recomputing s1
+ * from the signature and the public key.
+ *
+ * Returned value: 0 on success, or a negative error code.
+ */
+int falcon_det1024_sign_compressed_with_norm(void *sig, size_t *sig_len,
+	uint32_t *sqnorm, const void *privkey, const void *data, size_t data_len);
+
+/*
+ * Same as falcon_det1024_sign_compressed_with_norm() (sqnorm may be
+ * NULL), using the workspace *ctx.
+ */
+int falcon_det1024_sign_compressed_ctx(falcon_det1024_sign_ctx *ctx,
+	void *sig, size_t *sig_len, uint32_t *sqnorm,
+	const void *privkey, const void *data, size_t data_len);
+
+/*
+ * A det1024 private key, expanded for signing: the encoded private key
+ * (which seeds the deterministic RNG) along with the expanded key
+ * produced by falcon_expand_privkey() (the B0 matrix in FFT
+ * representation and the ffLDL tree). Expanding a private key once
+ * and reusing it skips the recomputation of the tree on every
+ * signature. The contents are opaque; the structure is large (about
+ * 120 kB), so it should not be allocated on the stack.
+ *
+ * The expanded key holds floating-point values at an offset that
+ * depends on its alignment (see falcon_expand_privkey()). It is stored
+ * first, as 64-bit words, so that the structure is 8-byte aligned and
+ * that offset is the same for every instance: an expanded private key
+ * may be copied (e.g. with memcpy() or by assignment) to another
+ * falcon_det1024_expanded_privkey and remain valid.
+ */
+typedef struct {
+	uint64_t expanded_key[(FALCON_DET1024_EXPANDEDKEY_SIZE + 7) / 8];
+	uint8_t privkey[FALCON_DET1024_PRIVKEY_SIZE];
+} falcon_det1024_expanded_privkey;
+
+/*
+ * Expand the private key provided in privkey[] (of length
+ * FALCON_DET1024_PRIVKEY_SIZE bytes) into *expanded_privkey.
+ *
+ * Returned value: 0 on success, or a negative error code.
+ */
+int falcon_det1024_expand_privkey(falcon_det1024_expanded_privkey *expanded_privkey,
+	const void *privkey);
+
+/*
+ * Same as falcon_det1024_sign_compressed(), but using an expanded
+ * private key (see falcon_det1024_expand_privkey()). The signature is
+ * identical to the one computed by falcon_det1024_sign_compressed()
+ * with the same private key and data; it is faster to compute since
+ * the ffLDL tree is not rebuilt.
+ *
+ * Returned value: 0 on success, or a negative error code.
+ */
+int falcon_det1024_sign_compressed_tree(void *sig, size_t *sig_len,
+	const falcon_det1024_expanded_privkey *expanded_privkey,
+	const void *data, size_t data_len);
+
+/*
+ * Same as falcon_det1024_sign_compressed_tree(), using the workspace
+ * *ctx.
+ */
+int falcon_det1024_sign_compressed_tree_ctx(falcon_det1024_sign_ctx *ctx,
+	void *sig, size_t *sig_len,
+	const falcon_det1024_expanded_privkey *expanded_privkey,
+	const void *data, size_t data_len);
+
+/*
+ * Same as falcon_det1024_sign_compressed_tree_ctx(), but also output
+ * the squared norm of the signature vector (s1,s2) in *sqnorm (if
+ * sqnorm is not NULL), as falcon_det1024_sign_compressed_ctx() does.
+ */
+int falcon_det1024_sign_compressed_tree_with_norm_ctx(falcon_det1024_sign_ctx *ctx,
+	void *sig, size_t *sig_len, uint32_t *sqnorm,
+	const falcon_det1024_expanded_privkey *expanded_privkey,
+	const void *data, size_t data_len);
+
+/*
+ * Evaluate a VCT lottery ticket: deterministically sign data[] (of
+ * length data_len bytes) with privkey[] (of length
+ * FALCON_DET1024_PRIVKEY_SIZE bytes), exactly as
+ * falcon_det1024_sign_compressed() does, and also output the
+ * aggregate squared norm of the signature vector (s1,s2) in *sqnorm,
+ * and whether that norm is below threshold in *selected (1 if
+ * *sqnorm < threshold, 0 otherwise).
+ *
+ * The norm is the one output by
+ * falcon_det1024_sign_compressed_with_norm().
+ *
+ * Returned value: 0 on success, or a negative error code.
+ */
+int falcon_det1024_vct_eval(void *sig, size_t *sig_len,
+	uint32_t *sqnorm, int *selected, const void *privkey,
+	const void *data, size_t data_len, uint32_t threshold);
+
+/*
+ * Result of one falcon_det1024_vct_eval() within a batch: status is
+ * the returned value (0 on success, or a negative error code); the
+ * other fields are meaningful only on success.
+ */
+typedef struct {
+	int status;
+	int selected;
+	uint32_t sqnorm;
+	size_t sig_len;
+	uint8_t sig[FALCON_DET1024_SIG_COMPRESSED_MAXSIZE];
+} falcon_det1024_vct_result;
+
+// Maximum number of worker threads used by the batch functions
+// (falcon_det1024_vct_eval_batch() and falcon_det1024_keygen_batch()).
+#define FALCON_DET1024_MAX_THREADS 64
+#define FALCON_DET1024_VCT_MAX_THREADS FALCON_DET1024_MAX_THREADS
+
+/*
+ * Evaluate count VCT lottery tickets over the same data[] (of length
+ * data_len bytes): privkeys[] holds count consecutive private keys of
+ * FALCON_DET1024_PRIVKEY_SIZE bytes each, and results[i] receives the
+ * outcome of falcon_det1024_vct_eval() for the i-th key.
+ *
+ * The work is spread over nthreads threads (including the calling
+ * thread); nthreads = 0 uses one thread per online CPU. The number of
+ * threads is capped at FALCON_DET1024_MAX_THREADS. If the library
+ * is built without thread support (FALCON_THREADS = 0), all tickets
+ * are evaluated in the calling thread. Results do not depend on the
+ * number of threads.
+ *
+ * Returned value: 0 if all evaluations succeeded, otherwise the error
+ * code of the first failed evaluation (in key order).
+ */
+int falcon_det1024_vct_eval_batch(falcon_det1024_vct_result *results,
+	const void *privkeys, size_t count,
+	const void *data, size_t data_len, uint32_t threshold,
+	unsigned nthreads);
+
+/*
+ * Generate count key pairs in parallel: key pair i is generated, as
+ * falcon_det1024_keygen() does, from a SHAKE256 PRNG seeded with
+ * seeds[i] (of length seed_lens[i] bytes; see
+ * shake256_init_prng_from_seed()). Private keys are written in
+ * privkeys[] and public keys in pubkeys[], as count consecutive keys
+ * of FALCON_DET1024_PRIVKEY_SIZE and FALCON_DET1024_PUBKEY_SIZE bytes
+ * respectively; status[i] receives the returned value for key pair i.
+ *
+ * Worker threads take seeds from a shared lock-free queue; threads are
+ * used as in falcon_det1024_vct_eval_batch(). Each key pair depends
+ * only on its seed, not on the number of threads or on scheduling.
+ *
+ * Returned value: 0 if all key pairs were generated, otherwise the
+ * error code of the first failure (in seed order).
+ */
+int falcon_det1024_keygen_batch(void *privkeys, void *pubkeys, int *status,
+	const void *const *seeds, const size_t *seed_lens, size_t count,
+	unsigned nthreads);
+
 /*
  * Verify the compressed-format, deterministic-mode (det1024)
  * signature provided in sig[] (of length sig_len bytes) with respect
@@ -86,6 +291,13 @@ int falcon_det1024_sign_compressed(void *sig, size_t *sig_len,
 int falcon_det1024_verify_compressed(const void *sig, size_t sig_len,
 	const void *pubkey, const void *data, size_t data_len);
 
+/*
+ * Same as falcon_det1024_verify_compressed(), using the workspace *ctx.
+ */
+int falcon_det1024_verify_compressed_ctx(falcon_det1024_verify_ctx *ctx,
+	const void *sig, size_t sig_len,
+	const void *pubkey, const void *data, size_t data_len);
+
 /*
  * Verify the CT-format, deterministic-mode (det1024) signature
  * provided in sig[] (of length FALCON_DET1024_SIG_CT_SIZE bytes) with
@@ -102,6 +314,87 @@ int falcon_det1024_verify_compressed(const void *sig, size_t sig_len,
 int falcon_det1024_verify_ct(const void *sig,
 	const void *pubkey, const void *data, size_t data_len);
 
+/*
+ * Same as falcon_det1024_verify_ct(), using the workspace *ctx.
+ */
+int falcon_det1024_verify_ct_ctx(falcon_det1024_verify_ctx *ctx,
+	const void *sig,
+	const void *pubkey, const void *data, size_t data_len);
+
+/*
+ * A det1024 public key, decoded and converted to the NTT + Montgomery
+ * representation used internally by signature verification. Expanding
+ * a public key once and reusing it skips the decoding and the NTT on
+ * every verification. The contents are opaque, and are only meaningful
+ * to the implementation that produced them.
+ */
+typedef struct {
+	uint16_t h[1 << FALCON_DET1024_LOGN];
+} falcon_det1024_expanded_pubkey;
+
+/*
+ * Expand the public key provided in pubkey[] (of length
+ * FALCON_DET1024_PUBKEY_SIZE bytes) into *expanded_pubkey.
+ *
+ * Returned value: 0 on success, or a negative error code.
+ */
+int falcon_det1024_expand_pubkey(falcon_det1024_expanded_pubkey *expanded_pubkey,
+	const void *pubkey);
+
+/*
+ * Same as falcon_det1024_verify_compressed(), but using a public key
+ * expanded with falcon_det1024_expand_pubkey().
+ *
+ * Returned value: 0 on success, or a negative error code.
+ */
+int falcon_det1024_verify_compressed_expanded(const void *sig, size_t sig_len,
+	const falcon_det1024_expanded_pubkey *expanded_pubkey,
+	const void *data, size_t data_len);
+
+/*
+ * Same as falcon_det1024_verify_ct(), but using a public key expanded
+ * with falcon_det1024_expand_pubkey().
+ *
+ * Returned value: 0 on success, or a negative error code.
+ */
+int falcon_det1024_verify_ct_expanded(const void *sig,
+	const falcon_det1024_expanded_pubkey *expanded_pubkey,
+	const void *data, size_t data_len);
+
+/*
+ * Verify a batch of count compressed-format, deterministic-mode
+ * (det1024) signatures, all under the same public key pubkey[] (of
+ * length FALCON_DET1024_PUBKEY_SIZE bytes). Signature i is sigs[i] (of
+ * length sig_lens[i] bytes) and covers data[i] (of length data_lens[i]
+ * bytes).
+ *
+ * The public key is decoded and converted to NTT representation only
+ * once for the whole batch, and the messages are hashed to points four
+ * at a time. Each signature is otherwise checked on its own, exactly
+ * as in falcon_det1024_verify_compressed(); in particular, the NTTs of
+ * the signatures are not interleaved.
+ *
+ * If results is not NULL, then results[i] receives the outcome for
+ * signature i (0 on success, or a negative error code). If the public
+ * key cannot be decoded, all entries are set to that error.
+ *
+ * Returned value: 0 if all signatures are valid, otherwise the first
+ * non-zero error code encountered.
+ */
+int falcon_det1024_verify_batch(int *results,
+	const void *const *sigs, const size_t *sig_lens,
+	const void *pubkey,
+	const void *const *data, const size_t *data_lens, size_t count);
+
+/*
+ * Same as falcon_det1024_verify_batch(), but using a public key
+ * expanded with falcon_det1024_expand_pubkey().
+ */
+int falcon_det1024_verify_batch_expanded(int *results,
+	const void *const *sigs, const size_t *sig_lens,
+	const falcon_det1024_expanded_pubkey *expanded_pubkey,
+	const void *const *data, const size_t *data_lens, size_t count);
+
 /*
  * Convert the compressed-format, deterministic-mode (det1024)
  * signature in sig_compressed (of length sig_compressed_len bytes) to
@@ -140,6 +433,16 @@ int falcon_det1024_pubkey_coeffs(uint16_t *h, const void *pubkey);
  */
 void falcon_det1024_hash_to_point_coeffs(uint16_t *c, const void *data, size_t data_len, uint8_t salt_version);
 
+/*
+ * Same as falcon_det1024_hash_to_point_coeffs(), for four messages at
+ * once: data[i] (of length data_lens[i]) is hashed into
+ * c[i*1024 .. (i+1)*1024-1], for i = 0..3. The four SHAKE256 outputs
+ * are squeezed in parallel; the output is identical to four calls to
+ * falcon_det1024_hash_to_point_coeffs().
+ */
+void falcon_det1024_hash_to_point_coeffs_x4(uint16_t *c,
+	const void *const *data, const size_t *data_lens, uint8_t salt_version);
+
 /*
  * Unpack a det1024 signature in CT format to the vector of polynomial
  * coefficients of the associated ring element s_2.
@@ -125,6 +125,136 @@ align_fpr(void *tmp)
 	return (fpr *)atmp;
 }
 
+/*
+ * Floating-point implementation currently in use for key pair
+ * generation and signing (see falcon_fp_select()).
+ */
+static const fp_backend *fp_current = &Zf(fp_backend);
+
+/*
+ * Known-answer test for a floating-point implementation: generate a
+ * key pair (degree 256) from a fixed seed, then compute some
+ * signatures with both the dynamic and expanded key variants, and
+ * compare a SHAKE256 digest of all outputs with the value obtained
+ * with the emulated code. Returned value is 1 on success, 0 on error.
+ */
+static int
+fp_selftest(const fp_backend *fb)
+{
+	/*
+	 * Digest obtained with the emulated implementation.
+	 */
+	static const uint8_t kat[32] = {
+		0x28, 0x38, 0xA5, 0xB8, 0xD7, 0x6D, 0xCB, 0x72,
+		0xB5, 0x88, 0x86, 0x05, 0x53, 0x35, 0xC6, 0xFC,
+		0xD1, 0xF8, 0xEC, 0xE2, 0x4C, 0xEA, 0xDD, 0xBF,
+		0xC4, 0xA6, 0x85, 0x72, 0x0D, 0x17, 0x2D, 0x64
+	};
+
+	union {
+		uint8_t b[FALCON_TMPSIZE_SIGNDYN(8)];
+		uint64_t dummy_u64;
+		fpr dummy_fpr;
+	} tmp;
+	union {
+		uint8_t b[FALCON_EXPANDEDKEY_SIZE(8)];
+		uint64_t dummy_u64;
+		fpr dummy_fpr;
+	} ek;
+	int8_t f[256], g[256], F[256], G[256];
+	uint16_t h[256], hm[256];
+	int16_t sig[256];
+	inner_shake256_context rng, dig;
+	uint8_t buf[4], out[32];
+	unsigned oldcw, u, v;
+	uint32_t sqnorm;
+
+	oldcw = set_fpu_cw(2);
+	inner_shake256_init(&rng);
+	inner_shake256_inject(&rng,
+		(const uint8_t *)"falcon fp self-test", 19);
+	inner_shake256_flip(&rng);
+	inner_shake256_init(&dig);
+	fb->keygen(&rng, f, g, F, G, h, 8, tmp.b);
+	inner_shake256_inject(&dig, (const uint8_t *)f, sizeof f);
+	inner_shake256_inject(&dig, (const uint8_t *)g, sizeof g);
+	inner_shake256_inject(&dig, (const uint8_t *)F, sizeof F);
+	inner_shake256_inject(&dig, (const uint8_t *)G, sizeof G);
+	for (u = 0; u < 256; u ++) {
+		buf[0] = (uint8_t)h[u];
+		buf[1] = (uint8_t)(h[u] >> 8);
+		inner_shake256_inject(&dig, buf, 2);
+	}
+	fb->expand_privkey(ek.b, f, g, F, G, 8, tmp.b);
+	for (u = 0; u < 8; u ++) {
+		Zf(hash_to_point_vartime)(&rng, hm, 8);
+		if ((u & 1) == 0) {
+			fb->sign_tree_norm(sig, &sqnorm,
+				&rng, ek.b, hm, 8, tmp.b);
+		} else {
+			fb->sign_dyn_norm(sig, &sqnorm,
+				&rng, f, g, F, G, hm, 8, tmp.b);
+		}
+		for (v = 0; v < 256; v ++) {
+			buf[0] = (uint8_t)sig[v];
+			buf[1] = (uint8_t)((uint16_t)sig[v] >> 8);
+			inner_shake256_inject(&dig, buf, 2);
+		}
+		buf[0] = (uint8_t)sqnorm;
+		buf[1] = (uint8_t)(sqnorm >> 8);
+		buf[2] = (uint8_t)(sqnorm >> 16);
+		buf[3] = (uint8_t)(sqnorm >> 24);
+		inner_shake256_inject(&dig, buf, 4);
+	}
+	set_fpu_cw(oldcw);
+	inner_shake256_flip(&dig);
+	inner_shake256_extract(&dig, out, sizeof out);
+	return memcmp(out, kat, sizeof kat) == 0;
+}
+
+/* see falcon.h */
+int
+falcon_fp_select(int fp)
+{
+	const fp_backend *fb;
+
+	switch (fp) {
+#if FALCON_FPEMU
+	case FALCON_FP_EMULATED:
+		fb = &Zf(fp_backend);
+		break;
+#if FALCON_FP_DISPATCH
+	case FALCON_FP_NATIVE:
+		fb = &Zf_native(fp_backend);
+		break;
+#endif
+#else
+	case FALCON_FP_NATIVE:
+		fb = &Zf(fp_backend);
+		break;
+#endif
+	default:
+		return FALCON_ERR_BADARG;
+	}
+	if (fb != fp_current && fb != &Zf(fp_backend) && !fp_selftest(fb)) {
+		return FALCON_ERR_INTERNAL;
+	}
+	fp_current = fb;
+	return 0;
+}
+
+/* see falcon.h */
+int
+falcon_fp_selected(void)
+{
+#if FALCON_FPEMU
+	return fp_current == &Zf(fp_backend)
+		? FALCON_FP_EMULATED : FALCON_FP_NATIVE;
+#else
+	return FALCON_FP_NATIVE;
+#endif
+}
+
 /* see falcon.h */
 int
 falcon_keygen_make(
@@ -133,13 +263,28 @@ falcon_keygen_make(
 	void *privkey, size_t privkey_len,
 	void *pubkey, size_t pubkey_len,
 	void *tmp, size_t tmp_len)
+{
+	return falcon_keygen_make_pool(rng, logn, privkey, privkey_len,
+		pubkey, pubkey_len, tmp, tmp_len, NULL);
+}
+
+/* see falcon.h */
+int
+falcon_keygen_make_pool(
+	shake256_context *rng,
+	unsigned logn,
+	void *privkey, size_t privkey_len,
+	void *pubkey, size_t pubkey_len,
+	void *tmp, size_t tmp_len,
+	const falcon_thread_pool *pool)
 {
 	int8_t *f, *g, *F;
 	uint16_t *h;
 	uint8_t *atmp;
 	size_t n, u, v, sk_len, pk_len;
 	uint8_t *sk, *pk;
-	unsigned oldcw;
+	unsigned oldcw, nthreads;
+	keygen_pool kp;
 
 	/*
 	 * Check parameters.
@@ -147,9 +292,12 @@ falcon_keygen_make(
 	if (logn < 1 || logn > 10) {
 		return FALCON_ERR_BADARG;
 	}
+	nthreads = (pool == NULL) ? 0 : pool->nthreads;
 	if (privkey_len < FALCON_PRIVKEY_SIZE(logn)
 		|| (pubkey != NULL && pubkey_len < FALCON_PUBKEY_SIZE(logn))
-		|| tmp_len < FALCON_TMPSIZE_KEYGEN(logn))
+		|| tmp_len < FALCON_TMPSIZE_KEYGEN(logn)
+		|| (nthreads > 1
+		&& tmp_len < FALCON_TMPSIZE_KEYGEN_POOL(logn, nthreads)))
 	{
 		return FALCON_ERR_SIZE;
 	}
@@ -165,8 +313,23 @@ falcon_keygen_make(
 	oldcw = set_fpu_cw(2);
 	// Zf(keygen)((inner_shake256_context *)rng,
 	// 	f, g, F, NULL, NULL, logn, atmp);
-	Zf(new_keygen)((inner_shake256_context *)rng,
-	f, g, F, NULL, NULL, logn, atmp);
+	if (nthreads > 1) {
+		/*
+		 * Per-task scratch areas follow the normal temporary
+		 * buffer.
+		 */
+		kp.run = pool->run;
+		kp.ctx = pool->pool;
+		kp.count = nthreads;
+		kp.scratch = (uint32_t *)align_u64(
+			(uint8_t *)tmp + FALCON_TMPSIZE_KEYGEN(logn));
+		kp.scratch_len = FALCON_KEYGEN_POOL_SCRATCH(logn);
+		fp_current->keygen_pool((inner_shake256_context *)rng,
+			f, g, F, NULL, NULL, logn, atmp, &kp);
+	} else {
+		fp_current->keygen((inner_shake256_context *)rng,
+			f, g, F, NULL, NULL, logn, atmp);
+	}
 	set_fpu_cw(oldcw);
 
 	/*
@@ -327,10 +490,13 @@ falcon_sign_start(shake256_context *rng,
 	return 0;
 }
 
-/* see falcon.h */
-int
-falcon_sign_dyn_finish(shake256_context *rng,
-	void *sig, size_t *sig_len, int sig_type,
+/*
+ * Implementation of falcon_sign_dyn_finish(); if sqnorm is not NULL,
+ * the squared norm of (s1,s2) is also written in *sqnorm.
+ */
+static int
+sign_dyn_finish(shake256_context *rng,
+	void *sig, size_t *sig_len, int sig_type, uint32_t *sqnorm,
 	const void *privkey, size_t privkey_len,
 	shake256_context *hash_data, const void *nonce,
 	void *tmp, size_t tmp_len)
@@ -453,7 +619,8 @@ falcon_sign_dyn_finish(shake256_context *rng,
 				hm, logn);
 		}
 		oldcw = set_fpu_cw(2);
-		Zf(sign_dyn)(sv, (inner_shake256_context *)rng,
+		fp_current->sign_dyn_norm(sv, sqnorm,
+			(inner_shake256_context *)rng,
 			f, g, F, G, hm, logn, atmp);
 		set_fpu_cw(oldcw);
 		es = sig;
@@ -578,15 +745,18 @@ falcon_expand_privkey(void *expanded_key, size_t expanded_key_len,
 	*(uint8_t *)expanded_key = logn;
 	expkey = align_fpr((uint8_t *)expanded_key + 1);
 	oldcw = set_fpu_cw(2);
-	Zf(expand_privkey)(expkey, f, g, F, G, logn, atmp);
+	fp_current->expand_privkey(expkey, f, g, F, G, logn, atmp);
 	set_fpu_cw(oldcw);
 	return 0;
 }
 
-/* see falcon.h */
-int
-falcon_sign_tree_finish(shake256_context *rng,
-	void *sig, size_t *sig_len, int sig_type,
+/*
+ * Implementation of falcon_sign_tree_finish(); if sqnorm is not NULL,
+ * the squared norm of (s1,s2) is also written in *sqnorm.
+ */
+static int
+sign_tree_finish(shake256_context *rng,
+	void *sig, size_t *sig_len, int sig_type, uint32_t *sqnorm,
 	const void *expanded_key,
 	shake256_context *hash_data, const void *nonce,
 	void *tmp, size_t tmp_len)
@@ -667,7 +837,8 @@ falcon_sign_tree_finish(shake256_context *rng,
 				hm, logn);
 		}
 		oldcw = set_fpu_cw(2);
-		Zf(sign_tree)(sv, (inner_shake256_context *)rng,
+		fp_current->sign_tree_norm(sv, sqnorm,
+			(inner_shake256_context *)rng,
 			expkey, hm, logn, atmp);
 		set_fpu_cw(oldcw);
 		es = sig;
@@ -713,6 +884,56 @@ falcon_sign_tree_finish(shake256_context *rng,
 	}
 }
 
+/* see falcon.h */
+int
+falcon_sign_dyn_finish(shake256_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *privkey, size_t privkey_len,
+	shake256_context *hash_data, const void *nonce,
+	void *tmp, size_t tmp_len)
+{
+	return sign_dyn_finish(rng, sig, sig_len, sig_type, NULL,
+		privkey, privkey_len, hash_data, nonce, tmp, tmp_len);
+}
+
+/* see falcon.h */
+int
+falcon_sign_tree_finish(shake256_context *rng,
+	void *sig, size_t *sig_len, int sig_type,
+	const void *expanded_key,
+	shake256_context *hash_data, const void *nonce,
+	void *tmp, size_t tmp_len)
+{
+	return sign_tree_finish(rng, sig, sig_len, sig_type, NULL,
+		expanded_key, hash_data, nonce, tmp, tmp_len);
+}
+
+/* see inner.h */
+int
+Zf(sign_dyn_finish_norm)(inner_shake256_context *rng,
+	void *sig, size_t *sig_len, int sig_type, uint32_t *sqnorm,
+	const void *privkey, size_t privkey_len,
+	inner_shake256_context *hash_data, const void *nonce,
+	void *tmp, size_t tmp_len)
+{
+	return sign_dyn_finish((shake256_context *)rng,
+		sig, sig_len, sig_type, sqnorm, privkey, privkey_len,
+		(shake256_context *)hash_data, nonce, tmp, tmp_len);
+}
+
+/* see inner.h */
+int
+Zf(sign_tree_finish_norm)(inner_shake256_context *rng,
+	void *sig, size_t *sig_len, int sig_type, uint32_t *sqnorm,
+	const void *expanded_key,
+	inner_shake256_context *hash_data, const void *nonce,
+	void *tmp, size_t tmp_len)
+{
+	return sign_tree_finish((shake256_context *)rng,
+		sig, sig_len, sig_type, sqnorm, expanded_key,
+		(shake256_context *)hash_data, nonce, tmp, tmp_len);
+}
+
 /* see falcon.h */
 int
 falcon_sign_dyn(shake256_context *rng,
@@ -21,6 +21,7 @@ package falcon
 // NOTE: cgo go code couldn't compile with the flags: -Wmissing-prototypes and -Wno-unused-paramete
 
 //#cgo CFLAGS:  -Wall -Wextra -Wpedantic -Wredundant-decls -Wshadow -Wvla -Wpointer-arith -Wno-unused-parameter -Wno-overlength-strings  -O3 -fomit-frame-pointer -Wno-strict-prototypes
+//#cgo LDFLAGS: -lpthread
 // #include "falcon.h"
 // #include "deterministic.h"
 import "C"
@@ -29,6 +30,7 @@ import (
 	"errors"
 	"fmt"
 	"runtime"
+	"sync"
 	"unsafe"
 )
 
@@ -39,6 +41,11 @@ var (
 	ErrVerifyFail  = errors.New("falcon verify failed")
 	ErrConvertFail = errors.New("falcon convert to CT failed")
 
+	ErrExpandPubkeyFail  = errors.New("falcon expand public key failed")
+	ErrExpandPrivkeyFail = errors.New("falcon expand private key failed")
+	ErrVCTEvalFail       = errors.New("falcon VCT evaluation failed")
+	ErrFPSelectFail      = errors.New("falcon floating-point selection failed")
+
 	ErrPubkeyCoefficientsFail = errors.New("falcon pubkey coefficients failed")
 	ErrS1CoefficientsFail     = errors.New("falcon computing S1 coefficients failed")
 	ErrS2CoefficientsFail     = errors.New("falcon computing S2 coefficients failed")
@@ -66,6 +73,27 @@ type PublicKey [PublicKeySize]byte
 // PrivateKey represents a falcon private key
 type PrivateKey [PrivateKeySize]byte
 
+// ExpandedPublicKey is a public key decoded and converted to the NTT form
+// used by verification, so that it can be reused across many verifications.
+type ExpandedPublicKey struct {
+	key C.falcon_det1024_expanded_pubkey
+}
+
+// ExpandedPrivateKey is a private key together with its precomputed ffLDL tree,
+// so that signers that sign many messages with the same key do not rebuild the
+// tree on every signature. It is large (about 120 kB). It may be copied by
+// value; the copy signs like the original.
+type ExpandedPrivateKey struct {
+	key C.falcon_det1024_expanded_privkey
+}
+
+// The C workspaces used by signing and verification are pooled, so that
+// calls reuse them instead of placing large temporary buffers on the stack.
+var (
+	signCtxPool   = sync.Pool{New: func() any { return new(C.falcon_det1024_sign_ctx) }}
+	verifyCtxPool = sync.Pool{New: func() any { return new(C.falcon_det1024_verify_ctx) }}
+)
+
 // CompressedSignature is a deterministic Falcon signature in compressed
 // format, which is variable-length.
 type CompressedSignature []byte
@@ -87,7 +115,9 @@ func GenerateKey(seed []byte) (PublicKey, PrivateKey, error) {
 	publicKey := PublicKey{}
 	privateKey := PrivateKey{}
 
-	r := C.falcon_det1024_keygen(&rng, unsafe.Pointer(&privateKey[0]), unsafe.Pointer(&publicKey[0]))
+	ctx := signCtxPool.Get().(*C.falcon_det1024_sign_ctx)
+	defer signCtxPool.Put(ctx)
+	r := C.falcon_det1024_keygen_ctx(ctx, &rng, unsafe.Pointer(&privateKey[0]), unsafe.Pointer(&publicKey[0]))
 	if r != 0 {
 		return PublicKey{}, PrivateKey{}, fmt.Errorf("error code is %d: %w", int(r), ErrKeygenFail)
 	}
@@ -96,23 +126,199 @@ func GenerateKey(seed []byte) (PublicKey, PrivateKey, error) {
 	return publicKey, privateKey, nil
 }
 
+// GenerateKeysParallel generates one key pair per seed, exactly as GenerateKey
+// does, spreading the work over one thread per CPU. pubs[i] and privs[i] are
+// the keys for seeds[i], whatever the scheduling.
+func GenerateKeysParallel(seeds [][]byte) ([]PublicKey, []PrivateKey, error) {
+	count := len(seeds)
+	if count == 0 {
+		return nil, nil, nil
+	}
+
+	var pinner runtime.Pinner
+	defer pinner.Unpin()
+
+	seedPtrs := make([]unsafe.Pointer, count)
+	seedLens := make([]C.size_t, count)
+	for i, seed := range seeds {
+		if len(seed) != 0 {
+			pinner.Pin(&seed[0])
+			seedPtrs[i] = unsafe.Pointer(&seed[0])
+			seedLens[i] = C.size_t(len(seed))
+		}
+	}
+
+	pubs := make([]PublicKey, count)
+	privs := make([]PrivateKey, count)
+	status := make([]C.int, count)
+	r := C.falcon_det1024_keygen_batch(unsafe.Pointer(&privs[0]), unsafe.Pointer(&pubs[0]), &status[0], &seedPtrs[0], &seedLens[0], C.size_t(count), 0)
+	if r != 0 {
+		return nil, nil, fmt.Errorf("error code is %d: %w", int(r), ErrKeygenFail)
+	}
+	return pubs, privs, nil
+}
+
 // SignCompressed signs the message with privateKey and returns a compressed-format
 // signature, or an error if signing fails (e.g., due to a malformed private key).
 func (sk *PrivateKey) SignCompressed(msg []byte) (CompressedSignature, error) {
+	return signWithCtx(msg, func(ctx *C.falcon_det1024_sign_ctx, sigLen *C.size_t) C.int {
+		if len(msg) == 0 {
+			return C.falcon_det1024_sign_compressed_ctx(ctx, unsafe.Pointer(&ctx.sig[0]), sigLen, nil, unsafe.Pointer(&(*sk)), C.NULL, 0)
+		}
+		return C.falcon_det1024_sign_compressed_ctx(ctx, unsafe.Pointer(&ctx.sig[0]), sigLen, nil, unsafe.Pointer(&(*sk)), unsafe.Pointer(&msg[0]), C.size_t(len(msg)))
+	})
+}
+
+// signWithCtx runs a C signing function with a pooled workspace, which also
+// receives the signature, and returns a copy of the signature.
+func signWithCtx(msg []byte, sign func(ctx *C.falcon_det1024_sign_ctx, sigLen *C.size_t) C.int) (CompressedSignature, error) {
+	ctx := signCtxPool.Get().(*C.falcon_det1024_sign_ctx)
+	defer signCtxPool.Put(ctx)
+
 	var sigLen C.size_t
-	var sig [SignatureMaxSize]byte
+	r := sign(ctx, &sigLen)
+	if r != 0 {
+		return nil, fmt.Errorf("error code %d: %w", int(r), ErrSignFail)
+	}
+
+	runtime.KeepAlive(msg)
+	return C.GoBytes(unsafe.Pointer(&ctx.sig[0]), C.int(sigLen)), nil
+}
+
+// Expand precomputes the signing tree of the private key.
+func (sk *PrivateKey) Expand() (*ExpandedPrivateKey, error) {
+	esk := new(ExpandedPrivateKey)
+	if err := sk.ExpandInto(esk); err != nil {
+		return nil, err
+	}
+	return esk, nil
+}
+
+// ExpandInto is the same as Expand, but writes the expanded key into *esk
+// instead of allocating it, e.g. into a record of a memory-mapped key store.
+// The record must be 8-byte aligned, as any ExpandedPrivateKey value is.
+func (sk *PrivateKey) ExpandInto(esk *ExpandedPrivateKey) error {
+	r := C.falcon_det1024_expand_privkey(&esk.key, unsafe.Pointer(&(*sk)))
+	if r != 0 {
+		return fmt.Errorf("error code %d: %w", int(r), ErrExpandPrivkeyFail)
+	}
+	return nil
+}
+
+// SignCompressed signs the message and returns a compressed-format signature,
+// identical to the one returned by PrivateKey.SignCompressed for the same key.
+func (esk *ExpandedPrivateKey) SignCompressed(msg []byte) (CompressedSignature, error) {
+	return signWithCtx(msg, func(ctx *C.falcon_det1024_sign_ctx, sigLen *C.size_t) C.int {
+		if len(msg) == 0 {
+			return C.falcon_det1024_sign_compressed_tree_ctx(ctx, unsafe.Pointer(&ctx.sig[0]), sigLen, &esk.key, C.NULL, 0)
+		}
+		return C.falcon_det1024_sign_compressed_tree_ctx(ctx, unsafe.Pointer(&ctx.sig[0]), sigLen, &esk.key, unsafe.Pointer(&msg[0]), C.size_t(len(msg)))
+	})
+}
+
+// SignCompressedWithNorm is the same as SignCompressed, but also returns the
+// squared norm of the signature vector (s1, s2), as computed by the signer.
+func (sk *PrivateKey) SignCompressedWithNorm(msg []byte) (CompressedSignature, uint32, error) {
+	var norm C.uint32_t
+	sig, err := signWithCtx(msg, func(ctx *C.falcon_det1024_sign_ctx, sigLen *C.size_t) C.int {
+		if len(msg) == 0 {
+			return C.falcon_det1024_sign_compressed_ctx(ctx, unsafe.Pointer(&ctx.sig[0]), sigLen, &norm, unsafe.Pointer(&(*sk)), C.NULL, 0)
+		}
+		return C.falcon_det1024_sign_compressed_ctx(ctx, unsafe.Pointer(&ctx.sig[0]), sigLen, &norm, unsafe.Pointer(&(*sk)), unsafe.Pointer(&msg[0]), C.size_t(len(msg)))
+	})
+	if err != nil {
+		return nil, 0, err
+	}
+	return sig, uint32(norm), nil
+}
+
+// SignCompressedWithNorm is the same as SignCompressed, but also returns the
+// squared norm of the signature vector (s1, s2), as computed by the signer.
+func (esk *ExpandedPrivateKey) SignCompressedWithNorm(msg []byte) (CompressedSignature, uint32, error) {
+	var norm C.uint32_t
+	sig, err := signWithCtx(msg, func(ctx *C.falcon_det1024_sign_ctx, sigLen *C.size_t) C.int {
+		if len(msg) == 0 {
+			return C.falcon_det1024_sign_compressed_tree_with_norm_ctx(ctx, unsafe.Pointer(&ctx.sig[0]), sigLen, &norm, &esk.key, C.NULL, 0)
+		}
+		return C.falcon_det1024_sign_compressed_tree_with_norm_ctx(ctx, unsafe.Pointer(&ctx.sig[0]), sigLen, &norm, &esk.key, unsafe.Pointer(&msg[0]), C.size_t(len(msg)))
+	})
+	if err != nil {
+		return nil, 0, err
+	}
+	return sig, uint32(norm), nil
+}
+
+// VCTResult is the outcome of a VCT lottery ticket evaluation: the
+// deterministic signature of the round message, the squared norm of the
+// signature vector (s1, s2), and whether that norm is below the threshold.
+type VCTResult struct {
+	Signature CompressedSignature
+	Norm      uint32
+	Selected  bool
+	Err       error
+}
+
+// VCTEval signs msg with privateKey, exactly as SignCompressed does, and returns
+// the signature together with its squared norm and the threshold decision
+// (norm < threshold). The norm is computed by the signer, without recomputing
+// s1 from the signature.
+func (sk *PrivateKey) VCTEval(msg []byte, threshold uint32) (VCTResult, error) {
+	sig, norm, err := sk.SignCompressedWithNorm(msg)
+	if err != nil {
+		err = fmt.Errorf("%w: %w", ErrVCTEvalFail, err)
+		return VCTResult{Err: err}, err
+	}
+	return VCTResult{Signature: sig, Norm: norm, Selected: norm < threshold}, nil
+}
+
+// VCTEval is the same as PrivateKey.VCTEval, with the signature computed from
+// the expanded key.
+func (esk *ExpandedPrivateKey) VCTEval(msg []byte, threshold uint32) (VCTResult, error) {
+	sig, norm, err := esk.SignCompressedWithNorm(msg)
+	if err != nil {
+		err = fmt.Errorf("%w: %w", ErrVCTEvalFail, err)
+		return VCTResult{Err: err}, err
+	}
+	return VCTResult{Signature: sig, Norm: norm, Selected: norm < threshold}, nil
+}
+
+// VCTEvalBatch evaluates one VCT lottery ticket per private key over the same
+// message, in a single call spread over workers threads (0 means one thread per
+// CPU). results[i] is the outcome for sks[i]; the returned error is the first
+// per-ticket error, if any.
+func VCTEvalBatch(sks []PrivateKey, msg []byte, threshold uint32, workers int) ([]VCTResult, error) {
+	count := len(sks)
+	if count == 0 {
+		return nil, nil
+	}
+	if workers < 0 {
+		workers = 0
+	}
+
+	cres := make([]C.falcon_det1024_vct_result, count)
 	var r C.int
 	if len(msg) == 0 {
-		r = C.falcon_det1024_sign_compressed(unsafe.Pointer(&sig[0]), &sigLen, unsafe.Pointer(&(*sk)), C.NULL, 0)
+		r = C.falcon_det1024_vct_eval_batch(&cres[0], unsafe.Pointer(&sks[0]), C.size_t(count), C.NULL, 0, C.uint32_t(threshold), C.unsigned(workers))
 	} else {
-		r = C.falcon_det1024_sign_compressed(unsafe.Pointer(&sig[0]), &sigLen, unsafe.Pointer(&(*sk)), unsafe.Pointer(&msg[0]), C.size_t(len(msg)))
+		r = C.falcon_det1024_vct_eval_batch(&cres[0], unsafe.Pointer(&sks[0]), C.size_t(count), unsafe.Pointer(&msg[0]), C.size_t(len(msg)), C.uint32_t(threshold), C.unsigned(workers))
+	}
+	runtime.KeepAlive(sks)
+	runtime.KeepAlive(msg)
+
+	results := make([]VCTResult, count)
+	for i := range cres {
+		if cres[i].status != 0 {
+			results[i].Err = fmt.Errorf("error code %d: %w", int(cres[i].status), ErrVCTEvalFail)
+			continue
+		}
+		results[i].Signature = C.GoBytes(unsafe.Pointer(&cres[i].sig[0]), C.int(cres[i].sig_len))
+		results[i].Norm = uint32(cres[i].sqnorm)
+		results[i].Selected = cres[i].selected != 0
 	}
 	if r != 0 {
-		return nil, fmt.Errorf("error code %d: %w", int(r), ErrSignFail)
+		return results, fmt.Errorf("error code %d: %w", int(r), ErrVCTEvalFail)
 	}
-
-	runtime.KeepAlive(msg)
-	return sig[:sigLen], nil
+	return results, nil
 }
 
 // ConvertToCT converts a compressed-format signature to a CT-format signature.
@@ -133,11 +339,14 @@ func (pk *PublicKey) Verify(signature CompressedSignature, msg []byte) error {
 		return fmt.Errorf("empty signature: %w", ErrVerifyFail)
 	}
 
+	ctx := verifyCtxPool.Get().(*C.falcon_det1024_verify_ctx)
+	defer verifyCtxPool.Put(ctx)
+
 	var r C.int
 	if len(msg) == 0 {
-		r = C.falcon_det1024_verify_compressed(unsafe.Pointer(&signature[0]), C.size_t(len(signature)), unsafe.Pointer(&(*pk)), C.NULL, 0)
+		r = C.falcon_det1024_verify_compressed_ctx(ctx, unsafe.Pointer(&signature[0]), C.size_t(len(signature)), unsafe.Pointer(&(*pk)), C.NULL, 0)
 	} else {
-		r = C.falcon_det1024_verify_compressed(unsafe.Pointer(&signature[0]), C.size_t(len(signature)), unsafe.Pointer(&(*pk)), unsafe.Pointer(&msg[0]), C.size_t(len(msg)))
+		r = C.falcon_det1024_verify_compressed_ctx(ctx, unsafe.Pointer(&signature[0]), C.size_t(len(signature)), unsafe.Pointer(&(*pk)), unsafe.Pointer(&msg[0]), C.size_t(len(msg)))
 	}
 	if r != 0 {
 		return fmt.Errorf("error code %d: %w", int(r), ErrVerifyFail)
@@ -148,14 +357,76 @@ func (pk *PublicKey) Verify(signature CompressedSignature, msg []byte) error {
 	return nil
 }
 
+// VerifyBatch reports, for each i, whether signatures[i] is a valid
+// compressed-format signature of msgs[i] under publicKey. The public key
+// is decoded and converted to NTT form only once for the whole batch.
+// It outputs one entry per signature (nil if that signature is valid),
+// and a non-nil error if the batch is malformed or any signature fails.
+func (pk *PublicKey) VerifyBatch(signatures []CompressedSignature, msgs [][]byte) ([]error, error) {
+	return verifyBatch(signatures, msgs, func(results *C.int, sigs *unsafe.Pointer, sigLens *C.size_t, data *unsafe.Pointer, dataLens *C.size_t, count C.size_t) C.int {
+		return C.falcon_det1024_verify_batch(results, sigs, sigLens, unsafe.Pointer(&(*pk)), data, dataLens, count)
+	})
+}
+
+// verifyBatch lays out signatures and msgs as the pointer/length arrays
+// expected by the C batch verifiers, and runs verify over them.
+func verifyBatch(signatures []CompressedSignature, msgs [][]byte, verify func(*C.int, *unsafe.Pointer, *C.size_t, *unsafe.Pointer, *C.size_t, C.size_t) C.int) ([]error, error) {
+	if len(signatures) != len(msgs) {
+		return nil, fmt.Errorf("%d signatures for %d messages: %w", len(signatures), len(msgs), ErrVerifyFail)
+	}
+	count := len(signatures)
+	if count == 0 {
+		return nil, nil
+	}
+
+	// The C side receives arrays of pointers into Go memory, so each
+	// signature and message must be pinned for the duration of the call.
+	var pinner runtime.Pinner
+	defer pinner.Unpin()
+
+	sigPtrs := make([]unsafe.Pointer, count)
+	sigLens := make([]C.size_t, count)
+	msgPtrs := make([]unsafe.Pointer, count)
+	msgLens := make([]C.size_t, count)
+	for i := 0; i < count; i++ {
+		if len(signatures[i]) != 0 {
+			pinner.Pin(&signatures[i][0])
+			sigPtrs[i] = unsafe.Pointer(&signatures[i][0])
+			sigLens[i] = C.size_t(len(signatures[i]))
+		}
+		if len(msgs[i]) != 0 {
+			pinner.Pin(&msgs[i][0])
+			msgPtrs[i] = unsafe.Pointer(&msgs[i][0])
+			msgLens[i] = C.size_t(len(msgs[i]))
+		}
+	}
+
+	results := make([]C.int, count)
+	r := verify(&results[0], &sigPtrs[0], &sigLens[0], &msgPtrs[0], &msgLens[0], C.size_t(count))
+
+	errs := make([]error, count)
+	for i := range results {
+		if results[i] != 0 {
+			errs[i] = fmt.Errorf("error code %d: %w", int(results[i]), ErrVerifyFail)
+		}
+	}
+	if r != 0 {
+		return errs, fmt.Errorf("error code %d: %w", int(r), ErrVerifyFail)
+	}
+	return errs, nil
+}
+
 // VerifyCTSignature reports whether sig is a valid CT-format signature of msg under publicKey.
 // It outputs nil if so, and an error otherwise.
 func (pk *PublicKey) VerifyCTSignature(signature CTSignature, msg []byte) error {
+	ctx := verifyCtxPool.Get().(*C.falcon_det1024_verify_ctx)
+	defer verifyCtxPool.Put(ctx)
+
 	var r C.int
 	if len(msg) == 0 {
-		r = C.falcon_det1024_verify_ct(unsafe.Pointer(&signature[0]), unsafe.Pointer(&(*pk)), C.NULL, 0)
+		r = C.falcon_det1024_verify_ct_ctx(ctx, unsafe.Pointer(&signature[0]), unsafe.Pointer(&(*pk)), C.NULL, 0)
 	} else {
-		r = C.falcon_det1024_verify_ct(unsafe.Pointer(&signature[0]), unsafe.Pointer(&(*pk)), unsafe.Pointer(&msg[0]), C.size_t(len(msg)))
+		r = C.falcon_det1024_verify_ct_ctx(ctx, unsafe.Pointer(&signature[0]), unsafe.Pointer(&(*pk)), unsafe.Pointer(&msg[0]), C.size_t(len(msg)))
 	}
 	if r != 0 {
 		return fmt.Errorf("error code %d: %w", int(r), ErrVerifyFail)
@@ -166,6 +437,66 @@ func (pk *PublicKey) VerifyCTSignature(signature CTSignature, msg []byte) error
 	return nil
 }
 
+// Expand decodes publicKey and converts it to the NTT form used by
+// verification. The resulting ExpandedPublicKey can be reused to verify
+// any number of signatures without decoding the key again.
+func (pk *PublicKey) Expand() (*ExpandedPublicKey, error) {
+	epk := &ExpandedPublicKey{}
+	r := C.falcon_det1024_expand_pubkey(&epk.key, unsafe.Pointer(&(*pk)))
+	if r != 0 {
+		return nil, fmt.Errorf("error code %d: %w", int(r), ErrExpandPubkeyFail)
+	}
+	return epk, nil
+}
+
+// Verify reports whether sig is a valid compressed-format signature of msg under
+// the expanded public key. It outputs nil if so, and an error otherwise.
+func (epk *ExpandedPublicKey) Verify(signature CompressedSignature, msg []byte) error {
+	if len(signature) == 0 {
+		return fmt.Errorf("empty signature: %w", ErrVerifyFail)
+	}
+
+	var r C.int
+	if len(msg) == 0 {
+		r = C.falcon_det1024_verify_compressed_expanded(unsafe.Pointer(&signature[0]), C.size_t(len(signature)), &epk.key, C.NULL, 0)
+	} else {
+		r = C.falcon_det1024_verify_compressed_expanded(unsafe.Pointer(&signature[0]), C.size_t(len(signature)), &epk.key, unsafe.Pointer(&msg[0]), C.size_t(len(msg)))
+	}
+	if r != 0 {
+		return fmt.Errorf("error code %d: %w", int(r), ErrVerifyFail)
+	}
+
+	runtime.KeepAlive(msg)
+	runtime.KeepAlive(signature)
+	return nil
+}
+
+// VerifyCTSignature reports whether sig is a valid CT-format signature of msg under
+// the expanded public key. It outputs nil if so, and an error otherwise.
+func (epk *ExpandedPublicKey) VerifyCTSignature(signature CTSignature, msg []byte) error {
+	var r C.int
+	if len(msg) == 0 {
+		r = C.falcon_det1024_verify_ct_expanded(unsafe.Pointer(&signature[0]), &epk.key, C.NULL, 0)
+	} else {
+		r = C.falcon_det1024_verify_ct_expanded(unsafe.Pointer(&signature[0]), &epk.key, unsafe.Pointer(&msg[0]), C.size_t(len(msg)))
+	}
+	if r != 0 {
+		return fmt.Errorf("error code %d: %w", int(r), ErrVerifyFail)
+	}
+
+	runtime.KeepAlive(msg)
+	runtime.KeepAlive(signature)
+	return nil
+}
+
+// VerifyBatch is the same as PublicKey.VerifyBatch, but uses the expanded
+// public key.
+func (epk *ExpandedPublicKey) VerifyBatch(signatures []CompressedSignature, msgs [][]byte) ([]error, error) {
+	return verifyBatch(signatures, msgs, func(results *C.int, sigs *unsafe.Pointer, sigLens *C.size_t, data *unsafe.Pointer, dataLens *C.size_t, count C.size_t) C.int {
+		return C.falcon_det1024_verify_batch_expanded(results, sigs, sigLens, &epk.key, data, dataLens, count)
+	})
+}
+
 // SaltVersion returns the salt version used in a compressed-format signature.
 // By definition, the default salt version is 0, if the signature is too short to specify one.
 // (Such a signature is malformed, and would not pass verification, but is still considered to have a salt version.)
@@ -235,3 +566,42 @@ func HashToPointCoefficients(msg []byte, saltVersion byte) (c [N]uint16) {
 	}
 	return
 }
+
+// HashToPointCoefficientsX4 is equivalent to calling HashToPointCoefficients on
+// each of the four messages, but squeezes the four SHAKE256 outputs in parallel.
+func HashToPointCoefficientsX4(msgs [4][]byte, saltVersion byte) (c [4][N]uint16) {
+	var pinner runtime.Pinner
+	defer pinner.Unpin()
+
+	msgPtrs := make([]unsafe.Pointer, 4)
+	msgLens := make([]C.size_t, 4)
+	for i, msg := range msgs {
+		if len(msg) != 0 {
+			pinner.Pin(&msg[0])
+			msgPtrs[i] = unsafe.Pointer(&msg[0])
+			msgLens[i] = C.size_t(len(msg))
+		}
+	}
+	C.falcon_det1024_hash_to_point_coeffs_x4((*C.uint16_t)(&c[0][0]), &msgPtrs[0], &msgLens[0], C.uint8_t(saltVersion))
+	return
+}
+
+// SetNativeFP selects the floating-point implementation used by key generation
+// and signing: the native FPU code if native is true, or the portable emulated
+// code (the default) otherwise. Both produce exactly the same keys and
+// signatures; before enabling the native code, the library checks this with a
+// known-answer test and returns an error (keeping the emulated code) if it
+// fails or if the native code is not built for this platform.
+//
+// SetNativeFP is not safe to call concurrently with any other function of this
+// package; call it once at initialization.
+func SetNativeFP(native bool) error {
+	fp := C.int(C.FALCON_FP_EMULATED)
+	if native {
+		fp = C.FALCON_FP_NATIVE
+	}
+	if r := C.falcon_fp_select(fp); r != 0 {
+		return fmt.Errorf("error code %d: %w", int(r), ErrFPSelectFail)
+	}
+	return nil
+}
@@ -349,6 +349,13 @@ extern "C" {
 #define FALCON_TMPSIZE_KEYGEN(logn) \
 	(((logn) <= 3 ? 272u : (28u << (logn))) + (3u << (logn)) + 7)
 
+/*
+ * Temporary buffer size for key pair generation with a thread pool of
+ * nthreads tasks (falcon_keygen_make_pool()).
+ */
+#define FALCON_TMPSIZE_KEYGEN_POOL(logn, nthreads) \
+	(FALCON_TMPSIZE_KEYGEN(logn) + (size_t)(nthreads) * (20u << (logn)) + 7)
+
 /*
  * Temporary buffer size for computing the pubic key from the private key.
  */
@@ -498,6 +505,44 @@ int falcon_keygen_make(
 	void *pubkey, size_t pubkey_len,
 	void *tmp, size_t tmp_len);
 
+/*
+ * Thread pool for multi-threaded key pair generation, supplied by the
+ * caller. run(pool, task, arg, count) must call task(arg, i) exactly
+ * once for each i in 0..count-1, and return only when all these calls
+ * have completed; the calls may run concurrently, in any order (count
+ * is never larger than nthreads). The library itself does not create
+ * threads.
+ */
+typedef struct {
+	void (*run)(void *pool, void (*task)(void *arg, unsigned idx),
+		void *arg, unsigned count);
+	void *pool;
+	unsigned nthreads;
+} falcon_thread_pool;
+
+/*
+ * Same as falcon_keygen_make(), except that the NTRU equation solving
+ * spreads its work over the tasks of the provided thread pool (the
+ * computations modulo the small primes used by the solver are
+ * independent of each other). The generated key pair is the same as
+ * with falcon_keygen_make() for the same rng state, regardless of the
+ * number of tasks and of their scheduling.
+ *
+ * The tmp[] buffer size tmp_len MUST be at least
+ * FALCON_TMPSIZE_KEYGEN_POOL(logn, pool->nthreads) bytes. If pool is
+ * NULL or pool->nthreads is 0 or 1, then this is equivalent to
+ * falcon_keygen_make().
+ *
+ * Returned value: 0 on success, or a negative error code.
+ */
+int falcon_keygen_make_pool(
+	shake256_context *rng,
+	unsigned logn,
+	void *privkey, size_t privkey_len,
+	void *pubkey, size_t pubkey_len,
+	void *tmp, size_t tmp_len,
+	const falcon_thread_pool *pool);
+
 /*
  * Recompute the public key from the private key.
  *
@@ -802,6 +847,52 @@ int falcon_verify_finish(const void *sig, size_t sig_len, int sig_type,
 	shake256_context *hash_data,
 	void *tmp, size_t tmp_len);
 
+/* ==================================================================== */
+/*
+ * Floating-point implementation selection.
+ *
+ * Key pair generation and signature generation use floating-point
+ * computations. These are done either with an integer-only emulation
+ * (FALCON_FP_EMULATED), which is portable and constant-time, or with
+ * the native floating-point unit (FALCON_FP_NATIVE), which is much
+ * faster. Which implementations are available depends on the build
+ * (see FALCON_FPEMU and FALCON_FP_DISPATCH in config.h); with the
+ * default configuration on 64-bit x86 and ARM, both are available and
+ * the emulated code is used unless the native code is explicitly
+ * selected.
+ *
+ * Signature verification does not use floating-point and is not
+ * affected by this selection.
+ */
+
+#define FALCON_FP_EMULATED   0
+#define FALCON_FP_NATIVE     1
+
+/*
+ * Select the floating-point implementation used by all subsequent key
+ * pair generation, private key expansion and signature generation
+ * calls. Before switching away from the default implementation, a
+ * known-answer test is run, which verifies that the selected code
+ * computes the same keys and signatures as the emulated code on this
+ * platform; the selection is not changed if that test fails. Expanded
+ * keys remain valid across a selection change.
+ *
+ * This function is not thread-safe: it must not be called while other
+ * threads use this library (normally, it is called once at application
+ * initialization).
+ *
+ * Returned value: 0 on success, FALCON_ERR_BADARG if the requested
+ * implementation is not available in this build, or
+ * FALCON_ERR_INTERNAL if the known-answer test failed.
+ */
+int falcon_fp_select(int fp);
+
+/*
+ * Get the currently selected floating-point implementation
+ * (FALCON_FP_EMULATED or FALCON_FP_NATIVE).
+ */
+int falcon_fp_selected(void);
+
 /* ==================================================================== */
 
 #ifdef __cplusplus
@@ -3,8 +3,11 @@ package falcon
 import (
 	"bytes"
 	"crypto/rand"
+	"errors"
+	"fmt"
 	mathrand "math/rand"
 	"strings"
+	"sync"
 	"testing"
 	"time"
 )
@@ -367,6 +370,525 @@ func TestPointerToPointer(t *testing.T) {
 	_ = HashToPointCoefficients(v.msg[:], 0)
 }
 
+func TestFalconVerifyBatch(t *testing.T) {
+	seed := make([]byte, 64)
+	rand.Read(seed)
+
+	pub, priv, err := GenerateKey(seed)
+	if err != nil {
+		t.Fatalf("failed to generate keys. err message: %s", err)
+	}
+
+	const count = 16
+	sigs := make([]CompressedSignature, count)
+	msgs := make([][]byte, count)
+	for i := 0; i < count; i++ {
+		msgs[i] = make([]byte, i*7)
+		rand.Read(msgs[i])
+		sigs[i], err = priv.SignCompressed(msgs[i])
+		if err != nil {
+			t.Fatalf("failed to sign message. err message: %s", err)
+		}
+	}
+
+	errs, err := pub.VerifyBatch(sigs, msgs)
+	if err != nil {
+		t.Fatalf("batch verification failed: %s", err)
+	}
+	for i := range errs {
+		if errs[i] != nil {
+			t.Fatalf("signature %d failed batch verification: %s", i, errs[i])
+		}
+	}
+
+	// Corrupt a few entries and check that each one is reported exactly
+	// as the single-signature path reports it.
+	sigs[3] = append(CompressedSignature{}, sigs[3]...)
+	sigs[3][len(sigs[3])/2] ^= 0x10
+	msgs[5] = append([]byte{}, msgs[5]...)
+	msgs[5][0] ^= 1
+	sigs[7] = nil
+	sigs[9] = sigs[9][:len(sigs[9])-1]
+
+	errs, err = pub.VerifyBatch(sigs, msgs)
+	if err == nil {
+		t.Fatalf("batch verification succeeded. should have failed.")
+	}
+	for i := range errs {
+		single := pub.Verify(sigs[i], msgs[i])
+		if (errs[i] == nil) != (single == nil) {
+			t.Fatalf("signature %d: batch result %v, single result %v", i, errs[i], single)
+		}
+		// An empty signature is rejected by Verify before reaching C.
+		if single != nil && len(sigs[i]) != 0 && errs[i].Error() != single.Error() {
+			t.Fatalf("signature %d: batch error %v, single error %v", i, errs[i], single)
+		}
+	}
+
+	badpub := pub
+	badpub[0] ^= 0x01
+	if _, err := badpub.VerifyBatch(sigs[:1], msgs[:1]); err == nil {
+		t.Fatalf("batch verification with bad public key succeeded. should have failed.")
+	}
+
+	if _, err := pub.VerifyBatch(sigs, msgs[:1]); err == nil {
+		t.Fatalf("batch verification with mismatched lengths succeeded. should have failed.")
+	}
+}
+
+func TestFalconExpandedPublicKey(t *testing.T) {
+	seed := make([]byte, 64)
+	rand.Read(seed)
+
+	pub, priv, err := GenerateKey(seed)
+	if err != nil {
+		t.Fatalf("failed to generate keys. err message: %s", err)
+	}
+	epk, err := pub.Expand()
+	if err != nil {
+		t.Fatalf("failed to expand public key. err message: %s", err)
+	}
+
+	for _, msg := range [][]byte{nil, {}, []byte("expanded key"), make([]byte, 500)} {
+		sig, err := priv.SignCompressed(msg)
+		if err != nil {
+			t.Fatalf("failed to sign message. err message: %s", err)
+		}
+		if err := epk.Verify(sig, msg); err != nil {
+			t.Fatalf("failed to verify message with expanded key. err message: %s", err)
+		}
+
+		sigCT, err := sig.ConvertToCT()
+		if err != nil {
+			t.Fatalf("failed to convert signature. err message: %s", err)
+		}
+		if err := epk.VerifyCTSignature(sigCT, msg); err != nil {
+			t.Fatalf("failed to verify ct signature with expanded key. err message: %s", err)
+		}
+
+		badmsg := append([]byte{0}, msg...)
+		if err := epk.Verify(sig, badmsg); err == nil {
+			t.Fatalf("expected verify to fail on modified message")
+		}
+		if err := epk.VerifyCTSignature(sigCT, badmsg); err == nil {
+			t.Fatalf("expected verify_ct to fail on modified message")
+		}
+
+		badsig := append(CompressedSignature{}, sig...)
+		badsig[len(badsig)-1] ^= 0x01
+		if (epk.Verify(badsig, msg) == nil) != (pub.Verify(badsig, msg) == nil) {
+			t.Fatalf("expanded and plain public keys disagree on a modified signature")
+		}
+	}
+
+	if err := epk.Verify(nil, nil); err == nil {
+		t.Fatalf("verification of empty signature succeeded. should have failed.")
+	}
+
+	errs, err := epk.VerifyBatch([]CompressedSignature{nil}, [][]byte{nil})
+	if err == nil || errs[0] == nil {
+		t.Fatalf("batch verification of empty signature succeeded. should have failed.")
+	}
+
+	badpub := pub
+	badpub[0] ^= 0x01
+	if _, err := badpub.Expand(); err == nil {
+		t.Fatalf("expanding a bad public key succeeded. should have failed.")
+	}
+}
+
+// TestFalconS1CoefficientsReference checks the NTT-based computation of
+// s_1 = c - s_2 * h against a schoolbook product modulo (X^N+1, q).
+func TestFalconS1CoefficientsReference(t *testing.T) {
+	const q = 12289
+	for count := 0; count < 4; count++ {
+		seed := make([]byte, 64)
+		rand.Read(seed)
+		pub, priv, err := GenerateKey(seed)
+		if err != nil {
+			t.Fatalf("failed to generate keys. err message: %s", err)
+		}
+		msg := make([]byte, 64)
+		rand.Read(msg)
+		sig, err := priv.SignCompressed(msg)
+		if err != nil {
+			t.Fatalf("failed to sign message. err message: %s", err)
+		}
+		sigCT, err := sig.ConvertToCT()
+		if err != nil {
+			t.Fatalf("failed to convert signature. err message: %s", err)
+		}
+
+		h, err := pub.Coefficients()
+		if err != nil {
+			t.Fatalf("pubkey coefficients failed: %s", err)
+		}
+		c := HashToPointCoefficients(msg, sigCT.SaltVersion())
+		s2, err := sigCT.S2Coefficients()
+		if err != nil {
+			t.Fatalf("s2 coefficients failed: %s", err)
+		}
+		s1, err := S1Coefficients(h, c, s2)
+		if err != nil {
+			t.Fatalf("s1 coefficients failed: %s", err)
+		}
+
+		var prod [2 * N]int64
+		for i := 0; i < N; i++ {
+			for j := 0; j < N; j++ {
+				prod[i+j] += int64(s2[i]) * int64(h[j])
+			}
+		}
+		for i := 0; i < N; i++ {
+			w := (int64(c[i]) - prod[i] + prod[i+N]) % q
+			if w < 0 {
+				w += q
+			}
+			if w > q/2 {
+				w -= q
+			}
+			if int64(s1[i]) != w {
+				t.Fatalf("s1[%d] = %d, want %d", i, s1[i], w)
+			}
+		}
+	}
+}
+
+func TestFalconHashToPointX4(t *testing.T) {
+	for count := 0; count < 8; count++ {
+		var msgs [4][]byte
+		for i := range msgs {
+			// Mix of lengths, including empty and multi-block messages.
+			msgs[i] = make([]byte, (count*97+i*61)%400)
+			rand.Read(msgs[i])
+		}
+		saltVersion := byte(count)
+		c := HashToPointCoefficientsX4(msgs, saltVersion)
+		for i := range msgs {
+			if c[i] != HashToPointCoefficients(msgs[i], saltVersion) {
+				t.Fatalf("x4 hash of message %d (length %d) differs from single hash", i, len(msgs[i]))
+			}
+		}
+	}
+}
+
+func TestFalconExpandedPrivateKey(t *testing.T) {
+	for count := 0; count < 3; count++ {
+		seed := make([]byte, 48)
+		rand.Read(seed)
+		pub, priv, err := GenerateKey(seed)
+		if err != nil {
+			t.Fatalf("failed to generate keys. err message: %s", err)
+		}
+		esk, err := priv.Expand()
+		if err != nil {
+			t.Fatalf("Expand failed: %s", err)
+		}
+		for i := 0; i < 8; i++ {
+			msg := make([]byte, i*13)
+			rand.Read(msg)
+			want, err := priv.SignCompressed(msg)
+			if err != nil {
+				t.Fatalf("failed to sign message. err message: %s", err)
+			}
+			sig, err := esk.SignCompressed(msg)
+			if err != nil {
+				t.Fatalf("expanded key failed to sign message: %s", err)
+			}
+			if !bytes.Equal(sig, want) {
+				t.Fatalf("expanded key signature differs from dyn signature")
+			}
+			if err := pub.Verify(sig, msg); err != nil {
+				t.Fatalf("expanded key signature does not verify: %s", err)
+			}
+		}
+
+		// A copy of the expanded key, at another address and offset,
+		// signs the same way.
+		holder := new(struct {
+			pad byte
+			esk ExpandedPrivateKey
+		})
+		holder.esk = *esk
+		msg := []byte("copied expanded key")
+		want, _ := esk.SignCompressed(msg)
+		sig, err := holder.esk.SignCompressed(msg)
+		if err != nil || !bytes.Equal(sig, want) {
+			t.Fatalf("copied expanded key signs differently (err: %v)", err)
+		}
+	}
+
+	var bad PrivateKey
+	if _, err := bad.Expand(); err == nil {
+		t.Fatalf("Expand accepted a malformed private key")
+	}
+}
+
+func TestFalconConcurrentSignVerify(t *testing.T) {
+	// Signing and verification share pooled C workspaces; concurrent
+	// calls must not interfere with each other.
+	pub, priv, err := GenerateKey([]byte("concurrent"))
+	if err != nil {
+		t.Fatalf("failed to generate keys. err message: %s", err)
+	}
+	msgs := make([][]byte, 16)
+	want := make([]CompressedSignature, len(msgs))
+	for i := range msgs {
+		msgs[i] = make([]byte, 32+i)
+		rand.Read(msgs[i])
+		want[i], err = priv.SignCompressed(msgs[i])
+		if err != nil {
+			t.Fatalf("failed to sign message. err message: %s", err)
+		}
+	}
+
+	var wg sync.WaitGroup
+	errs := make(chan error, len(msgs))
+	for i := range msgs {
+		wg.Add(1)
+		go func(i int) {
+			defer wg.Done()
+			sig, err := priv.SignCompressed(msgs[i])
+			if err != nil {
+				errs <- err
+				return
+			}
+			if !bytes.Equal(sig, want[i]) {
+				errs <- fmt.Errorf("signature %d differs under concurrency", i)
+				return
+			}
+			if err := pub.Verify(sig, msgs[i]); err != nil {
+				errs <- err
+			}
+		}(i)
+	}
+	wg.Wait()
+	close(errs)
+	for err := range errs {
+		t.Fatal(err)
+	}
+}
+
+// recomputeNorm returns the squared norm of (s1, s2) for sig, with s1
+// recomputed from the public key as a verifier would.
+func recomputeNorm(t *testing.T, pub PublicKey, sig CompressedSignature, msg []byte) uint32 {
+	sigCT, err := sig.ConvertToCT()
+	if err != nil {
+		t.Fatalf("failed to convert signature. err message: %s", err)
+	}
+	h, _ := pub.Coefficients()
+	s2, _ := sigCT.S2Coefficients()
+	s1, err := S1Coefficients(h, HashToPointCoefficients(msg, sigCT.SaltVersion()), s2)
+	if err != nil {
+		t.Fatalf("s1 coefficients failed: %s", err)
+	}
+	var norm uint32
+	for j := 0; j < N; j++ {
+		norm += uint32(int32(s1[j])*int32(s1[j])) + uint32(int32(s2[j])*int32(s2[j]))
+	}
+	return norm
+}
+
+func TestFalconSignCompressedWithNorm(t *testing.T) {
+	for count := 0; count < 4; count++ {
+		seed := make([]byte, 48)
+		rand.Read(seed)
+		pub, priv, err := GenerateKey(seed)
+		if err != nil {
+			t.Fatalf("failed to generate keys. err message: %s", err)
+		}
+		msg := make([]byte, count*20)
+		rand.Read(msg)
+
+		sig, norm, err := priv.SignCompressedWithNorm(msg)
+		if err != nil {
+			t.Fatalf("SignCompressedWithNorm failed: %s", err)
+		}
+		want, err := priv.SignCompressed(msg)
+		if err != nil {
+			t.Fatalf("failed to sign message. err message: %s", err)
+		}
+		if !bytes.Equal(sig, want) {
+			t.Fatalf("SignCompressedWithNorm signature differs from SignCompressed")
+		}
+		if n := recomputeNorm(t, pub, sig, msg); norm != n {
+			t.Fatalf("SignCompressedWithNorm norm = %d, want %d", norm, n)
+		}
+	}
+}
+
+func TestFalconVCTEval(t *testing.T) {
+	const count = 6
+	const threshold = 56543158
+
+	msg := make([]byte, 48)
+	rand.Read(msg)
+
+	sks := make([]PrivateKey, count)
+	for i := range sks {
+		seed := make([]byte, 48)
+		rand.Read(seed)
+		pub, priv, err := GenerateKey(seed)
+		if err != nil {
+			t.Fatalf("failed to generate keys. err message: %s", err)
+		}
+		sks[i] = priv
+
+		res, err := priv.VCTEval(msg, threshold)
+		if err != nil {
+			t.Fatalf("VCTEval failed: %s", err)
+		}
+
+		// Signature must match plain signing, and the norm must match the
+		// one recomputed from the public key.
+		sig, err := priv.SignCompressed(msg)
+		if err != nil {
+			t.Fatalf("failed to sign message. err message: %s", err)
+		}
+		if !bytes.Equal(res.Signature, sig) {
+			t.Fatalf("VCTEval signature differs from SignCompressed")
+		}
+		if err := pub.Verify(res.Signature, msg); err != nil {
+			t.Fatalf("VCTEval signature does not verify: %s", err)
+		}
+		norm := recomputeNorm(t, pub, sig, msg)
+		if res.Norm != norm {
+			t.Fatalf("VCTEval norm = %d, want %d", res.Norm, norm)
+		}
+		if res.Selected != (norm < threshold) {
+			t.Fatalf("VCTEval selected = %v for norm %d", res.Selected, norm)
+		}
+
+		esk, err := priv.Expand()
+		if err != nil {
+			t.Fatalf("Expand failed: %s", err)
+		}
+		eres, err := esk.VCTEval(msg, threshold)
+		if err != nil {
+			t.Fatalf("expanded key VCTEval failed: %s", err)
+		}
+		if !bytes.Equal(eres.Signature, res.Signature) || eres.Norm != res.Norm || eres.Selected != res.Selected {
+			t.Fatalf("expanded key VCTEval differs from VCTEval")
+		}
+	}
+
+	for _, workers := range []int{0, 1, 3} {
+		results, err := VCTEvalBatch(sks, msg, threshold, workers)
+		if err != nil {
+			t.Fatalf("VCTEvalBatch failed: %s", err)
+		}
+		for i := range sks {
+			single, _ := sks[i].VCTEval(msg, threshold)
+			if !bytes.Equal(results[i].Signature, single.Signature) ||
+				results[i].Norm != single.Norm || results[i].Selected != single.Selected {
+				t.Fatalf("VCTEvalBatch result %d (workers %d) differs from VCTEval", i, workers)
+			}
+		}
+	}
+
+	bad := append([]PrivateKey{}, sks...)
+	bad[2][0] ^= 0xFF
+	results, err := VCTEvalBatch(bad, msg, threshold, 2)
+	if err == nil || results[2].Err == nil {
+		t.Fatalf("VCTEvalBatch accepted a malformed private key")
+	}
+	if results[1].Err != nil || results[3].Err != nil {
+		t.Fatalf("a malformed private key failed other tickets")
+	}
+}
+
+func TestFalconNativeFP(t *testing.T) {
+	type vector struct {
+		pub  PublicKey
+		priv PrivateKey
+		sigs []CompressedSignature
+	}
+	compute := func() []vector {
+		vs := make([]vector, 3)
+		for i := range vs {
+			pub, priv, err := GenerateKey([]byte(fmt.Sprintf("native fp seed %d", i)))
+			if err != nil {
+				t.Fatalf("failed to generate keys. err message: %s", err)
+			}
+			esk, err := priv.Expand()
+			if err != nil {
+				t.Fatalf("Expand failed: %s", err)
+			}
+			vs[i] = vector{pub: pub, priv: priv}
+			for j := 0; j < 4; j++ {
+				msg := []byte(fmt.Sprintf("native fp message %d", j))
+				sig, err := priv.SignCompressed(msg)
+				if err != nil {
+					t.Fatalf("failed to sign message. err message: %s", err)
+				}
+				tsig, err := esk.SignCompressed(msg)
+				if err != nil {
+					t.Fatalf("expanded key failed to sign message: %s", err)
+				}
+				if !bytes.Equal(sig, tsig) {
+					t.Fatalf("expanded key signature differs from dyn signature")
+				}
+				vs[i].sigs = append(vs[i].sigs, sig)
+			}
+		}
+		return vs
+	}
+
+	want := compute()
+	if err := SetNativeFP(true); err != nil {
+		if !errors.Is(err, ErrFPSelectFail) {
+			t.Fatalf("SetNativeFP returned an unexpected error: %s", err)
+		}
+		t.Skipf("native floating-point not available: %s", err)
+	}
+	defer func() {
+		if err := SetNativeFP(false); err != nil {
+			t.Fatalf("SetNativeFP(false) failed: %s", err)
+		}
+	}()
+	got := compute()
+	for i := range want {
+		if want[i].pub != got[i].pub || want[i].priv != got[i].priv {
+			t.Fatalf("native keygen differs from emulated keygen (key %d)", i)
+		}
+		for j := range want[i].sigs {
+			if !bytes.Equal(want[i].sigs[j], got[i].sigs[j]) {
+				t.Fatalf("native signature differs from emulated signature (key %d, msg %d)", i, j)
+			}
+		}
+	}
+}
+
+func TestFalconGenerateKeysParallel(t *testing.T) {
+	seeds := make([][]byte, 7)
+	for i := range seeds {
+		seeds[i] = make([]byte, 48)
+		rand.Read(seeds[i])
+	}
+	seeds[3] = nil // same as GenerateKey(nil)
+
+	pubs, privs, err := GenerateKeysParallel(seeds)
+	if err != nil {
+		t.Fatalf("GenerateKeysParallel failed: %s", err)
+	}
+	if len(pubs) != len(seeds) || len(privs) != len(seeds) {
+		t.Fatalf("GenerateKeysParallel returned %d/%d keys for %d seeds", len(pubs), len(privs), len(seeds))
+	}
+	for i, seed := range seeds {
+		pub, priv, err := GenerateKey(seed)
+		if err != nil {
+			t.Fatalf("failed to generate keys. err message: %s", err)
+		}
+		if pubs[i] != pub || privs[i] != priv {
+			t.Fatalf("GenerateKeysParallel key %d differs from GenerateKey", i)
+		}
+	}
+
+	if pubs, privs, err := GenerateKeysParallel(nil); err != nil || pubs != nil || privs != nil {
+		t.Fatalf("GenerateKeysParallel(nil) = %v, %v, %v", pubs, privs, err)
+	}
+}
+
 func BenchmarkFalconKeyGen(b *testing.B) {
 	var seed [48]byte
 	rand.Read(seed[:])
@@ -376,6 +898,17 @@ func BenchmarkFalconKeyGen(b *testing.B) {
 	}
 }
 
+func BenchmarkFalconGenerateKeysParallel(b *testing.B) {
+	seeds := make([][]byte, b.N)
+	for i := range seeds {
+		seeds[i] = make([]byte, 48)
+		rand.Read(seeds[i])
+	}
+
+	b.ResetTimer()
+	GenerateKeysParallel(seeds)
+}
+
 func BenchmarkFalconSignCompressed(b *testing.B) {
 	_, sk, err := GenerateKey([]byte("seed"))
 	if err != nil {
@@ -418,3 +951,92 @@ func BenchmarkFalconVerify(b *testing.B) {
 		pk.Verify(sigs[i], strs[i][:])
 	}
 }
+
+func BenchmarkFalconVerifyBatch(b *testing.B) {
+	pk, sk, err := GenerateKey([]byte("seed"))
+	if err != nil {
+		b.Fatalf("GenerateKey with error %v", err)
+	}
+
+	msgs := make([][]byte, b.N)
+	sigs := make([]CompressedSignature, b.N)
+	for i := 0; i < b.N; i++ {
+		msgs[i] = make([]byte, 64)
+		rand.Read(msgs[i])
+		sigs[i], err = sk.SignCompressed(msgs[i])
+		if err != nil {
+			b.Fatalf("SignCompressed failed with error %v", err)
+		}
+	}
+
+	b.ResetTimer()
+	pk.VerifyBatch(sigs, msgs)
+}
+
+func BenchmarkFalconVerifyExpanded(b *testing.B) {
+	pk, sk, err := GenerateKey([]byte("seed"))
+	if err != nil {
+		b.Fatalf("GenerateKey with error %v", err)
+	}
+	epk, err := pk.Expand()
+	if err != nil {
+		b.Fatalf("Expand with error %v", err)
+	}
+
+	strs := make([][64]byte, b.N)
+	sigs := make([]CompressedSignature, b.N)
+	for i := 0; i < b.N; i++ {
+		var msg [64]byte
+		rand.Read(msg[:])
+		strs[i] = msg
+		sigs[i], err = sk.SignCompressed(msg[:])
+		if err != nil {
+			b.Fatalf("SignCompressed failed with error %v", err)
+		}
+	}
+
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		epk.Verify(sigs[i], strs[i][:])
+	}
+}
+
+func BenchmarkFalconVCTEvalBatch(b *testing.B) {
+	sks := make([]PrivateKey, b.N)
+	for i := range sks {
+		var seed [48]byte
+		rand.Read(seed[:])
+		_, sk, err := GenerateKey(seed[:])
+		if err != nil {
+			b.Fatalf("GenerateKey with error %v", err)
+		}
+		sks[i] = sk
+	}
+	msg := make([]byte, 64)
+	rand.Read(msg)
+
+	b.ResetTimer()
+	VCTEvalBatch(sks, msg, 56543158, 0)
+}
+
+func BenchmarkFalconSignExpanded(b *testing.B) {
+	_, sk, err := GenerateKey([]byte("seed"))
+	if err != nil {
+		b.Fatalf("GenerateKey with error %v", err)
+	}
+	esk, err := sk.Expand()
+	if err != nil {
+		b.Fatalf("Expand with error %v", err)
+	}
+
+	msgs := make([][]byte, b.N)
+	for i := range msgs {
+		msgs[i] = make([]byte, 64)
+		rand.Read(msgs[i])
+	}
+
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		esk.SignCompressed(msgs[i])
+	}
+}
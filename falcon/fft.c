@@ -142,6 +142,89 @@
 		(d_im) = fpct_d_im; \
 	} while (0)
 
+/*
+ * Batched complex operations for the portable code. Values are
+ * processed by chunks of up to FPC_VEC_CHUNK elements with the
+ * fpr_*_vec() functions, which use SIMD opcodes for the emulated
+ * floating-point when available. Each value is computed with the same
+ * operations as with the FPC_*() macros, hence with the same results.
+ *
+ * Output arrays may be equal to input arrays, but not overlap them
+ * partially.
+ */
+#define FPC_VEC_CHUNK   16
+
+#define FPC_VEC_LEN(k, n, u)   do { \
+		(k) = (n) - (u); \
+		if ((k) > FPC_VEC_CHUNK) { \
+			(k) = FPC_VEC_CHUNK; \
+		} \
+	} while (0)
+
+/*
+ * d = a * b, or d = a * conj(b) if cb != 0 (over n complex values).
+ */
+static void
+fpc_mul_vec(fpr *d_re, fpr *d_im, const fpr *a_re, const fpr *a_im,
+	const fpr *b_re, const fpr *b_im, size_t n, int cb)
+{
+	size_t u, k;
+
+	for (u = 0; u < n; u += k) {
+		fpr t0[FPC_VEC_CHUNK], t1[FPC_VEC_CHUNK];
+		fpr t2[FPC_VEC_CHUNK], t3[FPC_VEC_CHUNK];
+
+		FPC_VEC_LEN(k, n, u);
+		fpr_mul_vec(t0, a_re + u, b_re + u, k);
+		fpr_mul_vec(t1, a_im + u, b_im + u, k);
+		fpr_mul_vec(t2, a_re + u, b_im + u, k);
+		fpr_mul_vec(t3, a_im + u, b_re + u, k);
+		if (cb) {
+			/*
+			 * Negating an operand of fpr_mul() negates the
+			 * result, and fpr_add() is commutative.
+			 */
+			fpr_add_vec(d_re + u, t0, t1, k);
+			fpr_sub_vec(d_im + u, t3, t2, k);
+		} else {
+			fpr_sub_vec(d_re + u, t0, t1, k);
+			fpr_add_vec(d_im + u, t2, t3, k);
+		}
+	}
+}
+
+/*
+ * d = a / b (over n complex values), as FPC_DIV().
+ */
+static void
+fpc_div_vec(fpr *d_re, fpr *d_im, const fpr *a_re, const fpr *a_im,
+	const fpr *b_re, const fpr *b_im, size_t n)
+{
+	size_t u, k, v;
+
+	for (u = 0; u < n; u += k) {
+		fpr m[FPC_VEC_CHUNK], t[FPC_VEC_CHUNK];
+		fpr c_re[FPC_VEC_CHUNK], c_im[FPC_VEC_CHUNK];
+
+		FPC_VEC_LEN(k, n, u);
+		fpr_mul_vec(m, b_re + u, b_re + u, k);
+		fpr_mul_vec(t, b_im + u, b_im + u, k);
+		fpr_add_vec(m, m, t, k);
+		for (v = 0; v < k; v ++) {
+			m[v] = fpr_inv(m[v]);
+		}
+
+		/*
+		 * FPC_DIV() multiplies a with (b_re*m, (-b_im)*m), which
+		 * is the conjugate of (b_re*m, b_im*m).
+		 */
+		fpr_mul_vec(c_re, b_re + u, m, k);
+		fpr_mul_vec(c_im, b_im + u, m, k);
+		fpc_mul_vec(d_re + u, d_im + u, a_re + u, a_im + u,
+			c_re, c_im, k, 1);
+	}
+}
+
 /*
  * Let w = exp(i*pi/N); w is a primitive 2N-th root of 1. We define the
  * values w_j = w^(2j+1) for all j from 0 to N-1: these are the roots
@@ -166,6 +249,375 @@
  * (Note that rev(j) is even for j < N/2.)
  */
 
+#if !FALCON_AVX2
+/*
+ * Portable FFT engine. Each pass over the data computes two successive
+ * layers of the FFT (radix-4 butterflies), which halves the number of
+ * passes over the array. Every value is computed with exactly the same
+ * operations as in the radix-2 algorithms described in Zf(FFT)() and
+ * Zf(iFFT)(), hence the results are identical.
+ *
+ * With FALCON_FPEMU, butterflies are processed by chunks of
+ * FPC_VEC_CHUNK: their operands are gathered into local arrays, along
+ * with the twiddle factors in the order in which they are used, so
+ * that the batched fpr_*_vec() functions apply to all layers, including
+ * the last ones where the butterfly span is small. The working set of a
+ * chunk is about 2 kB and stays in L1 cache (a whole polynomial is at
+ * most 8 kB anyway). With native floating-point, the gathering would
+ * only add memory traffic, and the butterflies are computed in place.
+ */
+
+#if FALCON_FPEMU // yyyFPEMU+1
+
+/*
+ * Forward butterfly: d = a + s*b and b = a - s*b (b is modified).
+ */
+static void
+fpc_fwd_vec(fpr *d_re, fpr *d_im, const fpr *a_re, const fpr *a_im,
+	fpr *b_re, fpr *b_im, const fpr *s_re, const fpr *s_im, size_t k)
+{
+	fpc_mul_vec(b_re, b_im, b_re, b_im, s_re, s_im, k, 0);
+	fpr_add_vec(d_re, a_re, b_re, k);
+	fpr_add_vec(d_im, a_im, b_im, k);
+	fpr_sub_vec(b_re, a_re, b_re, k);
+	fpr_sub_vec(b_im, a_im, b_im, k);
+}
+
+/*
+ * Inverse butterfly: d = a + b and b = s*(a - b) (b is modified).
+ */
+static void
+fpc_inv_vec(fpr *d_re, fpr *d_im, const fpr *a_re, const fpr *a_im,
+	fpr *b_re, fpr *b_im, const fpr *s_re, const fpr *s_im, size_t k)
+{
+	fpr_add_vec(d_re, a_re, b_re, k);
+	fpr_add_vec(d_im, a_im, b_im, k);
+	fpr_sub_vec(b_re, a_re, b_re, k);
+	fpr_sub_vec(b_im, a_im, b_im, k);
+	fpc_mul_vec(b_re, b_im, b_re, b_im, s_re, s_im, k, 0);
+}
+
+/*
+ * FFT layers with m = 2^lm (butterfly half-span 2*qt) and 2*m
+ * (half-span qt), with qt = 2^lq, over hn complex values. If two is
+ * zero, only one layer is computed, with m = 2^lm and half-span qt.
+ */
+static void
+fft_pass(fpr *f, size_t hn, unsigned lm, unsigned lq, int two)
+{
+	size_t m, qt, nr, r, k, v;
+
+	m = (size_t)1 << lm;
+	qt = (size_t)1 << lq;
+	nr = hn >> (1 + two);
+	for (r = 0; r < nr; r += k) {
+		fpr x_re[4][FPC_VEC_CHUNK], x_im[4][FPC_VEC_CHUNK];
+		fpr y_re[2][FPC_VEC_CHUNK], y_im[2][FPC_VEC_CHUNK];
+		fpr s_re[3][FPC_VEC_CHUNK], s_im[3][FPC_VEC_CHUNK];
+		size_t jj[FPC_VEC_CHUNK];
+
+		FPC_VEC_LEN(k, nr, r);
+		for (v = 0; v < k; v ++) {
+			size_t i1, j, z;
+			const fpr *gm;
+
+			/*
+			 * Butterfly r+v is in block i1 of the first layer;
+			 * its operands are at j, j+qt, j+2*qt and j+3*qt
+			 * (only j and j+qt for a single layer).
+			 */
+			i1 = (r + v) >> lq;
+			j = ((i1 << (1 + two)) << lq) + ((r + v) & (qt - 1));
+			jj[v] = j;
+			for (z = 0; z < ((size_t)2 << two); z ++) {
+				x_re[z][v] = f[j + z * qt];
+				x_im[z][v] = f[j + z * qt + hn];
+			}
+			gm = &fpr_gm_tab[(m + i1) << 1];
+			s_re[0][v] = gm[0];
+			s_im[0][v] = gm[1];
+			if (two) {
+				gm = &fpr_gm_tab[(m + i1) << 2];
+				s_re[1][v] = gm[0];
+				s_im[1][v] = gm[1];
+				s_re[2][v] = gm[2];
+				s_im[2][v] = gm[3];
+			}
+		}
+		if (two) {
+			fpc_fwd_vec(y_re[0], y_im[0], x_re[0], x_im[0],
+				x_re[2], x_im[2], s_re[0], s_im[0], k);
+			fpc_fwd_vec(y_re[1], y_im[1], x_re[1], x_im[1],
+				x_re[3], x_im[3], s_re[0], s_im[0], k);
+			fpc_fwd_vec(x_re[0], x_im[0], y_re[0], y_im[0],
+				y_re[1], y_im[1], s_re[1], s_im[1], k);
+			fpc_fwd_vec(y_re[0], y_im[0], x_re[2], x_im[2],
+				x_re[3], x_im[3], s_re[2], s_im[2], k);
+			for (v = 0; v < k; v ++) {
+				size_t j;
+
+				j = jj[v];
+				f[j] = x_re[0][v];
+				f[j + hn] = x_im[0][v];
+				f[j + qt] = y_re[1][v];
+				f[j + qt + hn] = y_im[1][v];
+				f[j + 2 * qt] = y_re[0][v];
+				f[j + 2 * qt + hn] = y_im[0][v];
+				f[j + 3 * qt] = x_re[3][v];
+				f[j + 3 * qt + hn] = x_im[3][v];
+			}
+		} else {
+			fpc_fwd_vec(y_re[0], y_im[0], x_re[0], x_im[0],
+				x_re[1], x_im[1], s_re[0], s_im[0], k);
+			for (v = 0; v < k; v ++) {
+				size_t j;
+
+				j = jj[v];
+				f[j] = y_re[0][v];
+				f[j + hn] = y_im[0][v];
+				f[j + qt] = x_re[1][v];
+				f[j + qt + hn] = x_im[1][v];
+			}
+		}
+	}
+}
+
+/*
+ * iFFT layers with hm = 2^lh (butterfly span t) and hm/2 (span 2*t),
+ * with t = 2^lt, over hn complex values. If two is zero, only one layer
+ * is computed, with hm = 2^lh and span t.
+ */
+static void
+ifft_pass(fpr *f, size_t hn, unsigned lh, unsigned lt, int two)
+{
+	size_t hm, t, nr, r, k, v;
+
+	hm = (size_t)1 << lh;
+	t = (size_t)1 << lt;
+	nr = hn >> (1 + two);
+	for (r = 0; r < nr; r += k) {
+		fpr x_re[4][FPC_VEC_CHUNK], x_im[4][FPC_VEC_CHUNK];
+		fpr y_re[2][FPC_VEC_CHUNK], y_im[2][FPC_VEC_CHUNK];
+		fpr s_re[3][FPC_VEC_CHUNK], s_im[3][FPC_VEC_CHUNK];
+		size_t jj[FPC_VEC_CHUNK];
+
+		FPC_VEC_LEN(k, nr, r);
+		for (v = 0; v < k; v ++) {
+			size_t i2, j, z;
+			const fpr *gm;
+
+			/*
+			 * Butterfly r+v is in block i2 of the last layer;
+			 * its operands are at j, j+t, j+2*t and j+3*t
+			 * (only j and j+t for a single layer). Twiddle
+			 * factors are conjugated.
+			 */
+			i2 = (r + v) >> lt;
+			j = ((i2 << (1 + two)) << lt) + ((r + v) & (t - 1));
+			jj[v] = j;
+			for (z = 0; z < ((size_t)2 << two); z ++) {
+				x_re[z][v] = f[j + z * t];
+				x_im[z][v] = f[j + z * t + hn];
+			}
+			if (two) {
+				gm = &fpr_gm_tab[((hm >> 1) + i2) << 2];
+				s_re[0][v] = gm[0];
+				s_im[0][v] = fpr_neg(gm[1]);
+				s_re[1][v] = gm[2];
+				s_im[1][v] = fpr_neg(gm[3]);
+				gm = &fpr_gm_tab[((hm >> 1) + i2) << 1];
+				s_re[2][v] = gm[0];
+				s_im[2][v] = fpr_neg(gm[1]);
+			} else {
+				gm = &fpr_gm_tab[(hm + i2) << 1];
+				s_re[0][v] = gm[0];
+				s_im[0][v] = fpr_neg(gm[1]);
+			}
+		}
+		if (two) {
+			fpc_inv_vec(y_re[0], y_im[0], x_re[0], x_im[0],
+				x_re[1], x_im[1], s_re[0], s_im[0], k);
+			fpc_inv_vec(y_re[1], y_im[1], x_re[2], x_im[2],
+				x_re[3], x_im[3], s_re[1], s_im[1], k);
+			fpc_inv_vec(x_re[0], x_im[0], y_re[0], y_im[0],
+				y_re[1], y_im[1], s_re[2], s_im[2], k);
+			fpc_inv_vec(x_re[2], x_im[2], x_re[1], x_im[1],
+				x_re[3], x_im[3], s_re[2], s_im[2], k);
+			for (v = 0; v < k; v ++) {
+				size_t j;
+
+				j = jj[v];
+				f[j] = x_re[0][v];
+				f[j + hn] = x_im[0][v];
+				f[j + t] = x_re[2][v];
+				f[j + t + hn] = x_im[2][v];
+				f[j + 2 * t] = y_re[1][v];
+				f[j + 2 * t + hn] = y_im[1][v];
+				f[j + 3 * t] = x_re[3][v];
+				f[j + 3 * t + hn] = x_im[3][v];
+			}
+		} else {
+			fpc_inv_vec(y_re[0], y_im[0], x_re[0], x_im[0],
+				x_re[1], x_im[1], s_re[0], s_im[0], k);
+			for (v = 0; v < k; v ++) {
+				size_t j;
+
+				j = jj[v];
+				f[j] = y_re[0][v];
+				f[j + hn] = y_im[0][v];
+				f[j + t] = x_re[1][v];
+				f[j + t + hn] = x_im[1][v];
+			}
+		}
+	}
+}
+
+#else // yyyFPEMU+0
+
+/* see the FALCON_FPEMU version above */
+static void
+fft_pass(fpr *f, size_t hn, unsigned lm, unsigned lq, int two)
+{
+	size_t m, qt, nb, i1;
+
+	m = (size_t)1 << lm;
+	qt = (size_t)1 << lq;
+	nb = hn >> (lq + 1 + two);
+	for (i1 = 0; i1 < nb; i1 ++) {
+		fpr s0_re, s0_im, s1_re, s1_im, s2_re, s2_im;
+		size_t j, j1, j2;
+
+		s0_re = fpr_gm_tab[((m + i1) << 1) + 0];
+		s0_im = fpr_gm_tab[((m + i1) << 1) + 1];
+		j1 = (i1 << (1 + two)) << lq;
+		j2 = j1 + qt;
+		if (!two) {
+			for (j = j1; j < j2; j ++) {
+				fpr x_re, x_im, y_re, y_im;
+
+				x_re = f[j];
+				x_im = f[j + hn];
+				y_re = f[j + qt];
+				y_im = f[j + qt + hn];
+				FPC_MUL(y_re, y_im, y_re, y_im, s0_re, s0_im);
+				FPC_ADD(f[j], f[j + hn],
+					x_re, x_im, y_re, y_im);
+				FPC_SUB(f[j + qt], f[j + qt + hn],
+					x_re, x_im, y_re, y_im);
+			}
+			continue;
+		}
+		s1_re = fpr_gm_tab[((m + i1) << 2) + 0];
+		s1_im = fpr_gm_tab[((m + i1) << 2) + 1];
+		s2_re = fpr_gm_tab[((m + i1) << 2) + 2];
+		s2_im = fpr_gm_tab[((m + i1) << 2) + 3];
+		for (j = j1; j < j2; j ++) {
+			fpr x0_re, x0_im, x1_re, x1_im;
+			fpr x2_re, x2_im, x3_re, x3_im;
+			fpr y_re, y_im;
+
+			x0_re = f[j];
+			x0_im = f[j + hn];
+			x1_re = f[j + qt];
+			x1_im = f[j + qt + hn];
+			x2_re = f[j + 2 * qt];
+			x2_im = f[j + 2 * qt + hn];
+			x3_re = f[j + 3 * qt];
+			x3_im = f[j + 3 * qt + hn];
+			FPC_MUL(y_re, y_im, x2_re, x2_im, s0_re, s0_im);
+			FPC_SUB(x2_re, x2_im, x0_re, x0_im, y_re, y_im);
+			FPC_ADD(x0_re, x0_im, x0_re, x0_im, y_re, y_im);
+			FPC_MUL(y_re, y_im, x3_re, x3_im, s0_re, s0_im);
+			FPC_SUB(x3_re, x3_im, x1_re, x1_im, y_re, y_im);
+			FPC_ADD(x1_re, x1_im, x1_re, x1_im, y_re, y_im);
+			FPC_MUL(y_re, y_im, x1_re, x1_im, s1_re, s1_im);
+			FPC_ADD(f[j], f[j + hn], x0_re, x0_im, y_re, y_im);
+			FPC_SUB(f[j + qt], f[j + qt + hn],
+				x0_re, x0_im, y_re, y_im);
+			FPC_MUL(y_re, y_im, x3_re, x3_im, s2_re, s2_im);
+			FPC_ADD(f[j + 2 * qt], f[j + 2 * qt + hn],
+				x2_re, x2_im, y_re, y_im);
+			FPC_SUB(f[j + 3 * qt], f[j + 3 * qt + hn],
+				x2_re, x2_im, y_re, y_im);
+		}
+	}
+}
+
+/* see the FALCON_FPEMU version above */
+static void
+ifft_pass(fpr *f, size_t hn, unsigned lh, unsigned lt, int two)
+{
+	size_t hm, t, nb, i2;
+
+	hm = (size_t)1 << lh;
+	t = (size_t)1 << lt;
+	nb = hn >> (lt + 1 + two);
+	for (i2 = 0; i2 < nb; i2 ++) {
+		fpr s0_re, s0_im, s1_re, s1_im, s2_re, s2_im;
+		size_t j, j1, j2, g;
+
+		j1 = (i2 << (1 + two)) << lt;
+		j2 = j1 + t;
+		if (!two) {
+			s0_re = fpr_gm_tab[((hm + i2) << 1) + 0];
+			s0_im = fpr_neg(fpr_gm_tab[((hm + i2) << 1) + 1]);
+			for (j = j1; j < j2; j ++) {
+				fpr x_re, x_im, y_re, y_im;
+
+				x_re = f[j];
+				x_im = f[j + hn];
+				y_re = f[j + t];
+				y_im = f[j + t + hn];
+				FPC_ADD(f[j], f[j + hn],
+					x_re, x_im, y_re, y_im);
+				FPC_SUB(x_re, x_im, x_re, x_im, y_re, y_im);
+				FPC_MUL(f[j + t], f[j + t + hn],
+					x_re, x_im, s0_re, s0_im);
+			}
+			continue;
+		}
+		g = (hm >> 1) + i2;
+		s0_re = fpr_gm_tab[(g << 2) + 0];
+		s0_im = fpr_neg(fpr_gm_tab[(g << 2) + 1]);
+		s1_re = fpr_gm_tab[(g << 2) + 2];
+		s1_im = fpr_neg(fpr_gm_tab[(g << 2) + 3]);
+		s2_re = fpr_gm_tab[(g << 1) + 0];
+		s2_im = fpr_neg(fpr_gm_tab[(g << 1) + 1]);
+		for (j = j1; j < j2; j ++) {
+			fpr x0_re, x0_im, x1_re, x1_im;
+			fpr x2_re, x2_im, x3_re, x3_im;
+			fpr y_re, y_im;
+
+			x0_re = f[j];
+			x0_im = f[j + hn];
+			x1_re = f[j + t];
+			x1_im = f[j + t + hn];
+			x2_re = f[j + 2 * t];
+			x2_im = f[j + 2 * t + hn];
+			x3_re = f[j + 3 * t];
+			x3_im = f[j + 3 * t + hn];
+			FPC_SUB(y_re, y_im, x0_re, x0_im, x1_re, x1_im);
+			FPC_ADD(x0_re, x0_im, x0_re, x0_im, x1_re, x1_im);
+			FPC_MUL(x1_re, x1_im, y_re, y_im, s0_re, s0_im);
+			FPC_SUB(y_re, y_im, x2_re, x2_im, x3_re, x3_im);
+			FPC_ADD(x2_re, x2_im, x2_re, x2_im, x3_re, x3_im);
+			FPC_MUL(x3_re, x3_im, y_re, y_im, s1_re, s1_im);
+			FPC_SUB(y_re, y_im, x0_re, x0_im, x2_re, x2_im);
+			FPC_ADD(f[j], f[j + hn], x0_re, x0_im, x2_re, x2_im);
+			FPC_MUL(f[j + 2 * t], f[j + 2 * t + hn],
+				y_re, y_im, s2_re, s2_im);
+			FPC_SUB(y_re, y_im, x1_re, x1_im, x3_re, x3_im);
+			FPC_ADD(f[j + t], f[j + t + hn],
+				x1_re, x1_im, x3_re, x3_im);
+			FPC_MUL(f[j + 3 * t], f[j + 3 * t + hn],
+				y_re, y_im, s2_re, s2_im);
+		}
+	}
+}
+
+#endif // yyyFPEMU-
+#endif
+
 /* see inner.h */
 TARGET_AVX2
 void
@@ -201,7 +653,10 @@ Zf(FFT)(fpr *f, unsigned logn)
 	 */
 
 	unsigned u;
-	size_t t, n, hn, m;
+	size_t n, hn;
+#if FALCON_AVX2 // yyyAVX2+1
+	size_t t, m;
+#endif // yyyAVX2-
 
 	/*
 	 * First iteration: compute f[j] + i * f[j+N/2] for all j < N/2
@@ -216,6 +671,7 @@ Zf(FFT)(fpr *f, unsigned logn)
 	 */
 	n = (size_t)1 << logn;
 	hn = n >> 1;
+#if FALCON_AVX2 // yyyAVX2+1
 	t = hn;
 	for (u = 1, m = 2; u < logn; u ++, m <<= 1) {
 		size_t ht, hm, i1, j1;
@@ -226,7 +682,6 @@ Zf(FFT)(fpr *f, unsigned logn)
 			size_t j, j2;
 
 			j2 = j1 + ht;
-#if FALCON_AVX2 // yyyAVX2+1
 			if (ht >= 4) {
 				__m256d s_re, s_im;
 
@@ -275,28 +730,24 @@ Zf(FFT)(fpr *f, unsigned logn)
 						x_re, x_im, y_re, y_im);
 				}
 			}
-#else // yyyAVX2+0
-			fpr s_re, s_im;
-
-			s_re = fpr_gm_tab[((m + i1) << 1) + 0];
-			s_im = fpr_gm_tab[((m + i1) << 1) + 1];
-			for (j = j1; j < j2; j ++) {
-				fpr x_re, x_im, y_re, y_im;
-
-				x_re = f[j];
-				x_im = f[j + hn];
-				y_re = f[j + ht];
-				y_im = f[j + ht + hn];
-				FPC_MUL(y_re, y_im, y_re, y_im, s_re, s_im);
-				FPC_ADD(f[j], f[j + hn],
-					x_re, x_im, y_re, y_im);
-				FPC_SUB(f[j + ht], f[j + ht + hn],
-					x_re, x_im, y_re, y_im);
-			}
-#endif // yyyAVX2-
 		}
 		t = ht;
 	}
+#else // yyyAVX2+0
+	/*
+	 * Layers u = 1 to logn-1 (m = 2^u, butterfly half-span
+	 * 2^(logn-1-u)) are computed two at a time, starting with a
+	 * single layer if their number is odd.
+	 */
+	u = 1;
+	if (logn >= 2 && (logn & 1) == 0) {
+		fft_pass(f, hn, 1, logn - 2, 0);
+		u = 2;
+	}
+	for (; u + 1 < logn; u += 2) {
+		fft_pass(f, hn, u, logn - 2 - u, 1);
+	}
+#endif // yyyAVX2-
 }
 
 /* see inner.h */
@@ -346,12 +797,18 @@ Zf(iFFT)(fpr *f, unsigned logn)
 	 * We make the last iteration a no-op by tweaking the final
 	 * division into a division by N/2, not N.
 	 */
-	size_t u, n, hn, t, m;
+	size_t n, hn;
+#if FALCON_AVX2 // yyyAVX2+1
+	size_t u, t, m;
+#else // yyyAVX2+0
+	unsigned u;
+#endif // yyyAVX2-
 
 	n = (size_t)1 << logn;
+	hn = n >> 1;
+#if FALCON_AVX2 // yyyAVX2+1
 	t = 1;
 	m = n;
-	hn = n >> 1;
 	for (u = logn; u > 1; u --) {
 		size_t hm, dt, i1, j1;
 
@@ -361,7 +818,6 @@ Zf(iFFT)(fpr *f, unsigned logn)
 			size_t j, j2;
 
 			j2 = j1 + t;
-#if FALCON_AVX2 // yyyAVX2+1
 			if (t >= 4) {
 				__m256d s_re, s_im;
 
@@ -410,29 +866,23 @@ Zf(iFFT)(fpr *f, unsigned logn)
 						x_re, x_im, s_re, s_im);
 				}
 			}
-#else // yyyAVX2+0
-			fpr s_re, s_im;
-
-			s_re = fpr_gm_tab[((hm + i1) << 1) + 0];
-			s_im = fpr_neg(fpr_gm_tab[((hm + i1) << 1) + 1]);
-			for (j = j1; j < j2; j ++) {
-				fpr x_re, x_im, y_re, y_im;
-
-				x_re = f[j];
-				x_im = f[j + hn];
-				y_re = f[j + t];
-				y_im = f[j + t + hn];
-				FPC_ADD(f[j], f[j + hn],
-					x_re, x_im, y_re, y_im);
-				FPC_SUB(x_re, x_im, x_re, x_im, y_re, y_im);
-				FPC_MUL(f[j + t], f[j + t + hn],
-					x_re, x_im, s_re, s_im);
-			}
-#endif // yyyAVX2-
 		}
 		t = dt;
 		m = hm;
 	}
+#else // yyyAVX2+0
+	/*
+	 * Layers u = logn down to 2 (hm = 2^(u-1), butterfly span
+	 * 2^(logn-u)) are computed two at a time, ending with a single
+	 * layer if their number is odd.
+	 */
+	for (u = logn; u >= 3; u -= 2) {
+		ifft_pass(f, hn, u - 1, logn - u, 1);
+	}
+	if (u == 2) {
+		ifft_pass(f, hn, 1, logn - 2, 0);
+	}
+#endif // yyyAVX2-
 
 	/*
 	 * Last iteration is a no-op, provided that we divide by N/2
@@ -442,9 +892,7 @@ Zf(iFFT)(fpr *f, unsigned logn)
 		fpr ni;
 
 		ni = fpr_p2_tab[logn];
-		for (u = 0; u < n; u ++) {
-			f[u] = fpr_mul(f[u], ni);
-		}
+		fpr_mulconst_vec(f, f, ni, n);
 	}
 }
 
@@ -454,11 +902,12 @@ void
 Zf(poly_add)(
 	fpr *restrict a, const fpr *restrict b, unsigned logn)
 {
-	size_t n, u;
+	size_t n;
 
 	n = (size_t)1 << logn;
 #if FALCON_AVX2 // yyyAVX2+1
 	if (n >= 4) {
+		size_t u;
 		for (u = 0; u < n; u += 4) {
 			_mm256_storeu_pd(&a[u].v,
 				_mm256_add_pd(
@@ -466,14 +915,10 @@ Zf(poly_add)(
 					_mm256_loadu_pd(&b[u].v)));
 		}
 	} else {
-		for (u = 0; u < n; u ++) {
-			a[u] = fpr_add(a[u], b[u]);
-		}
+		fpr_add_vec(a, a, b, n);
 	}
 #else // yyyAVX2+0
-	for (u = 0; u < n; u ++) {
-		a[u] = fpr_add(a[u], b[u]);
-	}
+	fpr_add_vec(a, a, b, n);
 #endif // yyyAVX2-
 }
 
@@ -483,11 +928,12 @@ void
 Zf(poly_sub)(
 	fpr *restrict a, const fpr *restrict b, unsigned logn)
 {
-	size_t n, u;
+	size_t n;
 
 	n = (size_t)1 << logn;
 #if FALCON_AVX2 // yyyAVX2+1
 	if (n >= 4) {
+		size_t u;
 		for (u = 0; u < n; u += 4) {
 			_mm256_storeu_pd(&a[u].v,
 				_mm256_sub_pd(
@@ -495,14 +941,10 @@ Zf(poly_sub)(
 					_mm256_loadu_pd(&b[u].v)));
 		}
 	} else {
-		for (u = 0; u < n; u ++) {
-			a[u] = fpr_sub(a[u], b[u]);
-		}
+		fpr_sub_vec(a, a, b, n);
 	}
 #else // yyyAVX2+0
-	for (u = 0; u < n; u ++) {
-		a[u] = fpr_sub(a[u], b[u]);
-	}
+	fpr_sub_vec(a, a, b, n);
 #endif // yyyAVX2-
 }
 
@@ -570,12 +1012,14 @@ void
 Zf(poly_mul_fft)(
 	fpr *restrict a, const fpr *restrict b, unsigned logn)
 {
-	size_t n, hn, u;
+	size_t n, hn;
 
 	n = (size_t)1 << logn;
 	hn = n >> 1;
 #if FALCON_AVX2 // yyyAVX2+1
 	if (n >= 8) {
+		size_t u;
+
 		for (u = 0; u < hn; u += 4) {
 			__m256d a_re, a_im, b_re, b_im, c_re, c_im;
 
@@ -591,26 +1035,10 @@ Zf(poly_mul_fft)(
 			_mm256_storeu_pd(&a[u + hn].v, c_im);
 		}
 	} else {
-		for (u = 0; u < hn; u ++) {
-			fpr a_re, a_im, b_re, b_im;
-
-			a_re = a[u];
-			a_im = a[u + hn];
-			b_re = b[u];
-			b_im = b[u + hn];
-			FPC_MUL(a[u], a[u + hn], a_re, a_im, b_re, b_im);
-		}
+		fpc_mul_vec(a, a + hn, a, a + hn, b, b + hn, hn, 0);
 	}
 #else // yyyAVX2+0
-	for (u = 0; u < hn; u ++) {
-		fpr a_re, a_im, b_re, b_im;
-
-		a_re = a[u];
-		a_im = a[u + hn];
-		b_re = b[u];
-		b_im = b[u + hn];
-		FPC_MUL(a[u], a[u + hn], a_re, a_im, b_re, b_im);
-	}
+	fpc_mul_vec(a, a + hn, a, a + hn, b, b + hn, hn, 0);
 #endif // yyyAVX2-
 }
 
@@ -620,12 +1048,14 @@ void
 Zf(poly_muladj_fft)(
 	fpr *restrict a, const fpr *restrict b, unsigned logn)
 {
-	size_t n, hn, u;
+	size_t n, hn;
 
 	n = (size_t)1 << logn;
 	hn = n >> 1;
 #if FALCON_AVX2 // yyyAVX2+1
 	if (n >= 8) {
+		size_t u;
+
 		for (u = 0; u < hn; u += 4) {
 			__m256d a_re, a_im, b_re, b_im, c_re, c_im;
 
@@ -641,26 +1071,10 @@ Zf(poly_muladj_fft)(
 			_mm256_storeu_pd(&a[u + hn].v, c_im);
 		}
 	} else {
-		for (u = 0; u < hn; u ++) {
-			fpr a_re, a_im, b_re, b_im;
-
-			a_re = a[u];
-			a_im = a[u + hn];
-			b_re = b[u];
-			b_im = fpr_neg(b[u + hn]);
-			FPC_MUL(a[u], a[u + hn], a_re, a_im, b_re, b_im);
-		}
+		fpc_mul_vec(a, a + hn, a, a + hn, b, b + hn, hn, 1);
 	}
 #else // yyyAVX2+0
-	for (u = 0; u < hn; u ++) {
-		fpr a_re, a_im, b_re, b_im;
-
-		a_re = a[u];
-		a_im = a[u + hn];
-		b_re = b[u];
-		b_im = fpr_neg(b[u + hn]);
-		FPC_MUL(a[u], a[u + hn], a_re, a_im, b_re, b_im);
-	}
+	fpc_mul_vec(a, a + hn, a, a + hn, b, b + hn, hn, 1);
 #endif // yyyAVX2-
 }
 
@@ -703,13 +1117,17 @@ Zf(poly_mulselfadj_fft)(fpr *a, unsigned logn)
 		}
 	}
 #else // yyyAVX2+0
-	for (u = 0; u < hn; u ++) {
-		fpr a_re, a_im;
-
-		a_re = a[u];
-		a_im = a[u + hn];
-		a[u] = fpr_add(fpr_sqr(a_re), fpr_sqr(a_im));
-		a[u + hn] = fpr_zero;
+	for (u = 0; u < hn; u += FPC_VEC_CHUNK) {
+		fpr t[FPC_VEC_CHUNK];
+		size_t k, v;
+
+		FPC_VEC_LEN(k, hn, u);
+		fpr_mul_vec(t, a + u + hn, a + u + hn, k);
+		fpr_mul_vec(a + u, a + u, a + u, k);
+		fpr_add_vec(a + u, a + u, t, k);
+		for (v = 0; v < k; v ++) {
+			a[u + v + hn] = fpr_zero;
+		}
 	}
 #endif // yyyAVX2-
 }
@@ -719,12 +1137,13 @@ TARGET_AVX2
 void
 Zf(poly_mulconst)(fpr *a, fpr x, unsigned logn)
 {
-	size_t n, u;
+	size_t n;
 
 	n = (size_t)1 << logn;
 #if FALCON_AVX2 // yyyAVX2+1
 	if (n >= 4) {
 		__m256d x4;
+		size_t u;
 
 		x4 = _mm256_set1_pd(x.v);
 		for (u = 0; u < n; u += 4) {
@@ -732,14 +1151,10 @@ Zf(poly_mulconst)(fpr *a, fpr x, unsigned logn)
 				_mm256_mul_pd(x4, _mm256_loadu_pd(&a[u].v)));
 		}
 	} else {
-		for (u = 0; u < n; u ++) {
-			a[u] = fpr_mul(a[u], x);
-		}
+		fpr_mulconst_vec(a, a, x, n);
 	}
 #else // yyyAVX2+0
-	for (u = 0; u < n; u ++) {
-		a[u] = fpr_mul(a[u], x);
-	}
+	fpr_mulconst_vec(a, a, x, n);
 #endif // yyyAVX2-
 }
 
@@ -749,13 +1164,14 @@ void
 Zf(poly_div_fft)(
 	fpr *restrict a, const fpr *restrict b, unsigned logn)
 {
-	size_t n, hn, u;
+	size_t n, hn;
 
 	n = (size_t)1 << logn;
 	hn = n >> 1;
 #if FALCON_AVX2 // yyyAVX2+1
 	if (n >= 8) {
 		__m256d one;
+		size_t u;
 
 		one = _mm256_set1_pd(1.0);
 		for (u = 0; u < hn; u += 4) {
@@ -778,26 +1194,10 @@ Zf(poly_div_fft)(
 			_mm256_storeu_pd(&a[u + hn].v, c_im);
 		}
 	} else {
-		for (u = 0; u < hn; u ++) {
-			fpr a_re, a_im, b_re, b_im;
-
-			a_re = a[u];
-			a_im = a[u + hn];
-			b_re = b[u];
-			b_im = b[u + hn];
-			FPC_DIV(a[u], a[u + hn], a_re, a_im, b_re, b_im);
-		}
+		fpc_div_vec(a, a + hn, a, a + hn, b, b + hn, hn);
 	}
 #else // yyyAVX2+0
-	for (u = 0; u < hn; u ++) {
-		fpr a_re, a_im, b_re, b_im;
-
-		a_re = a[u];
-		a_im = a[u + hn];
-		b_re = b[u];
-		b_im = b[u + hn];
-		FPC_DIV(a[u], a[u + hn], a_re, a_im, b_re, b_im);
-	}
+	fpc_div_vec(a, a + hn, a, a + hn, b, b + hn, hn);
 #endif // yyyAVX2-
 }
 
@@ -846,17 +1246,21 @@ Zf(poly_invnorm2_fft)(fpr *restrict d,
 		}
 	}
 #else // yyyAVX2+0
-	for (u = 0; u < hn; u ++) {
-		fpr a_re, a_im;
-		fpr b_re, b_im;
-
-		a_re = a[u];
-		a_im = a[u + hn];
-		b_re = b[u];
-		b_im = b[u + hn];
-		d[u] = fpr_inv(fpr_add(
-			fpr_add(fpr_sqr(a_re), fpr_sqr(a_im)),
-			fpr_add(fpr_sqr(b_re), fpr_sqr(b_im))));
+	for (u = 0; u < hn; u += FPC_VEC_CHUNK) {
+		fpr t0[FPC_VEC_CHUNK], t1[FPC_VEC_CHUNK];
+		size_t k, v;
+
+		FPC_VEC_LEN(k, hn, u);
+		fpr_mul_vec(t0, a + u, a + u, k);
+		fpr_mul_vec(t1, a + u + hn, a + u + hn, k);
+		fpr_add_vec(t0, t0, t1, k);
+		fpr_mul_vec(d + u, b + u, b + u, k);
+		fpr_mul_vec(t1, b + u + hn, b + u + hn, k);
+		fpr_add_vec(t1, d + u, t1, k);
+		fpr_add_vec(t0, t0, t1, k);
+		for (v = 0; v < k; v ++) {
+			d[u + v] = fpr_inv(t0[v]);
+		}
 	}
 #endif // yyyAVX2-
 }
@@ -923,24 +1327,17 @@ Zf(poly_add_muladj_fft)(fpr *restrict d,
 		}
 	}
 #else // yyyAVX2+0
-	for (u = 0; u < hn; u ++) {
-		fpr F_re, F_im, G_re, G_im;
-		fpr f_re, f_im, g_re, g_im;
-		fpr a_re, a_im, b_re, b_im;
-
-		F_re = F[u];
-		F_im = F[u + hn];
-		G_re = G[u];
-		G_im = G[u + hn];
-		f_re = f[u];
-		f_im = f[u + hn];
-		g_re = g[u];
-		g_im = g[u + hn];
-
-		FPC_MUL(a_re, a_im, F_re, F_im, f_re, fpr_neg(f_im));
-		FPC_MUL(b_re, b_im, G_re, G_im, g_re, fpr_neg(g_im));
-		d[u] = fpr_add(a_re, b_re);
-		d[u + hn] = fpr_add(a_im, b_im);
+	for (u = 0; u < hn; u += FPC_VEC_CHUNK) {
+		fpr b_re[FPC_VEC_CHUNK], b_im[FPC_VEC_CHUNK];
+		size_t k;
+
+		FPC_VEC_LEN(k, hn, u);
+		fpc_mul_vec(d + u, d + u + hn, F + u, F + u + hn,
+			f + u, f + u + hn, k, 1);
+		fpc_mul_vec(b_re, b_im, G + u, G + u + hn,
+			g + u, g + u + hn, k, 1);
+		fpr_add_vec(d + u, d + u, b_re, k);
+		fpr_add_vec(d + u + hn, d + u + hn, b_im, k);
 	}
 #endif // yyyAVX2-
 }
@@ -951,12 +1348,14 @@ void
 Zf(poly_mul_autoadj_fft)(
 	fpr *restrict a, const fpr *restrict b, unsigned logn)
 {
-	size_t n, hn, u;
+	size_t n, hn;
 
 	n = (size_t)1 << logn;
 	hn = n >> 1;
 #if FALCON_AVX2 // yyyAVX2+1
 	if (n >= 8) {
+		size_t u;
+
 		for (u = 0; u < hn; u += 4) {
 			__m256d a_re, a_im, bv;
 
@@ -969,16 +1368,12 @@ Zf(poly_mul_autoadj_fft)(
 				_mm256_mul_pd(a_im, bv));
 		}
 	} else {
-		for (u = 0; u < hn; u ++) {
-			a[u] = fpr_mul(a[u], b[u]);
-			a[u + hn] = fpr_mul(a[u + hn], b[u]);
-		}
+		fpr_mul_vec(a, a, b, hn);
+		fpr_mul_vec(a + hn, a + hn, b, hn);
 	}
 #else // yyyAVX2+0
-	for (u = 0; u < hn; u ++) {
-		a[u] = fpr_mul(a[u], b[u]);
-		a[u + hn] = fpr_mul(a[u + hn], b[u]);
-	}
+	fpr_mul_vec(a, a, b, hn);
+	fpr_mul_vec(a + hn, a + hn, b, hn);
 #endif // yyyAVX2-
 }
 
@@ -1016,12 +1411,317 @@ Zf(poly_div_autoadj_fft)(
 		}
 	}
 #else // yyyAVX2+0
-	for (u = 0; u < hn; u ++) {
-		fpr ib;
+	for (u = 0; u < hn; u += FPC_VEC_CHUNK) {
+		fpr ib[FPC_VEC_CHUNK];
+		size_t k, v;
+
+		FPC_VEC_LEN(k, hn, u);
+		for (v = 0; v < k; v ++) {
+			ib[v] = fpr_inv(b[u + v]);
+		}
+		fpr_mul_vec(a + u, a + u, ib, k);
+		fpr_mul_vec(a + u + hn, a + u + hn, ib, k);
+	}
+#endif // yyyAVX2-
+}
+
+/* see inner.h */
+TARGET_AVX2
+void
+Zf(poly_gram_fft)(fpr *g00, fpr *g01, fpr *g11,
+	const fpr *b00, const fpr *b01, const fpr *b10, const fpr *b11,
+	unsigned logn)
+{
+	size_t n, hn, u;
+
+	n = (size_t)1 << logn;
+	hn = n >> 1;
+#if FALCON_AVX2 // yyyAVX2+1
+	if (n >= 8) {
+		__m256d zero;
+
+		zero = _mm256_setzero_pd();
+		for (u = 0; u < hn; u += 4) {
+			__m256d b00_re, b00_im, b01_re, b01_im;
+			__m256d b10_re, b10_im, b11_re, b11_im;
+			__m256d a_re, a_im, b_re, b_im;
+
+			b00_re = _mm256_loadu_pd(&b00[u].v);
+			b00_im = _mm256_loadu_pd(&b00[u + hn].v);
+			b01_re = _mm256_loadu_pd(&b01[u].v);
+			b01_im = _mm256_loadu_pd(&b01[u + hn].v);
+			b10_re = _mm256_loadu_pd(&b10[u].v);
+			b10_im = _mm256_loadu_pd(&b10[u + hn].v);
+			b11_re = _mm256_loadu_pd(&b11[u].v);
+			b11_im = _mm256_loadu_pd(&b11[u + hn].v);
+
+			a_re = FMADD(b00_re, b00_re,
+				_mm256_mul_pd(b00_im, b00_im));
+			b_re = FMADD(b01_re, b01_re,
+				_mm256_mul_pd(b01_im, b01_im));
+			_mm256_storeu_pd(&g00[u].v, _mm256_add_pd(a_re, b_re));
+			_mm256_storeu_pd(&g00[u + hn].v, zero);
+
+			a_re = FMADD(b00_re, b10_re,
+				_mm256_mul_pd(b00_im, b10_im));
+			a_im = FMSUB(b00_im, b10_re,
+				_mm256_mul_pd(b00_re, b10_im));
+			b_re = FMADD(b01_re, b11_re,
+				_mm256_mul_pd(b01_im, b11_im));
+			b_im = FMSUB(b01_im, b11_re,
+				_mm256_mul_pd(b01_re, b11_im));
+			_mm256_storeu_pd(&g01[u].v, _mm256_add_pd(a_re, b_re));
+			_mm256_storeu_pd(&g01[u + hn].v,
+				_mm256_add_pd(a_im, b_im));
+
+			a_re = FMADD(b10_re, b10_re,
+				_mm256_mul_pd(b10_im, b10_im));
+			b_re = FMADD(b11_re, b11_re,
+				_mm256_mul_pd(b11_im, b11_im));
+			_mm256_storeu_pd(&g11[u].v, _mm256_add_pd(a_re, b_re));
+			_mm256_storeu_pd(&g11[u + hn].v, zero);
+		}
+	} else {
+		for (u = 0; u < hn; u ++) {
+			fpr b00_re, b00_im, b01_re, b01_im;
+			fpr b10_re, b10_im, b11_re, b11_im;
+			fpr a_re, a_im, b_re, b_im;
+
+			b00_re = b00[u];
+			b00_im = b00[u + hn];
+			b01_re = b01[u];
+			b01_im = b01[u + hn];
+			b10_re = b10[u];
+			b10_im = b10[u + hn];
+			b11_re = b11[u];
+			b11_im = b11[u + hn];
+
+			a_re = fpr_add(fpr_sqr(b00_re), fpr_sqr(b00_im));
+			b_re = fpr_add(fpr_sqr(b01_re), fpr_sqr(b01_im));
+			g00[u] = fpr_add(a_re, b_re);
+			g00[u + hn] = fpr_zero;
+
+			FPC_MUL(a_re, a_im, b00_re, b00_im,
+				b10_re, fpr_neg(b10_im));
+			FPC_MUL(b_re, b_im, b01_re, b01_im,
+				b11_re, fpr_neg(b11_im));
+			g01[u] = fpr_add(a_re, b_re);
+			g01[u + hn] = fpr_add(a_im, b_im);
+
+			a_re = fpr_add(fpr_sqr(b10_re), fpr_sqr(b10_im));
+			b_re = fpr_add(fpr_sqr(b11_re), fpr_sqr(b11_im));
+			g11[u] = fpr_add(a_re, b_re);
+			g11[u + hn] = fpr_zero;
+		}
+	}
+#else // yyyAVX2+0
+	for (u = 0; u < hn; u += FPC_VEC_CHUNK) {
+		fpr a_re[FPC_VEC_CHUNK], a_im[FPC_VEC_CHUNK];
+		fpr b_re[FPC_VEC_CHUNK], b_im[FPC_VEC_CHUNK];
+		fpr c00[FPC_VEC_CHUNK], c01_re[FPC_VEC_CHUNK];
+		fpr c01_im[FPC_VEC_CHUNK], t[FPC_VEC_CHUNK];
+		size_t k, v;
+
+		/*
+		 * Outputs may be the same arrays as inputs: all inputs
+		 * of a chunk are read before its outputs are written.
+		 */
+		FPC_VEC_LEN(k, hn, u);
+		fpr_mul_vec(a_re, b00 + u, b00 + u, k);
+		fpr_mul_vec(t, b00 + u + hn, b00 + u + hn, k);
+		fpr_add_vec(a_re, a_re, t, k);
+		fpr_mul_vec(b_re, b01 + u, b01 + u, k);
+		fpr_mul_vec(t, b01 + u + hn, b01 + u + hn, k);
+		fpr_add_vec(b_re, b_re, t, k);
+		fpr_add_vec(c00, a_re, b_re, k);
+
+		fpc_mul_vec(a_re, a_im, b00 + u, b00 + u + hn,
+			b10 + u, b10 + u + hn, k, 1);
+		fpc_mul_vec(b_re, b_im, b01 + u, b01 + u + hn,
+			b11 + u, b11 + u + hn, k, 1);
+		fpr_add_vec(c01_re, a_re, b_re, k);
+		fpr_add_vec(c01_im, a_im, b_im, k);
+
+		fpr_mul_vec(a_re, b10 + u, b10 + u, k);
+		fpr_mul_vec(t, b10 + u + hn, b10 + u + hn, k);
+		fpr_add_vec(a_re, a_re, t, k);
+		fpr_mul_vec(b_re, b11 + u, b11 + u, k);
+		fpr_mul_vec(t, b11 + u + hn, b11 + u + hn, k);
+		fpr_add_vec(b_re, b_re, t, k);
+
+		fpr_add_vec(g11 + u, a_re, b_re, k);
+		for (v = 0; v < k; v ++) {
+			g00[u + v] = c00[v];
+			g00[u + v + hn] = fpr_zero;
+			g01[u + v] = c01_re[v];
+			g01[u + v + hn] = c01_im[v];
+			g11[u + v + hn] = fpr_zero;
+		}
+	}
+#endif // yyyAVX2-
+}
+
+/* see inner.h */
+TARGET_AVX2
+void
+Zf(poly_target_fft)(fpr *restrict t0, fpr *restrict t1,
+	const fpr *restrict b01, const fpr *restrict b11, fpr x, unsigned logn)
+{
+	size_t n, hn, u;
+	fpr nx;
 
-		ib = fpr_inv(b[u]);
-		a[u] = fpr_mul(a[u], ib);
-		a[u + hn] = fpr_mul(a[u + hn], ib);
+	n = (size_t)1 << logn;
+	hn = n >> 1;
+	nx = fpr_neg(x);
+#if FALCON_AVX2 // yyyAVX2+1
+	if (n >= 8) {
+		__m256d x4, nx4;
+
+		x4 = _mm256_set1_pd(x.v);
+		nx4 = _mm256_set1_pd(nx.v);
+		for (u = 0; u < hn; u += 4) {
+			__m256d c_re, c_im, b_re, b_im, d_re, d_im;
+
+			c_re = _mm256_loadu_pd(&t0[u].v);
+			c_im = _mm256_loadu_pd(&t0[u + hn].v);
+			b_re = _mm256_loadu_pd(&b01[u].v);
+			b_im = _mm256_loadu_pd(&b01[u + hn].v);
+			d_re = FMSUB(c_re, b_re, _mm256_mul_pd(c_im, b_im));
+			d_im = FMADD(c_re, b_im, _mm256_mul_pd(c_im, b_re));
+			_mm256_storeu_pd(&t1[u].v, _mm256_mul_pd(nx4, d_re));
+			_mm256_storeu_pd(&t1[u + hn].v,
+				_mm256_mul_pd(nx4, d_im));
+			b_re = _mm256_loadu_pd(&b11[u].v);
+			b_im = _mm256_loadu_pd(&b11[u + hn].v);
+			d_re = FMSUB(c_re, b_re, _mm256_mul_pd(c_im, b_im));
+			d_im = FMADD(c_re, b_im, _mm256_mul_pd(c_im, b_re));
+			_mm256_storeu_pd(&t0[u].v, _mm256_mul_pd(x4, d_re));
+			_mm256_storeu_pd(&t0[u + hn].v,
+				_mm256_mul_pd(x4, d_im));
+		}
+	} else {
+		for (u = 0; u < hn; u ++) {
+			fpr c_re, c_im, d_re, d_im;
+
+			c_re = t0[u];
+			c_im = t0[u + hn];
+			FPC_MUL(d_re, d_im, c_re, c_im, b01[u], b01[u + hn]);
+			t1[u] = fpr_mul(d_re, nx);
+			t1[u + hn] = fpr_mul(d_im, nx);
+			FPC_MUL(d_re, d_im, c_re, c_im, b11[u], b11[u + hn]);
+			t0[u] = fpr_mul(d_re, x);
+			t0[u + hn] = fpr_mul(d_im, x);
+		}
+	}
+#else // yyyAVX2+0
+	for (u = 0; u < hn; u += FPC_VEC_CHUNK) {
+		size_t k;
+
+		FPC_VEC_LEN(k, hn, u);
+		fpc_mul_vec(t1 + u, t1 + u + hn, t0 + u, t0 + u + hn,
+			b01 + u, b01 + u + hn, k, 0);
+		fpr_mulconst_vec(t1 + u, t1 + u, nx, k);
+		fpr_mulconst_vec(t1 + u + hn, t1 + u + hn, nx, k);
+		fpc_mul_vec(t0 + u, t0 + u + hn, t0 + u, t0 + u + hn,
+			b11 + u, b11 + u + hn, k, 0);
+		fpr_mulconst_vec(t0 + u, t0 + u, x, k);
+		fpr_mulconst_vec(t0 + u + hn, t0 + u + hn, x, k);
+	}
+#endif // yyyAVX2-
+}
+
+/* see inner.h */
+TARGET_AVX2
+void
+Zf(poly_apply_basis_fft)(fpr *d0, fpr *d1, const fpr *t0, const fpr *t1,
+	const fpr *b00, const fpr *b01, const fpr *b10, const fpr *b11,
+	unsigned logn)
+{
+	size_t n, hn, u;
+
+	n = (size_t)1 << logn;
+	hn = n >> 1;
+#if FALCON_AVX2 // yyyAVX2+1
+	if (n >= 8) {
+		for (u = 0; u < hn; u += 4) {
+			__m256d x_re, x_im, y_re, y_im;
+			__m256d b_re, b_im, a_re, a_im, c_re, c_im;
+
+			x_re = _mm256_loadu_pd(&t0[u].v);
+			x_im = _mm256_loadu_pd(&t0[u + hn].v);
+			y_re = _mm256_loadu_pd(&t1[u].v);
+			y_im = _mm256_loadu_pd(&t1[u + hn].v);
+
+			b_re = _mm256_loadu_pd(&b00[u].v);
+			b_im = _mm256_loadu_pd(&b00[u + hn].v);
+			a_re = FMSUB(x_re, b_re, _mm256_mul_pd(x_im, b_im));
+			a_im = FMADD(x_re, b_im, _mm256_mul_pd(x_im, b_re));
+			b_re = _mm256_loadu_pd(&b10[u].v);
+			b_im = _mm256_loadu_pd(&b10[u + hn].v);
+			c_re = FMSUB(y_re, b_re, _mm256_mul_pd(y_im, b_im));
+			c_im = FMADD(y_re, b_im, _mm256_mul_pd(y_im, b_re));
+			a_re = _mm256_add_pd(a_re, c_re);
+			a_im = _mm256_add_pd(a_im, c_im);
+
+			b_re = _mm256_loadu_pd(&b11[u].v);
+			b_im = _mm256_loadu_pd(&b11[u + hn].v);
+			c_re = FMSUB(y_re, b_re, _mm256_mul_pd(y_im, b_im));
+			c_im = FMADD(y_re, b_im, _mm256_mul_pd(y_im, b_re));
+			b_re = _mm256_loadu_pd(&b01[u].v);
+			b_im = _mm256_loadu_pd(&b01[u + hn].v);
+			y_re = FMSUB(x_re, b_re, _mm256_mul_pd(x_im, b_im));
+			y_im = FMADD(x_re, b_im, _mm256_mul_pd(x_im, b_re));
+
+			_mm256_storeu_pd(&d0[u].v, a_re);
+			_mm256_storeu_pd(&d0[u + hn].v, a_im);
+			_mm256_storeu_pd(&d1[u].v, _mm256_add_pd(c_re, y_re));
+			_mm256_storeu_pd(&d1[u + hn].v,
+				_mm256_add_pd(c_im, y_im));
+		}
+	} else {
+		for (u = 0; u < hn; u ++) {
+			fpr x_re, x_im, y_re, y_im;
+			fpr a_re, a_im, b_re, b_im;
+
+			x_re = t0[u];
+			x_im = t0[u + hn];
+			y_re = t1[u];
+			y_im = t1[u + hn];
+			FPC_MUL(a_re, a_im, x_re, x_im, b00[u], b00[u + hn]);
+			FPC_MUL(b_re, b_im, y_re, y_im, b10[u], b10[u + hn]);
+			d0[u] = fpr_add(a_re, b_re);
+			d0[u + hn] = fpr_add(a_im, b_im);
+			FPC_MUL(a_re, a_im, y_re, y_im, b11[u], b11[u + hn]);
+			FPC_MUL(b_re, b_im, x_re, x_im, b01[u], b01[u + hn]);
+			d1[u] = fpr_add(a_re, b_re);
+			d1[u + hn] = fpr_add(a_im, b_im);
+		}
+	}
+#else // yyyAVX2+0
+	for (u = 0; u < hn; u += FPC_VEC_CHUNK) {
+		fpr a_re[FPC_VEC_CHUNK], a_im[FPC_VEC_CHUNK];
+		fpr b_re[FPC_VEC_CHUNK], b_im[FPC_VEC_CHUNK];
+		fpr c_re[FPC_VEC_CHUNK], c_im[FPC_VEC_CHUNK];
+		fpr e_re[FPC_VEC_CHUNK], e_im[FPC_VEC_CHUNK];
+		size_t k;
+
+		/*
+		 * Outputs may be the same arrays as inputs: all inputs
+		 * of a chunk are read before its outputs are written.
+		 */
+		FPC_VEC_LEN(k, hn, u);
+		fpc_mul_vec(a_re, a_im, t0 + u, t0 + u + hn,
+			b00 + u, b00 + u + hn, k, 0);
+		fpc_mul_vec(b_re, b_im, t1 + u, t1 + u + hn,
+			b10 + u, b10 + u + hn, k, 0);
+		fpc_mul_vec(c_re, c_im, t1 + u, t1 + u + hn,
+			b11 + u, b11 + u + hn, k, 0);
+		fpc_mul_vec(e_re, e_im, t0 + u, t0 + u + hn,
+			b01 + u, b01 + u + hn, k, 0);
+		fpr_add_vec(d0 + u, a_re, b_re, k);
+		fpr_add_vec(d0 + u + hn, a_im, b_im, k);
+		fpr_add_vec(d1 + u, c_re, e_re, k);
+		fpr_add_vec(d1 + u + hn, c_im, e_im, k);
 	}
 #endif // yyyAVX2-
 }
@@ -1094,21 +1794,22 @@ Zf(poly_LDL_fft)(
 		}
 	}
 #else // yyyAVX2+0
-	for (u = 0; u < hn; u ++) {
-		fpr g00_re, g00_im, g01_re, g01_im, g11_re, g11_im;
-		fpr mu_re, mu_im;
-
-		g00_re = g00[u];
-		g00_im = g00[u + hn];
-		g01_re = g01[u];
-		g01_im = g01[u + hn];
-		g11_re = g11[u];
-		g11_im = g11[u + hn];
-		FPC_DIV(mu_re, mu_im, g01_re, g01_im, g00_re, g00_im);
-		FPC_MUL(g01_re, g01_im, mu_re, mu_im, g01_re, fpr_neg(g01_im));
-		FPC_SUB(g11[u], g11[u + hn], g11_re, g11_im, g01_re, g01_im);
-		g01[u] = mu_re;
-		g01[u + hn] = fpr_neg(mu_im);
+	for (u = 0; u < hn; u += FPC_VEC_CHUNK) {
+		fpr mu_re[FPC_VEC_CHUNK], mu_im[FPC_VEC_CHUNK];
+		fpr t_re[FPC_VEC_CHUNK], t_im[FPC_VEC_CHUNK];
+		size_t k, v;
+
+		FPC_VEC_LEN(k, hn, u);
+		fpc_div_vec(mu_re, mu_im, g01 + u, g01 + u + hn,
+			g00 + u, g00 + u + hn, k);
+		fpc_mul_vec(t_re, t_im, mu_re, mu_im,
+			g01 + u, g01 + u + hn, k, 1);
+		fpr_sub_vec(g11 + u, g11 + u, t_re, k);
+		fpr_sub_vec(g11 + u + hn, g11 + u + hn, t_im, k);
+		for (v = 0; v < k; v ++) {
+			g01[u + v] = mu_re[v];
+			g01[u + v + hn] = fpr_neg(mu_im[v]);
+		}
 	}
 #endif // yyyAVX2-
 }
@@ -1182,21 +1883,22 @@ Zf(poly_LDLmv_fft)(
 		}
 	}
 #else // yyyAVX2+0
-	for (u = 0; u < hn; u ++) {
-		fpr g00_re, g00_im, g01_re, g01_im, g11_re, g11_im;
-		fpr mu_re, mu_im;
-
-		g00_re = g00[u];
-		g00_im = g00[u + hn];
-		g01_re = g01[u];
-		g01_im = g01[u + hn];
-		g11_re = g11[u];
-		g11_im = g11[u + hn];
-		FPC_DIV(mu_re, mu_im, g01_re, g01_im, g00_re, g00_im);
-		FPC_MUL(g01_re, g01_im, mu_re, mu_im, g01_re, fpr_neg(g01_im));
-		FPC_SUB(d11[u], d11[u + hn], g11_re, g11_im, g01_re, g01_im);
-		l10[u] = mu_re;
-		l10[u + hn] = fpr_neg(mu_im);
+	for (u = 0; u < hn; u += FPC_VEC_CHUNK) {
+		fpr mu_re[FPC_VEC_CHUNK], mu_im[FPC_VEC_CHUNK];
+		fpr t_re[FPC_VEC_CHUNK], t_im[FPC_VEC_CHUNK];
+		size_t k, v;
+
+		FPC_VEC_LEN(k, hn, u);
+		fpc_div_vec(mu_re, mu_im, g01 + u, g01 + u + hn,
+			g00 + u, g00 + u + hn, k);
+		fpc_mul_vec(t_re, t_im, mu_re, mu_im,
+			g01 + u, g01 + u + hn, k, 1);
+		fpr_sub_vec(d11 + u, g11 + u, t_re, k);
+		fpr_sub_vec(d11 + u + hn, g11 + u + hn, t_im, k);
+		for (v = 0; v < k; v ++) {
+			l10[u + v] = mu_re[v];
+			l10[u + v + hn] = fpr_neg(mu_im[v]);
+		}
 	}
 #endif // yyyAVX2-
 }
@@ -1285,6 +1987,40 @@ Zf(poly_split_fft)(
 	f0[0] = f[0];
 	f1[0] = f[hn];
 
+#if FALCON_FPEMU // yyyFPEMU+1
+	for (u = 0; u < qn; u += FPC_VEC_CHUNK) {
+		fpr a_re[FPC_VEC_CHUNK], a_im[FPC_VEC_CHUNK];
+		fpr b_re[FPC_VEC_CHUNK], b_im[FPC_VEC_CHUNK];
+		fpr t_re[FPC_VEC_CHUNK], t_im[FPC_VEC_CHUNK];
+		fpr s_re[FPC_VEC_CHUNK], s_im[FPC_VEC_CHUNK];
+		size_t k, v;
+
+		FPC_VEC_LEN(k, qn, u);
+		for (v = 0; v < k; v ++) {
+			a_re[v] = f[((u + v) << 1) + 0];
+			a_im[v] = f[((u + v) << 1) + 0 + hn];
+			b_re[v] = f[((u + v) << 1) + 1];
+			b_im[v] = f[((u + v) << 1) + 1 + hn];
+			s_re[v] = fpr_gm_tab[((u + v + hn) << 1) + 0];
+			s_im[v] = fpr_neg(fpr_gm_tab[((u + v + hn) << 1) + 1]);
+		}
+
+		fpr_add_vec(t_re, a_re, b_re, k);
+		fpr_add_vec(t_im, a_im, b_im, k);
+		for (v = 0; v < k; v ++) {
+			f0[u + v] = fpr_half(t_re[v]);
+			f0[u + v + qn] = fpr_half(t_im[v]);
+		}
+
+		fpr_sub_vec(t_re, a_re, b_re, k);
+		fpr_sub_vec(t_im, a_im, b_im, k);
+		fpc_mul_vec(t_re, t_im, t_re, t_im, s_re, s_im, k, 0);
+		for (v = 0; v < k; v ++) {
+			f1[u + v] = fpr_half(t_re[v]);
+			f1[u + v + qn] = fpr_half(t_im[v]);
+		}
+	}
+#else // yyyFPEMU+0
 	for (u = 0; u < qn; u ++) {
 		fpr a_re, a_im, b_re, b_im;
 		fpr t_re, t_im;
@@ -1305,6 +2041,7 @@ Zf(poly_split_fft)(
 		f1[u] = fpr_half(t_re);
 		f1[u + qn] = fpr_half(t_im);
 	}
+#endif // yyyFPEMU-
 #endif // yyyAVX2-
 }
 
@@ -1392,6 +2129,31 @@ Zf(poly_merge_fft)(
 	f[0] = f0[0];
 	f[hn] = f1[0];
 
+#if FALCON_FPEMU // yyyFPEMU+1
+	for (u = 0; u < qn; u += FPC_VEC_CHUNK) {
+		fpr b_re[FPC_VEC_CHUNK], b_im[FPC_VEC_CHUNK];
+		fpr t_re[FPC_VEC_CHUNK], t_im[FPC_VEC_CHUNK];
+		fpr s_re[FPC_VEC_CHUNK], s_im[FPC_VEC_CHUNK];
+		size_t k, v;
+
+		FPC_VEC_LEN(k, qn, u);
+		for (v = 0; v < k; v ++) {
+			s_re[v] = fpr_gm_tab[((u + v + hn) << 1) + 0];
+			s_im[v] = fpr_gm_tab[((u + v + hn) << 1) + 1];
+		}
+		fpc_mul_vec(b_re, b_im, f1 + u, f1 + u + qn, s_re, s_im, k, 0);
+		fpr_add_vec(t_re, f0 + u, b_re, k);
+		fpr_add_vec(t_im, f0 + u + qn, b_im, k);
+		fpr_sub_vec(b_re, f0 + u, b_re, k);
+		fpr_sub_vec(b_im, f0 + u + qn, b_im, k);
+		for (v = 0; v < k; v ++) {
+			f[((u + v) << 1) + 0] = t_re[v];
+			f[((u + v) << 1) + 0 + hn] = t_im[v];
+			f[((u + v) << 1) + 1] = b_re[v];
+			f[((u + v) << 1) + 1 + hn] = b_im[v];
+		}
+	}
+#else // yyyFPEMU+0
 	for (u = 0; u < qn; u ++) {
 		fpr a_re, a_im, b_re, b_im;
 		fpr t_re, t_im;
@@ -1408,5 +2170,6 @@ Zf(poly_merge_fft)(
 		f[(u << 1) + 1] = t_re;
 		f[(u << 1) + 1 + hn] = t_im;
 	}
+#endif // yyyFPEMU-
 #endif // yyyAVX2-
 }
@@ -0,0 +1,77 @@
+/*
+ * Native floating-point copy of the Falcon core, for runtime selection
+ * (FALCON_FP_DISPATCH).
+ *
+ * This file recompiles the internal implementation with native
+ * floating-point, in bit-exact mode (FALCON_FPNATIVE_EXACT), and with
+ * the FALCON_FPNATIVE_PREFIX symbol prefix so that it may be linked
+ * along with the normal (emulated) code. The resulting functions are
+ * reachable only through Zf_native(fp_backend); see falcon_fp_select().
+ *
+ * This file is distributed under the same MIT license terms as the
+ * rest of the Falcon implementation (see the other source files).
+ */
+
+#include "config.h"
+
+/*
+ * The native copy is built only if the default code is emulated and
+ * runtime dispatch is enabled; this mirrors the FALCON_FP_DISPATCH
+ * autodetection in inner.h, which cannot be included yet since it
+ * fixes the floating-point implementation.
+ */
+#if defined FALCON_FPEMU && FALCON_FPEMU \
+	&& !(defined FALCON_FPNATIVE && FALCON_FPNATIVE)
+#if defined FALCON_FP_DISPATCH
+#define FPNATIVE_COPY   FALCON_FP_DISPATCH
+#elif (defined __x86_64__ || defined __aarch64__) \
+	&& (defined __GNUC__ || defined __clang__)
+#define FPNATIVE_COPY   1
+#endif
+#endif
+
+#if defined FPNATIVE_COPY && FPNATIVE_COPY
+
+#undef FALCON_FPEMU
+#undef FALCON_FPNATIVE
+#undef FALCON_FPNATIVE_EXACT
+#undef FALCON_PREFIX
+#define FALCON_FPEMU            0
+#define FALCON_FPNATIVE         1
+#define FALCON_FPNATIVE_EXACT   1
+#ifndef FALCON_FPNATIVE_PREFIX
+#define FALCON_FPNATIVE_PREFIX   falcon_inner_fpnative
+#endif
+#define FALCON_PREFIX   FALCON_FPNATIVE_PREFIX
+
+/*
+ * Fused multiply-add changes rounding, hence outputs: it must not be
+ * used, either explicitly or through compiler contractions (which GCC
+ * enables by default whenever the target has FMA opcodes).
+ */
+#undef FALCON_FMA
+#define FALCON_FMA   0
+#if defined __clang__
+#pragma STDC FP_CONTRACT OFF
+#elif defined __GNUC__
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+#include "codec.c"
+#include "common.c"
+#include "fpr.c"
+#include "fft.c"
+#include "keygen.c"
+#include "rng.c"
+#include "shake.c"
+#include "sign.c"
+#include "vrfy.c"
+
+#else
+
+/*
+ * ISO C forbids empty translation units.
+ */
+typedef int fpnative_dummy;
+
+#endif
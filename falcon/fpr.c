@@ -36,47 +36,7 @@
 
 #if FALCON_FPEMU // yyyFPEMU+1
 
-/*
- * Normalize a provided unsigned integer to the 2^63..2^64-1 range by
- * left-shifting it if necessary. The exponent e is adjusted accordingly
- * (i.e. if the value was left-shifted by n bits, then n is subtracted
- * from e). If source m is 0, then it remains 0, but e is altered.
- * Both m and e must be simple variables (no expressions allowed).
- */
-#define FPR_NORM64(m, e)   do { \
-		uint32_t nt; \
- \
-		(e) -= 63; \
- \
-		nt = (uint32_t)((m) >> 32); \
-		nt = (nt | -nt) >> 31; \
-		(m) ^= ((m) ^ ((m) << 32)) & ((uint64_t)nt - 1); \
-		(e) += (int)(nt << 5); \
- \
-		nt = (uint32_t)((m) >> 48); \
-		nt = (nt | -nt) >> 31; \
-		(m) ^= ((m) ^ ((m) << 16)) & ((uint64_t)nt - 1); \
-		(e) += (int)(nt << 4); \
- \
-		nt = (uint32_t)((m) >> 56); \
-		nt = (nt | -nt) >> 31; \
-		(m) ^= ((m) ^ ((m) <<  8)) & ((uint64_t)nt - 1); \
-		(e) += (int)(nt << 3); \
- \
-		nt = (uint32_t)((m) >> 60); \
-		nt = (nt | -nt) >> 31; \
-		(m) ^= ((m) ^ ((m) <<  4)) & ((uint64_t)nt - 1); \
-		(e) += (int)(nt << 2); \
- \
-		nt = (uint32_t)((m) >> 62); \
-		nt = (nt | -nt) >> 31; \
-		(m) ^= ((m) ^ ((m) <<  2)) & ((uint64_t)nt - 1); \
-		(e) += (int)(nt << 1); \
- \
-		nt = (uint32_t)((m) >> 63); \
-		(m) ^= ((m) ^ ((m) <<  1)) & ((uint64_t)nt - 1); \
-		(e) += (int)(nt); \
-	} while (0)
+#include "fpremu.h"
 
 #if FALCON_ASM_CORTEXM4 // yyyASM_CORTEXM4+1
 
@@ -467,117 +427,6 @@ fpr_add(fpr x __attribute__((unused)), fpr y __attribute__((unused)))
 	"pop	{ r4, r5, r6, r7, r8, r10, r11, pc }\n\t"
 	);
 }
-
-#else // yyyASM_CORTEXM4+0
-
-fpr
-fpr_add(fpr x, fpr y)
-{
-	uint64_t m, xu, yu, za;
-	uint32_t cs;
-	int ex, ey, sx, sy, cc;
-
-	/*
-	 * Make sure that the first operand (x) has the larger absolute
-	 * value. This guarantees that the exponent of y is less than
-	 * or equal to the exponent of x, and, if they are equal, then
-	 * the mantissa of y will not be greater than the mantissa of x.
-	 *
-	 * After this swap, the result will have the sign x, except in
-	 * the following edge case: abs(x) = abs(y), and x and y have
-	 * opposite sign bits; in that case, the result shall be +0
-	 * even if the sign bit of x is 1. To handle this case properly,
-	 * we do the swap is abs(x) = abs(y) AND the sign of x is 1.
-	 */
-	m = ((uint64_t)1 << 63) - 1;
-	za = (x & m) - (y & m);
-	cs = (uint32_t)(za >> 63)
-		| ((1U - (uint32_t)(-za >> 63)) & (uint32_t)(x >> 63));
-	m = (x ^ y) & -(uint64_t)cs;
-	x ^= m;
-	y ^= m;
-
-	/*
-	 * Extract sign bits, exponents and mantissas. The mantissas are
-	 * scaled up to 2^55..2^56-1, and the exponent is unbiased. If
-	 * an operand is zero, its mantissa is set to 0 at this step, and
-	 * its exponent will be -1078.
-	 */
-	ex = (int)(x >> 52);
-	sx = ex >> 11;
-	ex &= 0x7FF;
-	m = (uint64_t)(uint32_t)((ex + 0x7FF) >> 11) << 52;
-	xu = ((x & (((uint64_t)1 << 52) - 1)) | m) << 3;
-	ex -= 1078;
-	ey = (int)(y >> 52);
-	sy = ey >> 11;
-	ey &= 0x7FF;
-	m = (uint64_t)(uint32_t)((ey + 0x7FF) >> 11) << 52;
-	yu = ((y & (((uint64_t)1 << 52) - 1)) | m) << 3;
-	ey -= 1078;
-
-	/*
-	 * x has the larger exponent; hence, we only need to right-shift y.
-	 * If the shift count is larger than 59 bits then we clamp the
-	 * value to zero.
-	 */
-	cc = ex - ey;
-	yu &= -(uint64_t)((uint32_t)(cc - 60) >> 31);
-	cc &= 63;
-
-	/*
-	 * The lowest bit of yu is "sticky".
-	 */
-	m = fpr_ulsh(1, cc) - 1;
-	yu |= (yu & m) + m;
-	yu = fpr_ursh(yu, cc);
-
-	/*
-	 * If the operands have the same sign, then we add the mantissas;
-	 * otherwise, we subtract the mantissas.
-	 */
-	xu += yu - ((yu << 1) & -(uint64_t)(sx ^ sy));
-
-	/*
-	 * The result may be smaller, or slightly larger. We normalize
-	 * it to the 2^63..2^64-1 range (if xu is zero, then it stays
-	 * at zero).
-	 */
-	FPR_NORM64(xu, ex);
-
-	/*
-	 * Scale down the value to 2^54..s^55-1, handling the last bit
-	 * as sticky.
-	 */
-	xu |= ((uint32_t)xu & 0x1FF) + 0x1FF;
-	xu >>= 9;
-	ex += 9;
-
-	/*
-	 * In general, the result has the sign of x. However, if the
-	 * result is exactly zero, then the following situations may
-	 * be encountered:
-	 *   x > 0, y = -x   -> result should be +0
-	 *   x < 0, y = -x   -> result should be +0
-	 *   x = +0, y = +0  -> result should be +0
-	 *   x = -0, y = +0  -> result should be +0
-	 *   x = +0, y = -0  -> result should be +0
-	 *   x = -0, y = -0  -> result should be -0
-	 *
-	 * But at the conditional swap step at the start of the
-	 * function, we ensured that if abs(x) = abs(y) and the
-	 * sign of x was 1, then x and y were swapped. Thus, the
-	 * two following cases cannot actually happen:
-	 *   x < 0, y = -x
-	 *   x = -0, y = +0
-	 * In all other cases, the sign bit of x is conserved, which
-	 * is what the FPR() function does. The FPR() function also
-	 * properly clamps values to zero when the exponent is too
-	 * low, but does not alter the sign in that case.
-	 */
-	return FPR(sx, ex, xu);
-}
-
 #endif // yyyASM_CORTEXM4-
 
 #if FALCON_ASM_CORTEXM4 // yyyASM_CORTEXM4+1
@@ -699,106 +548,321 @@ fpr_mul(fpr x __attribute__((unused)), fpr y __attribute__((unused)))
 	"pop	{ r4, r5, r6, r7, r8, r10, r11, pc }\n\t"
 	);
 }
+#endif // yyyASM_CORTEXM4-
 
-#else // yyyASM_CORTEXM4+0
+#if FALCON_AVX2_RUNTIME
+/*
+ * AVX2 implementations of fpr_add() and fpr_mul() over 4 lanes of 64
+ * bits. Each lane computes exactly what the scalar functions compute,
+ * with the same integer operations (the 32-bit intermediate values of
+ * the scalar code never exceed their range, so they can be kept in
+ * 64-bit lanes), hence results are bit-exact.
+ */
 
-fpr
-fpr_mul(fpr x, fpr y)
+/*
+ * Vector version of FPR(): s is 0 or 1, e is a signed 64-bit value.
+ */
+TARGET_AVX2_RUNTIME
+static inline __m256i
+FPR_x4(__m256i s, __m256i e, __m256i m)
+{
+	__m256i zero, x;
+
+	zero = _mm256_setzero_si256();
+	e = _mm256_add_epi64(e, _mm256_set1_epi64x(1076));
+	m = _mm256_andnot_si256(_mm256_cmpgt_epi64(zero, e), m);
+	e = _mm256_andnot_si256(
+		_mm256_cmpeq_epi64(_mm256_srli_epi64(m, 54), zero), e);
+	x = _mm256_add_epi64(
+		_mm256_or_si256(_mm256_slli_epi64(s, 63),
+			_mm256_srli_epi64(m, 2)),
+		_mm256_slli_epi64(e, 52));
+	return _mm256_add_epi64(x, _mm256_and_si256(
+		_mm256_srlv_epi64(_mm256_set1_epi64x(0xC8),
+			_mm256_and_si256(m, _mm256_set1_epi64x(7))),
+		_mm256_set1_epi64x(1)));
+}
+
+/*
+ * One step of FPR_NORM64(): if the top k bits of m are all zero, then
+ * m is left-shifted by k bits; otherwise, k is added to e.
+ */
+#define FPR_NORM64_STEP_x4(m, e, k)   do { \
+		__m256i nsz; \
+ \
+		nsz = _mm256_cmpeq_epi64(_mm256_srli_epi64(m, 64 - (k)), \
+			_mm256_setzero_si256()); \
+		(m) = _mm256_blendv_epi8((m), _mm256_slli_epi64(m, k), nsz); \
+		(e) = _mm256_add_epi64((e), \
+			_mm256_andnot_si256(nsz, _mm256_set1_epi64x(k))); \
+	} while (0)
+
+TARGET_AVX2_RUNTIME
+static inline __m256i
+fpr_add_x4(__m256i x, __m256i y)
 {
-	uint64_t xu, yu, w, zu, zv;
-	uint32_t x0, x1, y0, y1, z0, z1, z2;
-	int ex, ey, d, e, s;
+	__m256i m, za, cs, xu, yu, ex, ey, sx, sy, cc, zero, one, m52;
+
+	zero = _mm256_setzero_si256();
+	one = _mm256_set1_epi64x(1);
+	m52 = _mm256_set1_epi64x((int64_t)(((uint64_t)1 << 52) - 1));
 
 	/*
-	 * Extract absolute values as scaled unsigned integers. We
-	 * don't extract exponents yet.
+	 * Conditional swap so that x has the larger absolute value
+	 * (see fpr_add()).
 	 */
-	xu = (x & (((uint64_t)1 << 52) - 1)) | ((uint64_t)1 << 52);
-	yu = (y & (((uint64_t)1 << 52) - 1)) | ((uint64_t)1 << 52);
+	m = _mm256_set1_epi64x(INT64_MAX);
+	za = _mm256_sub_epi64(_mm256_and_si256(x, m), _mm256_and_si256(y, m));
+	cs = _mm256_or_si256(_mm256_srli_epi64(za, 63),
+		_mm256_and_si256(
+			_mm256_xor_si256(one, _mm256_srli_epi64(
+				_mm256_sub_epi64(zero, za), 63)),
+			_mm256_srli_epi64(x, 63)));
+	m = _mm256_and_si256(_mm256_xor_si256(x, y),
+		_mm256_sub_epi64(zero, cs));
+	x = _mm256_xor_si256(x, m);
+	y = _mm256_xor_si256(y, m);
 
 	/*
-	 * We have two 53-bit integers to multiply; we need to split
-	 * each into a lower half and a upper half. Moreover, we
-	 * prefer to have lower halves to be of 25 bits each, for
-	 * reasons explained later on.
+	 * Extract sign bits, exponents and mantissas.
 	 */
-	x0 = (uint32_t)xu & 0x01FFFFFF;
-	x1 = (uint32_t)(xu >> 25);
-	y0 = (uint32_t)yu & 0x01FFFFFF;
-	y1 = (uint32_t)(yu >> 25);
-	w = (uint64_t)x0 * (uint64_t)y0;
-	z0 = (uint32_t)w & 0x01FFFFFF;
-	z1 = (uint32_t)(w >> 25);
-	w = (uint64_t)x0 * (uint64_t)y1;
-	z1 += (uint32_t)w & 0x01FFFFFF;
-	z2 = (uint32_t)(w >> 25);
-	w = (uint64_t)x1 * (uint64_t)y0;
-	z1 += (uint32_t)w & 0x01FFFFFF;
-	z2 += (uint32_t)(w >> 25);
-	zu = (uint64_t)x1 * (uint64_t)y1;
-	z2 += (z1 >> 25);
-	z1 &= 0x01FFFFFF;
-	zu += z2;
+	sx = _mm256_srli_epi64(x, 63);
+	ex = _mm256_and_si256(_mm256_srli_epi64(x, 52),
+		_mm256_set1_epi64x(0x7FF));
+	m = _mm256_slli_epi64(_mm256_srli_epi64(
+		_mm256_add_epi64(ex, _mm256_set1_epi64x(0x7FF)), 11), 52);
+	xu = _mm256_slli_epi64(
+		_mm256_or_si256(_mm256_and_si256(x, m52), m), 3);
+	ex = _mm256_sub_epi64(ex, _mm256_set1_epi64x(1078));
+	sy = _mm256_srli_epi64(y, 63);
+	ey = _mm256_and_si256(_mm256_srli_epi64(y, 52),
+		_mm256_set1_epi64x(0x7FF));
+	m = _mm256_slli_epi64(_mm256_srli_epi64(
+		_mm256_add_epi64(ey, _mm256_set1_epi64x(0x7FF)), 11), 52);
+	yu = _mm256_slli_epi64(
+		_mm256_or_si256(_mm256_and_si256(y, m52), m), 3);
+	ey = _mm256_sub_epi64(ey, _mm256_set1_epi64x(1078));
 
 	/*
-	 * Since xu and yu are both in the 2^52..2^53-1 range, the
-	 * product is in the 2^104..2^106-1 range. We first reassemble
-	 * it and round it into the 2^54..2^56-1 range; the bottom bit
-	 * is made "sticky". Since the low limbs z0 and z1 are 25 bits
-	 * each, we just take the upper part (zu), and consider z0 and
-	 * z1 only for purposes of stickiness.
-	 * (This is the reason why we chose 25-bit limbs above.)
+	 * Right-shift y, with a sticky bit; clamp to zero if the shift
+	 * count is 60 or more.
 	 */
-	zu |= ((z0 | z1) + 0x01FFFFFF) >> 25;
+	cc = _mm256_sub_epi64(ex, ey);
+	yu = _mm256_and_si256(yu,
+		_mm256_cmpgt_epi64(_mm256_set1_epi64x(60), cc));
+	cc = _mm256_and_si256(cc, _mm256_set1_epi64x(63));
+	m = _mm256_sub_epi64(_mm256_sllv_epi64(one, cc), one);
+	yu = _mm256_or_si256(yu,
+		_mm256_add_epi64(_mm256_and_si256(yu, m), m));
+	yu = _mm256_srlv_epi64(yu, cc);
 
 	/*
-	 * We normalize zu to the 2^54..s^55-1 range: it could be one
-	 * bit too large at this point. This is done with a conditional
-	 * right-shift that takes into account the sticky bit.
+	 * Add or subtract the mantissas.
 	 */
-	zv = (zu >> 1) | (zu & 1);
-	w = zu >> 55;
-	zu ^= (zu ^ zv) & -w;
+	xu = _mm256_add_epi64(xu, _mm256_sub_epi64(yu,
+		_mm256_and_si256(_mm256_slli_epi64(yu, 1),
+			_mm256_sub_epi64(zero, _mm256_xor_si256(sx, sy)))));
 
 	/*
-	 * Get the aggregate scaling factor:
-	 *
-	 *   - Each exponent is biased by 1023.
-	 *
-	 *   - Integral mantissas are scaled by 2^52, hence an
-	 *     extra 52 bias for each exponent.
-	 *
-	 *   - However, we right-shifted z by 50 bits, and then
-	 *     by 0 or 1 extra bit (depending on the value of w).
-	 *
-	 * In total, we must add the exponents, then subtract
-	 * 2 * (1023 + 52), then add 50 + w.
+	 * Normalize and scale down, with a sticky low bit.
 	 */
-	ex = (int)((x >> 52) & 0x7FF);
-	ey = (int)((y >> 52) & 0x7FF);
-	e = ex + ey - 2100 + (int)w;
+	ex = _mm256_sub_epi64(ex, _mm256_set1_epi64x(63));
+	FPR_NORM64_STEP_x4(xu, ex, 32);
+	FPR_NORM64_STEP_x4(xu, ex, 16);
+	FPR_NORM64_STEP_x4(xu, ex, 8);
+	FPR_NORM64_STEP_x4(xu, ex, 4);
+	FPR_NORM64_STEP_x4(xu, ex, 2);
+	FPR_NORM64_STEP_x4(xu, ex, 1);
+	m = _mm256_set1_epi64x(0x1FF);
+	xu = _mm256_or_si256(xu,
+		_mm256_add_epi64(_mm256_and_si256(xu, m), m));
+	xu = _mm256_srli_epi64(xu, 9);
+	ex = _mm256_add_epi64(ex, _mm256_set1_epi64x(9));
+
+	return FPR_x4(sx, ex, xu);
+}
+
+TARGET_AVX2_RUNTIME
+static inline __m256i
+fpr_mul_x4(__m256i x, __m256i y)
+{
+	__m256i xu, yu, x0, x1, y0, y1, w, z0, z1, z2, zu, zv;
+	__m256i ex, ey, e, s, d, m25, m52;
+
+	m25 = _mm256_set1_epi64x(0x01FFFFFF);
+	m52 = _mm256_set1_epi64x((int64_t)(((uint64_t)1 << 52) - 1));
 
 	/*
-	 * Sign bit is the XOR of the operand sign bits.
+	 * Split the 53-bit mantissas into 25-bit and 28-bit halves, and
+	 * multiply them (see fpr_mul()).
 	 */
-	s = (int)((x ^ y) >> 63);
+	xu = _mm256_or_si256(_mm256_and_si256(x, m52),
+		_mm256_set1_epi64x((int64_t)1 << 52));
+	yu = _mm256_or_si256(_mm256_and_si256(y, m52),
+		_mm256_set1_epi64x((int64_t)1 << 52));
+	x0 = _mm256_and_si256(xu, m25);
+	x1 = _mm256_srli_epi64(xu, 25);
+	y0 = _mm256_and_si256(yu, m25);
+	y1 = _mm256_srli_epi64(yu, 25);
+	w = _mm256_mul_epu32(x0, y0);
+	z0 = _mm256_and_si256(w, m25);
+	z1 = _mm256_srli_epi64(w, 25);
+	w = _mm256_mul_epu32(x0, y1);
+	z1 = _mm256_add_epi64(z1, _mm256_and_si256(w, m25));
+	z2 = _mm256_srli_epi64(w, 25);
+	w = _mm256_mul_epu32(x1, y0);
+	z1 = _mm256_add_epi64(z1, _mm256_and_si256(w, m25));
+	z2 = _mm256_add_epi64(z2, _mm256_srli_epi64(w, 25));
+	zu = _mm256_mul_epu32(x1, y1);
+	z2 = _mm256_add_epi64(z2, _mm256_srli_epi64(z1, 25));
+	z1 = _mm256_and_si256(z1, m25);
+	zu = _mm256_add_epi64(zu, z2);
 
 	/*
-	 * Corrective actions for zeros: if either of the operands is
-	 * zero, then the computations above were wrong. Test for zero
-	 * is whether ex or ey is zero. We just have to set the mantissa
-	 * (zu) to zero, the FPR() function will normalize e.
+	 * Sticky bit, and normalization to 2^54..2^55-1.
 	 */
-	d = ((ex + 0x7FF) & (ey + 0x7FF)) >> 11;
-	zu &= -(uint64_t)d;
+	zu = _mm256_or_si256(zu, _mm256_srli_epi64(_mm256_add_epi64(
+		_mm256_or_si256(z0, z1), m25), 25));
+	zv = _mm256_or_si256(_mm256_srli_epi64(zu, 1),
+		_mm256_and_si256(zu, _mm256_set1_epi64x(1)));
+	w = _mm256_srli_epi64(zu, 55);
+	zu = _mm256_xor_si256(zu, _mm256_and_si256(_mm256_xor_si256(zu, zv),
+		_mm256_sub_epi64(_mm256_setzero_si256(), w)));
 
 	/*
-	 * FPR() packs the result and applies proper rounding.
+	 * Exponent and sign; mantissa is cleared if an operand is zero.
 	 */
-	return FPR(s, e, zu);
+	ex = _mm256_and_si256(_mm256_srli_epi64(x, 52),
+		_mm256_set1_epi64x(0x7FF));
+	ey = _mm256_and_si256(_mm256_srli_epi64(y, 52),
+		_mm256_set1_epi64x(0x7FF));
+	e = _mm256_add_epi64(_mm256_add_epi64(ex, ey),
+		_mm256_sub_epi64(w, _mm256_set1_epi64x(2100)));
+	s = _mm256_srli_epi64(_mm256_xor_si256(x, y), 63);
+	d = _mm256_srli_epi64(_mm256_and_si256(
+		_mm256_add_epi64(ex, _mm256_set1_epi64x(0x7FF)),
+		_mm256_add_epi64(ey, _mm256_set1_epi64x(0x7FF))), 11);
+	zu = _mm256_and_si256(zu, _mm256_sub_epi64(_mm256_setzero_si256(), d));
+
+	return FPR_x4(s, e, zu);
 }
 
-#endif // yyyASM_CORTEXM4-
+TARGET_AVX2_RUNTIME
+static void
+fpr_add_vec_avx2(fpr *d, const fpr *a, const fpr *b, size_t n, uint64_t sb)
+{
+	__m256i ys;
+	size_t u;
+
+	ys = _mm256_set1_epi64x((int64_t)sb);
+	for (u = 0; u + 4 <= n; u += 4) {
+		_mm256_storeu_si256((__m256i *)(d + u), fpr_add_x4(
+			_mm256_loadu_si256((const __m256i *)(a + u)),
+			_mm256_xor_si256(ys,
+				_mm256_loadu_si256((const __m256i *)(b + u)))));
+	}
+	for (; u < n; u ++) {
+		d[u] = fpr_add(a[u], b[u] ^ sb);
+	}
+}
+
+TARGET_AVX2_RUNTIME
+static void
+fpr_mul_vec_avx2(fpr *d, const fpr *a, const fpr *b, size_t n)
+{
+	size_t u;
+
+	for (u = 0; u + 4 <= n; u += 4) {
+		_mm256_storeu_si256((__m256i *)(d + u), fpr_mul_x4(
+			_mm256_loadu_si256((const __m256i *)(a + u)),
+			_mm256_loadu_si256((const __m256i *)(b + u))));
+	}
+	for (; u < n; u ++) {
+		d[u] = fpr_mul(a[u], b[u]);
+	}
+}
+
+TARGET_AVX2_RUNTIME
+static void
+fpr_mulconst_vec_avx2(fpr *d, const fpr *a, fpr x, size_t n)
+{
+	__m256i xx;
+	size_t u;
+
+	xx = _mm256_set1_epi64x((int64_t)x);
+	for (u = 0; u + 4 <= n; u += 4) {
+		_mm256_storeu_si256((__m256i *)(d + u), fpr_mul_x4(
+			_mm256_loadu_si256((const __m256i *)(a + u)), xx));
+	}
+	for (; u < n; u ++) {
+		d[u] = fpr_mul(a[u], x);
+	}
+}
+#endif
+
+void
+fpr_add_vec(fpr *d, const fpr *a, const fpr *b, size_t n)
+{
+	size_t u;
+
+#if FALCON_AVX2_RUNTIME
+	if (n >= 4 && cpu_has_avx2()) {
+		fpr_add_vec_avx2(d, a, b, n, 0);
+		return;
+	}
+#endif
+	for (u = 0; u < n; u ++) {
+		d[u] = fpr_add(a[u], b[u]);
+	}
+}
+
+void
+fpr_sub_vec(fpr *d, const fpr *a, const fpr *b, size_t n)
+{
+	size_t u;
+
+#if FALCON_AVX2_RUNTIME
+	if (n >= 4 && cpu_has_avx2()) {
+		fpr_add_vec_avx2(d, a, b, n, (uint64_t)1 << 63);
+		return;
+	}
+#endif
+	for (u = 0; u < n; u ++) {
+		d[u] = fpr_sub(a[u], b[u]);
+	}
+}
+
+void
+fpr_mul_vec(fpr *d, const fpr *a, const fpr *b, size_t n)
+{
+	size_t u;
+
+#if FALCON_AVX2_RUNTIME
+	if (n >= 4 && cpu_has_avx2()) {
+		fpr_mul_vec_avx2(d, a, b, n);
+		return;
+	}
+#endif
+	for (u = 0; u < n; u ++) {
+		d[u] = fpr_mul(a[u], b[u]);
+	}
+}
+
+void
+fpr_mulconst_vec(fpr *d, const fpr *a, fpr x, size_t n)
+{
+	size_t u;
+
+#if FALCON_AVX2_RUNTIME
+	if (n >= 4 && cpu_has_avx2()) {
+		fpr_mulconst_vec_avx2(d, a, x, n);
+		return;
+	}
+#endif
+	for (u = 0; u < n; u ++) {
+		d[u] = fpr_mul(a[u], x);
+	}
+}
 
 #if FALCON_ASM_CORTEXM4 // yyyASM_CORTEXM4+1
 
@@ -934,96 +998,6 @@ fpr_div(fpr x __attribute__((unused)), fpr y __attribute__((unused)))
 	"pop	{ r4, r5, r6, r7, r8, r10, r11, pc }\n\t"
 	);
 }
-
-#else // yyyASM_CORTEXM4+0
-
-fpr
-fpr_div(fpr x, fpr y)
-{
-	uint64_t xu, yu, q, q2, w;
-	int i, ex, ey, e, d, s;
-
-	/*
-	 * Extract mantissas of x and y (unsigned).
-	 */
-	xu = (x & (((uint64_t)1 << 52) - 1)) | ((uint64_t)1 << 52);
-	yu = (y & (((uint64_t)1 << 52) - 1)) | ((uint64_t)1 << 52);
-
-	/*
-	 * Perform bit-by-bit division of xu by yu. We run it for 55 bits.
-	 */
-	q = 0;
-	for (i = 0; i < 55; i ++) {
-		/*
-		 * If yu is less than or equal xu, then subtract it and
-		 * push a 1 in the quotient; otherwise, leave xu unchanged
-		 * and push a 0.
-		 */
-		uint64_t b;
-
-		b = ((xu - yu) >> 63) - 1;
-		xu -= b & yu;
-		q |= b & 1;
-		xu <<= 1;
-		q <<= 1;
-	}
-
-	/*
-	 * We got 55 bits in the quotient, followed by an extra zero. We
-	 * want that 56th bit to be "sticky": it should be a 1 if and
-	 * only if the remainder (xu) is non-zero.
-	 */
-	q |= (xu | -xu) >> 63;
-
-	/*
-	 * Quotient is at most 2^56-1. Its top bit may be zero, but in
-	 * that case the next-to-top bit will be a one, since the
-	 * initial xu and yu were both in the 2^52..2^53-1 range.
-	 * We perform a conditional shift to normalize q to the
-	 * 2^54..2^55-1 range (with the bottom bit being sticky).
-	 */
-	q2 = (q >> 1) | (q & 1);
-	w = q >> 55;
-	q ^= (q ^ q2) & -w;
-
-	/*
-	 * Extract exponents to compute the scaling factor:
-	 *
-	 *   - Each exponent is biased and we scaled them up by
-	 *     52 bits; but these biases will cancel out.
-	 *
-	 *   - The division loop produced a 55-bit shifted result,
-	 *     so we must scale it down by 55 bits.
-	 *
-	 *   - If w = 1, we right-shifted the integer by 1 bit,
-	 *     hence we must add 1 to the scaling.
-	 */
-	ex = (int)((x >> 52) & 0x7FF);
-	ey = (int)((y >> 52) & 0x7FF);
-	e = ex - ey - 55 + (int)w;
-
-	/*
-	 * Sign is the XOR of the signs of the operands.
-	 */
-	s = (int)((x ^ y) >> 63);
-
-	/*
-	 * Corrective actions for zeros: if x = 0, then the computation
-	 * is wrong, and we must clamp e and q to 0. We do not care
-	 * about the case y = 0 (as per assumptions in this module,
-	 * the caller does not perform divisions by zero).
-	 */
-	d = (ex + 0x7FF) >> 11;
-	s &= d;
-	e &= -d;
-	q &= -(uint64_t)d;
-
-	/*
-	 * FPR() packs the result and applies proper rounding.
-	 */
-	return FPR(s, e, q);
-}
-
 #endif // yyyASM_CORTEXM4-
 
 #if FALCON_ASM_CORTEXM4 // yyyASM_CORTEXM4+1
@@ -1201,174 +1175,8 @@ fpr_sqrt(fpr x __attribute__((unused)))
 	"pop	{ r4, r5, r6, r7, r8, r10, r11, pc }\n\t"
 	);
 }
-
-#else // yyyASM_CORTEXM4+0
-
-fpr
-fpr_sqrt(fpr x)
-{
-	uint64_t xu, q, s, r;
-	int ex, e;
-
-	/*
-	 * Extract the mantissa and the exponent. We don't care about
-	 * the sign: by assumption, the operand is nonnegative.
-	 * We want the "true" exponent corresponding to a mantissa
-	 * in the 1..2 range.
-	 */
-	xu = (x & (((uint64_t)1 << 52) - 1)) | ((uint64_t)1 << 52);
-	ex = (int)((x >> 52) & 0x7FF);
-	e = ex - 1023;
-
-	/*
-	 * If the exponent is odd, double the mantissa and decrement
-	 * the exponent. The exponent is then halved to account for
-	 * the square root.
-	 */
-	xu += xu & -(uint64_t)(e & 1);
-	e >>= 1;
-
-	/*
-	 * Double the mantissa.
-	 */
-	xu <<= 1;
-
-	/*
-	 * We now have a mantissa in the 2^53..2^55-1 range. It
-	 * represents a value between 1 (inclusive) and 4 (exclusive)
-	 * in fixed point notation (with 53 fractional bits). We
-	 * compute the square root bit by bit.
-	 */
-	q = 0;
-	s = 0;
-	r = (uint64_t)1 << 53;
-	for (int i = 0; i < 54; i ++) {
-		uint64_t t, b;
-
-		t = s + r;
-		b = ((xu - t) >> 63) - 1;
-		s += (r << 1) & b;
-		xu -= t & b;
-		q += r & b;
-		xu <<= 1;
-		r >>= 1;
-	}
-
-	/*
-	 * Now, q is a rounded-low 54-bit value, with a leading 1,
-	 * 52 fractional digits, and an additional guard bit. We add
-	 * an extra sticky bit to account for what remains of the operand.
-	 */
-	q <<= 1;
-	q |= (xu | -xu) >> 63;
-
-	/*
-	 * Result q is in the 2^54..2^55-1 range; we bias the exponent
-	 * by 54 bits (the value e at that point contains the "true"
-	 * exponent, but q is now considered an integer, i.e. scaled
-	 * up.
-	 */
-	e -= 54;
-
-	/*
-	 * Corrective action for an operand of value zero.
-	 */
-	q &= -(uint64_t)((ex + 0x7FF) >> 11);
-
-	/*
-	 * Apply rounding and back result.
-	 */
-	return FPR(0, e, q);
-}
-
 #endif // yyyASM_CORTEXM4-
 
-uint64_t
-fpr_expm_p63(fpr x, fpr ccs)
-{
-	/*
-	 * Polynomial approximation of exp(-x) is taken from FACCT:
-	 *   https://eprint.iacr.org/2018/1234
-	 * Specifically, values are extracted from the implementation
-	 * referenced from the FACCT article, and available at:
-	 *   https://github.com/raykzhao/gaussian
-	 * Here, the coefficients have been scaled up by 2^63 and
-	 * converted to integers.
-	 *
-	 * Tests over more than 24 billions of random inputs in the
-	 * 0..log(2) range have never shown a deviation larger than
-	 * 2^(-50) from the true mathematical value.
-	 */
-	static const uint64_t C[] = {
-		0x00000004741183A3u,
-		0x00000036548CFC06u,
-		0x0000024FDCBF140Au,
-		0x0000171D939DE045u,
-		0x0000D00CF58F6F84u,
-		0x000680681CF796E3u,
-		0x002D82D8305B0FEAu,
-		0x011111110E066FD0u,
-		0x0555555555070F00u,
-		0x155555555581FF00u,
-		0x400000000002B400u,
-		0x7FFFFFFFFFFF4800u,
-		0x8000000000000000u
-	};
-
-	uint64_t z, y;
-	unsigned u;
-	uint32_t z0, z1, y0, y1;
-	uint64_t a, b;
-
-	y = C[0];
-	z = (uint64_t)fpr_trunc(fpr_mul(x, fpr_ptwo63)) << 1;
-	for (u = 1; u < (sizeof C) / sizeof(C[0]); u ++) {
-		/*
-		 * Compute product z * y over 128 bits, but keep only
-		 * the top 64 bits.
-		 *
-		 * TODO: On some architectures/compilers we could use
-		 * some intrinsics (__umulh() on MSVC) or other compiler
-		 * extensions (unsigned __int128 on GCC / Clang) for
-		 * improved speed; however, most 64-bit architectures
-		 * also have appropriate IEEE754 floating-point support,
-		 * which is better.
-		 */
-		uint64_t c;
-
-		z0 = (uint32_t)z;
-		z1 = (uint32_t)(z >> 32);
-		y0 = (uint32_t)y;
-		y1 = (uint32_t)(y >> 32);
-		a = ((uint64_t)z0 * (uint64_t)y1)
-			+ (((uint64_t)z0 * (uint64_t)y0) >> 32);
-		b = ((uint64_t)z1 * (uint64_t)y0);
-		c = (a >> 32) + (b >> 32);
-		c += (((uint64_t)(uint32_t)a + (uint64_t)(uint32_t)b) >> 32);
-		c += (uint64_t)z1 * (uint64_t)y1;
-		y = C[u] - c;
-	}
-
-	/*
-	 * The scaling factor must be applied at the end. Since y is now
-	 * in fixed-point notation, we have to convert the factor to the
-	 * same format, and do an extra integer multiplication.
-	 */
-	z = (uint64_t)fpr_trunc(fpr_mul(ccs, fpr_ptwo63)) << 1;
-	z0 = (uint32_t)z;
-	z1 = (uint32_t)(z >> 32);
-	y0 = (uint32_t)y;
-	y1 = (uint32_t)(y >> 32);
-	a = ((uint64_t)z0 * (uint64_t)y1)
-		+ (((uint64_t)z0 * (uint64_t)y0) >> 32);
-	b = ((uint64_t)z1 * (uint64_t)y0);
-	y = (a >> 32) + (b >> 32);
-	y += (((uint64_t)(uint32_t)a + (uint64_t)(uint32_t)b) >> 32);
-	y += (uint64_t)z1 * (uint64_t)y1;
-
-	return y;
-}
-
 const fpr fpr_gm_tab[] = {
 	0, 0,
 	 9223372036854775808U,  4607182418800017408U,
@@ -3458,3 +3266,99 @@ const fpr fpr_p2_tab[] = {
 #error No FP implementation selected
 
 #endif // yyyFPNATIVE- yyyFPEMU-
+
+#if FALCON_FPEMU || FALCON_FPNATIVE_EXACT
+
+/*
+ * Top 64 bits of the 128-bit product x*y. With GCC and Clang on 64-bit
+ * platforms, unsigned __int128 maps to the native widening multiply;
+ * otherwise the product is assembled from 32-bit halves. Both versions
+ * return exactly floor(x*y / 2^64).
+ */
+static inline uint64_t
+mulhi64(uint64_t x, uint64_t y)
+{
+#if defined __SIZEOF_INT128__
+	__extension__ typedef unsigned __int128 u128;
+
+	return (uint64_t)(((u128)x * y) >> 64);
+#else
+	uint32_t x0, x1, y0, y1;
+	uint64_t a, b, c;
+
+	x0 = (uint32_t)x;
+	x1 = (uint32_t)(x >> 32);
+	y0 = (uint32_t)y;
+	y1 = (uint32_t)(y >> 32);
+	a = ((uint64_t)x0 * (uint64_t)y1)
+		+ (((uint64_t)x0 * (uint64_t)y0) >> 32);
+	b = ((uint64_t)x1 * (uint64_t)y0);
+	c = (a >> 32) + (b >> 32);
+	c += (((uint64_t)(uint32_t)a + (uint64_t)(uint32_t)b) >> 32);
+	c += (uint64_t)x1 * (uint64_t)y1;
+	return c;
+#endif
+}
+
+uint64_t
+fpr_expm_p63(fpr x, fpr ccs)
+{
+	/*
+	 * Polynomial approximation of exp(-x) is taken from FACCT:
+	 *   https://eprint.iacr.org/2018/1234
+	 * Specifically, values are extracted from the implementation
+	 * referenced from the FACCT article, and available at:
+	 *   https://github.com/raykzhao/gaussian
+	 * Here, the coefficients have been scaled up by 2^63 and
+	 * converted to integers.
+	 *
+	 * Tests over more than 24 billions of random inputs in the
+	 * 0..log(2) range have never shown a deviation larger than
+	 * 2^(-50) from the true mathematical value.
+	 *
+	 * With FALCON_FPNATIVE_EXACT, this integer implementation is
+	 * also used with native floating-point, so that the native and
+	 * emulated code sample exactly the same values (including for
+	 * the small negative values of x that new_sampler() may use).
+	 */
+	static const uint64_t C[] = {
+		0x00000004741183A3u,
+		0x00000036548CFC06u,
+		0x0000024FDCBF140Au,
+		0x0000171D939DE045u,
+		0x0000D00CF58F6F84u,
+		0x000680681CF796E3u,
+		0x002D82D8305B0FEAu,
+		0x011111110E066FD0u,
+		0x0555555555070F00u,
+		0x155555555581FF00u,
+		0x400000000002B400u,
+		0x7FFFFFFFFFFF4800u,
+		0x8000000000000000u
+	};
+
+	uint64_t z, y;
+	unsigned u;
+
+	y = C[0];
+	z = (uint64_t)fpr_trunc(fpr_mul(x, fpr_ptwo63)) << 1;
+	for (u = 1; u < (sizeof C) / sizeof(C[0]); u ++) {
+		/*
+		 * Compute product z * y over 128 bits, but keep only
+		 * the top 64 bits.
+		 */
+		y = C[u] - mulhi64(z, y);
+	}
+
+	/*
+	 * The scaling factor must be applied at the end. Since y is now
+	 * in fixed-point notation, we have to convert the factor to the
+	 * same format, and do an extra integer multiplication.
+	 */
+	z = (uint64_t)fpr_trunc(fpr_mul(ccs, fpr_ptwo63)) << 1;
+	y = mulhi64(z, y);
+
+	return y;
+}
+
+#endif
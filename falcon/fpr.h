@@ -394,8 +394,23 @@ fpr_trunc(fpr x)
 	return *(int64_t *)&xu;
 }
 
+/*
+ * Addition, multiplication, division and square root are implemented in
+ * fpremu.h; they are normally compiled out-of-line in fpr.c, but with
+ * FALCON_FPEMU_INLINE they are defined here as static inline functions.
+ */
 #define fpr_add   Zf(fpr_add)
+#define fpr_mul   Zf(fpr_mul)
+#define fpr_div   Zf(fpr_div)
+#define fpr_sqrt   Zf(fpr_sqrt)
+#if FALCON_FPEMU_INLINE
+#include "fpremu.h"
+#else
 fpr fpr_add(fpr x, fpr y);
+fpr fpr_mul(fpr x, fpr y);
+fpr fpr_div(fpr x, fpr y);
+fpr fpr_sqrt(fpr x);
+#endif
 
 static inline fpr
 fpr_sub(fpr x, fpr y)
@@ -438,17 +453,27 @@ fpr_double(fpr x)
 	return x;
 }
 
-#define fpr_mul   Zf(fpr_mul)
-fpr fpr_mul(fpr x, fpr y);
-
 static inline fpr
 fpr_sqr(fpr x)
 {
 	return fpr_mul(x, x);
 }
 
-#define fpr_div   Zf(fpr_div)
-fpr fpr_div(fpr x, fpr y);
+/*
+ * Batched operations: d[i] = a[i] + b[i], a[i] - b[i], a[i] * b[i] or
+ * a[i] * x, for i = 0 to n-1. Results are identical to those of the
+ * scalar functions; when available, AVX2 opcodes are used (selected at
+ * runtime, with FALCON_AVX2_RUNTIME). The output array may be equal to
+ * one of the input arrays, but not overlap them partially.
+ */
+#define fpr_add_vec   Zf(fpr_add_vec)
+void fpr_add_vec(fpr *d, const fpr *a, const fpr *b, size_t n);
+#define fpr_sub_vec   Zf(fpr_sub_vec)
+void fpr_sub_vec(fpr *d, const fpr *a, const fpr *b, size_t n);
+#define fpr_mul_vec   Zf(fpr_mul_vec)
+void fpr_mul_vec(fpr *d, const fpr *a, const fpr *b, size_t n);
+#define fpr_mulconst_vec   Zf(fpr_mulconst_vec)
+void fpr_mulconst_vec(fpr *d, const fpr *a, fpr x, size_t n);
 
 static inline fpr
 fpr_inv(fpr x)
@@ -456,9 +481,6 @@ fpr_inv(fpr x)
 	return fpr_div(4607182418800017408u, x);
 }
 
-#define fpr_sqrt   Zf(fpr_sqrt)
-fpr fpr_sqrt(fpr x);
-
 static inline int
 fpr_lt(fpr x, fpr y)
 {
@@ -708,6 +730,46 @@ fpr_div(fpr x, fpr y)
 	return FPR(x.v / y.v);
 }
 
+static inline void
+fpr_add_vec(fpr *d, const fpr *a, const fpr *b, size_t n)
+{
+	size_t u;
+
+	for (u = 0; u < n; u ++) {
+		d[u] = fpr_add(a[u], b[u]);
+	}
+}
+
+static inline void
+fpr_sub_vec(fpr *d, const fpr *a, const fpr *b, size_t n)
+{
+	size_t u;
+
+	for (u = 0; u < n; u ++) {
+		d[u] = fpr_sub(a[u], b[u]);
+	}
+}
+
+static inline void
+fpr_mul_vec(fpr *d, const fpr *a, const fpr *b, size_t n)
+{
+	size_t u;
+
+	for (u = 0; u < n; u ++) {
+		d[u] = fpr_mul(a[u], b[u]);
+	}
+}
+
+static inline void
+fpr_mulconst_vec(fpr *d, const fpr *a, fpr x, size_t n)
+{
+	size_t u;
+
+	for (u = 0; u < n; u ++) {
+		d[u] = fpr_mul(a[u], x);
+	}
+}
+
 #if FALCON_AVX2  // yyyAVX2+1
 TARGET_AVX2
 static inline void
@@ -822,6 +884,17 @@ fpr_lt(fpr x, fpr y)
 	return x.v < y.v;
 }
 
+#if FALCON_FPNATIVE_EXACT
+
+/*
+ * Bit-exact mode: we use the integer implementation from the emulated
+ * code (in fpr.c), so that outputs match those of FALCON_FPEMU.
+ */
+#define fpr_expm_p63   Zf(fpr_expm_p63)
+uint64_t fpr_expm_p63(fpr x, fpr ccs);
+
+#else
+
 TARGET_AVX2
 static inline uint64_t
 fpr_expm_p63(fpr x, fpr ccs)
@@ -924,6 +997,8 @@ fpr_expm_p63(fpr x, fpr ccs)
 #endif  // yyyAVX2-
 }
 
+#endif
+
 #define fpr_gm_tab   Zf(fpr_gm_tab)
 extern const fpr fpr_gm_tab[];
 
@@ -0,0 +1,465 @@
+#ifndef FALCON_FPREMU_H__
+#define FALCON_FPREMU_H__
+
+/*
+ * Portable C implementation of the emulated floating-point operations
+ * that are too large to be defined directly in fpr.h (addition,
+ * multiplication, division and square root).
+ *
+ * This file is included by fpr.c, which then provides these functions
+ * as normal out-of-line functions. With FALCON_FPEMU_INLINE, it is
+ * included by fpr.h instead, and the functions become static inline in
+ * every translation unit, so that the compiler may inline them in the
+ * FFT and sampling loops. When FALCON_ASM_CORTEXM4 is used, fpr.c
+ * provides assembly versions of these functions, and only the
+ * FPR_NORM64() macro is defined here.
+ *
+ * ==========================(LICENSE BEGIN)============================
+ *
+ * Copyright (c) 2017-2019  Falcon Project
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * ===========================(LICENSE END)=============================
+ *
+ * @author   Thomas Pornin <thomas.pornin@nccgroup.com>
+ */
+
+/*
+ * Normalize a provided unsigned integer to the 2^63..2^64-1 range by
+ * left-shifting it if necessary. The exponent e is adjusted accordingly
+ * (i.e. if the value was left-shifted by n bits, then n is subtracted
+ * from e). If source m is 0, then it remains 0, but e is altered.
+ * Both m and e must be simple variables (no expressions allowed).
+ */
+#define FPR_NORM64(m, e)   do { \
+		uint32_t nt; \
+ \
+		(e) -= 63; \
+ \
+		nt = (uint32_t)((m) >> 32); \
+		nt = (nt | -nt) >> 31; \
+		(m) ^= ((m) ^ ((m) << 32)) & ((uint64_t)nt - 1); \
+		(e) += (int)(nt << 5); \
+ \
+		nt = (uint32_t)((m) >> 48); \
+		nt = (nt | -nt) >> 31; \
+		(m) ^= ((m) ^ ((m) << 16)) & ((uint64_t)nt - 1); \
+		(e) += (int)(nt << 4); \
+ \
+		nt = (uint32_t)((m) >> 56); \
+		nt = (nt | -nt) >> 31; \
+		(m) ^= ((m) ^ ((m) <<  8)) & ((uint64_t)nt - 1); \
+		(e) += (int)(nt << 3); \
+ \
+		nt = (uint32_t)((m) >> 60); \
+		nt = (nt | -nt) >> 31; \
+		(m) ^= ((m) ^ ((m) <<  4)) & ((uint64_t)nt - 1); \
+		(e) += (int)(nt << 2); \
+ \
+		nt = (uint32_t)((m) >> 62); \
+		nt = (nt | -nt) >> 31; \
+		(m) ^= ((m) ^ ((m) <<  2)) & ((uint64_t)nt - 1); \
+		(e) += (int)(nt << 1); \
+ \
+		nt = (uint32_t)((m) >> 63); \
+		(m) ^= ((m) ^ ((m) <<  1)) & ((uint64_t)nt - 1); \
+		(e) += (int)(nt); \
+	} while (0)
+
+#if !FALCON_ASM_CORTEXM4
+
+#if FALCON_FPEMU_INLINE
+#define FPREMU_FN   static inline
+#else
+#define FPREMU_FN
+#endif
+
+FPREMU_FN fpr
+fpr_add(fpr x, fpr y)
+{
+	uint64_t m, xu, yu, za;
+	uint32_t cs;
+	int ex, ey, sx, sy, cc;
+
+	/*
+	 * Make sure that the first operand (x) has the larger absolute
+	 * value. This guarantees that the exponent of y is less than
+	 * or equal to the exponent of x, and, if they are equal, then
+	 * the mantissa of y will not be greater than the mantissa of x.
+	 *
+	 * After this swap, the result will have the sign x, except in
+	 * the following edge case: abs(x) = abs(y), and x and y have
+	 * opposite sign bits; in that case, the result shall be +0
+	 * even if the sign bit of x is 1. To handle this case properly,
+	 * we do the swap is abs(x) = abs(y) AND the sign of x is 1.
+	 */
+	m = ((uint64_t)1 << 63) - 1;
+	za = (x & m) - (y & m);
+	cs = (uint32_t)(za >> 63)
+		| ((1U - (uint32_t)(-za >> 63)) & (uint32_t)(x >> 63));
+	m = (x ^ y) & -(uint64_t)cs;
+	x ^= m;
+	y ^= m;
+
+	/*
+	 * Extract sign bits, exponents and mantissas. The mantissas are
+	 * scaled up to 2^55..2^56-1, and the exponent is unbiased. If
+	 * an operand is zero, its mantissa is set to 0 at this step, and
+	 * its exponent will be -1078.
+	 */
+	ex = (int)(x >> 52);
+	sx = ex >> 11;
+	ex &= 0x7FF;
+	m = (uint64_t)(uint32_t)((ex + 0x7FF) >> 11) << 52;
+	xu = ((x & (((uint64_t)1 << 52) - 1)) | m) << 3;
+	ex -= 1078;
+	ey = (int)(y >> 52);
+	sy = ey >> 11;
+	ey &= 0x7FF;
+	m = (uint64_t)(uint32_t)((ey + 0x7FF) >> 11) << 52;
+	yu = ((y & (((uint64_t)1 << 52) - 1)) | m) << 3;
+	ey -= 1078;
+
+	/*
+	 * x has the larger exponent; hence, we only need to right-shift y.
+	 * If the shift count is larger than 59 bits then we clamp the
+	 * value to zero.
+	 */
+	cc = ex - ey;
+	yu &= -(uint64_t)((uint32_t)(cc - 60) >> 31);
+	cc &= 63;
+
+	/*
+	 * The lowest bit of yu is "sticky".
+	 */
+	m = fpr_ulsh(1, cc) - 1;
+	yu |= (yu & m) + m;
+	yu = fpr_ursh(yu, cc);
+
+	/*
+	 * If the operands have the same sign, then we add the mantissas;
+	 * otherwise, we subtract the mantissas.
+	 */
+	xu += yu - ((yu << 1) & -(uint64_t)(sx ^ sy));
+
+	/*
+	 * The result may be smaller, or slightly larger. We normalize
+	 * it to the 2^63..2^64-1 range (if xu is zero, then it stays
+	 * at zero).
+	 */
+	FPR_NORM64(xu, ex);
+
+	/*
+	 * Scale down the value to 2^54..s^55-1, handling the last bit
+	 * as sticky.
+	 */
+	xu |= ((uint32_t)xu & 0x1FF) + 0x1FF;
+	xu >>= 9;
+	ex += 9;
+
+	/*
+	 * In general, the result has the sign of x. However, if the
+	 * result is exactly zero, then the following situations may
+	 * be encountered:
+	 *   x > 0, y = -x   -> result should be +0
+	 *   x < 0, y = -x   -> result should be +0
+	 *   x = +0, y = +0  -> result should be +0
+	 *   x = -0, y = +0  -> result should be +0
+	 *   x = +0, y = -0  -> result should be +0
+	 *   x = -0, y = -0  -> result should be -0
+	 *
+	 * But at the conditional swap step at the start of the
+	 * function, we ensured that if abs(x) = abs(y) and the
+	 * sign of x was 1, then x and y were swapped. Thus, the
+	 * two following cases cannot actually happen:
+	 *   x < 0, y = -x
+	 *   x = -0, y = +0
+	 * In all other cases, the sign bit of x is conserved, which
+	 * is what the FPR() function does. The FPR() function also
+	 * properly clamps values to zero when the exponent is too
+	 * low, but does not alter the sign in that case.
+	 */
+	return FPR(sx, ex, xu);
+}
+
+FPREMU_FN fpr
+fpr_mul(fpr x, fpr y)
+{
+	uint64_t xu, yu, w, zu, zv;
+	uint32_t x0, x1, y0, y1, z0, z1, z2;
+	int ex, ey, d, e, s;
+
+	/*
+	 * Extract absolute values as scaled unsigned integers. We
+	 * don't extract exponents yet.
+	 */
+	xu = (x & (((uint64_t)1 << 52) - 1)) | ((uint64_t)1 << 52);
+	yu = (y & (((uint64_t)1 << 52) - 1)) | ((uint64_t)1 << 52);
+
+	/*
+	 * We have two 53-bit integers to multiply; we need to split
+	 * each into a lower half and a upper half. Moreover, we
+	 * prefer to have lower halves to be of 25 bits each, for
+	 * reasons explained later on.
+	 */
+	x0 = (uint32_t)xu & 0x01FFFFFF;
+	x1 = (uint32_t)(xu >> 25);
+	y0 = (uint32_t)yu & 0x01FFFFFF;
+	y1 = (uint32_t)(yu >> 25);
+	w = (uint64_t)x0 * (uint64_t)y0;
+	z0 = (uint32_t)w & 0x01FFFFFF;
+	z1 = (uint32_t)(w >> 25);
+	w = (uint64_t)x0 * (uint64_t)y1;
+	z1 += (uint32_t)w & 0x01FFFFFF;
+	z2 = (uint32_t)(w >> 25);
+	w = (uint64_t)x1 * (uint64_t)y0;
+	z1 += (uint32_t)w & 0x01FFFFFF;
+	z2 += (uint32_t)(w >> 25);
+	zu = (uint64_t)x1 * (uint64_t)y1;
+	z2 += (z1 >> 25);
+	z1 &= 0x01FFFFFF;
+	zu += z2;
+
+	/*
+	 * Since xu and yu are both in the 2^52..2^53-1 range, the
+	 * product is in the 2^104..2^106-1 range. We first reassemble
+	 * it and round it into the 2^54..2^56-1 range; the bottom bit
+	 * is made "sticky". Since the low limbs z0 and z1 are 25 bits
+	 * each, we just take the upper part (zu), and consider z0 and
+	 * z1 only for purposes of stickiness.
+	 * (This is the reason why we chose 25-bit limbs above.)
+	 */
+	zu |= ((z0 | z1) + 0x01FFFFFF) >> 25;
+
+	/*
+	 * We normalize zu to the 2^54..s^55-1 range: it could be one
+	 * bit too large at this point. This is done with a conditional
+	 * right-shift that takes into account the sticky bit.
+	 */
+	zv = (zu >> 1) | (zu & 1);
+	w = zu >> 55;
+	zu ^= (zu ^ zv) & -w;
+
+	/*
+	 * Get the aggregate scaling factor:
+	 *
+	 *   - Each exponent is biased by 1023.
+	 *
+	 *   - Integral mantissas are scaled by 2^52, hence an
+	 *     extra 52 bias for each exponent.
+	 *
+	 *   - However, we right-shifted z by 50 bits, and then
+	 *     by 0 or 1 extra bit (depending on the value of w).
+	 *
+	 * In total, we must add the exponents, then subtract
+	 * 2 * (1023 + 52), then add 50 + w.
+	 */
+	ex = (int)((x >> 52) & 0x7FF);
+	ey = (int)((y >> 52) & 0x7FF);
+	e = ex + ey - 2100 + (int)w;
+
+	/*
+	 * Sign bit is the XOR of the operand sign bits.
+	 */
+	s = (int)((x ^ y) >> 63);
+
+	/*
+	 * Corrective actions for zeros: if either of the operands is
+	 * zero, then the computations above were wrong. Test for zero
+	 * is whether ex or ey is zero. We just have to set the mantissa
+	 * (zu) to zero, the FPR() function will normalize e.
+	 */
+	d = ((ex + 0x7FF) & (ey + 0x7FF)) >> 11;
+	zu &= -(uint64_t)d;
+
+	/*
+	 * FPR() packs the result and applies proper rounding.
+	 */
+	return FPR(s, e, zu);
+}
+
+FPREMU_FN fpr
+fpr_div(fpr x, fpr y)
+{
+	uint64_t xu, yu, q, q2, w;
+	int i, ex, ey, e, d, s;
+
+	/*
+	 * Extract mantissas of x and y (unsigned).
+	 */
+	xu = (x & (((uint64_t)1 << 52) - 1)) | ((uint64_t)1 << 52);
+	yu = (y & (((uint64_t)1 << 52) - 1)) | ((uint64_t)1 << 52);
+
+	/*
+	 * Perform bit-by-bit division of xu by yu. We run it for 55 bits.
+	 */
+	q = 0;
+	for (i = 0; i < 55; i ++) {
+		/*
+		 * If yu is less than or equal xu, then subtract it and
+		 * push a 1 in the quotient; otherwise, leave xu unchanged
+		 * and push a 0.
+		 */
+		uint64_t b;
+
+		b = ((xu - yu) >> 63) - 1;
+		xu -= b & yu;
+		q |= b & 1;
+		xu <<= 1;
+		q <<= 1;
+	}
+
+	/*
+	 * We got 55 bits in the quotient, followed by an extra zero. We
+	 * want that 56th bit to be "sticky": it should be a 1 if and
+	 * only if the remainder (xu) is non-zero.
+	 */
+	q |= (xu | -xu) >> 63;
+
+	/*
+	 * Quotient is at most 2^56-1. Its top bit may be zero, but in
+	 * that case the next-to-top bit will be a one, since the
+	 * initial xu and yu were both in the 2^52..2^53-1 range.
+	 * We perform a conditional shift to normalize q to the
+	 * 2^54..2^55-1 range (with the bottom bit being sticky).
+	 */
+	q2 = (q >> 1) | (q & 1);
+	w = q >> 55;
+	q ^= (q ^ q2) & -w;
+
+	/*
+	 * Extract exponents to compute the scaling factor:
+	 *
+	 *   - Each exponent is biased and we scaled them up by
+	 *     52 bits; but these biases will cancel out.
+	 *
+	 *   - The division loop produced a 55-bit shifted result,
+	 *     so we must scale it down by 55 bits.
+	 *
+	 *   - If w = 1, we right-shifted the integer by 1 bit,
+	 *     hence we must add 1 to the scaling.
+	 */
+	ex = (int)((x >> 52) & 0x7FF);
+	ey = (int)((y >> 52) & 0x7FF);
+	e = ex - ey - 55 + (int)w;
+
+	/*
+	 * Sign is the XOR of the signs of the operands.
+	 */
+	s = (int)((x ^ y) >> 63);
+
+	/*
+	 * Corrective actions for zeros: if x = 0, then the computation
+	 * is wrong, and we must clamp e and q to 0. We do not care
+	 * about the case y = 0 (as per assumptions in this module,
+	 * the caller does not perform divisions by zero).
+	 */
+	d = (ex + 0x7FF) >> 11;
+	s &= d;
+	e &= -d;
+	q &= -(uint64_t)d;
+
+	/*
+	 * FPR() packs the result and applies proper rounding.
+	 */
+	return FPR(s, e, q);
+}
+
+FPREMU_FN fpr
+fpr_sqrt(fpr x)
+{
+	uint64_t xu, q, s, r;
+	int ex, e;
+
+	/*
+	 * Extract the mantissa and the exponent. We don't care about
+	 * the sign: by assumption, the operand is nonnegative.
+	 * We want the "true" exponent corresponding to a mantissa
+	 * in the 1..2 range.
+	 */
+	xu = (x & (((uint64_t)1 << 52) - 1)) | ((uint64_t)1 << 52);
+	ex = (int)((x >> 52) & 0x7FF);
+	e = ex - 1023;
+
+	/*
+	 * If the exponent is odd, double the mantissa and decrement
+	 * the exponent. The exponent is then halved to account for
+	 * the square root.
+	 */
+	xu += xu & -(uint64_t)(e & 1);
+	e >>= 1;
+
+	/*
+	 * Double the mantissa.
+	 */
+	xu <<= 1;
+
+	/*
+	 * We now have a mantissa in the 2^53..2^55-1 range. It
+	 * represents a value between 1 (inclusive) and 4 (exclusive)
+	 * in fixed point notation (with 53 fractional bits). We
+	 * compute the square root bit by bit.
+	 */
+	q = 0;
+	s = 0;
+	r = (uint64_t)1 << 53;
+	for (int i = 0; i < 54; i ++) {
+		uint64_t t, b;
+
+		t = s + r;
+		b = ((xu - t) >> 63) - 1;
+		s += (r << 1) & b;
+		xu -= t & b;
+		q += r & b;
+		xu <<= 1;
+		r >>= 1;
+	}
+
+	/*
+	 * Now, q is a rounded-low 54-bit value, with a leading 1,
+	 * 52 fractional digits, and an additional guard bit. We add
+	 * an extra sticky bit to account for what remains of the operand.
+	 */
+	q <<= 1;
+	q |= (xu | -xu) >> 63;
+
+	/*
+	 * Result q is in the 2^54..2^55-1 range; we bias the exponent
+	 * by 54 bits (the value e at that point contains the "true"
+	 * exponent, but q is now considered an integer, i.e. scaled
+	 * up.
+	 */
+	e -= 54;
+
+	/*
+	 * Corrective action for an operand of value zero.
+	 */
+	q &= -(uint64_t)((ex + 0x7FF) >> 11);
+
+	/*
+	 * Apply rounding and back result.
+	 */
+	return FPR(0, e, q);
+}
+
+#endif
+
+#endif
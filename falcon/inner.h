@@ -280,6 +280,56 @@
 #ifndef FALCON_KG_CHACHA20
 #define FALCON_KG_CHACHA20   0
 #endif
+#ifndef FALCON_AVX2_RUNTIME
+#if (defined __x86_64__ || defined __i386__) \
+	&& (defined __GNUC__ || defined __clang__)
+#define FALCON_AVX2_RUNTIME   1
+#else
+#define FALCON_AVX2_RUNTIME   0
+#endif
+#endif
+#ifndef FALCON_THREADS
+#if defined __unix__ || defined __APPLE__
+#define FALCON_THREADS   1
+#else
+#define FALCON_THREADS   0
+#endif
+#endif
+#ifndef FALCON_KG_CACHE
+#if (defined __GNUC__ || defined __clang__) || !FALCON_THREADS
+#define FALCON_KG_CACHE   1
+#else
+#define FALCON_KG_CACHE   0
+#endif
+#endif
+#if !defined FALCON_FPEMU_INLINE || FALCON_ASM_CORTEXM4
+#undef FALCON_FPEMU_INLINE
+#define FALCON_FPEMU_INLINE   0
+#endif
+#ifndef FALCON_SAMPLER_STATS
+#define FALCON_SAMPLER_STATS   0
+#endif
+#ifndef FALCON_PRNG_BLOCKS
+#define FALCON_PRNG_BLOCKS   4
+#endif
+#if FALCON_PRNG_BLOCKS < 1
+#error FALCON_PRNG_BLOCKS must be at least 1
+#endif
+#ifndef FALCON_FP_DISPATCH
+#if FALCON_FPEMU && (defined __x86_64__ || defined __aarch64__) \
+	&& (defined __GNUC__ || defined __clang__)
+#define FALCON_FP_DISPATCH   1
+#else
+#define FALCON_FP_DISPATCH   0
+#endif
+#elif !FALCON_FPEMU
+/* Dispatch is meaningful only when the default code is emulated. */
+#undef FALCON_FP_DISPATCH
+#define FALCON_FP_DISPATCH   0
+#endif
+#ifndef FALCON_FPNATIVE_EXACT
+#define FALCON_FPNATIVE_EXACT   0
+#endif
 // yyyNIST- yyyPQCLEAN-
 
 // yyyPQCLEAN+0 yyySUPERCOP+0
@@ -293,6 +343,15 @@
 #define Zf(name)             Zf_(FALCON_PREFIX, name)
 #define Zf_(prefix, name)    Zf__(prefix, name)
 #define Zf__(prefix, name)   prefix ## _ ## name  
+
+/*
+ * Symbol prefix for the native floating-point copy of the code, when
+ * FALCON_FP_DISPATCH is enabled (see fpnative.c).
+ */
+#ifndef FALCON_FPNATIVE_PREFIX
+#define FALCON_FPNATIVE_PREFIX   falcon_inner_fpnative
+#endif
+#define Zf_native(name)      Zf_(FALCON_FPNATIVE_PREFIX, name)
 // yyyPQCLEAN- yyySUPERCOP-
 
 // yyyAVX2+1
@@ -307,6 +366,48 @@
 #endif
 // yyyAVX2-
 
+/*
+ * Functions tagged with TARGET_AVX2_RUNTIME are compiled for AVX2 even
+ * when the rest of the code is not; they must only be called after
+ * cpu_has_avx2() returned 1. This is used only for integer code, which
+ * is bit-exact with the portable implementation (see config.h).
+ */
+#if FALCON_AVX2_RUNTIME
+#include <immintrin.h>
+#define TARGET_AVX2_RUNTIME   __attribute__((target("avx2")))
+#define TARGET_AVX512_RUNTIME   \
+	__attribute__((target("avx2,avx512f,avx512vl")))
+
+static inline int
+cpu_has_avx2(void)
+{
+	return __builtin_cpu_supports("avx2");
+}
+
+static inline int
+cpu_has_avx512vl(void)
+{
+	return __builtin_cpu_supports("avx2")
+		&& __builtin_cpu_supports("avx512f")
+		&& __builtin_cpu_supports("avx512vl");
+}
+#else
+#define TARGET_AVX2_RUNTIME
+#define TARGET_AVX512_RUNTIME
+
+static inline int
+cpu_has_avx2(void)
+{
+	return 0;
+}
+
+static inline int
+cpu_has_avx512vl(void)
+{
+	return 0;
+}
+#endif
+
 /*
  * Some computations with floating-point elements, in particular
  * rounding to the nearest integer, rely on operations using _exactly_
@@ -424,6 +525,7 @@ typedef struct {
 #define inner_shake256_inject    Zf(i_shake256_inject)
 #define inner_shake256_flip      Zf(i_shake256_flip)
 #define inner_shake256_extract   Zf(i_shake256_extract)
+#define inner_shake256_extract_x4  Zf(i_shake256_extract_x4)
 
 void Zf(i_shake256_init)(
 	inner_shake256_context *sc);
@@ -434,6 +536,17 @@ void Zf(i_shake256_flip)(
 void Zf(i_shake256_extract)(
 	inner_shake256_context *sc, uint8_t *out, size_t len);
 
+/*
+ * Extract len bytes from each of the four contexts sc[0..3] (which
+ * must all be flipped). Output for context i is written at
+ * out + i*len. When all four contexts are at the same output position
+ * (e.g. right after flipping), their Keccak states are permuted
+ * together (four-way AVX2, or two-way interleaved portable code);
+ * the output is identical to four calls to inner_shake256_extract().
+ */
+void Zf(i_shake256_extract_x4)(
+	inner_shake256_context *sc, uint8_t *out, size_t len);
+
 /*
 // yyyPQCLEAN+1
 
@@ -485,7 +598,9 @@ void Zf(i_shake256_extract)(
  *
  *   - comp: variable-length encoding for signed integers; each integer
  *     uses a minimum of 9 bits, possibly more. This is normally used
- *     only for signatures.
+ *     only for signatures. Each integer must be in the -2047..+2047
+ *     range; the decoder rejects "-0", and non-zero unused bits in the
+ *     last byte.
  *
  */
 
@@ -536,6 +651,18 @@ extern const uint8_t Zf(max_sig_bits)[];
 void Zf(hash_to_point_vartime)(inner_shake256_context *sc,
 	uint16_t *x, unsigned logn);
 
+/*
+ * Same as Zf(hash_to_point_vartime)(), but for four SHAKE256 contexts
+ * at once (sc[0..3], all flipped and at the same output position). The
+ * point for context i is written in x[i*2^logn .. (i+1)*2^logn-1].
+ * The SHAKE256 outputs are squeezed in parallel, by whole blocks; the
+ * points are identical to those of four calls to
+ * Zf(hash_to_point_vartime)(), but the contexts may end up at a later
+ * output position.
+ */
+void Zf(hash_to_point_vartime_x4)(inner_shake256_context *sc,
+	uint16_t *x, unsigned logn);
+
 /*
  * From a SHAKE256 context (must be already flipped), produce a new
  * point. The temporary buffer (tmp) must have room for 2*2^logn bytes.
@@ -547,6 +674,18 @@ void Zf(hash_to_point_vartime)(inner_shake256_context *sc,
 void Zf(hash_to_point_ct)(inner_shake256_context *sc,
 	uint16_t *x, unsigned logn, uint8_t *tmp);
 
+/*
+ * Same as Zf(hash_to_point_ct)(), but for four SHAKE256 contexts at
+ * once (sc[0..3], all flipped and at the same output position). The
+ * point for context i is written in x[i*2^logn .. (i+1)*2^logn-1].
+ * The output is identical to four calls to Zf(hash_to_point_ct)();
+ * the SHAKE256 outputs are squeezed in parallel.
+ * The temporary buffer (tmp) must have room for 8*2^logn bytes.
+ * tmp[] must have 16-bit alignment.
+ */
+void Zf(hash_to_point_x4)(inner_shake256_context *sc,
+	uint16_t *x, unsigned logn, uint8_t *tmp);
+
 /*
  * Tell whether a given vector (2N coordinates, in two halves) is
  * acceptable as a signature. This compares the appropriate norm of the
@@ -567,6 +706,15 @@ int Zf(is_short)(const int16_t *s1, const int16_t *s2, unsigned logn);
  */
 int Zf(is_short_half)(uint32_t sqn, const int16_t *s2, unsigned logn);
 
+/*
+ * Same as Zf(is_short_half)(), but also write into *sqnorm (if sqnorm
+ * is not NULL) the "saturated squared norm" of the whole vector, i.e.
+ * the sum of the squares of the coordinates of s1 and s2 (saturated at
+ * 2^32-1 if the sum exceeds 2^31-1), which is compared with the bound.
+ */
+int Zf(is_short_half_norm)(uint32_t sqn, const int16_t *s2,
+	unsigned logn, uint32_t *sqnorm);
+
 /* ==================================================================== */
 /*
  * Signature verification functions (vrfy.c).
@@ -784,12 +932,18 @@ int Zf(get_seed)(void *seed, size_t seed_len);
  * get generated in advance. The 'state' is used to keep the current
  * PRNG algorithm state (contents depend on the selected algorithm).
  *
+ * The buffer consists of FALCON_PRNG_BLOCKS blocks of 512 bytes. Values
+ * are extracted as if the buffer was a single block refilled on demand:
+ * a 64-bit value never straddles two blocks (prng_get_u64() skips to the
+ * next block instead), and the whole buffer is refilled when the last
+ * block is exhausted.
+ *
  * The unions with 'dummy_u64' are there to ensure proper alignment for
  * 64-bit direct access.
  */
 typedef struct {
 	union {
-		uint8_t d[512]; /* MUST be 512, exactly */
+		uint8_t d[512 * FALCON_PRNG_BLOCKS];
 		uint64_t dummy_u64;
 	} buf;
 	size_t ptr;
@@ -812,30 +966,83 @@ void Zf(prng_init)(prng *p, inner_shake256_context *src);
  */
 void Zf(prng_refill)(prng *p);
 
+/*
+ * Implementations of the ChaCha20 core used by prng_refill(). They all
+ * produce the same output (eight interleaved ChaCha20 instances per
+ * 512-byte block):
+ *   PRNG_REFILL_PORTABLE   plain C, four instances at a time
+ *   PRNG_REFILL_AVX2       eight instances in AVX2 registers
+ *   PRNG_REFILL_AVX512     sixteen instances (two blocks) in AVX-512
+ *                          registers, with the AVX-512 rotations
+ * With FALCON_AVX2_RUNTIME, prng_refill() uses the fastest implementation
+ * that the CPU supports and that produces the same output as the
+ * portable code on first use; prng_refill_selected() returns it.
+ * prng_refill_using() refills with the specified implementation; it
+ * returns 1 on success, or 0 if that implementation is not available
+ * (the buffer is then unchanged). These two functions are exported for
+ * tests.
+ */
+#define PRNG_REFILL_PORTABLE   0
+#define PRNG_REFILL_AVX2       1
+#define PRNG_REFILL_AVX512     2
+int Zf(prng_refill_selected)(void);
+int Zf(prng_refill_using)(prng *p, int impl);
+
 /*
  * Get some bytes from a PRNG.
  */
 void Zf(prng_get_bytes)(prng *p, void *dst, size_t len);
 
 /*
- * Get a 64-bit random value from a PRNG.
+ * Offset within a 512-byte block from which a 64-bit value is taken
+ * from the next block instead (less than 9 bytes remain).
  */
-static inline uint64_t
-prng_get_u64(prng *p)
+#define PRNG_U64_LIMIT   503
+
+/*
+ * Get the offset in the PRNG buffer of the next 64-bit value, without
+ * consuming it. If there are less than 9 bytes in the current 512-byte
+ * block, we move to the next one, and refill the buffer if that was
+ * the last block. This means that we may drop the last few bytes, but
+ * this allows for faster extraction code. Also, it means that we never
+ * leave an empty buffer. The move is branchless; the refill test is
+ * taken once per buffer.
+ */
+static inline size_t
+prng_next_u64_pos(prng *p)
 {
 	size_t u;
 
-	/*
-	 * If there are less than 9 bytes in the buffer, we refill it.
-	 * This means that we may drop the last few bytes, but this allows
-	 * for faster extraction code. Also, it means that we never leave
-	 * an empty buffer.
-	 */
 	u = p->ptr;
-	if (u >= (sizeof p->buf.d) - 9) {
+	u += (512 - (u & 511)) & -(size_t)((u & 511) >= PRNG_U64_LIMIT);
+	if (u == sizeof p->buf.d) {
 		Zf(prng_refill)(p);
 		u = 0;
 	}
+	return u;
+}
+
+/*
+ * Number of successive 9-byte samples (a 64-bit value then a byte, as
+ * read by the base sampler) that may be read from offset u, as
+ * returned by prng_next_u64_pos(), before the next one has to move to
+ * the next block.
+ */
+static inline size_t
+prng_u72_run(size_t u)
+{
+	return (PRNG_U64_LIMIT - (u & 511) + 8) / 9;
+}
+
+/*
+ * Get a 64-bit random value from a PRNG.
+ */
+static inline uint64_t
+prng_get_u64(prng *p)
+{
+	size_t u;
+
+	u = prng_next_u64_pos(p);
 	p->ptr = u + 8;
 
 	/*
@@ -993,6 +1200,41 @@ void Zf(poly_mul_autoadj_fft)(fpr *restrict a,
 void Zf(poly_div_autoadj_fft)(fpr *restrict a,
 	const fpr *restrict b, unsigned logn);
 
+/*
+ * Compute the Gram matrix G = B*adj(B) of the basis
+ * B = [[b00, b01], [b10, b11]] (FFT representation):
+ *   g00 = b00*adj(b00) + b01*adj(b01)
+ *   g01 = b00*adj(b10) + b01*adj(b11)
+ *   g11 = b10*adj(b10) + b11*adj(b11)
+ * (g10 = adj(g01) is not computed). This is a single pass over the
+ * inputs, with the same results as the corresponding sequence of
+ * poly_mulselfadj_fft(), poly_muladj_fft() and poly_add() calls. Each
+ * output array may be equal to one of the input arrays, but may not
+ * overlap it partially.
+ */
+void Zf(poly_gram_fft)(fpr *g00, fpr *g01, fpr *g11,
+	const fpr *b00, const fpr *b01, const fpr *b10, const fpr *b11,
+	unsigned logn);
+
+/*
+ * Apply the basis to the target vector [t0, 0], with scaling by x: set
+ * t1 to -x*t0*b01 and t0 to x*t0*b11 (FFT representation), in a single
+ * pass. The results are identical to those of poly_mul_fft() and
+ * poly_mulconst(). Arrays MUST NOT overlap.
+ */
+void Zf(poly_target_fft)(fpr *restrict t0, fpr *restrict t1,
+	const fpr *restrict b01, const fpr *restrict b11, fpr x, unsigned logn);
+
+/*
+ * Multiply the vector [t0, t1] by the basis B = [[b00, b01], [b10, b11]]
+ * (FFT representation): d0 = t0*b00 + t1*b10 and d1 = t1*b11 + t0*b01,
+ * in a single pass. d0 and d1 may be equal to t0 and t1 (respectively,
+ * or the other way round), but may not overlap them partially.
+ */
+void Zf(poly_apply_basis_fft)(fpr *d0, fpr *d1, const fpr *t0, const fpr *t1,
+	const fpr *b00, const fpr *b01, const fpr *b10, const fpr *b11,
+	unsigned logn);
+
 /*
  * Perform an LDL decomposition of an auto-adjoint matrix G, in FFT
  * representation. On input, g00, g01 and g11 are provided (where the
@@ -1075,6 +1317,37 @@ void Zf(new_keygen)(inner_shake256_context *rng,
 	int8_t *f, int8_t *g, int8_t *F, int8_t *G, uint16_t *h,
 	unsigned logn, uint8_t *tmp);
 
+/*
+ * Task pool for the multi-threaded NTRU solver. run(ctx, task, arg,
+ * count) must call task(arg, i) exactly once for each i in 0..count-1,
+ * possibly concurrently, and return only when all calls have completed
+ * (this is the contract of falcon_thread_pool, see falcon.h). There
+ * are 'count' scratch areas of 'scratch_len' 32-bit words each,
+ * starting at 'scratch'; task i uses area i. scratch_len must be at
+ * least FALCON_KEYGEN_POOL_SCRATCH(logn).
+ */
+typedef struct {
+	void (*run)(void *ctx, void (*task)(void *arg, unsigned idx),
+		void *arg, unsigned count);
+	void *ctx;
+	unsigned count;
+	uint32_t *scratch;
+	size_t scratch_len;
+} keygen_pool;
+
+#define FALCON_KEYGEN_POOL_SCRATCH(logn)   ((size_t)5 << (logn))
+
+/*
+ * Same as new_keygen(), except that the loops over the small primes
+ * in the NTRU solver are spread over the tasks of kp. The generated
+ * key pair is the same as with new_keygen() (for the same rng state),
+ * regardless of the number of tasks and of their scheduling. If kp is
+ * NULL, then this is new_keygen().
+ */
+void Zf(new_keygen_pool)(inner_shake256_context *rng,
+	int8_t *f, int8_t *g, int8_t *F, int8_t *G, uint16_t *h,
+	unsigned logn, uint8_t *tmp, const keygen_pool *kp);
+
 /* ==================================================================== */
 /*
  * Signature generation.
@@ -1135,6 +1408,76 @@ void Zf(sign_dyn)(int16_t *sig, inner_shake256_context *rng,
 	const int8_t *restrict F, const int8_t *restrict G,
 	const uint16_t *hm, unsigned logn, uint8_t *tmp);
 
+/*
+ * Same as Zf(sign_tree)() and Zf(sign_dyn)(), but also write the
+ * squared norm of the aggregate vector (s1,s2), as computed by the
+ * signer for its acceptance test, into *sqnorm (if sqnorm is not NULL).
+ */
+void Zf(sign_tree_norm)(int16_t *sig, uint32_t *sqnorm,
+	inner_shake256_context *rng,
+	const fpr *restrict expanded_key,
+	const uint16_t *hm, unsigned logn, uint8_t *tmp);
+void Zf(sign_dyn_norm)(int16_t *sig, uint32_t *sqnorm,
+	inner_shake256_context *rng,
+	const int8_t *restrict f, const int8_t *restrict g,
+	const int8_t *restrict F, const int8_t *restrict G,
+	const uint16_t *hm, unsigned logn, uint8_t *tmp);
+
+/*
+ * Same as falcon_sign_dyn_finish() and falcon_sign_tree_finish() (see
+ * falcon.h), but also write the squared norm of the signature vector
+ * (s1,s2) into *sqnorm (if sqnorm is not NULL). The rng and hash_data
+ * contexts are the shake256_context structures of the public API
+ * (which use the same layout as inner_shake256_context). These are
+ * used by the deterministic mode.
+ */
+int Zf(sign_dyn_finish_norm)(inner_shake256_context *rng,
+	void *sig, size_t *sig_len, int sig_type, uint32_t *sqnorm,
+	const void *privkey, size_t privkey_len,
+	inner_shake256_context *hash_data, const void *nonce,
+	void *tmp, size_t tmp_len);
+int Zf(sign_tree_finish_norm)(inner_shake256_context *rng,
+	void *sig, size_t *sig_len, int sig_type, uint32_t *sqnorm,
+	const void *expanded_key,
+	inner_shake256_context *hash_data, const void *nonce,
+	void *tmp, size_t tmp_len);
+
+/*
+ * Table of the functions that use floating-point, used by falcon.c to
+ * switch at runtime between the emulated and native implementations
+ * (FALCON_FP_DISPATCH). The expanded key is an opaque array of fpr
+ * values, whose representation is the same (64-bit words in native
+ * byte order) in both implementations. Zf(fp_backend) contains the
+ * functions of the current compilation unit; with FALCON_FP_DISPATCH,
+ * Zf_native(fp_backend) is the copy compiled with native
+ * floating-point.
+ */
+typedef struct {
+	void (*keygen)(inner_shake256_context *rng,
+		int8_t *f, int8_t *g, int8_t *F, int8_t *G, uint16_t *h,
+		unsigned logn, uint8_t *tmp);
+	void (*keygen_pool)(inner_shake256_context *rng,
+		int8_t *f, int8_t *g, int8_t *F, int8_t *G, uint16_t *h,
+		unsigned logn, uint8_t *tmp, const keygen_pool *kp);
+	void (*expand_privkey)(void *expanded_key,
+		const int8_t *f, const int8_t *g,
+		const int8_t *F, const int8_t *G,
+		unsigned logn, uint8_t *tmp);
+	void (*sign_dyn_norm)(int16_t *sig, uint32_t *sqnorm,
+		inner_shake256_context *rng,
+		const int8_t *restrict f, const int8_t *restrict g,
+		const int8_t *restrict F, const int8_t *restrict G,
+		const uint16_t *hm, unsigned logn, uint8_t *tmp);
+	void (*sign_tree_norm)(int16_t *sig, uint32_t *sqnorm,
+		inner_shake256_context *rng, const void *expanded_key,
+		const uint16_t *hm, unsigned logn, uint8_t *tmp);
+} fp_backend;
+
+extern const fp_backend Zf(fp_backend);
+#if FALCON_FP_DISPATCH
+extern const fp_backend Zf_native(fp_backend);
+#endif
+
 /*
  * Internal sampler engine. Exported for tests.
  *
@@ -1151,12 +1494,37 @@ void Zf(sign_dyn)(int16_t *sig, inner_shake256_context *rng,
  * gaussian0_sampler() takes as parameter a pointer to a PRNG, and
  * returns an integer sampled along a half-Gaussian with standard
  * deviation sigma0 = 1.8205 (center is 0, returned value is
- * nonnegative).
+ * nonnegative). gaussian0_sampler_batch() sets z[i] to the output of
+ * the i-th of num successive calls to gaussian0_sampler(), with the
+ * same PRNG consumption; the 72-bit values for all samples that fit in
+ * the current PRNG buffer are compared with the table together.
+ *
+ * With FALCON_SAMPLER_STATS, the sampler context counts the work done
+ * by new_sampler(); the rejection rate of the
+ * base sampler is base_rejected / base_draws, and the acceptance rate
+ * of SamplerZ is accepted / candidates. The counters are not reset by
+ * the sampler functions. sign_tree_norm() and sign_dyn_norm() call
+ * sampler_stats_hook (if not NULL) with the counters of each signing
+ * attempt, including rejected attempts.
  */
 
+#if FALCON_SAMPLER_STATS
+typedef struct {
+	uint64_t base_draws;
+	uint64_t base_rejected;
+	uint64_t candidates;
+	uint64_t accepted;
+} sampler_stats;
+
+extern void (*Zf(sampler_stats_hook))(const sampler_stats *st);
+#endif
+
 typedef struct {
 	prng p;
 	fpr sigma_min;
+#if FALCON_SAMPLER_STATS
+	sampler_stats stats;
+#endif
 } sampler_context;
 
 TARGET_AVX2
@@ -1168,6 +1536,9 @@ int Zf(sampler)(void *ctx, fpr mu, fpr isigma);
 TARGET_AVX2
 int Zf(gaussian0_sampler)(prng *p);
 
+TARGET_AVX2
+void Zf(gaussian0_sampler_batch)(prng *p, int *z, size_t num);
+
 TARGET_AVX2
 int Zf(new_gaussian0_sampler)(prng *p);
 /*
@@ -1001,6 +1001,277 @@ modp_mkgm2(uint32_t *restrict gm, uint32_t *restrict igm, unsigned logn,
 	}
 }
 
+#if FALCON_AVX2_RUNTIME
+/*
+ * AVX2 implementations of the modular operations, over 8 lanes of 32
+ * bits. Every lane computes exactly what the scalar functions compute
+ * (including the wrap-around of intermediate values), so results are
+ * bit-exact with the portable code.
+ */
+
+/*
+ * Montgomery multiplication over 8 lanes (see modp_montymul()). The
+ * 64-bit products are computed separately for the even and odd lanes.
+ */
+TARGET_AVX2_RUNTIME
+static inline __m256i
+modp_montymul_x8(__m256i a, __m256i b, __m256i p, __m256i p0i)
+{
+	__m256i ze, zo, we, wo, m31, d;
+
+	m31 = _mm256_set1_epi64x(0x7FFFFFFF);
+	ze = _mm256_mul_epu32(a, b);
+	zo = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+	we = _mm256_mul_epu32(_mm256_and_si256(_mm256_mul_epu32(ze, p0i), m31), p);
+	wo = _mm256_mul_epu32(_mm256_and_si256(_mm256_mul_epu32(zo, p0i), m31), p);
+	ze = _mm256_srli_epi64(_mm256_add_epi64(ze, we), 31);
+	zo = _mm256_slli_epi64(_mm256_add_epi64(zo, wo), 1);
+	d = _mm256_blend_epi32(ze, zo, 0xAA);
+	d = _mm256_sub_epi32(d, p);
+	return _mm256_add_epi32(d, _mm256_and_si256(p, _mm256_srai_epi32(d, 31)));
+}
+
+/*
+ * Addition modulo p over 8 lanes (see modp_add()).
+ */
+TARGET_AVX2_RUNTIME
+static inline __m256i
+modp_add_x8(__m256i a, __m256i b, __m256i p)
+{
+	__m256i d;
+
+	d = _mm256_sub_epi32(_mm256_add_epi32(a, b), p);
+	return _mm256_add_epi32(d, _mm256_and_si256(p, _mm256_srai_epi32(d, 31)));
+}
+
+/*
+ * Subtraction modulo p over 8 lanes (see modp_sub()).
+ */
+TARGET_AVX2_RUNTIME
+static inline __m256i
+modp_sub_x8(__m256i a, __m256i b, __m256i p)
+{
+	__m256i d;
+
+	d = _mm256_sub_epi32(a, b);
+	return _mm256_add_epi32(d, _mm256_and_si256(p, _mm256_srai_epi32(d, 31)));
+}
+
+/*
+ * One butterfly over 8 lanes: (x, y) -> (x + y*s, x - y*s) for the
+ * forward NTT, (x, y) -> (x + y, (x - y)*s) for the inverse NTT.
+ */
+TARGET_AVX2_RUNTIME
+static inline void
+modp_bfly_x8(__m256i *x, __m256i *y, __m256i s,
+	__m256i p, __m256i p0i, int inverse)
+{
+	__m256i u, v;
+
+	u = *x;
+	v = *y;
+	if (inverse) {
+		*x = modp_add_x8(u, v, p);
+		*y = modp_montymul_x8(modp_sub_x8(u, v, p), s, p, p0i);
+	} else {
+		v = modp_montymul_x8(v, s, p, p0i);
+		*x = modp_add_x8(u, v, p);
+		*y = modp_sub_x8(u, v, p);
+	}
+}
+
+/*
+ * Apply one layer of butterflies where the two halves of each group
+ * are ht elements apart, and the group twiddle factors are tw[0],
+ * tw[1],... (one per group of 2*ht elements). For ht >= 8, each group
+ * uses a single twiddle factor, broadcast to all lanes. For ht <= 4,
+ * elements are processed by blocks of 16: the two halves of the groups
+ * in the block are gathered into two vectors with in-register shuffles,
+ * and the twiddle factors are laid out to match.
+ */
+TARGET_AVX2_RUNTIME
+static void
+modp_NTT2_layer_avx2(uint32_t *a, size_t n, size_t ht,
+	const uint32_t *tw, __m256i p, __m256i p0i, int inverse)
+{
+	size_t j1, k;
+
+	if (ht >= 8) {
+		for (j1 = 0; j1 < n; j1 += ht << 1, tw ++) {
+			__m256i s;
+			size_t j;
+
+			s = _mm256_set1_epi32((int)*tw);
+			for (j = j1; j < j1 + ht; j += 8) {
+				__m256i x, y;
+
+				x = _mm256_loadu_si256((const __m256i *)(a + j));
+				y = _mm256_loadu_si256(
+					(const __m256i *)(a + j + ht));
+				modp_bfly_x8(&x, &y, s, p, p0i, inverse);
+				_mm256_storeu_si256((__m256i *)(a + j), x);
+				_mm256_storeu_si256((__m256i *)(a + j + ht), y);
+			}
+		}
+		return;
+	}
+
+	for (k = 0; k < n; k += 16, tw += 8 / ht) {
+		__m256i x, y, u, v, s;
+
+		x = _mm256_loadu_si256((const __m256i *)(a + k));
+		y = _mm256_loadu_si256((const __m256i *)(a + k + 8));
+		switch (ht) {
+		case 4:
+			/*
+			 * One group per vector (128-bit halves):
+			 * x = [g0u | g0v], y = [g1u | g1v].
+			 */
+			u = _mm256_permute2x128_si256(x, y, 0x20);
+			v = _mm256_permute2x128_si256(x, y, 0x31);
+			s = _mm256_setr_epi32(
+				(int)tw[0], (int)tw[0], (int)tw[0], (int)tw[0],
+				(int)tw[1], (int)tw[1], (int)tw[1], (int)tw[1]);
+			modp_bfly_x8(&u, &v, s, p, p0i, inverse);
+			x = _mm256_permute2x128_si256(u, v, 0x20);
+			y = _mm256_permute2x128_si256(u, v, 0x31);
+			break;
+		case 2:
+			/*
+			 * x = [g0u g0v | g1u g1v], y = [g2u g2v | g3u g3v]
+			 * (64-bit halves).
+			 */
+			u = _mm256_unpacklo_epi64(x, y);
+			v = _mm256_unpackhi_epi64(x, y);
+			s = _mm256_setr_epi32(
+				(int)tw[0], (int)tw[0], (int)tw[2], (int)tw[2],
+				(int)tw[1], (int)tw[1], (int)tw[3], (int)tw[3]);
+			modp_bfly_x8(&u, &v, s, p, p0i, inverse);
+			x = _mm256_unpacklo_epi64(u, v);
+			y = _mm256_unpackhi_epi64(u, v);
+			break;
+		default:
+			/*
+			 * 32-bit halves; after swapping the two middle
+			 * dwords of each 128-bit lane, x holds
+			 * [g0u g1u g0v g1v | g2u g3u g2v g3v].
+			 */
+			x = _mm256_shuffle_epi32(x, 0xD8);
+			y = _mm256_shuffle_epi32(y, 0xD8);
+			u = _mm256_unpacklo_epi64(x, y);
+			v = _mm256_unpackhi_epi64(x, y);
+			s = _mm256_setr_epi32(
+				(int)tw[0], (int)tw[1], (int)tw[4], (int)tw[5],
+				(int)tw[2], (int)tw[3], (int)tw[6], (int)tw[7]);
+			modp_bfly_x8(&u, &v, s, p, p0i, inverse);
+			x = _mm256_shuffle_epi32(_mm256_unpacklo_epi64(u, v), 0xD8);
+			y = _mm256_shuffle_epi32(_mm256_unpackhi_epi64(u, v), 0xD8);
+			break;
+		}
+		_mm256_storeu_si256((__m256i *)(a + k), x);
+		_mm256_storeu_si256((__m256i *)(a + k + 8), y);
+	}
+}
+
+/*
+ * NTT (inverse = 0) or inverse NTT (inverse = 1) over a polynomial
+ * whose elements are a[0], a[stride], a[2 * stride]... This requires
+ * 4 <= logn <= 10. Non-consecutive elements are first copied into a
+ * local buffer, which is cheaper than computing the butterflies with
+ * strided scalar accesses.
+ */
+TARGET_AVX2_RUNTIME
+static void
+modp_NTT2_avx2(uint32_t *a, size_t stride, const uint32_t *gm,
+	unsigned logn, uint32_t p, uint32_t p0i, int inverse)
+{
+	uint32_t buf[1024];
+	uint32_t *b;
+	size_t n, u;
+	__m256i pp, pp0i;
+
+	n = (size_t)1 << logn;
+	if (stride == 1) {
+		b = a;
+	} else {
+		b = buf;
+		for (u = 0; u < n; u ++) {
+			b[u] = a[u * stride];
+		}
+	}
+	pp = _mm256_set1_epi32((int)p);
+	pp0i = _mm256_set1_epi32((int)p0i);
+	if (inverse) {
+		size_t t, hm;
+		__m256i ni;
+
+		for (t = 1, hm = n >> 1; hm >= 1; t <<= 1, hm >>= 1) {
+			modp_NTT2_layer_avx2(b, n, t, gm + hm, pp, pp0i, 1);
+		}
+
+		/*
+		 * Divide by n, as in modp_iNTT2_ext().
+		 */
+		ni = _mm256_set1_epi32((int)((uint32_t)1 << (31 - logn)));
+		for (u = 0; u < n; u += 8) {
+			__m256i x;
+
+			x = _mm256_loadu_si256((const __m256i *)(b + u));
+			_mm256_storeu_si256((__m256i *)(b + u),
+				modp_montymul_x8(x, ni, pp, pp0i));
+		}
+	} else {
+		size_t m, ht;
+
+		for (m = 1, ht = n >> 1; ht >= 1; m <<= 1, ht >>= 1) {
+			modp_NTT2_layer_avx2(b, n, ht, gm + m, pp, pp0i, 0);
+		}
+	}
+	if (stride != 1) {
+		for (u = 0; u < n; u ++) {
+			a[u * stride] = b[u];
+		}
+	}
+}
+
+/*
+ * See modp_poly_rec_res(); this requires logn >= 4.
+ */
+TARGET_AVX2_RUNTIME
+static void
+modp_poly_rec_res_avx2(uint32_t *f, unsigned logn,
+	uint32_t p, uint32_t p0i, uint32_t R2)
+{
+	size_t hn, u;
+	__m256i pp, pp0i, rr, idx;
+
+	hn = (size_t)1 << (logn - 1);
+	pp = _mm256_set1_epi32((int)p);
+	pp0i = _mm256_set1_epi32((int)p0i);
+	rr = _mm256_set1_epi32((int)R2);
+	idx = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+	for (u = 0; u < hn; u += 8) {
+		__m256i x, y, w0, w1;
+
+		/*
+		 * Even and odd elements of f[2*u..2*u+15] are separated
+		 * into w0 and w1. All loads happen before the store, so
+		 * in-place operation is safe (we write below 2*u).
+		 */
+		x = _mm256_permutevar8x32_epi32(
+			_mm256_loadu_si256((const __m256i *)(f + (u << 1))), idx);
+		y = _mm256_permutevar8x32_epi32(
+			_mm256_loadu_si256((const __m256i *)(f + (u << 1) + 8)),
+			idx);
+		w0 = _mm256_permute2x128_si256(x, y, 0x20);
+		w1 = _mm256_permute2x128_si256(x, y, 0x31);
+		_mm256_storeu_si256((__m256i *)(f + u),
+			modp_montymul_x8(modp_montymul_x8(w0, w1, pp, pp0i),
+			rr, pp, pp0i));
+	}
+}
+#endif
+
 /*
  * Compute the NTT over a polynomial (binary case). Polynomial elements
  * are a[0], a[stride], a[2 * stride]...
@@ -1014,6 +1285,12 @@ modp_NTT2_ext(uint32_t *a, size_t stride, const uint32_t *gm, unsigned logn,
 	if (logn == 0) {
 		return;
 	}
+#if FALCON_AVX2_RUNTIME
+	if (logn >= 4 && cpu_has_avx2()) {
+		modp_NTT2_avx2(a, stride, gm, logn, p, p0i, 0);
+		return;
+	}
+#endif
 	n = (size_t)1 << logn;
 	t = n;
 	for (m = 1; m < n; m <<= 1) {
@@ -1055,6 +1332,12 @@ modp_iNTT2_ext(uint32_t *a, size_t stride, const uint32_t *igm, unsigned logn,
 	if (logn == 0) {
 		return;
 	}
+#if FALCON_AVX2_RUNTIME
+	if (logn >= 4 && cpu_has_avx2()) {
+		modp_NTT2_avx2(a, stride, igm, logn, p, p0i, 1);
+		return;
+	}
+#endif
 	n = (size_t)1 << logn;
 	t = 1;
 	for (m = n; m > 1; m >>= 1) {
@@ -1121,6 +1404,12 @@ modp_poly_rec_res(uint32_t *f, unsigned logn,
 {
 	size_t hn, u;
 
+#if FALCON_AVX2_RUNTIME
+	if (logn >= 4 && cpu_has_avx2()) {
+		modp_poly_rec_res_avx2(f, logn, p, p0i, R2);
+		return;
+	}
+#endif
 	hn = (size_t)1 << (logn - 1);
 	for (u = 0; u < hn; u ++) {
 		uint32_t w0, w1;
@@ -1267,6 +1556,91 @@ zint_mod_small_signed(const uint32_t *d, size_t dlen,
 	return z;
 }
 
+#if FALCON_AVX2_RUNTIME
+/*
+ * AVX2 version of zint_mod_small_unsigned() (sgn = 0) and
+ * zint_mod_small_signed() (sgn = 1), over 8 integers at once: integer
+ * v consists of the dlen words starting at d + v*dstride, and its
+ * residue is written in out[v*ostride]. This requires dlen > 0.
+ */
+TARGET_AVX2_RUNTIME
+static void
+zint_mod_small_x8_avx2(uint32_t *out, size_t ostride,
+	const uint32_t *d, size_t dlen, size_t dstride,
+	uint32_t p, uint32_t p0i, uint32_t R2, uint32_t Rx, int sgn)
+{
+	__m256i pp, pp0i, rr, idx, x;
+	uint32_t z[8];
+	size_t u;
+
+	pp = _mm256_set1_epi32((int)p);
+	pp0i = _mm256_set1_epi32((int)p0i);
+	rr = _mm256_set1_epi32((int)R2);
+	idx = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+		_mm256_set1_epi32((int)dstride));
+	x = _mm256_setzero_si256();
+	u = dlen;
+	while (u -- > 0) {
+		__m256i w;
+
+		x = modp_montymul_x8(x, rr, pp, pp0i);
+		w = _mm256_sub_epi32(
+			_mm256_i32gather_epi32((const int *)(d + u), idx, 4), pp);
+		w = _mm256_add_epi32(w,
+			_mm256_and_si256(pp, _mm256_srai_epi32(w, 31)));
+		x = modp_add_x8(x, w, pp);
+	}
+	if (sgn) {
+		__m256i w;
+
+		w = _mm256_i32gather_epi32(
+			(const int *)(d + dlen - 1), idx, 4);
+		w = _mm256_sub_epi32(_mm256_setzero_si256(),
+			_mm256_srli_epi32(w, 30));
+		x = modp_sub_x8(x,
+			_mm256_and_si256(_mm256_set1_epi32((int)Rx), w), pp);
+	}
+	_mm256_storeu_si256((__m256i *)z, x);
+	for (u = 0; u < 8; u ++) {
+		out[u * ostride] = z[u];
+	}
+}
+#endif
+
+/*
+ * Reduce num big integers modulo p, with zint_mod_small_unsigned()
+ * (sgn = 0) or zint_mod_small_signed() (sgn = 1, Rx = 2^(31*dlen) mod
+ * p): integer v consists of the dlen words starting at d + v*dstride,
+ * and its residue is written in out[v*ostride].
+ */
+static void
+zint_mod_small_batch(uint32_t *out, size_t ostride,
+	const uint32_t *d, size_t dlen, size_t dstride, size_t num,
+	uint32_t p, uint32_t p0i, uint32_t R2, uint32_t Rx, int sgn)
+{
+	size_t v;
+
+	v = 0;
+#if FALCON_AVX2_RUNTIME
+	if (dlen > 0 && cpu_has_avx2()) {
+		for (; v + 8 <= num; v += 8) {
+			zint_mod_small_x8_avx2(out + v * ostride, ostride,
+				d + v * dstride, dlen, dstride,
+				p, p0i, R2, Rx, sgn);
+		}
+	}
+#endif
+	for (; v < num; v ++) {
+		if (sgn) {
+			out[v * ostride] = zint_mod_small_signed(
+				d + v * dstride, dlen, p, p0i, R2, Rx);
+		} else {
+			out[v * ostride] = zint_mod_small_unsigned(
+				d + v * dstride, dlen, p, p0i, R2);
+		}
+	}
+}
+
 /*
  * Add y*s to x. x and y initially have length 'len' words; the new x
  * has length 'len+1' words. 's' must fit on 31 bits. x[] and y[] must
@@ -1379,28 +1753,46 @@ zint_rebuild_CRT(uint32_t *restrict xx, size_t xlen, size_t xstride,
 		 * We call 'q' the product of all previous primes.
 		 */
 		uint32_t p, p0i, s, R2;
-		size_t v;
+		size_t v, k;
 
 		p = primes[u].p;
 		s = primes[u].s;
 		p0i = modp_ninv31(p);
 		R2 = modp_R2(p, p0i);
 
-		for (v = 0, x = xx; v < num; v ++, x += xstride) {
-			uint32_t xp, xq, xr;
-			/*
-			 * xp = the integer x modulo the prime p for this
-			 *      iteration
-			 * xq = (x mod q) mod p
-			 */
-			xp = x[u];
-			xq = zint_mod_small_unsigned(x, u, p, p0i, R2);
+		for (v = 0; v < num; v += k) {
+			uint32_t xq[8];
+			size_t j;
 
 			/*
-			 * New value is (x mod q) + q * (s * (xp - xq) mod p)
+			 * Integers are processed by chunks of 8 so that
+			 * the reductions modulo p may be batched.
+			 * xq[j] = (x mod q) mod p, for the chunk integers.
 			 */
-			xr = modp_montymul(s, modp_sub(xp, xq, p), p, p0i);
-			zint_add_mul_small(x, tmp, u, xr);
+			k = num - v;
+			if (k > 8) {
+				k = 8;
+			}
+			x = xx + v * xstride;
+			zint_mod_small_batch(xq, 1, x, u, xstride, k,
+				p, p0i, R2, 0, 0);
+			for (j = 0; j < k; j ++, x += xstride) {
+				uint32_t xp, xr;
+
+				/*
+				 * xp = the integer x modulo the prime p for
+				 *      this iteration
+				 */
+				xp = x[u];
+
+				/*
+				 * New value is (x mod q)
+				 * + q * (s * (xp - xq) mod p)
+				 */
+				xr = modp_montymul(s,
+					modp_sub(xp, xq[j], p), p, p0i);
+				zint_add_mul_small(x, tmp, u, xr);
+			}
 		}
 
 		/*
@@ -1419,6 +1811,126 @@ zint_rebuild_CRT(uint32_t *restrict xx, size_t xlen, size_t xstride,
 	}
 }
 
+/*
+ * Multi-threaded NTRU solving (see Zf(new_keygen_pool)()). The work
+ * done for each small prime is independent of the other primes: a
+ * kg_job applies fn(arg, u, scratch) to all u in start..end-1, with
+ * the values of u spread over the pool tasks (task i handles u =
+ * start+i, start+i+count,...), and each task using its own scratch
+ * area. Each prime is processed exactly as in the sequential code,
+ * hence the results do not depend on the number of tasks.
+ */
+typedef struct {
+	void (*fn)(void *arg, size_t u, uint32_t *scratch);
+	void *arg;
+	size_t start, end, step;
+	uint32_t *scratch;
+	size_t scratch_len;
+} kg_job;
+
+static void
+kg_task(void *arg, unsigned idx)
+{
+	kg_job *job;
+	uint32_t *scratch;
+	size_t u;
+
+	job = arg;
+	scratch = job->scratch + (size_t)idx * job->scratch_len;
+	for (u = job->start + idx; u < job->end; u += job->step) {
+		job->fn(job->arg, u, scratch);
+	}
+}
+
+/*
+ * Apply fn(arg, u, scratch) for all u in start..end-1. If kp is NULL
+ * or has a single task, then this is done in the calling thread, with
+ * the provided scratch area.
+ */
+static void
+kg_run(const keygen_pool *kp,
+	void (*fn)(void *arg, size_t u, uint32_t *scratch), void *arg,
+	size_t start, size_t end, uint32_t *scratch)
+{
+	kg_job job;
+	size_t u, count;
+
+	count = end - start;
+	if (kp == NULL || kp->count <= 1 || count <= 1) {
+		for (u = start; u < end; u ++) {
+			fn(arg, u, scratch);
+		}
+		return;
+	}
+	if (count > kp->count) {
+		count = kp->count;
+	}
+	job.fn = fn;
+	job.arg = arg;
+	job.start = start;
+	job.end = end;
+	job.step = count;
+	job.scratch = kp->scratch;
+	job.scratch_len = kp->scratch_len;
+	kp->run(kp->ctx, &kg_task, &job, (unsigned)count);
+}
+
+/*
+ * Parameters of kg_rebuild_CRT(); chunk u covers the integers
+ * u*chunk to (u+1)*chunk-1.
+ */
+typedef struct {
+	uint32_t *xx;
+	size_t xlen, xstride, num, chunk;
+	const small_prime *primes;
+	int normalize_signed;
+} kg_rebuild_job;
+
+static void
+kg_rebuild_chunk(void *arg, size_t u, uint32_t *scratch)
+{
+	const kg_rebuild_job *job;
+	size_t v, num;
+
+	job = arg;
+	v = u * job->chunk;
+	num = job->num - v;
+	if (num > job->chunk) {
+		num = job->chunk;
+	}
+	zint_rebuild_CRT(job->xx + v * job->xstride, job->xlen, job->xstride,
+		num, job->primes, job->normalize_signed, scratch);
+}
+
+/*
+ * Same as zint_rebuild_CRT(), with the integers split into chunks
+ * that are processed by the tasks of kp. Each task recomputes the
+ * product of the primes in its own scratch area (xlen words).
+ */
+static void
+kg_rebuild_CRT(const keygen_pool *kp,
+	uint32_t *restrict xx, size_t xlen, size_t xstride,
+	size_t num, const small_prime *primes, int normalize_signed,
+	uint32_t *restrict tmp)
+{
+	kg_rebuild_job job;
+
+	if (kp == NULL || kp->count <= 1 || num < 2) {
+		zint_rebuild_CRT(xx, xlen, xstride, num,
+			primes, normalize_signed, tmp);
+		return;
+	}
+	job.xx = xx;
+	job.xlen = xlen;
+	job.xstride = xstride;
+	job.num = num;
+	job.chunk = (num + kp->count - 1) / kp->count;
+	job.primes = primes;
+	job.normalize_signed = normalize_signed;
+	kg_run(kp, &kg_rebuild_chunk, &job,
+		0, (num + job.chunk - 1) / job.chunk, tmp);
+}
+
 /*
  * Negate a big integer conditionally: value a is replaced with -a if
  * and only if ctl = 1. Control value ctl must be 0 or 1.
@@ -2164,6 +2676,277 @@ poly_sub_scaled(uint32_t *restrict F, size_t Flen, size_t Fstride,
 	}
 }
 
+/*
+ * The MAX_BL_SMALL[] and MAX_BL_LARGE[] contain the lengths, in 31-bit
+ * words, of intermediate values in the computation:
+ *
+ *   MAX_BL_SMALL[depth]: length for the input f and g at that depth
+ *   MAX_BL_LARGE[depth]: length for the unreduced F and G at that depth
+ *
+ * Rules:
+ *
+ *  - Within an array, values grow.
+ *
+ *  - The 'SMALL' array must have an entry for maximum depth, corresponding
+ *    to the size of values used in the binary GCD. There is no such value
+ *    for the 'LARGE' array (the binary GCD yields already reduced
+ *    coefficients).
+ *
+ *  - MAX_BL_LARGE[depth] >= MAX_BL_SMALL[depth + 1].
+ *
+ *  - Values must be large enough to handle the common cases, with some
+ *    margins.
+ *
+ *  - Values must not be "too large" either because we will convert some
+ *    integers into floating-point values by considering the top 10 words,
+ *    i.e. 310 bits; hence, for values of length more than 10 words, we
+ *    should take care to have the length centered on the expected size.
+ *
+ * The following average lengths, in bits, have been measured on thousands
+ * of random keys (fg = max length of the absolute value of coefficients
+ * of f and g at that depth; FG = idem for the unreduced F and G; for the
+ * maximum depth, F and G are the output of binary GCD, multiplied by q;
+ * for each value, the average and standard deviation are provided).
+ *
+ * Binary case:
+ *    depth: 10    fg: 6307.52 (24.48)    FG: 6319.66 (24.51)
+ *    depth:  9    fg: 3138.35 (12.25)    FG: 9403.29 (27.55)
+ *    depth:  8    fg: 1576.87 ( 7.49)    FG: 4703.30 (14.77)
+ *    depth:  7    fg:  794.17 ( 4.98)    FG: 2361.84 ( 9.31)
+ *    depth:  6    fg:  400.67 ( 3.10)    FG: 1188.68 ( 6.04)
+ *    depth:  5    fg:  202.22 ( 1.87)    FG:  599.81 ( 3.87)
+ *    depth:  4    fg:  101.62 ( 1.02)    FG:  303.49 ( 2.38)
+ *    depth:  3    fg:   50.37 ( 0.53)    FG:  153.65 ( 1.39)
+ *    depth:  2    fg:   24.07 ( 0.25)    FG:   78.20 ( 0.73)
+ *    depth:  1    fg:   10.99 ( 0.08)    FG:   39.82 ( 0.41)
+ *    depth:  0    fg:    4.00 ( 0.00)    FG:   19.61 ( 0.49)
+ *
+ * Integers are actually represented either in binary notation over
+ * 31-bit words (signed, using two's complement), or in RNS, modulo
+ * many small primes. These small primes are close to, but slightly
+ * lower than, 2^31. Use of RNS loses less than two bits, even for
+ * the largest values.
+ *
+ * IMPORTANT: if these values are modified, then the temporary buffer
+ * sizes (FALCON_KEYGEN_TEMP_*, in inner.h) must be recomputed
+ * accordingly.
+ */
+
+static const size_t MAX_BL_SMALL[] = {
+	1, 1, 2, 2, 4, 7, 14, 27, 53, 106, 209
+};
+
+static const size_t MAX_BL_LARGE[] = {
+	2, 2, 5, 7, 12, 21, 40, 78, 157, 308
+};
+
+/*
+ * Per-prime constants (p0i, R2) and NTT tables (see modp_mkgm2()) for
+ * the NTRU solver. With FALCON_KG_CACHE, they are computed once and
+ * kept in a process-wide cache, which is filled lazily and never
+ * modified afterwards.
+ *
+ * The table for a degree 2^logn is the first 2^logn elements of the
+ * table for any larger degree (since the bit-reversal function is
+ * over 10 bits in both cases). Prime PRIMES[u] is used at degree
+ * 2^(10-d) at most, where d is the lowest depth such that u is lower
+ * than MAX_BL_LARGE[d]; the cache keeps tables of that size, which
+ * makes 9812 words for the 308 primes that the solver may use with
+ * NTT. Requests not covered by the cache (which should not happen)
+ * are handled by computing the values directly.
+ */
+#if FALCON_KG_CACHE
+
+#define MODP_CACHE_PRIMES   308
+#define MODP_CACHE_WORDS    9812
+
+/*
+ * Entry states: empty, being filled by some thread, ready. A thread
+ * that finds an entry being filled computes the values itself instead
+ * of waiting.
+ */
+#define MODP_CACHE_EMPTY   0
+#define MODP_CACHE_BUSY    1
+#define MODP_CACHE_READY   2
+
+#if defined __GNUC__ || defined __clang__
+#define MODP_CACHE_LOAD(x)   __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define MODP_CACHE_STORE(x, v)   __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+#define MODP_CACHE_CLAIM(x)   modp_cache_claim(&(x))
+static inline int
+modp_cache_claim(unsigned *x)
+{
+	unsigned e;
+
+	e = MODP_CACHE_EMPTY;
+	return __atomic_compare_exchange_n(x, &e, MODP_CACHE_BUSY, 0,
+		__ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+#else
+/*
+ * Without atomic operations, FALCON_KG_CACHE is enabled only if
+ * FALCON_THREADS is not.
+ */
+#define MODP_CACHE_LOAD(x)   (x)
+#define MODP_CACHE_STORE(x, v)   ((x) = (v))
+#define MODP_CACHE_CLAIM(x)   ((x) = MODP_CACHE_BUSY, 1)
+#endif
+
+static unsigned modp_cache_state[MODP_CACHE_PRIMES];
+static uint32_t modp_cache_consts[MODP_CACHE_PRIMES][2];
+static uint32_t modp_cache_gm[MODP_CACHE_WORDS];
+
+/*
+ * Get the offset of the tables of PRIMES[u] in modp_cache_gm[] (gm[]
+ * followed by igm[]), and their degree (logarithm).
+ */
+static size_t
+modp_cache_slot(size_t u, unsigned *logn)
+{
+	size_t off, lo;
+	unsigned d;
+
+	off = 0;
+	lo = 0;
+	for (d = 0;; d ++) {
+		size_t hi;
+
+		hi = MAX_BL_LARGE[d];
+		if (u < hi) {
+			*logn = 10 - d;
+			return off + ((u - lo) << (11 - d));
+		}
+		off += (hi - lo) << (11 - d);
+		lo = hi;
+	}
+}
+
+/*
+ * Get the cache entry for PRIMES[u], filling it if needed. Returned
+ * value is 1 if the entry can be used, 0 otherwise.
+ */
+static int
+modp_cache_entry(size_t u)
+{
+	uint32_t p, p0i, R2, *gm;
+	size_t off;
+	unsigned logn;
+
+	if (u >= MODP_CACHE_PRIMES) {
+		return 0;
+	}
+	if (MODP_CACHE_LOAD(modp_cache_state[u]) == MODP_CACHE_READY) {
+		return 1;
+	}
+	if (!MODP_CACHE_CLAIM(modp_cache_state[u])) {
+		return 0;
+	}
+	p = PRIMES[u].p;
+	p0i = modp_ninv31(p);
+	R2 = modp_R2(p, p0i);
+	off = modp_cache_slot(u, &logn);
+	gm = modp_cache_gm + off;
+	modp_mkgm2(gm, gm + MKN(logn), logn, PRIMES[u].g, p, p0i);
+	modp_cache_consts[u][0] = p0i;
+	modp_cache_consts[u][1] = R2;
+	MODP_CACHE_STORE(modp_cache_state[u], MODP_CACHE_READY);
+	return 1;
+}
+
+#endif
+
+/*
+ * Get p0i = -1/p mod 2^31 and R2 = 2^62 mod p for p = PRIMES[u].
+ */
+static inline void
+modp_prime_init(size_t u, uint32_t *p0i, uint32_t *R2)
+{
+	uint32_t p;
+
+#if FALCON_KG_CACHE
+	if (modp_cache_entry(u)) {
+		*p0i = modp_cache_consts[u][0];
+		*R2 = modp_cache_consts[u][1];
+		return;
+	}
+#endif
+	p = PRIMES[u].p;
+	*p0i = modp_ninv31(p);
+	*R2 = modp_R2(p, *p0i);
+}
+
+/*
+ * Equivalent to modp_mkgm2(gm, igm, logn, PRIMES[u].g, PRIMES[u].p, p0i).
+ */
+static void
+modp_mkgm2_prime(uint32_t *restrict gm, uint32_t *restrict igm,
+	unsigned logn, size_t u, uint32_t p0i)
+{
+#if FALCON_KG_CACHE
+	if (modp_cache_entry(u)) {
+		const uint32_t *cgm;
+		unsigned clogn;
+
+		cgm = modp_cache_gm + modp_cache_slot(u, &clogn);
+		if (logn <= clogn) {
+			memcpy(gm, cgm, MKN(logn) * sizeof *gm);
+			memcpy(igm, cgm + MKN(clogn), MKN(logn) * sizeof *igm);
+			return;
+		}
+	}
+#endif
+	modp_mkgm2(gm, igm, logn, PRIMES[u].g, PRIMES[u].p, p0i);
+}
+
+/*
+ * Per-prime work of poly_sub_scaled_ntt() (see kg_run()): compute k*f
+ * modulo the small prime u, in column u of fk[]. The scratch area
+ * receives the NTT tables and k modulo p (3*2^logn words).
+ */
+typedef struct {
+	uint32_t *fk;
+	const uint32_t *f;
+	size_t flen, fstride, tlen;
+	const int32_t *k;
+	unsigned logn;
+} poly_sub_scaled_ntt_job;
+
+static void
+poly_sub_scaled_ntt_prime(void *arg, size_t u, uint32_t *scratch)
+{
+	const poly_sub_scaled_ntt_job *job;
+	uint32_t *gm, *igm, *t1, *x;
+	uint32_t p, p0i, R2, Rx;
+	size_t n, v, tlen;
+	unsigned logn;
+
+	job = arg;
+	logn = job->logn;
+	tlen = job->tlen;
+	n = MKN(logn);
+	gm = scratch;
+	igm = gm + n;
+	t1 = igm + n;
+
+	p = PRIMES[u].p;
+	modp_prime_init(u, &p0i, &R2);
+	Rx = modp_Rx((unsigned)job->flen, p, p0i, R2);
+	modp_mkgm2_prime(gm, igm, logn, u, p0i);
+
+	for (v = 0; v < n; v ++) {
+		t1[v] = modp_set(job->k[v], p);
+	}
+	modp_NTT2(t1, gm, logn, p, p0i);
+	zint_mod_small_batch(job->fk + u, tlen, job->f, job->flen,
+		job->fstride, n, p, p0i, R2, Rx, 1);
+	modp_NTT2_ext(job->fk + u, tlen, gm, logn, p, p0i);
+	for (v = 0, x = job->fk + u; v < n; v ++, x += tlen) {
+		*x = modp_montymul(
+			modp_montymul(t1[v], *x, p, p0i), R2, p, p0i);
+	}
+	modp_iNTT2_ext(job->fk + u, tlen, igm, logn, p, p0i);
+}
+
 /*
  * Subtract k*f from F. Coefficients of polynomial k are small integers
  * (signed values in the -2^31..2^31 range) scaled by 2^sc. This function
@@ -2174,56 +2957,34 @@ static void
 poly_sub_scaled_ntt(uint32_t *restrict F, size_t Flen, size_t Fstride,
 	const uint32_t *restrict f, size_t flen, size_t fstride,
 	const int32_t *restrict k, uint32_t sch, uint32_t scl, unsigned logn,
-	uint32_t *restrict tmp)
+	uint32_t *restrict tmp, const keygen_pool *kp)
 {
-	uint32_t *gm, *igm, *fk, *t1, *x;
+	poly_sub_scaled_ntt_job job;
+	uint32_t *fk, *t1, *x;
 	const uint32_t *y;
 	size_t n, u, tlen;
-	const small_prime *primes;
 
 	n = MKN(logn);
 	tlen = flen + 1;
-	gm = tmp;
-	igm = gm + MKN(logn);
-	fk = igm + MKN(logn);
+	fk = tmp;
 	t1 = fk + n * tlen;
 
-	primes = PRIMES;
-
 	/*
 	 * Compute k*f in fk[], in RNS notation.
 	 */
-	for (u = 0; u < tlen; u ++) {
-		uint32_t p, p0i, R2, Rx;
-		size_t v;
-
-		p = primes[u].p;
-		p0i = modp_ninv31(p);
-		R2 = modp_R2(p, p0i);
-		Rx = modp_Rx((unsigned)flen, p, p0i, R2);
-		modp_mkgm2(gm, igm, logn, primes[u].g, p, p0i);
-
-		for (v = 0; v < n; v ++) {
-			t1[v] = modp_set(k[v], p);
-		}
-		modp_NTT2(t1, gm, logn, p, p0i);
-		for (v = 0, y = f, x = fk + u;
-			v < n; v ++, y += fstride, x += tlen)
-		{
-			*x = zint_mod_small_signed(y, flen, p, p0i, R2, Rx);
-		}
-		modp_NTT2_ext(fk + u, tlen, gm, logn, p, p0i);
-		for (v = 0, x = fk + u; v < n; v ++, x += tlen) {
-			*x = modp_montymul(
-				modp_montymul(t1[v], *x, p, p0i), R2, p, p0i);
-		}
-		modp_iNTT2_ext(fk + u, tlen, igm, logn, p, p0i);
-	}
+	job.fk = fk;
+	job.f = f;
+	job.flen = flen;
+	job.fstride = fstride;
+	job.tlen = tlen;
+	job.k = k;
+	job.logn = logn;
+	kg_run(kp, &poly_sub_scaled_ntt_prime, &job, 0, tlen, t1);
 
 	/*
 	 * Rebuild k*f.
 	 */
-	zint_rebuild_CRT(fk, tlen, tlen, n, primes, 1, t1);
+	kg_rebuild_CRT(kp, fk, tlen, tlen, n, PRIMES, 1, t1);
 
 	/*
 	 * Subtract k*f, scaled, from F.
@@ -2385,70 +3146,6 @@ mkgauss(RNG_CONTEXT *rng, unsigned logn)
 	return val;
 }
 
-/*
- * The MAX_BL_SMALL[] and MAX_BL_LARGE[] contain the lengths, in 31-bit
- * words, of intermediate values in the computation:
- *
- *   MAX_BL_SMALL[depth]: length for the input f and g at that depth
- *   MAX_BL_LARGE[depth]: length for the unreduced F and G at that depth
- *
- * Rules:
- *
- *  - Within an array, values grow.
- *
- *  - The 'SMALL' array must have an entry for maximum depth, corresponding
- *    to the size of values used in the binary GCD. There is no such value
- *    for the 'LARGE' array (the binary GCD yields already reduced
- *    coefficients).
- *
- *  - MAX_BL_LARGE[depth] >= MAX_BL_SMALL[depth + 1].
- *
- *  - Values must be large enough to handle the common cases, with some
- *    margins.
- *
- *  - Values must not be "too large" either because we will convert some
- *    integers into floating-point values by considering the top 10 words,
- *    i.e. 310 bits; hence, for values of length more than 10 words, we
- *    should take care to have the length centered on the expected size.
- *
- * The following average lengths, in bits, have been measured on thousands
- * of random keys (fg = max length of the absolute value of coefficients
- * of f and g at that depth; FG = idem for the unreduced F and G; for the
- * maximum depth, F and G are the output of binary GCD, multiplied by q;
- * for each value, the average and standard deviation are provided).
- *
- * Binary case:
- *    depth: 10    fg: 6307.52 (24.48)    FG: 6319.66 (24.51)
- *    depth:  9    fg: 3138.35 (12.25)    FG: 9403.29 (27.55)
- *    depth:  8    fg: 1576.87 ( 7.49)    FG: 4703.30 (14.77)
- *    depth:  7    fg:  794.17 ( 4.98)    FG: 2361.84 ( 9.31)
- *    depth:  6    fg:  400.67 ( 3.10)    FG: 1188.68 ( 6.04)
- *    depth:  5    fg:  202.22 ( 1.87)    FG:  599.81 ( 3.87)
- *    depth:  4    fg:  101.62 ( 1.02)    FG:  303.49 ( 2.38)
- *    depth:  3    fg:   50.37 ( 0.53)    FG:  153.65 ( 1.39)
- *    depth:  2    fg:   24.07 ( 0.25)    FG:   78.20 ( 0.73)
- *    depth:  1    fg:   10.99 ( 0.08)    FG:   39.82 ( 0.41)
- *    depth:  0    fg:    4.00 ( 0.00)    FG:   19.61 ( 0.49)
- *
- * Integers are actually represented either in binary notation over
- * 31-bit words (signed, using two's complement), or in RNS, modulo
- * many small primes. These small primes are close to, but slightly
- * lower than, 2^31. Use of RNS loses less than two bits, even for
- * the largest values.
- *
- * IMPORTANT: if these values are modified, then the temporary buffer
- * sizes (FALCON_KEYGEN_TEMP_*, in inner.h) must be recomputed
- * accordingly.
- */
-
-static const size_t MAX_BL_SMALL[] = {
-	1, 1, 2, 2, 4, 7, 14, 27, 53, 106, 209
-};
-
-static const size_t MAX_BL_LARGE[] = {
-	2, 2, 5, 7, 12, 21, 40, 78, 157, 308
-};
-
 /*
  * Average and standard deviation for the maximum size (in bits) of
  * coefficients of (f,g), depending on depth. These values are used
@@ -2555,58 +3252,52 @@ poly_small_to_fp(fpr *x, const int8_t *f, unsigned logn)
 }
 
 /*
- * Input: f,g of degree N = 2^logn; 'depth' is used only to get their
- * individual length.
- *
- * Output: f',g' of degree N/2, with the length for 'depth+1'.
- *
- * Values are in RNS; input and/or output may also be in NTT.
+ * Per-prime work of make_fg_step() (see kg_run()). For the first slen
+ * primes, the input values are used directly (with inverse NTT applied
+ * as we go); for the remaining primes, the input values must have been
+ * rebuilt with the CRT, and modular reductions extract the values. The
+ * scratch area receives the NTT tables and one polynomial (3*2^logn
+ * words).
  */
+typedef struct {
+	uint32_t *fd, *gd, *fs, *gs;
+	unsigned logn;
+	size_t slen, tlen;
+	int in_ntt, out_ntt;
+} make_fg_step_job;
+
 static void
-make_fg_step(uint32_t *data, unsigned logn, unsigned depth,
-	int in_ntt, int out_ntt)
+make_fg_step_prime(void *arg, size_t u, uint32_t *scratch)
 {
-	size_t n, hn, u;
-	size_t slen, tlen;
-	uint32_t *fd, *gd, *fs, *gs, *gm, *igm, *t1;
-	const small_prime *primes;
+	const make_fg_step_job *job;
+	size_t n, hn, v, slen, tlen;
+	uint32_t *fd, *gd, *fs, *gs, *gm, *igm, *t1, *x;
+	uint32_t p, p0i, R2;
+	unsigned logn;
 
+	job = arg;
+	logn = job->logn;
+	slen = job->slen;
+	tlen = job->tlen;
+	fd = job->fd;
+	gd = job->gd;
+	fs = job->fs;
+	gs = job->gs;
 	n = (size_t)1 << logn;
 	hn = n >> 1;
-	slen = MAX_BL_SMALL[depth];
-	tlen = MAX_BL_SMALL[depth + 1];
-	primes = PRIMES;
-
-	/*
-	 * Prepare room for the result.
-	 */
-	fd = data;
-	gd = fd + hn * tlen;
-	fs = gd + hn * tlen;
-	gs = fs + n * slen;
-	gm = gs + n * slen;
+	gm = scratch;
 	igm = gm + n;
 	t1 = igm + n;
-	memmove(fs, data, 2 * n * slen * sizeof *data);
 
-	/*
-	 * First slen words: we use the input values directly, and apply
-	 * inverse NTT as we go.
-	 */
-	for (u = 0; u < slen; u ++) {
-		uint32_t p, p0i, R2;
-		size_t v;
-		uint32_t *x;
-
-		p = primes[u].p;
-		p0i = modp_ninv31(p);
-		R2 = modp_R2(p, p0i);
-		modp_mkgm2(gm, igm, logn, primes[u].g, p, p0i);
+	p = PRIMES[u].p;
+	modp_prime_init(u, &p0i, &R2);
+	modp_mkgm2_prime(gm, igm, logn, u, p0i);
 
+	if (u < slen) {
 		for (v = 0, x = fs + u; v < n; v ++, x += slen) {
 			t1[v] = *x;
 		}
-		if (!in_ntt) {
+		if (!job->in_ntt) {
 			modp_NTT2(t1, gm, logn, p, p0i);
 		}
 		for (v = 0, x = fd + u; v < hn; v ++, x += tlen) {
@@ -2617,14 +3308,14 @@ make_fg_step(uint32_t *data, unsigned logn, unsigned depth,
 			*x = modp_montymul(
 				modp_montymul(w0, w1, p, p0i), R2, p, p0i);
 		}
-		if (in_ntt) {
+		if (job->in_ntt) {
 			modp_iNTT2_ext(fs + u, slen, igm, logn, p, p0i);
 		}
 
 		for (v = 0, x = gs + u; v < n; v ++, x += slen) {
 			t1[v] = *x;
 		}
-		if (!in_ntt) {
+		if (!job->in_ntt) {
 			modp_NTT2(t1, gm, logn, p, p0i);
 		}
 		for (v = 0, x = gd + u; v < hn; v ++, x += tlen) {
@@ -2635,39 +3326,15 @@ make_fg_step(uint32_t *data, unsigned logn, unsigned depth,
 			*x = modp_montymul(
 				modp_montymul(w0, w1, p, p0i), R2, p, p0i);
 		}
-		if (in_ntt) {
+		if (job->in_ntt) {
 			modp_iNTT2_ext(gs + u, slen, igm, logn, p, p0i);
 		}
+	} else {
+		uint32_t Rx;
 
-		if (!out_ntt) {
-			modp_iNTT2_ext(fd + u, tlen, igm, logn - 1, p, p0i);
-			modp_iNTT2_ext(gd + u, tlen, igm, logn - 1, p, p0i);
-		}
-	}
-
-	/*
-	 * Since the fs and gs words have been de-NTTized, we can use the
-	 * CRT to rebuild the values.
-	 */
-	zint_rebuild_CRT(fs, slen, slen, n, primes, 1, gm);
-	zint_rebuild_CRT(gs, slen, slen, n, primes, 1, gm);
-
-	/*
-	 * Remaining words: use modular reductions to extract the values.
-	 */
-	for (u = slen; u < tlen; u ++) {
-		uint32_t p, p0i, R2, Rx;
-		size_t v;
-		uint32_t *x;
-
-		p = primes[u].p;
-		p0i = modp_ninv31(p);
-		R2 = modp_R2(p, p0i);
 		Rx = modp_Rx((unsigned)slen, p, p0i, R2);
-		modp_mkgm2(gm, igm, logn, primes[u].g, p, p0i);
-		for (v = 0, x = fs; v < n; v ++, x += slen) {
-			t1[v] = zint_mod_small_signed(x, slen, p, p0i, R2, Rx);
-		}
+		zint_mod_small_batch(t1, 1, fs, slen, slen, n,
+			p, p0i, R2, Rx, 1);
 		modp_NTT2(t1, gm, logn, p, p0i);
 		for (v = 0, x = fd + u; v < hn; v ++, x += tlen) {
 			uint32_t w0, w1;
@@ -2677,24 +3344,84 @@ make_fg_step(uint32_t *data, unsigned logn, unsigned depth,
 			*x = modp_montymul(
 				modp_montymul(w0, w1, p, p0i), R2, p, p0i);
 		}
-		for (v = 0, x = gs; v < n; v ++, x += slen) {
-			t1[v] = zint_mod_small_signed(x, slen, p, p0i, R2, Rx);
-		}
+		zint_mod_small_batch(t1, 1, gs, slen, slen, n,
+			p, p0i, R2, Rx, 1);
 		modp_NTT2(t1, gm, logn, p, p0i);
 		for (v = 0, x = gd + u; v < hn; v ++, x += tlen) {
 			uint32_t w0, w1;
 
-			w0 = t1[(v << 1) + 0];
-			w1 = t1[(v << 1) + 1];
-			*x = modp_montymul(
-				modp_montymul(w0, w1, p, p0i), R2, p, p0i);
-		}
+			w0 = t1[(v << 1) + 0];
+			w1 = t1[(v << 1) + 1];
+			*x = modp_montymul(
+				modp_montymul(w0, w1, p, p0i), R2, p, p0i);
+		}
+	}
+
+	if (!job->out_ntt) {
+		modp_iNTT2_ext(fd + u, tlen, igm, logn - 1, p, p0i);
+		modp_iNTT2_ext(gd + u, tlen, igm, logn - 1, p, p0i);
+	}
+}
+
+/*
+ * Input: f,g of degree N = 2^logn; 'depth' is used only to get their
+ * individual length.
+ *
+ * Output: f',g' of degree N/2, with the length for 'depth+1'.
+ *
+ * Values are in RNS; input and/or output may also be in NTT.
+ */
+static void
+make_fg_step(uint32_t *data, unsigned logn, unsigned depth,
+	int in_ntt, int out_ntt, const keygen_pool *kp)
+{
+	make_fg_step_job job;
+	size_t n, hn;
+	size_t slen, tlen;
+	uint32_t *fd, *gd, *fs, *gs, *gm;
+
+	n = (size_t)1 << logn;
+	hn = n >> 1;
+	slen = MAX_BL_SMALL[depth];
+	tlen = MAX_BL_SMALL[depth + 1];
+
+	/*
+	 * Prepare room for the result.
+	 */
+	fd = data;
+	gd = fd + hn * tlen;
+	fs = gd + hn * tlen;
+	gs = fs + n * slen;
+	gm = gs + n * slen;
+	memmove(fs, data, 2 * n * slen * sizeof *data);
+
+	job.fd = fd;
+	job.gd = gd;
+	job.fs = fs;
+	job.gs = gs;
+	job.logn = logn;
+	job.slen = slen;
+	job.tlen = tlen;
+	job.in_ntt = in_ntt;
+	job.out_ntt = out_ntt;
+
+	/*
+	 * First slen words: we use the input values directly, and apply
+	 * inverse NTT as we go.
+	 */
+	kg_run(kp, &make_fg_step_prime, &job, 0, slen, gm);
 
-		if (!out_ntt) {
-			modp_iNTT2_ext(fd + u, tlen, igm, logn - 1, p, p0i);
-			modp_iNTT2_ext(gd + u, tlen, igm, logn - 1, p, p0i);
-		}
-	}
+	/*
+	 * Since the fs and gs words have been de-NTTized, we can use the
+	 * CRT to rebuild the values.
+	 */
+	kg_rebuild_CRT(kp, fs, slen, slen, n, PRIMES, 1, gm);
+	kg_rebuild_CRT(kp, gs, slen, slen, n, PRIMES, 1, gm);
+
+	/*
+	 * Remaining words: use modular reductions to extract the values.
+	 */
+	kg_run(kp, &make_fg_step_prime, &job, slen, tlen, gm);
 }
 
 /*
@@ -2710,7 +3437,7 @@ make_fg_step(uint32_t *data, unsigned logn, unsigned depth,
  */
 static void
 make_fg(uint32_t *data, const int8_t *f, const int8_t *g,
-	unsigned logn, unsigned depth, int out_ntt)
+	unsigned logn, unsigned depth, int out_ntt, const keygen_pool *kp)
 {
 	size_t n, u;
 	uint32_t *ft, *gt, p0;
@@ -2735,7 +3462,7 @@ make_fg(uint32_t *data, const int8_t *f, const int8_t *g,
 		p0i = modp_ninv31(p);
 		gm = gt + n;
 		igm = gm + MKN(logn);
-		modp_mkgm2(gm, igm, logn, primes[0].g, p, p0i);
+		modp_mkgm2_prime(gm, igm, logn, 0, p0i);
 		modp_NTT2(ft, gm, logn, p, p0i);
 		modp_NTT2(gt, gm, logn, p, p0i);
 		return;
@@ -2743,7 +3470,7 @@ make_fg(uint32_t *data, const int8_t *f, const int8_t *g,
 
 	for (d = 0; d < depth; d ++) {
 		make_fg_step(data, logn - d, d,
-			d != 0, (d + 1) < depth || out_ntt);
+			d != 0, (d + 1) < depth || out_ntt, kp);
 	}
 }
 
@@ -2756,7 +3483,7 @@ make_fg(uint32_t *data, const int8_t *f, const int8_t *g,
  */
 static int
 solve_NTRU_deepest(unsigned logn_top,
-	const int8_t *f, const int8_t *g, uint32_t *tmp)
+	const int8_t *f, const int8_t *g, uint32_t *tmp, const keygen_pool *kp)
 {
 	size_t len;
 	uint32_t *Fp, *Gp, *fp, *gp, *t1, q;
@@ -2771,7 +3498,7 @@ solve_NTRU_deepest(unsigned logn_top,
 	gp = fp + len;
 	t1 = gp + len;
 
-	make_fg(fp, f, g, logn_top, logn_top, 0);
+	make_fg(fp, f, g, logn_top, logn_top, 0, kp);
 
 	/*
 	 * We use the CRT to rebuild the resultants as big integers.
@@ -2890,6 +3617,170 @@ solve_NTRU_deepest(unsigned logn_top,
 	return 1;
 }
 
+/*
+ * Shared state for the per-prime work of solve_NTRU_intermediate() and
+ * solve_NTRU_binary_depth1() (see kg_run()).
+ */
+typedef struct {
+	const int8_t *f, *g;
+	unsigned logn_top, logn;
+	size_t slen, dlen, llen;
+	uint32_t *Fd, *Gd, *Ft, *Gt, *ft, *gt;
+} solve_NTRU_job;
+
+/*
+ * Reduce the F and G from the deeper level (Fd and Gd, of degree N/2)
+ * modulo the small prime u, into column u of Ft and Gt.
+ */
+static void
+solve_NTRU_reduce_prime(void *arg, size_t u, uint32_t *scratch)
+{
+	const solve_NTRU_job *job;
+	uint32_t p, p0i, R2, Rx;
+	size_t hn;
+
+	(void)scratch;
+	job = arg;
+	hn = (size_t)1 << (job->logn - 1);
+	p = PRIMES[u].p;
+	modp_prime_init(u, &p0i, &R2);
+	Rx = modp_Rx((unsigned)job->dlen, p, p0i, R2);
+	zint_mod_small_batch(job->Ft + u, job->llen, job->Fd, job->dlen,
+		job->dlen, hn, p, p0i, R2, Rx, 1);
+	zint_mod_small_batch(job->Gt + u, job->llen, job->Gd, job->dlen,
+		job->dlen, hn, p, p0i, R2, Rx, 1);
+}
+
+/*
+ * Compute F and G modulo the small prime u (solve_NTRU_intermediate()),
+ * in column u of Ft and Gt. For u < slen, f and g (ft and gt) are in
+ * RNS + NTT representation, and column u is de-NTTized; for u >= slen,
+ * they must have been rebuilt with the CRT. The scratch area receives
+ * the NTT tables and temporary polynomials (5*2^logn words).
+ */
+static void
+solve_NTRU_intermediate_prime(void *arg, size_t u, uint32_t *scratch)
+{
+	const solve_NTRU_job *job;
+	unsigned logn;
+	size_t n, hn, slen, llen;
+	uint32_t *Ft, *Gt, *ft, *gt, *x, *y;
+	uint32_t p, p0i, R2;
+	uint32_t *gm, *igm, *fx, *gx, *Fp, *Gp;
+	size_t v;
+
+	job = arg;
+	logn = job->logn;
+	n = (size_t)1 << logn;
+	hn = n >> 1;
+	slen = job->slen;
+	llen = job->llen;
+	Ft = job->Ft;
+	Gt = job->Gt;
+	ft = job->ft;
+	gt = job->gt;
+
+	/*
+	 * All computations are done modulo p.
+	 */
+	p = PRIMES[u].p;
+	modp_prime_init(u, &p0i, &R2);
+
+	gm = scratch;
+	igm = gm + n;
+	fx = igm + n;
+	gx = fx + n;
+
+	modp_mkgm2_prime(gm, igm, logn, u, p0i);
+
+	if (u < slen) {
+		for (v = 0, x = ft + u, y = gt + u;
+			v < n; v ++, x += slen, y += slen)
+		{
+			fx[v] = *x;
+			gx[v] = *y;
+		}
+		modp_iNTT2_ext(ft + u, slen, igm, logn, p, p0i);
+		modp_iNTT2_ext(gt + u, slen, igm, logn, p, p0i);
+	} else {
+		uint32_t Rx;
+
+		Rx = modp_Rx((unsigned)slen, p, p0i, R2);
+		zint_mod_small_batch(fx, 1, ft, slen, slen, n,
+			p, p0i, R2, Rx, 1);
+		zint_mod_small_batch(gx, 1, gt, slen, slen, n,
+			p, p0i, R2, Rx, 1);
+		modp_NTT2(fx, gm, logn, p, p0i);
+		modp_NTT2(gx, gm, logn, p, p0i);
+	}
+
+	/*
+	 * Get F' and G' modulo p and in NTT representation
+	 * (they have degree n/2). These values were computed in
+	 * a previous step, and stored in Ft and Gt.
+	 */
+	Fp = gx + n;
+	Gp = Fp + hn;
+	for (v = 0, x = Ft + u, y = Gt + u;
+		v < hn; v ++, x += llen, y += llen)
+	{
+		Fp[v] = *x;
+		Gp[v] = *y;
+	}
+	modp_NTT2(Fp, gm, logn - 1, p, p0i);
+	modp_NTT2(Gp, gm, logn - 1, p, p0i);
+
+	/*
+	 * Compute our F and G modulo p.
+	 *
+	 * General case:
+	 *
+	 *   we divide degree by d = 2 or 3
+	 *   f'(x^d) = N(f)(x^d) = f * adj(f)
+	 *   g'(x^d) = N(g)(x^d) = g * adj(g)
+	 *   f'*G' - g'*F' = q
+	 *   F = F'(x^d) * adj(g)
+	 *   G = G'(x^d) * adj(f)
+	 *
+	 * We compute things in the NTT. We group roots of phi
+	 * such that all roots x in a group share the same x^d.
+	 * If the roots in a group are x_1, x_2... x_d, then:
+	 *
+	 *   N(f)(x_1^d) = f(x_1)*f(x_2)*...*f(x_d)
+	 *
+	 * Thus, we have:
+	 *
+	 *   G(x_1) = f(x_2)*f(x_3)*...*f(x_d)*G'(x_1^d)
+	 *   G(x_2) = f(x_1)*f(x_3)*...*f(x_d)*G'(x_1^d)
+	 *   ...
+	 *   G(x_d) = f(x_1)*f(x_2)*...*f(x_{d-1})*G'(x_1^d)
+	 *
+	 * In all cases, we can thus compute F and G in NTT
+	 * representation by a few simple multiplications.
+	 * Moreover, in our chosen NTT representation, roots
+	 * from the same group are consecutive in RAM.
+	 */
+	for (v = 0, x = Ft + u, y = Gt + u; v < hn;
+		v ++, x += (llen << 1), y += (llen << 1))
+	{
+		uint32_t ftA, ftB, gtA, gtB;
+		uint32_t mFp, mGp;
+
+		ftA = fx[(v << 1) + 0];
+		ftB = fx[(v << 1) + 1];
+		gtA = gx[(v << 1) + 0];
+		gtB = gx[(v << 1) + 1];
+		mFp = modp_montymul(Fp[v], R2, p, p0i);
+		mGp = modp_montymul(Gp[v], R2, p, p0i);
+		x[0] = modp_montymul(gtB, mFp, p, p0i);
+		x[llen] = modp_montymul(gtA, mFp, p, p0i);
+		y[0] = modp_montymul(ftB, mGp, p, p0i);
+		y[llen] = modp_montymul(ftA, mGp, p, p0i);
+	}
+	modp_iNTT2_ext(Ft + u, llen, igm, logn, p, p0i);
+	modp_iNTT2_ext(Gt + u, llen, igm, logn, p, p0i);
+}
+
 /*
  * Solving the NTRU equation, intermediate level. Upon entry, the F and G
  * from the previous level should be in the tmp[] array.
@@ -2899,7 +3790,8 @@ solve_NTRU_deepest(unsigned logn_top,
  */
 static int
 solve_NTRU_intermediate(unsigned logn_top,
-	const int8_t *f, const int8_t *g, unsigned depth, uint32_t *tmp)
+	const int8_t *f, const int8_t *g, unsigned depth, uint32_t *tmp,
+	const keygen_pool *kp)
 {
 	/*
 	 * In this function, 'logn' is the log2 of the degree for
@@ -2916,6 +3808,7 @@ solve_NTRU_intermediate(unsigned logn_top,
 	uint32_t *x, *y;
 	int32_t *k;
 	const small_prime *primes;
+	solve_NTRU_job job;
 
 	logn = logn_top - depth;
 	n = (size_t)1 << logn;
@@ -2949,7 +3842,7 @@ solve_NTRU_intermediate(unsigned logn_top,
 	 * and g in RNS + NTT representation.
 	 */
 	ft = Gd + dlen * hn;
-	make_fg(ft, f, g, logn_top, depth, 1);
+	make_fg(ft, f, g, logn_top, depth, 1, kp);
 
 	/*
 	 * Move the newly computed f and g to make room for our candidate
@@ -2974,23 +3867,20 @@ solve_NTRU_intermediate(unsigned logn_top,
 	 * We reduce Fd and Gd modulo all the small primes we will need,
 	 * and store the values in Ft and Gt (only n/2 values in each).
 	 */
-	for (u = 0; u < llen; u ++) {
-		uint32_t p, p0i, R2, Rx;
-		size_t v;
-		uint32_t *xs, *ys, *xd, *yd;
-
-		p = primes[u].p;
-		p0i = modp_ninv31(p);
-		R2 = modp_R2(p, p0i);
-		Rx = modp_Rx((unsigned)dlen, p, p0i, R2);
-		for (v = 0, xs = Fd, ys = Gd, xd = Ft + u, yd = Gt + u;
-			v < hn;
-			v ++, xs += dlen, ys += dlen, xd += llen, yd += llen)
-		{
-			*xd = zint_mod_small_signed(xs, dlen, p, p0i, R2, Rx);
-			*yd = zint_mod_small_signed(ys, dlen, p, p0i, R2, Rx);
-		}
-	}
+	job.logn_top = logn_top;
+	job.logn = logn;
+	job.slen = slen;
+	job.dlen = dlen;
+	job.llen = llen;
+	job.Fd = Fd;
+	job.Gd = Gd;
+	job.Ft = Ft;
+	job.Gt = Gt;
+	job.ft = ft;
+	job.gt = gt;
+	job.f = f;
+	job.g = g;
+	kg_run(kp, &solve_NTRU_reduce_prime, &job, 0, llen, t1);
 
 	/*
 	 * We do not need Fd and Gd after that point.
@@ -2998,132 +3888,19 @@ solve_NTRU_intermediate(unsigned logn_top,
 
 	/*
 	 * Compute our F and G modulo sufficiently many small primes.
+	 * After the first slen primes, f and g have been de-NTTized,
+	 * and are in RNS; we rebuild them for the remaining primes.
 	 */
-	for (u = 0; u < llen; u ++) {
-		uint32_t p, p0i, R2;
-		uint32_t *gm, *igm, *fx, *gx, *Fp, *Gp;
-		size_t v;
-
-		/*
-		 * All computations are done modulo p.
-		 */
-		p = primes[u].p;
-		p0i = modp_ninv31(p);
-		R2 = modp_R2(p, p0i);
-
-		/*
-		 * If we processed slen words, then f and g have been
-		 * de-NTTized, and are in RNS; we can rebuild them.
-		 */
-		if (u == slen) {
-			zint_rebuild_CRT(ft, slen, slen, n, primes, 1, t1);
-			zint_rebuild_CRT(gt, slen, slen, n, primes, 1, t1);
-		}
-
-		gm = t1;
-		igm = gm + n;
-		fx = igm + n;
-		gx = fx + n;
-
-		modp_mkgm2(gm, igm, logn, primes[u].g, p, p0i);
-
-		if (u < slen) {
-			for (v = 0, x = ft + u, y = gt + u;
-				v < n; v ++, x += slen, y += slen)
-			{
-				fx[v] = *x;
-				gx[v] = *y;
-			}
-			modp_iNTT2_ext(ft + u, slen, igm, logn, p, p0i);
-			modp_iNTT2_ext(gt + u, slen, igm, logn, p, p0i);
-		} else {
-			uint32_t Rx;
-
-			Rx = modp_Rx((unsigned)slen, p, p0i, R2);
-			for (v = 0, x = ft, y = gt;
-				v < n; v ++, x += slen, y += slen)
-			{
-				fx[v] = zint_mod_small_signed(x, slen,
-					p, p0i, R2, Rx);
-				gx[v] = zint_mod_small_signed(y, slen,
-					p, p0i, R2, Rx);
-			}
-			modp_NTT2(fx, gm, logn, p, p0i);
-			modp_NTT2(gx, gm, logn, p, p0i);
-		}
-
-		/*
-		 * Get F' and G' modulo p and in NTT representation
-		 * (they have degree n/2). These values were computed in
-		 * a previous step, and stored in Ft and Gt.
-		 */
-		Fp = gx + n;
-		Gp = Fp + hn;
-		for (v = 0, x = Ft + u, y = Gt + u;
-			v < hn; v ++, x += llen, y += llen)
-		{
-			Fp[v] = *x;
-			Gp[v] = *y;
-		}
-		modp_NTT2(Fp, gm, logn - 1, p, p0i);
-		modp_NTT2(Gp, gm, logn - 1, p, p0i);
-
-		/*
-		 * Compute our F and G modulo p.
-		 *
-		 * General case:
-		 *
-		 *   we divide degree by d = 2 or 3
-		 *   f'(x^d) = N(f)(x^d) = f * adj(f)
-		 *   g'(x^d) = N(g)(x^d) = g * adj(g)
-		 *   f'*G' - g'*F' = q
-		 *   F = F'(x^d) * adj(g)
-		 *   G = G'(x^d) * adj(f)
-		 *
-		 * We compute things in the NTT. We group roots of phi
-		 * such that all roots x in a group share the same x^d.
-		 * If the roots in a group are x_1, x_2... x_d, then:
-		 *
-		 *   N(f)(x_1^d) = f(x_1)*f(x_2)*...*f(x_d)
-		 *
-		 * Thus, we have:
-		 *
-		 *   G(x_1) = f(x_2)*f(x_3)*...*f(x_d)*G'(x_1^d)
-		 *   G(x_2) = f(x_1)*f(x_3)*...*f(x_d)*G'(x_1^d)
-		 *   ...
-		 *   G(x_d) = f(x_1)*f(x_2)*...*f(x_{d-1})*G'(x_1^d)
-		 *
-		 * In all cases, we can thus compute F and G in NTT
-		 * representation by a few simple multiplications.
-		 * Moreover, in our chosen NTT representation, roots
-		 * from the same group are consecutive in RAM.
-		 */
-		for (v = 0, x = Ft + u, y = Gt + u; v < hn;
-			v ++, x += (llen << 1), y += (llen << 1))
-		{
-			uint32_t ftA, ftB, gtA, gtB;
-			uint32_t mFp, mGp;
-
-			ftA = fx[(v << 1) + 0];
-			ftB = fx[(v << 1) + 1];
-			gtA = gx[(v << 1) + 0];
-			gtB = gx[(v << 1) + 1];
-			mFp = modp_montymul(Fp[v], R2, p, p0i);
-			mGp = modp_montymul(Gp[v], R2, p, p0i);
-			x[0] = modp_montymul(gtB, mFp, p, p0i);
-			x[llen] = modp_montymul(gtA, mFp, p, p0i);
-			y[0] = modp_montymul(ftB, mGp, p, p0i);
-			y[llen] = modp_montymul(ftA, mGp, p, p0i);
-		}
-		modp_iNTT2_ext(Ft + u, llen, igm, logn, p, p0i);
-		modp_iNTT2_ext(Gt + u, llen, igm, logn, p, p0i);
-	}
+	kg_run(kp, &solve_NTRU_intermediate_prime, &job, 0, slen, t1);
+	kg_rebuild_CRT(kp, ft, slen, slen, n, primes, 1, t1);
+	kg_rebuild_CRT(kp, gt, slen, slen, n, primes, 1, t1);
+	kg_run(kp, &solve_NTRU_intermediate_prime, &job, slen, llen, t1);
 
 	/*
 	 * Rebuild F and G with the CRT.
 	 */
-	zint_rebuild_CRT(Ft, llen, llen, n, primes, 1, t1);
-	zint_rebuild_CRT(Gt, llen, llen, n, primes, 1, t1);
+	kg_rebuild_CRT(kp, Ft, llen, llen, n, primes, 1, t1);
+	kg_rebuild_CRT(kp, Gt, llen, llen, n, primes, 1, t1);
 
 	/*
 	 * At that point, Ft, Gt, ft and gt are consecutive in RAM (in that
@@ -3371,9 +4148,9 @@ solve_NTRU_intermediate(unsigned logn_top,
 		scl = (uint32_t)(scale_k % 31);
 		if (depth <= DEPTH_INT_FG) {
 			poly_sub_scaled_ntt(Ft, FGlen, llen, ft, slen, slen,
-				k, sch, scl, logn, t1);
+				k, sch, scl, logn, t1, kp);
 			poly_sub_scaled_ntt(Gt, FGlen, llen, gt, slen, slen,
-				k, sch, scl, logn, t1);
+				k, sch, scl, logn, t1, kp);
 		} else {
 			poly_sub_scaled(Ft, FGlen, llen, ft, slen, slen,
 				k, sch, scl, logn);
@@ -3441,6 +4218,177 @@ solve_NTRU_intermediate(unsigned logn_top,
 	return 1;
 }
 
+/*
+ * Compute F and G modulo the small prime u (solve_NTRU_binary_depth1()),
+ * in column u of Ft and Gt; for u < slen, f and g modulo u are also
+ * saved in column u of ft and gt. The scratch area receives the NTT
+ * tables and temporary polynomials (7*2^(logn_top-1) words).
+ */
+static void
+solve_NTRU_binary_depth1_prime(void *arg, size_t u, uint32_t *scratch)
+{
+	const solve_NTRU_job *job;
+	const int8_t *f, *g;
+	unsigned logn_top, logn;
+	size_t n_top, n, hn, slen, llen;
+	uint32_t *Ft, *Gt, *ft, *gt, *x, *y;
+	uint32_t p, p0i, R2;
+	uint32_t *gm, *igm, *fx, *gx, *Fp, *Gp;
+	unsigned e;
+	size_t v;
+
+	job = arg;
+	f = job->f;
+	g = job->g;
+	logn_top = job->logn_top;
+	logn = job->logn;
+	n_top = (size_t)1 << logn_top;
+	n = (size_t)1 << logn;
+	hn = n >> 1;
+	slen = job->slen;
+	llen = job->llen;
+	Ft = job->Ft;
+	Gt = job->Gt;
+	ft = job->ft;
+	gt = job->gt;
+
+	/*
+	 * All computations are done modulo p.
+	 */
+	p = PRIMES[u].p;
+	modp_prime_init(u, &p0i, &R2);
+
+	/*
+	 * We recompute things from the source f and g, of full
+	 * degree. However, we will need only the n first elements
+	 * of the inverse NTT table (igm); the call to modp_mkgm()
+	 * below will fill n_top elements in igm[] (thus overflowing
+	 * into fx[]) but later code will overwrite these extra
+	 * elements.
+	 */
+	gm = scratch;
+	igm = gm + n_top;
+	fx = igm + n;
+	gx = fx + n_top;
+	modp_mkgm2_prime(gm, igm, logn_top, u, p0i);
+
+	/*
+	 * Set ft and gt to f and g modulo p, respectively.
+	 */
+	for (v = 0; v < n_top; v ++) {
+		fx[v] = modp_set(f[v], p);
+		gx[v] = modp_set(g[v], p);
+	}
+
+	/*
+	 * Convert to NTT and compute our f and g.
+	 */
+	modp_NTT2(fx, gm, logn_top, p, p0i);
+	modp_NTT2(gx, gm, logn_top, p, p0i);
+	for (e = logn_top; e > logn; e --) {
+		modp_poly_rec_res(fx, e, p, p0i, R2);
+		modp_poly_rec_res(gx, e, p, p0i, R2);
+	}
+
+	/*
+	 * From that point onward, we only need tables for
+	 * degree n, so we can save some space (depth = 1).
+	 */
+	memmove(gm + n, igm, n * sizeof *igm);
+	igm = gm + n;
+	memmove(igm + n, fx, n * sizeof *ft);
+	fx = igm + n;
+	memmove(fx + n, gx, n * sizeof *gt);
+	gx = fx + n;
+
+	/*
+	 * Get F' and G' modulo p and in NTT representation
+	 * (they have degree n/2). These values were computed
+	 * in a previous step, and stored in Ft and Gt.
+	 */
+	Fp = gx + n;
+	Gp = Fp + hn;
+	for (v = 0, x = Ft + u, y = Gt + u;
+		v < hn; v ++, x += llen, y += llen)
+	{
+		Fp[v] = *x;
+		Gp[v] = *y;
+	}
+	modp_NTT2(Fp, gm, logn - 1, p, p0i);
+	modp_NTT2(Gp, gm, logn - 1, p, p0i);
+
+	/*
+	 * Compute our F and G modulo p.
+	 *
+	 * Equations are:
+	 *
+	 *   f'(x^2) = N(f)(x^2) = f * adj(f)
+	 *   g'(x^2) = N(g)(x^2) = g * adj(g)
+	 *
+	 *   f'*G' - g'*F' = q
+	 *
+	 *   F = F'(x^2) * adj(g)
+	 *   G = G'(x^2) * adj(f)
+	 *
+	 * The NTT representation of f is f(w) for all w which
+	 * are roots of phi. In the binary case, as well as in
+	 * the ternary case for all depth except the deepest,
+	 * these roots can be grouped in pairs (w,-w), and we
+	 * then have:
+	 *
+	 *   f(w) = adj(f)(-w)
+	 *   f(-w) = adj(f)(w)
+	 *
+	 * and w^2 is then a root for phi at the half-degree.
+	 *
+	 * At the deepest level in the ternary case, this still
+	 * holds, in the following sense: the roots of x^2-x+1
+	 * are (w,-w^2) (for w^3 = -1, and w != -1), and we
+	 * have:
+	 *
+	 *   f(w) = adj(f)(-w^2)
+	 *   f(-w^2) = adj(f)(w)
+	 *
+	 * In all case, we can thus compute F and G in NTT
+	 * representation by a few simple multiplications.
+	 * Moreover, the two roots for each pair are consecutive
+	 * in our bit-reversal encoding.
+	 */
+	for (v = 0, x = Ft + u, y = Gt + u;
+		v < hn; v ++, x += (llen << 1), y += (llen << 1))
+	{
+		uint32_t ftA, ftB, gtA, gtB;
+		uint32_t mFp, mGp;
+
+		ftA = fx[(v << 1) + 0];
+		ftB = fx[(v << 1) + 1];
+		gtA = gx[(v << 1) + 0];
+		gtB = gx[(v << 1) + 1];
+		mFp = modp_montymul(Fp[v], R2, p, p0i);
+		mGp = modp_montymul(Gp[v], R2, p, p0i);
+		x[0] = modp_montymul(gtB, mFp, p, p0i);
+		x[llen] = modp_montymul(gtA, mFp, p, p0i);
+		y[0] = modp_montymul(ftB, mGp, p, p0i);
+		y[llen] = modp_montymul(ftA, mGp, p, p0i);
+	}
+	modp_iNTT2_ext(Ft + u, llen, igm, logn, p, p0i);
+	modp_iNTT2_ext(Gt + u, llen, igm, logn, p, p0i);
+
+	/*
+	 * Also save ft and gt (only up to size slen).
+	 */
+	if (u < slen) {
+		modp_iNTT2(fx, igm, logn, p, p0i);
+		modp_iNTT2(gx, igm, logn, p, p0i);
+		for (v = 0, x = ft + u, y = gt + u;
+			v < n; v ++, x += slen, y += slen)
+		{
+			*x = fx[v];
+			*y = gx[v];
+		}
+	}
+}
+
 /*
  * Solving the NTRU equation, binary case, depth = 1. Upon entry, the
  * F and G from the previous level should be in the tmp[] array.
@@ -3449,7 +4397,7 @@ solve_NTRU_intermediate(unsigned logn_top,
  */
 static int
 solve_NTRU_binary_depth1(unsigned logn_top,
-	const int8_t *f, const int8_t *g, uint32_t *tmp)
+	const int8_t *f, const int8_t *g, uint32_t *tmp, const keygen_pool *kp)
 {
 	/*
 	 * The first half of this function is a copy of the corresponding
@@ -3460,13 +4408,12 @@ solve_NTRU_binary_depth1(unsigned logn_top,
 	 * usage.
 	 */
 	unsigned depth, logn;
-	size_t n_top, n, hn, slen, dlen, llen, u;
+	size_t n, hn, slen, dlen, llen, u;
 	uint32_t *Fd, *Gd, *Ft, *Gt, *ft, *gt, *t1;
 	fpr *rt1, *rt2, *rt3, *rt4, *rt5, *rt6;
-	uint32_t *x, *y;
+	solve_NTRU_job job;
 
 	depth = 1;
-	n_top = (size_t)1 << logn_top;
 	logn = logn_top - depth;
 	n = (size_t)1 << logn;
 	hn = n >> 1;
@@ -3513,23 +4460,18 @@ solve_NTRU_binary_depth1(unsigned logn_top,
 	 * We reduce Fd and Gd modulo all the small primes we will need,
 	 * and store the values in Ft and Gt.
 	 */
-	for (u = 0; u < llen; u ++) {
-		uint32_t p, p0i, R2, Rx;
-		size_t v;
-		uint32_t *xs, *ys, *xd, *yd;
-
-		p = PRIMES[u].p;
-		p0i = modp_ninv31(p);
-		R2 = modp_R2(p, p0i);
-		Rx = modp_Rx((unsigned)dlen, p, p0i, R2);
-		for (v = 0, xs = Fd, ys = Gd, xd = Ft + u, yd = Gt + u;
-			v < hn;
-			v ++, xs += dlen, ys += dlen, xd += llen, yd += llen)
-		{
-			*xd = zint_mod_small_signed(xs, dlen, p, p0i, R2, Rx);
-			*yd = zint_mod_small_signed(ys, dlen, p, p0i, R2, Rx);
-		}
-	}
+	job.f = f;
+	job.g = g;
+	job.logn_top = logn_top;
+	job.logn = logn;
+	job.slen = slen;
+	job.dlen = dlen;
+	job.llen = llen;
+	job.Fd = Fd;
+	job.Gd = Gd;
+	job.Ft = Ft;
+	job.Gt = Gt;
+	kg_run(kp, &solve_NTRU_reduce_prime, &job, 0, llen, NULL);
 
 	/*
 	 * Now Fd and Gd are not needed anymore; we can squeeze them out.
@@ -3546,159 +4488,19 @@ solve_NTRU_binary_depth1(unsigned logn_top,
 	/*
 	 * Compute our F and G modulo sufficiently many small primes.
 	 */
-	for (u = 0; u < llen; u ++) {
-		uint32_t p, p0i, R2;
-		uint32_t *gm, *igm, *fx, *gx, *Fp, *Gp;
-		unsigned e;
-		size_t v;
-
-		/*
-		 * All computations are done modulo p.
-		 */
-		p = PRIMES[u].p;
-		p0i = modp_ninv31(p);
-		R2 = modp_R2(p, p0i);
-
-		/*
-		 * We recompute things from the source f and g, of full
-		 * degree. However, we will need only the n first elements
-		 * of the inverse NTT table (igm); the call to modp_mkgm()
-		 * below will fill n_top elements in igm[] (thus overflowing
-		 * into fx[]) but later code will overwrite these extra
-		 * elements.
-		 */
-		gm = t1;
-		igm = gm + n_top;
-		fx = igm + n;
-		gx = fx + n_top;
-		modp_mkgm2(gm, igm, logn_top, PRIMES[u].g, p, p0i);
-
-		/*
-		 * Set ft and gt to f and g modulo p, respectively.
-		 */
-		for (v = 0; v < n_top; v ++) {
-			fx[v] = modp_set(f[v], p);
-			gx[v] = modp_set(g[v], p);
-		}
-
-		/*
-		 * Convert to NTT and compute our f and g.
-		 */
-		modp_NTT2(fx, gm, logn_top, p, p0i);
-		modp_NTT2(gx, gm, logn_top, p, p0i);
-		for (e = logn_top; e > logn; e --) {
-			modp_poly_rec_res(fx, e, p, p0i, R2);
-			modp_poly_rec_res(gx, e, p, p0i, R2);
-		}
-
-		/*
-		 * From that point onward, we only need tables for
-		 * degree n, so we can save some space.
-		 */
-		if (depth > 0) { /* always true */
-			memmove(gm + n, igm, n * sizeof *igm);
-			igm = gm + n;
-			memmove(igm + n, fx, n * sizeof *ft);
-			fx = igm + n;
-			memmove(fx + n, gx, n * sizeof *gt);
-			gx = fx + n;
-		}
-
-		/*
-		 * Get F' and G' modulo p and in NTT representation
-		 * (they have degree n/2). These values were computed
-		 * in a previous step, and stored in Ft and Gt.
-		 */
-		Fp = gx + n;
-		Gp = Fp + hn;
-		for (v = 0, x = Ft + u, y = Gt + u;
-			v < hn; v ++, x += llen, y += llen)
-		{
-			Fp[v] = *x;
-			Gp[v] = *y;
-		}
-		modp_NTT2(Fp, gm, logn - 1, p, p0i);
-		modp_NTT2(Gp, gm, logn - 1, p, p0i);
-
-		/*
-		 * Compute our F and G modulo p.
-		 *
-		 * Equations are:
-		 *
-		 *   f'(x^2) = N(f)(x^2) = f * adj(f)
-		 *   g'(x^2) = N(g)(x^2) = g * adj(g)
-		 *
-		 *   f'*G' - g'*F' = q
-		 *
-		 *   F = F'(x^2) * adj(g)
-		 *   G = G'(x^2) * adj(f)
-		 *
-		 * The NTT representation of f is f(w) for all w which
-		 * are roots of phi. In the binary case, as well as in
-		 * the ternary case for all depth except the deepest,
-		 * these roots can be grouped in pairs (w,-w), and we
-		 * then have:
-		 *
-		 *   f(w) = adj(f)(-w)
-		 *   f(-w) = adj(f)(w)
-		 *
-		 * and w^2 is then a root for phi at the half-degree.
-		 *
-		 * At the deepest level in the ternary case, this still
-		 * holds, in the following sense: the roots of x^2-x+1
-		 * are (w,-w^2) (for w^3 = -1, and w != -1), and we
-		 * have:
-		 *
-		 *   f(w) = adj(f)(-w^2)
-		 *   f(-w^2) = adj(f)(w)
-		 *
-		 * In all case, we can thus compute F and G in NTT
-		 * representation by a few simple multiplications.
-		 * Moreover, the two roots for each pair are consecutive
-		 * in our bit-reversal encoding.
-		 */
-		for (v = 0, x = Ft + u, y = Gt + u;
-			v < hn; v ++, x += (llen << 1), y += (llen << 1))
-		{
-			uint32_t ftA, ftB, gtA, gtB;
-			uint32_t mFp, mGp;
-
-			ftA = fx[(v << 1) + 0];
-			ftB = fx[(v << 1) + 1];
-			gtA = gx[(v << 1) + 0];
-			gtB = gx[(v << 1) + 1];
-			mFp = modp_montymul(Fp[v], R2, p, p0i);
-			mGp = modp_montymul(Gp[v], R2, p, p0i);
-			x[0] = modp_montymul(gtB, mFp, p, p0i);
-			x[llen] = modp_montymul(gtA, mFp, p, p0i);
-			y[0] = modp_montymul(ftB, mGp, p, p0i);
-			y[llen] = modp_montymul(ftA, mGp, p, p0i);
-		}
-		modp_iNTT2_ext(Ft + u, llen, igm, logn, p, p0i);
-		modp_iNTT2_ext(Gt + u, llen, igm, logn, p, p0i);
-
-		/*
-		 * Also save ft and gt (only up to size slen).
-		 */
-		if (u < slen) {
-			modp_iNTT2(fx, igm, logn, p, p0i);
-			modp_iNTT2(gx, igm, logn, p, p0i);
-			for (v = 0, x = ft + u, y = gt + u;
-				v < n; v ++, x += slen, y += slen)
-			{
-				*x = fx[v];
-				*y = gx[v];
-			}
-		}
-	}
+	job.Ft = Ft;
+	job.Gt = Gt;
+	job.ft = ft;
+	job.gt = gt;
+	kg_run(kp, &solve_NTRU_binary_depth1_prime, &job, 0, llen, t1);
 
 	/*
 	 * Rebuild f, g, F and G with the CRT. Note that the elements of F
 	 * and G are consecutive, and thus can be rebuilt in a single
 	 * loop; similarly, the elements of f and g are consecutive.
 	 */
-	zint_rebuild_CRT(Ft, llen, llen, n << 1, PRIMES, 1, t1);
-	zint_rebuild_CRT(ft, slen, slen, n << 1, PRIMES, 1, t1);
+	kg_rebuild_CRT(kp, Ft, llen, llen, n << 1, PRIMES, 1, t1);
+	kg_rebuild_CRT(kp, ft, slen, slen, n << 1, PRIMES, 1, t1);
 
 	/*
 	 * Here starts the Babai reduction, specialized for depth = 1.
@@ -3856,8 +4658,7 @@ solve_NTRU_binary_depth0(unsigned logn,
 	 * the first small prime p = 2147473409.
 	 */
 	p = PRIMES[0].p;
-	p0i = modp_ninv31(p);
-	R2 = modp_R2(p, p0i);
+	modp_prime_init(0, &p0i, &R2);
 
 	Fp = tmp;
 	Gp = Fp + hn;
@@ -3866,7 +4667,7 @@ solve_NTRU_binary_depth0(unsigned logn,
 	gm = gt + n;
 	igm = gm + n;
 
-	modp_mkgm2(gm, igm, logn, PRIMES[0].g, p, p0i);
+	modp_mkgm2_prime(gm, igm, logn, 0, p0i);
 
 	/*
 	 * Convert F' anf G' in NTT representation.
@@ -3930,7 +4731,7 @@ solve_NTRU_binary_depth0(unsigned logn,
 	 * Compute the NTT tables in t1 and t2. We do not keep t2
 	 * (we'll recompute it later on).
 	 */
-	modp_mkgm2(t1, t2, logn, PRIMES[0].g, p, p0i);
+	modp_mkgm2_prime(t1, t2, logn, 0, p0i);
 
 	/*
 	 * Convert F and G to NTT.
@@ -3992,7 +4793,7 @@ solve_NTRU_binary_depth0(unsigned logn,
 	 * move them to t1 and t2. We first need to recompute the
 	 * inverse table for NTT.
 	 */
-	modp_mkgm2(t1, t4, logn, PRIMES[0].g, p, p0i);
+	modp_mkgm2_prime(t1, t4, logn, 0, p0i);
 	modp_iNTT2(t2, t4, logn, p, p0i);
 	modp_iNTT2(t3, t4, logn, p, p0i);
 	for (u = 0; u < n; u ++) {
@@ -4058,7 +4859,7 @@ solve_NTRU_binary_depth0(unsigned logn,
 	t3 = t2 + n;
 	t4 = t3 + n;
 	t5 = t4 + n;
-	modp_mkgm2(t2, t3, logn, PRIMES[0].g, p, p0i);
+	modp_mkgm2_prime(t2, t3, logn, 0, p0i);
 	for (u = 0; u < n; u ++) {
 		t4[u] = modp_set(f[u], p);
 		t5[u] = modp_set(g[u], p);
@@ -4093,7 +4894,8 @@ solve_NTRU_binary_depth0(unsigned logn,
  */
 static int
 solve_NTRU(unsigned logn, int8_t *F, int8_t *G,
-	const int8_t *f, const int8_t *g, int lim, uint32_t *tmp)
+	const int8_t *f, const int8_t *g, int lim, uint32_t *tmp,
+	const keygen_pool *kp)
 {
 	size_t n, u;
 	uint32_t *ft, *gt, *Ft, *Gt, *gm;
@@ -4102,7 +4904,7 @@ solve_NTRU(unsigned logn, int8_t *F, int8_t *G,
 
 	n = MKN(logn);
 
-	if (!solve_NTRU_deepest(logn, f, g, tmp)) {
+	if (!solve_NTRU_deepest(logn, f, g, tmp, kp)) {
 		return 0;
 	}
 
@@ -4116,7 +4918,9 @@ solve_NTRU(unsigned logn, int8_t *F, int8_t *G,
 
 		depth = logn;
 		while (depth -- > 0) {
-			if (!solve_NTRU_intermediate(logn, f, g, depth, tmp)) {
+			if (!solve_NTRU_intermediate(logn,
+				f, g, depth, tmp, kp))
+			{
 				return 0;
 			}
 		}
@@ -4125,11 +4929,13 @@ solve_NTRU(unsigned logn, int8_t *F, int8_t *G,
 
 		depth = logn;
 		while (depth -- > 2) {
-			if (!solve_NTRU_intermediate(logn, f, g, depth, tmp)) {
+			if (!solve_NTRU_intermediate(logn,
+				f, g, depth, tmp, kp))
+			{
 				return 0;
 			}
 		}
-		if (!solve_NTRU_binary_depth1(logn, f, g, tmp)) {
+		if (!solve_NTRU_binary_depth1(logn, f, g, tmp, kp)) {
 			return 0;
 		}
 		if (!solve_NTRU_binary_depth0(logn, f, g, tmp)) {
@@ -4171,7 +4977,7 @@ solve_NTRU(unsigned logn, int8_t *F, int8_t *G,
 	primes = PRIMES;
 	p = primes[0].p;
 	p0i = modp_ninv31(p);
-	modp_mkgm2(gm, tmp, logn, primes[0].g, p, p0i);
+	modp_mkgm2_prime(gm, tmp, logn, 0, p0i);
 	for (u = 0; u < n; u ++) {
 		Gt[u] = modp_set(G[u], p);
 	}
@@ -4400,7 +5206,7 @@ Zf(keygen)(inner_shake256_context *rng,
 		 * Solve the NTRU equation to get F and G.
 		 */
 		lim = (1 << (Zf(max_FG_bits)[logn] - 1)) - 1;
-		if (!solve_NTRU(logn, F, G, f, g, lim, (uint32_t *)tmp)) {
+		if (!solve_NTRU(logn, F, G, f, g, lim, (uint32_t *)tmp, NULL)) {
 			continue;
 		}
 
@@ -4467,11 +5273,20 @@ poly_small_mkgauss_choose(RNG_CONTEXT *rng, int8_t *f, unsigned logn, int parity
 	}
 }
 
-/* see falcon.h */
+/* see inner.h */
 void
 Zf(new_keygen)(inner_shake256_context *rng,
 	int8_t *f, int8_t *g, int8_t *F, int8_t *G, uint16_t *h,
 	unsigned logn, uint8_t *tmp)
+{
+	Zf(new_keygen_pool)(rng, f, g, F, G, h, logn, tmp, NULL);
+}
+
+/* see inner.h */
+void
+Zf(new_keygen_pool)(inner_shake256_context *rng,
+	int8_t *f, int8_t *g, int8_t *F, int8_t *G, uint16_t *h,
+	unsigned logn, uint8_t *tmp, const keygen_pool *kp)
 {
 	/*
 	 * Algorithm is the following:
@@ -4540,7 +5355,11 @@ Zf(new_keygen)(inner_shake256_context *rng,
 		 */
 		        /* 랜덤 비트 하나 뽑아서 어느 쪽을 odd로 할지 결정 */
 		uint8_t bb;
+#if FALCON_KG_CHACHA20  // yyyKG_CHACHA20+1
+		bb = (uint8_t)prng_get_u8(rc);
+#else // yyyKG_CHACHA20+0
 		inner_shake256_extract(rc, &bb, 1);   // 또는 shake256_extract(...)
+#endif  // yyyKG_CHACHA20-
 		int pf = bb & 1;
 		int pg = pf ^ 1;
 
@@ -4637,7 +5456,7 @@ Zf(new_keygen)(inner_shake256_context *rng,
 		 * Solve the NTRU equation to get F and G.
 		 */
 		lim = (1 << (Zf(max_FG_bits)[logn] - 1)) - 1;
-		if (!solve_NTRU(logn, F, G, f, g, lim, (uint32_t *)tmp)) {
+		if (!solve_NTRU(logn, F, G, f, g, lim, (uint32_t *)tmp, kp)) {
 			continue;
 		}
 
@@ -148,30 +148,417 @@ Zf(prng_init)(prng *p, inner_shake256_context *src)
 	Zf(prng_refill)(p);
 }
 
+static const uint32_t CW[] = {
+	0x61707865, 0x3320646e, 0x79622d32, 0x6b206574
+};
+
 /*
- * PRNG based on ChaCha20.
- *
- * State consists in key (32 bytes) then IV (16 bytes) and block counter
- * (8 bytes). Normally, we should not care about local endianness (this
- * is for a PRNG), but for the NIST competition we need reproducible KAT
- * vectors that work across architectures, so we enforce little-endian
- * interpretation where applicable. Moreover, output words are "spread
- * out" over the output buffer with the interleaving pattern that is
- * naturally obtained from the AVX2 implementation that runs eight
- * ChaCha20 instances in parallel.
- *
- * The block counter is XORed into the first 8 bytes of the IV.
+ * Portable ChaCha20 core for prng_refill(): the instances (eight per
+ * 512-byte block, with consecutive counters) are computed four at a
+ * time, with each step of the quarter-rounds done over four independent
+ * lanes, which compilers can keep in vector registers or at least
+ * interleave. Output order is that of the AVX2 implementation: word v
+ * of instance u is 32-bit word u + 8*v of the block.
  */
-TARGET_AVX2
-void
-Zf(prng_refill)(prng *p)
+static void
+prng_refill_portable(prng *p)
 {
-#if FALCON_AVX2 // yyyAVX2+1
+	uint64_t cc;
+	const uint32_t *sw;
+	size_t g;
+
+	/*
+	 * State uses local endianness. Only the output bytes must be
+	 * converted to little endian (if used on a big-endian machine).
+	 */
+	sw = (const uint32_t *)p->state.d;
+	cc = *(uint64_t *)(p->state.d + 48);
+	for (g = 0; g < 8 * FALCON_PRNG_BLOCKS; g += 4) {
+		uint32_t state[16][4];
+		size_t j, v, w;
+		int i;
+
+		for (j = 0; j < 4; j ++) {
+			for (v = 0; v < 4; v ++) {
+				state[v][j] = CW[v];
+			}
+			for (v = 4; v < 14; v ++) {
+				state[v][j] = sw[v - 4];
+			}
+			state[14][j] = sw[10] ^ (uint32_t)(cc + g + j);
+			state[15][j] = sw[11] ^ (uint32_t)((cc + g + j) >> 32);
+		}
+		for (i = 0; i < 10; i ++) {
+
+#define QROUND(a, b, c, d)   do { \
+		for (j = 0; j < 4; j ++) { \
+			state[a][j] += state[b][j]; \
+			state[d][j] ^= state[a][j]; \
+			state[d][j] = (state[d][j] << 16) | (state[d][j] >> 16); \
+			state[c][j] += state[d][j]; \
+			state[b][j] ^= state[c][j]; \
+			state[b][j] = (state[b][j] << 12) | (state[b][j] >> 20); \
+			state[a][j] += state[b][j]; \
+			state[d][j] ^= state[a][j]; \
+			state[d][j] = (state[d][j] <<  8) | (state[d][j] >> 24); \
+			state[c][j] += state[d][j]; \
+			state[b][j] ^= state[c][j]; \
+			state[b][j] = (state[b][j] <<  7) | (state[b][j] >> 25); \
+		} \
+	} while (0)
+
+			QROUND( 0,  4,  8, 12);
+			QROUND( 1,  5,  9, 13);
+			QROUND( 2,  6, 10, 14);
+			QROUND( 3,  7, 11, 15);
+			QROUND( 0,  5, 10, 15);
+			QROUND( 1,  6, 11, 12);
+			QROUND( 2,  7,  8, 13);
+			QROUND( 3,  4,  9, 14);
+
+#undef QROUND
 
-	static const uint32_t CW[] = {
-		0x61707865, 0x3320646e, 0x79622d32, 0x6b206574
+		}
+
+		for (j = 0; j < 4; j ++) {
+			for (v = 0; v < 4; v ++) {
+				state[v][j] += CW[v];
+			}
+			for (v = 4; v < 14; v ++) {
+				state[v][j] += sw[v - 4];
+			}
+			state[14][j] += sw[10] ^ (uint32_t)(cc + g + j);
+			state[15][j] += sw[11] ^ (uint32_t)((cc + g + j) >> 32);
+		}
+
+		/*
+		 * We mimic the interleaving that is used in the AVX2
+		 * implementation; w is the index of the first output word
+		 * of instance g in its block.
+		 */
+		w = ((g & ~(size_t)7) << 4) + (g & 7);
+		for (v = 0; v < 16; v ++) {
+			for (j = 0; j < 4; j ++) {
+#if FALCON_LE  // yyyLE+1
+				((uint32_t *)p->buf.d)[w + j + (v << 3)] =
+					state[v][j];
+#else  // yyyLE+0
+				uint8_t *d;
+
+				d = p->buf.d + ((w + j) << 2) + (v << 5);
+				d[0] = (uint8_t)state[v][j];
+				d[1] = (uint8_t)(state[v][j] >> 8);
+				d[2] = (uint8_t)(state[v][j] >> 16);
+				d[3] = (uint8_t)(state[v][j] >> 24);
+#endif  // yyyLE-
+			}
+		}
+	}
+	*(uint64_t *)(p->state.d + 48) = cc + 8 * FALCON_PRNG_BLOCKS;
+}
+
+#if FALCON_AVX2_RUNTIME
+
+/*
+ * Eight ChaCha20 instances in parallel, one per 32-bit lane of the
+ * AVX2 registers (same computation as the FALCON_AVX2 code in
+ * prng_refill()); this fills the 512-byte block at out. ROL(x, n)
+ * rotates each lane of x by n bits.
+ */
+#define PRNG_CHACHA20_X8(p, out, ROL)   do { \
+		uint64_t cc; \
+		size_t u; \
+		int i; \
+		const uint32_t *sw; \
+		uint32_t t[16]; \
+		__m256i state[16], init[16]; \
+ \
+		sw = (const uint32_t *)(p)->state.d; \
+		cc = *(uint64_t *)((p)->state.d + 48); \
+		*(uint64_t *)((p)->state.d + 48) = cc + 8; \
+		for (u = 0; u < 4; u ++) { \
+			init[u] = _mm256_set1_epi32((int32_t)CW[u]); \
+		} \
+		for (u = 0; u < 10; u ++) { \
+			init[u + 4] = _mm256_set1_epi32((int32_t)sw[u]); \
+		} \
+		for (u = 0; u < 8; u ++) { \
+			t[u] = (uint32_t)(cc + u); \
+			t[u + 8] = (uint32_t)((cc + u) >> 32); \
+		} \
+		init[14] = _mm256_xor_si256( \
+			_mm256_set1_epi32((int32_t)sw[10]), \
+			_mm256_loadu_si256((const __m256i *)&t[0])); \
+		init[15] = _mm256_xor_si256( \
+			_mm256_set1_epi32((int32_t)sw[11]), \
+			_mm256_loadu_si256((const __m256i *)&t[8])); \
+		for (u = 0; u < 16; u ++) { \
+			state[u] = init[u]; \
+		} \
+		for (i = 0; i < 10; i ++) { \
+			PRNG_QROUND_X8(state,  0,  4,  8, 12, ROL); \
+			PRNG_QROUND_X8(state,  1,  5,  9, 13, ROL); \
+			PRNG_QROUND_X8(state,  2,  6, 10, 14, ROL); \
+			PRNG_QROUND_X8(state,  3,  7, 11, 15, ROL); \
+			PRNG_QROUND_X8(state,  0,  5, 10, 15, ROL); \
+			PRNG_QROUND_X8(state,  1,  6, 11, 12, ROL); \
+			PRNG_QROUND_X8(state,  2,  7,  8, 13, ROL); \
+			PRNG_QROUND_X8(state,  3,  4,  9, 14, ROL); \
+		} \
+		for (u = 0; u < 16; u ++) { \
+			_mm256_storeu_si256((__m256i *)((out) + (u << 5)), \
+				_mm256_add_epi32(state[u], init[u])); \
+		} \
+	} while (0)
+
+#define PRNG_QROUND_X8(s, a, b, c, d, ROL)   do { \
+		s[a] = _mm256_add_epi32(s[a], s[b]); \
+		s[d] = ROL(_mm256_xor_si256(s[d], s[a]), 16); \
+		s[c] = _mm256_add_epi32(s[c], s[d]); \
+		s[b] = ROL(_mm256_xor_si256(s[b], s[c]), 12); \
+		s[a] = _mm256_add_epi32(s[a], s[b]); \
+		s[d] = ROL(_mm256_xor_si256(s[d], s[a]), 8); \
+		s[c] = _mm256_add_epi32(s[c], s[d]); \
+		s[b] = ROL(_mm256_xor_si256(s[b], s[c]), 7); \
+	} while (0)
+
+/*
+ * AVX2 has no rotation opcode; rotations by 16 and 8 bits are byte
+ * shuffles, the other ones use two shifts.
+ */
+#define PRNG_ROL_AVX2(x, n)   ((n) == 16 ? _mm256_shuffle_epi8((x), \
+		_mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, \
+			10, 11, 8, 9, 14, 15, 12, 13, \
+			2, 3, 0, 1, 6, 7, 4, 5, \
+			10, 11, 8, 9, 14, 15, 12, 13)) \
+	: (n) == 8 ? _mm256_shuffle_epi8((x), \
+		_mm256_setr_epi8(3, 0, 1, 2, 7, 4, 5, 6, \
+			11, 8, 9, 10, 15, 12, 13, 14, \
+			3, 0, 1, 2, 7, 4, 5, 6, \
+			11, 8, 9, 10, 15, 12, 13, 14)) \
+	: _mm256_or_si256(_mm256_slli_epi32((x), (n)), \
+		_mm256_srli_epi32((x), 32 - (n))))
+
+#define PRNG_ROL_AVX512(x, n)   _mm256_rol_epi32((x), (n))
+
+TARGET_AVX2_RUNTIME
+static void
+prng_refill_avx2(prng *p)
+{
+	size_t k;
+
+	for (k = 0; k < FALCON_PRNG_BLOCKS; k ++) {
+		PRNG_CHACHA20_X8(p, p->buf.d + (k << 9), PRNG_ROL_AVX2);
+	}
+}
+
+#define PRNG_QROUND_X16(s, a, b, c, d)   do { \
+		s[a] = _mm512_add_epi32(s[a], s[b]); \
+		s[d] = _mm512_rol_epi32(_mm512_xor_si512(s[d], s[a]), 16); \
+		s[c] = _mm512_add_epi32(s[c], s[d]); \
+		s[b] = _mm512_rol_epi32(_mm512_xor_si512(s[b], s[c]), 12); \
+		s[a] = _mm512_add_epi32(s[a], s[b]); \
+		s[d] = _mm512_rol_epi32(_mm512_xor_si512(s[d], s[a]), 8); \
+		s[c] = _mm512_add_epi32(s[c], s[d]); \
+		s[b] = _mm512_rol_epi32(_mm512_xor_si512(s[b], s[c]), 7); \
+	} while (0)
+
+/*
+ * The AVX-512 code computes two blocks at a time, with sixteen ChaCha20
+ * instances in the 32-bit lanes of the 512-bit registers: the low half
+ * of each register goes to the first block, the high half to the
+ * second one. With an odd number of blocks, the last one is computed
+ * with the 256-bit code.
+ */
+TARGET_AVX512_RUNTIME
+static void
+prng_refill_avx512(prng *p)
+{
+	size_t k;
+
+	for (k = 0; k + 1 < FALCON_PRNG_BLOCKS; k += 2) {
+		uint64_t cc;
+		size_t u;
+		int i;
+		const uint32_t *sw;
+		uint32_t t[32];
+		uint8_t *out;
+		__m512i state[16], init[16];
+
+		sw = (const uint32_t *)p->state.d;
+		cc = *(uint64_t *)(p->state.d + 48);
+		*(uint64_t *)(p->state.d + 48) = cc + 16;
+		for (u = 0; u < 4; u ++) {
+			init[u] = _mm512_set1_epi32((int32_t)CW[u]);
+		}
+		for (u = 0; u < 10; u ++) {
+			init[u + 4] = _mm512_set1_epi32((int32_t)sw[u]);
+		}
+		for (u = 0; u < 16; u ++) {
+			t[u] = (uint32_t)(cc + u);
+			t[u + 16] = (uint32_t)((cc + u) >> 32);
+		}
+		init[14] = _mm512_xor_si512(
+			_mm512_set1_epi32((int32_t)sw[10]),
+			_mm512_loadu_si512((const void *)&t[0]));
+		init[15] = _mm512_xor_si512(
+			_mm512_set1_epi32((int32_t)sw[11]),
+			_mm512_loadu_si512((const void *)&t[16]));
+		for (u = 0; u < 16; u ++) {
+			state[u] = init[u];
+		}
+		for (i = 0; i < 10; i ++) {
+			PRNG_QROUND_X16(state,  0,  4,  8, 12);
+			PRNG_QROUND_X16(state,  1,  5,  9, 13);
+			PRNG_QROUND_X16(state,  2,  6, 10, 14);
+			PRNG_QROUND_X16(state,  3,  7, 11, 15);
+			PRNG_QROUND_X16(state,  0,  5, 10, 15);
+			PRNG_QROUND_X16(state,  1,  6, 11, 12);
+			PRNG_QROUND_X16(state,  2,  7,  8, 13);
+			PRNG_QROUND_X16(state,  3,  4,  9, 14);
+		}
+		out = p->buf.d + (k << 9);
+		for (u = 0; u < 16; u ++) {
+			__m512i y;
+
+			y = _mm512_add_epi32(state[u], init[u]);
+			_mm256_storeu_si256((__m256i *)(out + (u << 5)),
+				_mm512_castsi512_si256(y));
+			_mm256_storeu_si256((__m256i *)(out + 512 + (u << 5)),
+				_mm512_extracti64x4_epi64(y, 1));
+		}
+	}
+#if FALCON_PRNG_BLOCKS & 1
+	PRNG_CHACHA20_X8(p, p->buf.d + (k << 9), PRNG_ROL_AVX512);
+#endif
+}
+
+#endif
+
+#if FALCON_AVX2_RUNTIME && !FALCON_AVX2
+
+/*
+ * Known-answer test for a refill implementation: one refill from a
+ * fixed state, whose block counter carries into its high word in the
+ * first block; the output buffer and the updated state must match
+ * those obtained with the portable code, and the SHAKE256 digest of
+ * the first block must match a fixed value (the other blocks depend
+ * on FALCON_PRNG_BLOCKS). Returned value is 1 on success, 0 on error.
+ */
+static int
+prng_refill_selftest(int impl)
+{
+	static const uint8_t kat[32] = {
+		0x3F, 0xDF, 0x9E, 0xD1, 0x25, 0x36, 0x08, 0x3C,
+		0x58, 0x7B, 0x77, 0x52, 0x4F, 0xEB, 0x2E, 0xC7,
+		0x80, 0x07, 0xB7, 0x1F, 0xC0, 0x5F, 0x22, 0xAD,
+		0x49, 0x53, 0xB3, 0x47, 0xC8, 0xEF, 0xB4, 0x7B
 	};
 
+	prng p, q;
+	inner_shake256_context dig;
+	uint8_t out[32];
+	size_t u;
+
+	for (u = 0; u < 48; u ++) {
+		p.state.d[u] = (uint8_t)(u * 37 + 11);
+	}
+	*(uint64_t *)(p.state.d + 48) = 0xFFFFFFFCu;
+	q = p;
+	prng_refill_portable(&q);
+	inner_shake256_init(&dig);
+	inner_shake256_inject(&dig, q.buf.d, 512);
+	inner_shake256_flip(&dig);
+	inner_shake256_extract(&dig, out, sizeof out);
+	if (memcmp(out, kat, sizeof kat) != 0) {
+		return 0;
+	}
+	if (!Zf(prng_refill_using)(&p, impl)) {
+		return 0;
+	}
+	return memcmp(p.buf.d, q.buf.d, sizeof p.buf.d) == 0
+		&& memcmp(p.state.d, q.state.d, 56) == 0;
+}
+
+#endif
+
+/* see inner.h */
+int
+Zf(prng_refill_selected)(void)
+{
+#if FALCON_AVX2 // yyyAVX2+1
+	return PRNG_REFILL_AVX2;
+#else // yyyAVX2+0
+#if FALCON_AVX2_RUNTIME
+	/*
+	 * 0 means "not selected yet"; otherwise, the implementation plus
+	 * one. Concurrent first calls all compute and store the same
+	 * value.
+	 */
+	static int sel = 0;
+	int r;
+
+	r = __atomic_load_n(&sel, __ATOMIC_RELAXED);
+	if (r == 0) {
+		if (cpu_has_avx512vl()
+			&& prng_refill_selftest(PRNG_REFILL_AVX512))
+		{
+			r = PRNG_REFILL_AVX512 + 1;
+		} else if (cpu_has_avx2()
+			&& prng_refill_selftest(PRNG_REFILL_AVX2))
+		{
+			r = PRNG_REFILL_AVX2 + 1;
+		} else {
+			r = PRNG_REFILL_PORTABLE + 1;
+		}
+		__atomic_store_n(&sel, r, __ATOMIC_RELAXED);
+	}
+	return r - 1;
+#else
+	return PRNG_REFILL_PORTABLE;
+#endif
+#endif // yyyAVX2-
+}
+
+/* see inner.h */
+int
+Zf(prng_refill_using)(prng *p, int impl)
+{
+	switch (impl) {
+	case PRNG_REFILL_PORTABLE:
+		prng_refill_portable(p);
+		break;
+#if FALCON_AVX2_RUNTIME
+	case PRNG_REFILL_AVX2:
+		if (!cpu_has_avx2()) {
+			return 0;
+		}
+		prng_refill_avx2(p);
+		break;
+	case PRNG_REFILL_AVX512:
+		if (!cpu_has_avx512vl()) {
+			return 0;
+		}
+		prng_refill_avx512(p);
+		break;
+#endif
+	default:
+		return 0;
+	}
+	p->ptr = 0;
+	return 1;
+}
+
+#if FALCON_AVX2 // yyyAVX2+1
+
+/*
+ * Compute one 512-byte block of output (eight ChaCha20 instances) into
+ * out, and advance the block counter.
+ */
+TARGET_AVX2
+static void
+prng_chacha20_block(prng *p, uint8_t *out)
+{
 	uint64_t cc;
 	size_t u;
 	int i;
@@ -259,95 +646,58 @@ Zf(prng_refill)(prng *p)
 	 * code uses a compatible order of values.
 	 */
 	for (u = 0; u < 16; u ++) {
-		_mm256_storeu_si256((__m256i *)&p->buf.d[u << 5],
+		_mm256_storeu_si256((__m256i *)(out + (u << 5)),
 			_mm256_add_epi32(state[u], init[u]));
 	}
+}
 
-#else // yyyAVX2+0
-
-	static const uint32_t CW[] = {
-		0x61707865, 0x3320646e, 0x79622d32, 0x6b206574
-	};
-
-	uint64_t cc;
-	size_t u;
-
-	/*
-	 * State uses local endianness. Only the output bytes must be
-	 * converted to little endian (if used on a big-endian machine).
-	 */
-	cc = *(uint64_t *)(p->state.d + 48);
-	for (u = 0; u < 8; u ++) {
-		uint32_t state[16];
-		size_t v;
-		int i;
-
-		memcpy(&state[0], CW, sizeof CW);
-		memcpy(&state[4], p->state.d, 48);
-		state[14] ^= (uint32_t)cc;
-		state[15] ^= (uint32_t)(cc >> 32);
-		for (i = 0; i < 10; i ++) {
-
-#define QROUND(a, b, c, d)   do { \
-		state[a] += state[b]; \
-		state[d] ^= state[a]; \
-		state[d] = (state[d] << 16) | (state[d] >> 16); \
-		state[c] += state[d]; \
-		state[b] ^= state[c]; \
-		state[b] = (state[b] << 12) | (state[b] >> 20); \
-		state[a] += state[b]; \
-		state[d] ^= state[a]; \
-		state[d] = (state[d] <<  8) | (state[d] >> 24); \
-		state[c] += state[d]; \
-		state[b] ^= state[c]; \
-		state[b] = (state[b] <<  7) | (state[b] >> 25); \
-	} while (0)
+#endif // yyyAVX2-
 
-			QROUND( 0,  4,  8, 12);
-			QROUND( 1,  5,  9, 13);
-			QROUND( 2,  6, 10, 14);
-			QROUND( 3,  7, 11, 15);
-			QROUND( 0,  5, 10, 15);
-			QROUND( 1,  6, 11, 12);
-			QROUND( 2,  7,  8, 13);
-			QROUND( 3,  4,  9, 14);
+/*
+ * PRNG based on ChaCha20.
+ *
+ * State consists in key (32 bytes) then IV (16 bytes) and block counter
+ * (8 bytes). Normally, we should not care about local endianness (this
+ * is for a PRNG), but for the NIST competition we need reproducible KAT
+ * vectors that work across architectures, so we enforce little-endian
+ * interpretation where applicable. Moreover, output words are "spread
+ * out" over the output buffer with the interleaving pattern that is
+ * naturally obtained from the AVX2 implementation that runs eight
+ * ChaCha20 instances in parallel. A refill produces FALCON_PRNG_BLOCKS
+ * such 512-byte blocks, in the order in which successive refills of a
+ * single block would.
+ *
+ * The block counter is XORed into the first 8 bytes of the IV.
+ */
+TARGET_AVX2
+void
+Zf(prng_refill)(prng *p)
+{
+#if FALCON_AVX2 // yyyAVX2+1
 
-#undef QROUND
+	size_t k;
 
-		}
+	for (k = 0; k < FALCON_PRNG_BLOCKS; k ++) {
+		prng_chacha20_block(p, p->buf.d + (k << 9));
+	}
 
-		for (v = 0; v < 4; v ++) {
-			state[v] += CW[v];
-		}
-		for (v = 4; v < 14; v ++) {
-			state[v] += ((uint32_t *)p->state.d)[v - 4];
-		}
-		state[14] += ((uint32_t *)p->state.d)[10]
-			^ (uint32_t)cc;
-		state[15] += ((uint32_t *)p->state.d)[11]
-			^ (uint32_t)(cc >> 32);
-		cc ++;
+#else // yyyAVX2+0
 
-		/*
-		 * We mimic the interleaving that is used in the AVX2
-		 * implementation.
-		 */
-		for (v = 0; v < 16; v ++) {
-#if FALCON_LE  // yyyLE+1
-			((uint32_t *)p->buf.d)[u + (v << 3)] = state[v];
-#else  // yyyLE+0
-			p->buf.d[(u << 2) + (v << 5) + 0] =
-				(uint8_t)state[v];
-			p->buf.d[(u << 2) + (v << 5) + 1] =
-				(uint8_t)(state[v] >> 8);
-			p->buf.d[(u << 2) + (v << 5) + 2] =
-				(uint8_t)(state[v] >> 16);
-			p->buf.d[(u << 2) + (v << 5) + 3] =
-				(uint8_t)(state[v] >> 24);
-#endif  // yyyLE-
-		}
+#if FALCON_AVX2_RUNTIME
+	switch (Zf(prng_refill_selected)()) {
+	case PRNG_REFILL_AVX512:
+		prng_refill_avx512(p);
+		break;
+	case PRNG_REFILL_AVX2:
+		prng_refill_avx2(p);
+		break;
+	default:
+		prng_refill_portable(p);
+		break;
 	}
-	*(uint64_t *)(p->state.d + 48) = cc;
+#else
+	prng_refill_portable(p);
+#endif
 
 #endif // yyyAVX2-
 
@@ -360,15 +710,21 @@ Zf(prng_get_bytes)(prng *p, void *dst, size_t len)
 {
 	uint8_t *buf;
 
+	/*
+	 * Bytes are copied from the start of the current 512-byte block,
+	 * not from the current position; this quirk of the reference
+	 * implementation is kept so that the output stream is unchanged.
+	 */
 	buf = dst;
 	while (len > 0) {
-		size_t clen;
+		size_t b, clen;
 
-		clen = (sizeof p->buf.d) - p->ptr;
+		b = p->ptr & ~(size_t)511;
+		clen = b + 512 - p->ptr;
 		if (clen > len) {
 			clen = len;
 		}
-		memcpy(buf, p->buf.d, clen);
+		memcpy(buf, p->buf.d + b, clen);
 		buf += clen;
 		len -= clen;
 		p->ptr += clen;
@@ -1175,3 +1175,244 @@ Zf(i_shake256_extract)(inner_shake256_context *sc, uint8_t *out, size_t len)
 	}
 	sc->dptr = dptr;
 }
+
+/* ===================================================================== */
+/*
+ * Multi-lane Keccak-f[1600]: four independent states are permuted at
+ * once. This is used to squeeze several SHAKE256 outputs in parallel
+ * (e.g. to hash several messages to points for batch verification).
+ *
+ * The permutation is written in its textbook form (theta, rho, pi,
+ * chi, iota); it computes exactly the same function as process_block().
+ */
+
+/*
+ * One round of Keccak-f[1600] (without iota) over the lanes A[0..24];
+ * B[], C[] and D[] are scratch arrays of 25, 5 and 5 lanes. Lane
+ * operations are provided as the XOR(), ROL() and ANDN() macros
+ * (ANDN(x, y) = ~x & y), so that the same round code is used for plain
+ * 64-bit words and for vectors of lanes.
+ */
+#define KECCAK_ROUND(A, B, C, D, XOR, ROL, ANDN)   do { \
+		C[0] = XOR(XOR(XOR(A[ 0], A[ 5]), XOR(A[10], A[15])), A[20]); \
+		C[1] = XOR(XOR(XOR(A[ 1], A[ 6]), XOR(A[11], A[16])), A[21]); \
+		C[2] = XOR(XOR(XOR(A[ 2], A[ 7]), XOR(A[12], A[17])), A[22]); \
+		C[3] = XOR(XOR(XOR(A[ 3], A[ 8]), XOR(A[13], A[18])), A[23]); \
+		C[4] = XOR(XOR(XOR(A[ 4], A[ 9]), XOR(A[14], A[19])), A[24]); \
+		D[0] = XOR(C[4], ROL(C[1], 1)); \
+		D[1] = XOR(C[0], ROL(C[2], 1)); \
+		D[2] = XOR(C[1], ROL(C[3], 1)); \
+		D[3] = XOR(C[2], ROL(C[4], 1)); \
+		D[4] = XOR(C[3], ROL(C[0], 1)); \
+		B[ 0] = XOR(A[ 0], D[0]); \
+		B[10] = ROL(XOR(A[ 1], D[1]), 1); \
+		B[20] = ROL(XOR(A[ 2], D[2]), 62); \
+		B[ 5] = ROL(XOR(A[ 3], D[3]), 28); \
+		B[15] = ROL(XOR(A[ 4], D[4]), 27); \
+		B[16] = ROL(XOR(A[ 5], D[0]), 36); \
+		B[ 1] = ROL(XOR(A[ 6], D[1]), 44); \
+		B[11] = ROL(XOR(A[ 7], D[2]), 6); \
+		B[21] = ROL(XOR(A[ 8], D[3]), 55); \
+		B[ 6] = ROL(XOR(A[ 9], D[4]), 20); \
+		B[ 7] = ROL(XOR(A[10], D[0]), 3); \
+		B[17] = ROL(XOR(A[11], D[1]), 10); \
+		B[ 2] = ROL(XOR(A[12], D[2]), 43); \
+		B[12] = ROL(XOR(A[13], D[3]), 25); \
+		B[22] = ROL(XOR(A[14], D[4]), 39); \
+		B[23] = ROL(XOR(A[15], D[0]), 41); \
+		B[ 8] = ROL(XOR(A[16], D[1]), 45); \
+		B[18] = ROL(XOR(A[17], D[2]), 15); \
+		B[ 3] = ROL(XOR(A[18], D[3]), 21); \
+		B[13] = ROL(XOR(A[19], D[4]), 8); \
+		B[14] = ROL(XOR(A[20], D[0]), 18); \
+		B[24] = ROL(XOR(A[21], D[1]), 2); \
+		B[ 9] = ROL(XOR(A[22], D[2]), 61); \
+		B[19] = ROL(XOR(A[23], D[3]), 56); \
+		B[ 4] = ROL(XOR(A[24], D[4]), 14); \
+		A[ 0] = XOR(B[ 0], ANDN(B[ 1], B[ 2])); \
+		A[ 1] = XOR(B[ 1], ANDN(B[ 2], B[ 3])); \
+		A[ 2] = XOR(B[ 2], ANDN(B[ 3], B[ 4])); \
+		A[ 3] = XOR(B[ 3], ANDN(B[ 4], B[ 0])); \
+		A[ 4] = XOR(B[ 4], ANDN(B[ 0], B[ 1])); \
+		A[ 5] = XOR(B[ 5], ANDN(B[ 6], B[ 7])); \
+		A[ 6] = XOR(B[ 6], ANDN(B[ 7], B[ 8])); \
+		A[ 7] = XOR(B[ 7], ANDN(B[ 8], B[ 9])); \
+		A[ 8] = XOR(B[ 8], ANDN(B[ 9], B[ 5])); \
+		A[ 9] = XOR(B[ 9], ANDN(B[ 5], B[ 6])); \
+		A[10] = XOR(B[10], ANDN(B[11], B[12])); \
+		A[11] = XOR(B[11], ANDN(B[12], B[13])); \
+		A[12] = XOR(B[12], ANDN(B[13], B[14])); \
+		A[13] = XOR(B[13], ANDN(B[14], B[10])); \
+		A[14] = XOR(B[14], ANDN(B[10], B[11])); \
+		A[15] = XOR(B[15], ANDN(B[16], B[17])); \
+		A[16] = XOR(B[16], ANDN(B[17], B[18])); \
+		A[17] = XOR(B[17], ANDN(B[18], B[19])); \
+		A[18] = XOR(B[18], ANDN(B[19], B[15])); \
+		A[19] = XOR(B[19], ANDN(B[15], B[16])); \
+		A[20] = XOR(B[20], ANDN(B[21], B[22])); \
+		A[21] = XOR(B[21], ANDN(B[22], B[23])); \
+		A[22] = XOR(B[22], ANDN(B[23], B[24])); \
+		A[23] = XOR(B[23], ANDN(B[24], B[20])); \
+		A[24] = XOR(B[24], ANDN(B[20], B[21])); \
+	} while (0)
+
+static const uint64_t KECCAK_RC[] = {
+	0x0000000000000001, 0x0000000000008082,
+	0x800000000000808A, 0x8000000080008000,
+	0x000000000000808B, 0x0000000080000001,
+	0x8000000080008081, 0x8000000000008009,
+	0x000000000000008A, 0x0000000000000088,
+	0x0000000080008009, 0x000000008000000A,
+	0x000000008000808B, 0x800000000000008B,
+	0x8000000000008089, 0x8000000000008003,
+	0x8000000000008002, 0x8000000000000080,
+	0x000000000000800A, 0x800000008000000A,
+	0x8000000080008081, 0x8000000000008080,
+	0x0000000080000001, 0x8000000080008008
+};
+
+#define KECCAK_XOR64(x, y)    ((x) ^ (y))
+#define KECCAK_ROL64(x, n)    (((x) << (n)) | ((x) >> (64 - (n))))
+#define KECCAK_ANDN64(x, y)   (~(x) & (y))
+
+/*
+ * Portable two-way interleaved permutation: both states go through
+ * the same round sequence, which gives the CPU two independent
+ * dependency chains to schedule.
+ */
+static void
+process_block_x2(uint64_t *A0, uint64_t *A1)
+{
+	uint64_t B0[25], C0[5], D0[5];
+	uint64_t B1[25], C1[5], D1[5];
+	int j;
+
+	for (j = 0; j < 24; j ++) {
+		KECCAK_ROUND(A0, B0, C0, D0,
+			KECCAK_XOR64, KECCAK_ROL64, KECCAK_ANDN64);
+		KECCAK_ROUND(A1, B1, C1, D1,
+			KECCAK_XOR64, KECCAK_ROL64, KECCAK_ANDN64);
+		A0[0] ^= KECCAK_RC[j];
+		A1[0] ^= KECCAK_RC[j];
+	}
+}
+
+#if FALCON_AVX2_RUNTIME
+
+#define KECCAK_XOR256(x, y)    _mm256_xor_si256(x, y)
+#define KECCAK_ROL256(x, n)    _mm256_or_si256( \
+		_mm256_slli_epi64(x, n), _mm256_srli_epi64(x, 64 - (n)))
+#define KECCAK_ANDN256(x, y)   _mm256_andnot_si256(x, y)
+
+/*
+ * AVX2 four-way permutation: each 256-bit register holds the same
+ * lane of the four states.
+ */
+TARGET_AVX2_RUNTIME
+static void
+process_block_x4_avx2(inner_shake256_context *sc)
+{
+	__m256i A[25], B[25], C[5], D[5];
+	int j, x;
+
+	for (x = 0; x < 25; x ++) {
+		A[x] = _mm256_setr_epi64x(
+			(long long)sc[0].st.A[x], (long long)sc[1].st.A[x],
+			(long long)sc[2].st.A[x], (long long)sc[3].st.A[x]);
+	}
+	for (j = 0; j < 24; j ++) {
+		KECCAK_ROUND(A, B, C, D,
+			KECCAK_XOR256, KECCAK_ROL256, KECCAK_ANDN256);
+		A[0] = _mm256_xor_si256(A[0],
+			_mm256_set1_epi64x((long long)KECCAK_RC[j]));
+	}
+	for (x = 0; x < 25; x ++) {
+		uint64_t t[4];
+
+		_mm256_storeu_si256((__m256i *)t, A[x]);
+		sc[0].st.A[x] = t[0];
+		sc[1].st.A[x] = t[1];
+		sc[2].st.A[x] = t[2];
+		sc[3].st.A[x] = t[3];
+	}
+}
+
+#endif
+
+/*
+ * Permute the states of four SHAKE256 contexts.
+ */
+static void
+process_block_x4(inner_shake256_context *sc)
+{
+#if FALCON_AVX2_RUNTIME
+	if (cpu_has_avx2()) {
+		process_block_x4_avx2(sc);
+		return;
+	}
+#endif
+	process_block_x2(sc[0].st.A, sc[1].st.A);
+	process_block_x2(sc[2].st.A, sc[3].st.A);
+}
+
+/* see inner.h */
+void
+Zf(i_shake256_extract_x4)(inner_shake256_context *sc, uint8_t *out, size_t len)
+{
+	size_t dptr, off;
+	int i;
+
+	/*
+	 * The four contexts are squeezed in lockstep, which requires
+	 * them to be at the same output position (this is always the
+	 * case right after flipping). Otherwise, we simply extract
+	 * from each context in turn.
+	 */
+	dptr = (size_t)sc[0].dptr;
+	if (sc[1].dptr != dptr || sc[2].dptr != dptr || sc[3].dptr != dptr) {
+		for (i = 0; i < 4; i ++) {
+			Zf(i_shake256_extract)(&sc[i], out + (size_t)i * len, len);
+		}
+		return;
+	}
+
+	off = 0;
+	while (off < len) {
+		size_t clen;
+
+		if (dptr == 136) {
+			process_block_x4(sc);
+			dptr = 0;
+		}
+		clen = 136 - dptr;
+		if (clen > len - off) {
+			clen = len - off;
+		}
+		for (i = 0; i < 4; i ++) {
+			uint8_t *d;
+
+			d = out + (size_t)i * len + off;
+#if FALCON_LE  // yyyLE+1
+			memcpy(d, sc[i].st.dbuf + dptr, clen);
+#else  // yyyLE+0
+			{
+				size_t u;
+
+				for (u = 0; u < clen; u ++) {
+					size_t v;
+
+					v = dptr + u;
+					d[u] = (uint8_t)(sc[i].st.A[v >> 3]
+						>> ((v & 7) << 3));
+				}
+			}
+#endif  // yyyLE-
+		}
+		dptr += clen;
+		off += clen;
+	}
+	for (i = 0; i < 4; i ++) {
+		sc[i].dptr = dptr;
+	}
+}
+
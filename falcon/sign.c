@@ -291,23 +291,7 @@ Zf(expand_privkey)(fpr *restrict expanded_key,
 	g11 = g01 + n;
 	gxx = g11 + n;
 
-	memcpy(g00, b00, n * sizeof *b00);
-	Zf(poly_mulselfadj_fft)(g00, logn);
-	memcpy(gxx, b01, n * sizeof *b01);
-	Zf(poly_mulselfadj_fft)(gxx, logn);
-	Zf(poly_add)(g00, gxx, logn);
-
-	memcpy(g01, b00, n * sizeof *b00);
-	Zf(poly_muladj_fft)(g01, b10, logn);
-	memcpy(gxx, b01, n * sizeof *b01);
-	Zf(poly_muladj_fft)(gxx, b11, logn);
-	Zf(poly_add)(g01, gxx, logn);
-
-	memcpy(g11, b10, n * sizeof *b10);
-	Zf(poly_mulselfadj_fft)(g11, logn);
-	memcpy(gxx, b11, n * sizeof *b11);
-	Zf(poly_mulselfadj_fft)(gxx, logn);
-	Zf(poly_add)(g11, gxx, logn);
+	Zf(poly_gram_fft)(g00, g01, g11, b00, b01, b10, b11, logn);
 
 	/*
 	 * Compute the Falcon tree.
@@ -322,104 +306,611 @@ Zf(expand_privkey)(fpr *restrict expanded_key,
 
 typedef int (*samplerZ)(void *ctx, fpr mu, fpr sigma);
 
+/*
+ * State of one level of ffSampling_fft_dyntree(): target (t0,t1),
+ * Gram matrix, and temporary buffer.
+ */
+typedef struct {
+	fpr *t0, *t1, *g00, *g01, *g11, *tmp;
+} ffs_dyn_frame;
+
 /*
  * Perform Fast Fourier Sampling for target vector t. The Gram matrix
  * is provided (G = [[g00, g01], [adj(g01), g11]]). The sampled vector
  * is written over (t0,t1). The Gram matrix is modified as well. The
  * tmp[] buffer must have room for four polynomials.
+ *
+ * The recursion over the LDL tree is unrolled into a loop over an
+ * explicit stack of frames, one per level. The traversal order is
+ * that of the recursive description: at each level, decompose G into
+ * LDL, sample the right sub-tree (on the split t1), then the left
+ * sub-tree (on the split t0 + (t1 - z1)*l10). Each level uses tmp[] at
+ * the offsets the recursive calls would use: l10 at tmp, the right
+ * sub-tree at tmp + n (its own tmp[] at tmp + 2*n), the left sub-tree
+ * at tmp (its own tmp[] at tmp + n).
  */
 TARGET_AVX2
 static void
 ffSampling_fft_dyntree(samplerZ samp, void *samp_ctx,
 	fpr *restrict t0, fpr *restrict t1,
 	fpr *restrict g00, fpr *restrict g01, fpr *restrict g11,
-	unsigned orig_logn, unsigned logn, fpr *restrict tmp)
+	unsigned logn, fpr *restrict tmp)
 {
-	size_t n, hn;
-	fpr *z0, *z1;
+	ffs_dyn_frame fr[11];
+	unsigned lev;
+	uint32_t side;
+
+	fr[logn].t0 = t0;
+	fr[logn].t1 = t1;
+	fr[logn].g00 = g00;
+	fr[logn].g01 = g01;
+	fr[logn].g11 = g11;
+	fr[logn].tmp = tmp;
+	lev = logn;
+	side = 0;
+	for (;;) {
+		fpr leaf;
+
+		/*
+		 * Go down along the right sub-trees to a leaf. At each
+		 * level, we decompose G into LDL (we only need d00,
+		 * identical to g00, d11, and l10; we do that in place),
+		 * then split d00 and d11 and expand them into half-size
+		 * quasi-cyclic Gram matrices. l10 is saved in tmp[].
+		 *
+		 * The half-size Gram matrices are then:
+		 *   - left sub-tree: g00, g00+hn, g01
+		 *   - right sub-tree: g11, g11+hn, g01+hn
+		 */
+		while (lev > 0) {
+			ffs_dyn_frame *f, *c;
+			size_t n, hn;
+			fpr *z1;
+
+			f = &fr[lev];
+			c = &fr[lev - 1];
+			n = (size_t)1 << lev;
+			hn = n >> 1;
+			Zf(poly_LDL_fft)(f->g00, f->g01, f->g11, lev);
+			Zf(poly_split_fft)(f->tmp, f->tmp + hn, f->g00, lev);
+			memcpy(f->g00, f->tmp, n * sizeof *f->tmp);
+			Zf(poly_split_fft)(f->tmp, f->tmp + hn, f->g11, lev);
+			memcpy(f->g11, f->tmp, n * sizeof *f->tmp);
+			memcpy(f->tmp, f->g01, n * sizeof *f->g01);
+			memcpy(f->g01, f->g00, hn * sizeof *f->g00);
+			memcpy(f->g01 + hn, f->g11, hn * sizeof *f->g00);
+
+			z1 = f->tmp + n;
+			Zf(poly_split_fft)(z1, z1 + hn, f->t1, lev);
+			c->t0 = z1;
+			c->t1 = z1 + hn;
+			c->g00 = f->g11;
+			c->g01 = f->g11 + hn;
+			c->g11 = f->g01 + hn;
+			c->tmp = z1 + n;
+			lev --;
+		}
+
+		/*
+		 * Leaf: the LDL tree leaf value is just g00 (the array
+		 * has length only 1 at this point); we normalize it with
+		 * regards to sigma, then use it for sampling.
+		 */
+		leaf = fr[0].g00[0];
+		leaf = fpr_mul(fpr_sqrt(leaf), fpr_inv_sigma[logn]);
+		fr[0].t0[0] = fpr_of(samp(samp_ctx, fr[0].t0[0], leaf));
+		fr[0].t1[0] = fpr_of(samp(samp_ctx, fr[0].t1[0], leaf));
+
+		/*
+		 * Go up until we find a level whose left sub-tree was
+		 * not sampled yet.
+		 */
+		for (;;) {
+			ffs_dyn_frame *f, *c;
+			size_t n, hn;
+			fpr *z0, *z1, *zm;
+
+			if (++ lev > logn) {
+				return;
+			}
+			f = &fr[lev];
+			c = &fr[lev - 1];
+			n = (size_t)1 << lev;
+			hn = n >> 1;
+			if ((side >> lev) & 1) {
+				/*
+				 * Both sub-trees are done: merge z0 into t0.
+				 */
+				Zf(poly_merge_fft)(f->t0,
+					f->tmp, f->tmp + hn, lev);
+				side &= ~((uint32_t)1 << lev);
+				continue;
+			}
+
+			/*
+			 * The right sub-tree is done; its output is merged
+			 * into zm = tmp + 2*n. We then compute
+			 * tb0 = t0 + (t1 - z1) * l10. At that point, l10 is
+			 * in tmp, t1 is unmodified, and z1 is in zm. In the
+			 * end, z1 is written over t1, and tb0 is in t0.
+			 */
+			z1 = f->tmp + n;
+			zm = z1 + n;
+			Zf(poly_merge_fft)(zm, z1, z1 + hn, lev);
+			memcpy(z1, f->t1, n * sizeof *f->t1);
+			Zf(poly_sub)(z1, zm, lev);
+			memcpy(f->t1, zm, n * sizeof *zm);
+			Zf(poly_mul_fft)(f->tmp, z1, lev);
+			Zf(poly_add)(f->t0, f->tmp, lev);
+
+			/*
+			 * The left sub-tree gets the split tb0.
+			 */
+			z0 = f->tmp;
+			Zf(poly_split_fft)(z0, z0 + hn, f->t0, lev);
+			c->t0 = z0;
+			c->t1 = z0 + hn;
+			c->g00 = f->g00;
+			c->g01 = f->g00 + hn;
+			c->g11 = f->g01;
+			c->tmp = z0 + n;
+			side |= (uint32_t)1 << lev;
+			lev --;
+			break;
+		}
+	}
+}
+
+/*
+ * ffSampling leaf kernels, for logn = 1 to 4. Each samples (z0,z1)
+ * for target (t0,t1) and LDL tree T with the same operations, in the
+ * same order, as the recursive description; the intermediate values
+ * are kept in local variables instead of tmp[].
+ *
+ * Case logn == 1 is reachable only when using Falcon-2 (the smallest
+ * size for which Falcon is mathematically defined, but of course way
+ * too insecure to be of any use).
+ *
+ * Normal end of recursion is for logn == 0. Since the last steps of
+ * the recursion are inlined in the kernels for logn == 1 and 2, that
+ * case is not reachable, and is retained here only for documentation
+ * purposes:
 
-	/*
-	 * Deepest level: the LDL tree leaf value is just g00 (the
-	 * array has length only 1 at this point); we normalize it
-	 * with regards to sigma, then use it for sampling.
-	 */
 	if (logn == 0) {
-		fpr leaf;
+		fpr x0, x1, sigma;
 
-		leaf = g00[0];
-		leaf = fpr_mul(fpr_sqrt(leaf), fpr_inv_sigma[orig_logn]);
-		t0[0] = fpr_of(samp(samp_ctx, t0[0], leaf));
-		t1[0] = fpr_of(samp(samp_ctx, t1[0], leaf));
+		x0 = t0[0];
+		x1 = t1[0];
+		sigma = tree[0];
+		z0[0] = fpr_of(samp(samp_ctx, x0, sigma));
+		z1[0] = fpr_of(samp(samp_ctx, x1, sigma));
 		return;
 	}
 
-	n = (size_t)1 << logn;
-	hn = n >> 1;
+ */
+static void
+ffSampling_leaf1(samplerZ samp, void *samp_ctx,
+	fpr *restrict z0, fpr *restrict z1, const fpr *restrict tree,
+	const fpr *restrict t0, const fpr *restrict t1)
+{
+	fpr x0, x1, y0, y1, sigma;
+	fpr a_re, a_im, b_re, b_im, c_re, c_im;
+
+	x0 = t1[0];
+	x1 = t1[1];
+	sigma = tree[3];
+	z1[0] = y0 = fpr_of(samp(samp_ctx, x0, sigma));
+	z1[1] = y1 = fpr_of(samp(samp_ctx, x1, sigma));
+	a_re = fpr_sub(x0, y0);
+	a_im = fpr_sub(x1, y1);
+	b_re = tree[0];
+	b_im = tree[1];
+	c_re = fpr_sub(fpr_mul(a_re, b_re), fpr_mul(a_im, b_im));
+	c_im = fpr_add(fpr_mul(a_re, b_im), fpr_mul(a_im, b_re));
+	x0 = fpr_add(c_re, t0[0]);
+	x1 = fpr_add(c_im, t0[1]);
+	sigma = tree[2];
+	z0[0] = fpr_of(samp(samp_ctx, x0, sigma));
+	z0[1] = fpr_of(samp(samp_ctx, x1, sigma));
+}
+
+/*
+ * Leaf kernel for logn == 2: the last two recursion levels are inlined.
+ */
+TARGET_AVX2
+static void
+ffSampling_leaf2(samplerZ samp, void *samp_ctx,
+	fpr *restrict z0, fpr *restrict z1, const fpr *restrict tree,
+	const fpr *restrict t0, const fpr *restrict t1)
+{
+	const fpr *tree0, *tree1;
+
+#if FALCON_AVX2  // yyyAVX2+1
+	fpr w0, w1, w2, w3, sigma;
+	__m128d ww0, ww1, wa, wb, wc, wd;
+	__m128d wy0, wy1, wz0, wz1;
+	__m128d half, invsqrt8, invsqrt2, neghi, neglo;
+	int si0, si1, si2, si3;
+
+	tree0 = tree + 4;
+	tree1 = tree + 8;
+
+	half = _mm_set1_pd(0.5);
+	invsqrt8 = _mm_set1_pd(0.353553390593273762200422181052);
+	invsqrt2 = _mm_set1_pd(0.707106781186547524400844362105);
+	neghi = _mm_set_pd(-0.0, 0.0);
+	neglo = _mm_set_pd(0.0, -0.0);
 
 	/*
-	 * Decompose G into LDL. We only need d00 (identical to g00),
-	 * d11, and l10; we do that in place.
+	 * We split t1 into w*, then do the recursive invocation,
+	 * with output in w*. We finally merge back into z1.
 	 */
-	Zf(poly_LDL_fft)(g00, g01, g11, logn);
+	ww0 = _mm_loadu_pd(&t1[0].v);
+	ww1 = _mm_loadu_pd(&t1[2].v);
+	wa = _mm_unpacklo_pd(ww0, ww1);
+	wb = _mm_unpackhi_pd(ww0, ww1);
+	wc = _mm_add_pd(wa, wb);
+	ww0 = _mm_mul_pd(wc, half);
+	wc = _mm_sub_pd(wa, wb);
+	wd = _mm_xor_pd(_mm_permute_pd(wc, 1), neghi);
+	ww1 = _mm_mul_pd(_mm_add_pd(wc, wd), invsqrt8);
+
+	w2.v = _mm_cvtsd_f64(ww1);
+	w3.v = _mm_cvtsd_f64(_mm_permute_pd(ww1, 1));
+	wa = ww1;
+	sigma = tree1[3];
+	si2 = samp(samp_ctx, w2, sigma);
+	si3 = samp(samp_ctx, w3, sigma);
+	ww1 = _mm_set_pd((double)si3, (double)si2);
+	wa = _mm_sub_pd(wa, ww1);
+	wb = _mm_loadu_pd(&tree1[0].v);
+	wc = _mm_mul_pd(wa, wb);
+	wd = _mm_mul_pd(wa, _mm_permute_pd(wb, 1));
+	wa = _mm_unpacklo_pd(wc, wd);
+	wb = _mm_unpackhi_pd(wc, wd);
+	ww0 = _mm_add_pd(ww0, _mm_add_pd(wa, _mm_xor_pd(wb, neglo)));
+	w0.v = _mm_cvtsd_f64(ww0);
+	w1.v = _mm_cvtsd_f64(_mm_permute_pd(ww0, 1));
+	sigma = tree1[2];
+	si0 = samp(samp_ctx, w0, sigma);
+	si1 = samp(samp_ctx, w1, sigma);
+	ww0 = _mm_set_pd((double)si1, (double)si0);
+
+	wc = _mm_mul_pd(
+		_mm_set_pd((double)(si2 + si3), (double)(si2 - si3)),
+		invsqrt2);
+	wa = _mm_add_pd(ww0, wc);
+	wb = _mm_sub_pd(ww0, wc);
+	ww0 = _mm_unpacklo_pd(wa, wb);
+	ww1 = _mm_unpackhi_pd(wa, wb);
+	_mm_storeu_pd(&z1[0].v, ww0);
+	_mm_storeu_pd(&z1[2].v, ww1);
 
 	/*
-	 * Split d00 and d11 and expand them into half-size quasi-cyclic
-	 * Gram matrices. We also save l10 in tmp[].
+	 * Compute tb0 = t0 + (t1 - z1) * L. Value tb0 ends up in w*.
 	 */
-	Zf(poly_split_fft)(tmp, tmp + hn, g00, logn);
-	memcpy(g00, tmp, n * sizeof *tmp);
-	Zf(poly_split_fft)(tmp, tmp + hn, g11, logn);
-	memcpy(g11, tmp, n * sizeof *tmp);
-	memcpy(tmp, g01, n * sizeof *g01);
-	memcpy(g01, g00, hn * sizeof *g00);
-	memcpy(g01 + hn, g11, hn * sizeof *g00);
+	wy0 = _mm_sub_pd(_mm_loadu_pd(&t1[0].v), ww0);
+	wy1 = _mm_sub_pd(_mm_loadu_pd(&t1[2].v), ww1);
+	wz0 = _mm_loadu_pd(&tree[0].v);
+	wz1 = _mm_loadu_pd(&tree[2].v);
+	ww0 = _mm_sub_pd(_mm_mul_pd(wy0, wz0), _mm_mul_pd(wy1, wz1));
+	ww1 = _mm_add_pd(_mm_mul_pd(wy0, wz1), _mm_mul_pd(wy1, wz0));
+	ww0 = _mm_add_pd(ww0, _mm_loadu_pd(&t0[0].v));
+	ww1 = _mm_add_pd(ww1, _mm_loadu_pd(&t0[2].v));
 
 	/*
-	 * The half-size Gram matrices for the recursive LDL tree
-	 * building are now:
-	 *   - left sub-tree: g00, g00+hn, g01
-	 *   - right sub-tree: g11, g11+hn, g01+hn
-	 * l10 is in tmp[].
+	 * Second recursive invocation.
 	 */
+	wa = _mm_unpacklo_pd(ww0, ww1);
+	wb = _mm_unpackhi_pd(ww0, ww1);
+	wc = _mm_add_pd(wa, wb);
+	ww0 = _mm_mul_pd(wc, half);
+	wc = _mm_sub_pd(wa, wb);
+	wd = _mm_xor_pd(_mm_permute_pd(wc, 1), neghi);
+	ww1 = _mm_mul_pd(_mm_add_pd(wc, wd), invsqrt8);
+
+	w2.v = _mm_cvtsd_f64(ww1);
+	w3.v = _mm_cvtsd_f64(_mm_permute_pd(ww1, 1));
+	wa = ww1;
+	sigma = tree0[3];
+	si2 = samp(samp_ctx, w2, sigma);
+	si3 = samp(samp_ctx, w3, sigma);
+	ww1 = _mm_set_pd((double)si3, (double)si2);
+	wa = _mm_sub_pd(wa, ww1);
+	wb = _mm_loadu_pd(&tree0[0].v);
+	wc = _mm_mul_pd(wa, wb);
+	wd = _mm_mul_pd(wa, _mm_permute_pd(wb, 1));
+	wa = _mm_unpacklo_pd(wc, wd);
+	wb = _mm_unpackhi_pd(wc, wd);
+	ww0 = _mm_add_pd(ww0, _mm_add_pd(wa, _mm_xor_pd(wb, neglo)));
+	w0.v = _mm_cvtsd_f64(ww0);
+	w1.v = _mm_cvtsd_f64(_mm_permute_pd(ww0, 1));
+	sigma = tree0[2];
+	si0 = samp(samp_ctx, w0, sigma);
+	si1 = samp(samp_ctx, w1, sigma);
+	ww0 = _mm_set_pd((double)si1, (double)si0);
+
+	wc = _mm_mul_pd(
+		_mm_set_pd((double)(si2 + si3), (double)(si2 - si3)),
+		invsqrt2);
+	wa = _mm_add_pd(ww0, wc);
+	wb = _mm_sub_pd(ww0, wc);
+	ww0 = _mm_unpacklo_pd(wa, wb);
+	ww1 = _mm_unpackhi_pd(wa, wb);
+	_mm_storeu_pd(&z0[0].v, ww0);
+	_mm_storeu_pd(&z0[2].v, ww1);
+#else  // yyyAVX2+0
+	fpr x0, x1, y0, y1, w0, w1, w2, w3, sigma;
+	fpr a_re, a_im, b_re, b_im, c_re, c_im;
+
+	tree0 = tree + 4;
+	tree1 = tree + 8;
 
 	/*
-	 * We split t1 and use the first recursive call on the two
-	 * halves, using the right sub-tree. The result is merged
-	 * back into tmp + 2*n.
+	 * We split t1 into w*, then do the recursive invocation,
+	 * with output in w*. We finally merge back into z1.
 	 */
-	z1 = tmp + n;
-	Zf(poly_split_fft)(z1, z1 + hn, t1, logn);
-	ffSampling_fft_dyntree(samp, samp_ctx, z1, z1 + hn,
-		g11, g11 + hn, g01 + hn, orig_logn, logn - 1, z1 + n);
-	Zf(poly_merge_fft)(tmp + (n << 1), z1, z1 + hn, logn);
+	a_re = t1[0];
+	a_im = t1[2];
+	b_re = t1[1];
+	b_im = t1[3];
+	c_re = fpr_add(a_re, b_re);
+	c_im = fpr_add(a_im, b_im);
+	w0 = fpr_half(c_re);
+	w1 = fpr_half(c_im);
+	c_re = fpr_sub(a_re, b_re);
+	c_im = fpr_sub(a_im, b_im);
+	// w2 = fpr_mul(fpr_add(c_re, c_im), fpr_invsqrt8);
+	// w3 = fpr_mul(fpr_sub(c_im, c_re), fpr_invsqrt8);
+	w2 = fpr_half(fpr_sub(fpr_mul(c_re, fpr_invsqrt2), fpr_mul(c_im, fpr_neg(fpr_invsqrt2))));
+	w3 = fpr_half(fpr_add(fpr_mul(c_re, fpr_neg(fpr_invsqrt2)), fpr_mul(c_im, fpr_invsqrt2)));
+
+	x0 = w2;
+	x1 = w3;
+	sigma = tree1[3];
+	w2 = fpr_of(samp(samp_ctx, x0, sigma));
+	w3 = fpr_of(samp(samp_ctx, x1, sigma));
+	a_re = fpr_sub(x0, w2);
+	a_im = fpr_sub(x1, w3);
+	b_re = tree1[0];
+	b_im = tree1[1];
+	c_re = fpr_sub(fpr_mul(a_re, b_re), fpr_mul(a_im, b_im));
+	c_im = fpr_add(fpr_mul(a_re, b_im), fpr_mul(a_im, b_re));
+	x0 = fpr_add(c_re, w0);
+	x1 = fpr_add(c_im, w1);
+	sigma = tree1[2];
+	w0 = fpr_of(samp(samp_ctx, x0, sigma));
+	w1 = fpr_of(samp(samp_ctx, x1, sigma));
+
+	a_re = w0;
+	a_im = w1;
+	b_re = w2;
+	b_im = w3;
+	// c_re = fpr_mul(fpr_sub(b_re, b_im), fpr_invsqrt2);
+	// c_im = fpr_mul(fpr_add(b_re, b_im), fpr_invsqrt2);
+	c_re = fpr_sub(fpr_mul(b_re, fpr_invsqrt2), fpr_mul(b_im, fpr_invsqrt2));
+	c_im = fpr_add(fpr_mul(b_re, fpr_invsqrt2), fpr_mul(b_im, fpr_invsqrt2));
+
+	z1[0] = w0 = fpr_add(a_re, c_re);
+	z1[2] = w2 = fpr_add(a_im, c_im);
+	z1[1] = w1 = fpr_sub(a_re, c_re);
+	z1[3] = w3 = fpr_sub(a_im, c_im);
 
 	/*
-	 * Compute tb0 = t0 + (t1 - z1) * l10.
-	 * At that point, l10 is in tmp, t1 is unmodified, and z1 is
-	 * in tmp + (n << 1). The buffer in z1 is free.
-	 *
-	 * In the end, z1 is written over t1, and tb0 is in t0.
+	 * Compute tb0 = t0 + (t1 - z1) * L. Value tb0 ends up in w*.
 	 */
-	memcpy(z1, t1, n * sizeof *t1);
-	Zf(poly_sub)(z1, tmp + (n << 1), logn);
-	memcpy(t1, tmp + (n << 1), n * sizeof *tmp);
-	Zf(poly_mul_fft)(tmp, z1, logn);
-	Zf(poly_add)(t0, tmp, logn);
+	w0 = fpr_sub(t1[0], w0);
+	w1 = fpr_sub(t1[1], w1);
+	w2 = fpr_sub(t1[2], w2);
+	w3 = fpr_sub(t1[3], w3);
+
+	a_re = w0;
+	a_im = w2;
+	b_re = tree[0];
+	b_im = tree[2];
+	w0 = fpr_sub(fpr_mul(a_re, b_re), fpr_mul(a_im, b_im));
+	w2 = fpr_add(fpr_mul(a_re, b_im), fpr_mul(a_im, b_re));
+	a_re = w1;
+	a_im = w3;
+	b_re = tree[1];
+	b_im = tree[3];
+	w1 = fpr_sub(fpr_mul(a_re, b_re), fpr_mul(a_im, b_im));
+	w3 = fpr_add(fpr_mul(a_re, b_im), fpr_mul(a_im, b_re));
+
+	w0 = fpr_add(w0, t0[0]);
+	w1 = fpr_add(w1, t0[1]);
+	w2 = fpr_add(w2, t0[2]);
+	w3 = fpr_add(w3, t0[3]);
 
 	/*
-	 * Second recursive invocation, on the split tb0 (currently in t0)
-	 * and the left sub-tree.
+	 * Second recursive invocation.
 	 */
-	z0 = tmp;
-	Zf(poly_split_fft)(z0, z0 + hn, t0, logn);
-	ffSampling_fft_dyntree(samp, samp_ctx, z0, z0 + hn,
-		g00, g00 + hn, g01, orig_logn, logn - 1, z0 + n);
-	Zf(poly_merge_fft)(t0, z0, z0 + hn, logn);
+	a_re = w0;
+	a_im = w2;
+	b_re = w1;
+	b_im = w3;
+	c_re = fpr_add(a_re, b_re);
+	c_im = fpr_add(a_im, b_im);
+	w0 = fpr_half(c_re);
+	w1 = fpr_half(c_im);
+	c_re = fpr_sub(a_re, b_re);
+	c_im = fpr_sub(a_im, b_im);
+	w2 = fpr_mul(fpr_add(c_re, c_im), fpr_invsqrt8);
+	w3 = fpr_mul(fpr_sub(c_im, c_re), fpr_invsqrt8);
+
+	x0 = w2;
+	x1 = w3;
+	sigma = tree0[3];
+	w2 = y0 = fpr_of(samp(samp_ctx, x0, sigma));
+	w3 = y1 = fpr_of(samp(samp_ctx, x1, sigma));
+	a_re = fpr_sub(x0, y0);
+	a_im = fpr_sub(x1, y1);
+	b_re = tree0[0];
+	b_im = tree0[1];
+	c_re = fpr_sub(fpr_mul(a_re, b_re), fpr_mul(a_im, b_im));
+	c_im = fpr_add(fpr_mul(a_re, b_im), fpr_mul(a_im, b_re));
+	x0 = fpr_add(c_re, w0);
+	x1 = fpr_add(c_im, w1);
+	sigma = tree0[2];
+	w0 = fpr_of(samp(samp_ctx, x0, sigma));
+	w1 = fpr_of(samp(samp_ctx, x1, sigma));
+
+	a_re = w0;
+	a_im = w1;
+	b_re = w2;
+	b_im = w3;
+	c_re = fpr_mul(fpr_sub(b_re, b_im), fpr_invsqrt2);
+	c_im = fpr_mul(fpr_add(b_re, b_im), fpr_invsqrt2);
+	z0[0] = fpr_add(a_re, c_re);
+	z0[2] = fpr_add(a_im, c_im);
+	z0[1] = fpr_sub(a_re, c_re);
+	z0[3] = fpr_sub(a_im, c_im);
+#endif  // yyyAVX2-
+}
+
+/*
+ * Split, merge and tb0 = t0 + (t1 - z1) * L for the leaf kernels: same
+ * operations as poly_split_fft(), poly_merge_fft() and the sequence
+ * poly_sub(), poly_mul_fft(), poly_add(), for a constant small logn.
+ */
+static inline void
+ffSampling_leaf_split(fpr *restrict f0, fpr *restrict f1,
+	const fpr *restrict f, unsigned logn)
+{
+	size_t hn, qn, u;
+
+	hn = (size_t)1 << (logn - 1);
+	qn = hn >> 1;
+	for (u = 0; u < qn; u ++) {
+		fpr a_re, a_im, b_re, b_im, t_re, t_im, s_re, s_im;
+
+		a_re = f[(u << 1) + 0];
+		a_im = f[(u << 1) + 0 + hn];
+		b_re = f[(u << 1) + 1];
+		b_im = f[(u << 1) + 1 + hn];
+		f0[u] = fpr_half(fpr_add(a_re, b_re));
+		f0[u + qn] = fpr_half(fpr_add(a_im, b_im));
+		t_re = fpr_sub(a_re, b_re);
+		t_im = fpr_sub(a_im, b_im);
+		s_re = fpr_gm_tab[((u + hn) << 1) + 0];
+		s_im = fpr_neg(fpr_gm_tab[((u + hn) << 1) + 1]);
+		f1[u] = fpr_half(fpr_sub(
+			fpr_mul(t_re, s_re), fpr_mul(t_im, s_im)));
+		f1[u + qn] = fpr_half(fpr_add(
+			fpr_mul(t_re, s_im), fpr_mul(t_im, s_re)));
+	}
+}
+
+static inline void
+ffSampling_leaf_merge(fpr *restrict f,
+	const fpr *restrict f0, const fpr *restrict f1, unsigned logn)
+{
+	size_t hn, qn, u;
+
+	hn = (size_t)1 << (logn - 1);
+	qn = hn >> 1;
+	for (u = 0; u < qn; u ++) {
+		fpr a_re, a_im, b_re, b_im, c_re, c_im, s_re, s_im;
+
+		a_re = f0[u];
+		a_im = f0[u + qn];
+		c_re = f1[u];
+		c_im = f1[u + qn];
+		s_re = fpr_gm_tab[((u + hn) << 1) + 0];
+		s_im = fpr_gm_tab[((u + hn) << 1) + 1];
+		b_re = fpr_sub(fpr_mul(c_re, s_re), fpr_mul(c_im, s_im));
+		b_im = fpr_add(fpr_mul(c_re, s_im), fpr_mul(c_im, s_re));
+		f[(u << 1) + 0] = fpr_add(a_re, b_re);
+		f[(u << 1) + 0 + hn] = fpr_add(a_im, b_im);
+		f[(u << 1) + 1] = fpr_sub(a_re, b_re);
+		f[(u << 1) + 1 + hn] = fpr_sub(a_im, b_im);
+	}
+}
+
+static inline void
+ffSampling_leaf_tb0(fpr *restrict tb0,
+	const fpr *restrict t0, const fpr *restrict t1,
+	const fpr *restrict z1, const fpr *restrict tree, unsigned logn)
+{
+	size_t hn, u;
+
+	hn = (size_t)1 << (logn - 1);
+	for (u = 0; u < hn; u ++) {
+		fpr a_re, a_im, b_re, b_im;
+
+		a_re = fpr_sub(t1[u], z1[u]);
+		a_im = fpr_sub(t1[u + hn], z1[u + hn]);
+		b_re = tree[u];
+		b_im = tree[u + hn];
+		tb0[u] = fpr_add(fpr_sub(
+			fpr_mul(a_re, b_re), fpr_mul(a_im, b_im)), t0[u]);
+		tb0[u + hn] = fpr_add(fpr_add(
+			fpr_mul(a_re, b_im), fpr_mul(a_im, b_re)), t0[u + hn]);
+	}
+}
+
+/*
+ * Leaf kernel for logn == 3: two calls to the logn == 2 kernel, with
+ * the split and merge steps inlined.
+ */
+TARGET_AVX2
+static void
+ffSampling_leaf3(samplerZ samp, void *samp_ctx,
+	fpr *restrict z0, fpr *restrict z1, const fpr *restrict tree,
+	const fpr *restrict t0, const fpr *restrict t1)
+{
+	fpr x[8], w[8];
+
+	ffSampling_leaf_split(x, x + 4, t1, 3);
+	ffSampling_leaf2(samp, samp_ctx, w, w + 4, tree + 8 + 12, x, x + 4);
+	ffSampling_leaf_merge(z1, w, w + 4, 3);
+	ffSampling_leaf_tb0(w, t0, t1, z1, tree, 3);
+	ffSampling_leaf_split(x, x + 4, w, 3);
+	ffSampling_leaf2(samp, samp_ctx, w, w + 4, tree + 8, x, x + 4);
+	ffSampling_leaf_merge(z0, w, w + 4, 3);
+}
+
+/*
+ * Leaf kernel for logn == 4: two calls to the logn == 3 kernel.
+ */
+TARGET_AVX2
+static void
+ffSampling_leaf4(samplerZ samp, void *samp_ctx,
+	fpr *restrict z0, fpr *restrict z1, const fpr *restrict tree,
+	const fpr *restrict t0, const fpr *restrict t1)
+{
+	fpr x[16], w[16];
+
+	ffSampling_leaf_split(x, x + 8, t1, 4);
+	ffSampling_leaf3(samp, samp_ctx, w, w + 8, tree + 16 + 32, x, x + 8);
+	ffSampling_leaf_merge(z1, w, w + 8, 4);
+	ffSampling_leaf_tb0(w, t0, t1, z1, tree, 4);
+	ffSampling_leaf_split(x, x + 8, w, 4);
+	ffSampling_leaf3(samp, samp_ctx, w, w + 8, tree + 16, x, x + 8);
+	ffSampling_leaf_merge(z0, w, w + 8, 4);
 }
 
+/*
+ * State of one level of ffSampling_fft(): target (t0,t1), output
+ * (z0,z1) and LDL sub-tree.
+ */
+typedef struct {
+	const fpr *t0, *t1, *tree;
+	fpr *z0, *z1;
+} ffs_frame;
+
 /*
  * Perform Fast Fourier Sampling for target vector t and LDL tree T.
  * tmp[] must have size for at least two polynomials of size 2^logn.
+ *
+ * The recursion is unrolled into a loop over an explicit stack of
+ * frames, one per level, down to the logn == 4 leaf kernel. Level k
+ * (for k from logn down to 5) keeps the output of its sub-trees in a
+ * block of 2^k elements of tmp[]; blocks are laid out contiguously
+ * from the start of tmp[], largest first (2*n - 32 elements in total).
+ * The traversal order is the one of the recursive description: right
+ * sub-tree (on the split t1), then left sub-tree (on the split
+ * t0 + (t1 - z1) * L).
  */
 TARGET_AVX2
 static void
@@ -429,343 +920,110 @@ ffSampling_fft(samplerZ samp, void *samp_ctx,
 	const fpr *restrict t0, const fpr *restrict t1, unsigned logn,
 	fpr *restrict tmp)
 {
-	size_t n, hn;
-	const fpr *tree0, *tree1;
-
-	/*
-	 * When logn == 2, we inline the last two recursion levels.
-	 */
-	if (logn == 2) {
-#if FALCON_AVX2  // yyyAVX2+1
-		fpr w0, w1, w2, w3, sigma;
-		__m128d ww0, ww1, wa, wb, wc, wd;
-		__m128d wy0, wy1, wz0, wz1;
-		__m128d half, invsqrt8, invsqrt2, neghi, neglo;
-		int si0, si1, si2, si3;
-
-		tree0 = tree + 4;
-		tree1 = tree + 8;
-
-		half = _mm_set1_pd(0.5);
-		invsqrt8 = _mm_set1_pd(0.353553390593273762200422181052);
-		invsqrt2 = _mm_set1_pd(0.707106781186547524400844362105);
-		neghi = _mm_set_pd(-0.0, 0.0);
-		neglo = _mm_set_pd(0.0, -0.0);
-
-		/*
-		 * We split t1 into w*, then do the recursive invocation,
-		 * with output in w*. We finally merge back into z1.
-		 */
-		ww0 = _mm_loadu_pd(&t1[0].v);
-		ww1 = _mm_loadu_pd(&t1[2].v);
-		wa = _mm_unpacklo_pd(ww0, ww1);
-		wb = _mm_unpackhi_pd(ww0, ww1);
-		wc = _mm_add_pd(wa, wb);
-		ww0 = _mm_mul_pd(wc, half);
-		wc = _mm_sub_pd(wa, wb);
-		wd = _mm_xor_pd(_mm_permute_pd(wc, 1), neghi);
-		ww1 = _mm_mul_pd(_mm_add_pd(wc, wd), invsqrt8);
-
-		w2.v = _mm_cvtsd_f64(ww1);
-		w3.v = _mm_cvtsd_f64(_mm_permute_pd(ww1, 1));
-		wa = ww1;
-		sigma = tree1[3];
-		si2 = samp(samp_ctx, w2, sigma);
-		si3 = samp(samp_ctx, w3, sigma);
-		ww1 = _mm_set_pd((double)si3, (double)si2);
-		wa = _mm_sub_pd(wa, ww1);
-		wb = _mm_loadu_pd(&tree1[0].v);
-		wc = _mm_mul_pd(wa, wb);
-		wd = _mm_mul_pd(wa, _mm_permute_pd(wb, 1));
-		wa = _mm_unpacklo_pd(wc, wd);
-		wb = _mm_unpackhi_pd(wc, wd);
-		ww0 = _mm_add_pd(ww0, _mm_add_pd(wa, _mm_xor_pd(wb, neglo)));
-		w0.v = _mm_cvtsd_f64(ww0);
-		w1.v = _mm_cvtsd_f64(_mm_permute_pd(ww0, 1));
-		sigma = tree1[2];
-		si0 = samp(samp_ctx, w0, sigma);
-		si1 = samp(samp_ctx, w1, sigma);
-		ww0 = _mm_set_pd((double)si1, (double)si0);
-
-		wc = _mm_mul_pd(
-			_mm_set_pd((double)(si2 + si3), (double)(si2 - si3)),
-			invsqrt2);
-		wa = _mm_add_pd(ww0, wc);
-		wb = _mm_sub_pd(ww0, wc);
-		ww0 = _mm_unpacklo_pd(wa, wb);
-		ww1 = _mm_unpackhi_pd(wa, wb);
-		_mm_storeu_pd(&z1[0].v, ww0);
-		_mm_storeu_pd(&z1[2].v, ww1);
-
-		/*
-		 * Compute tb0 = t0 + (t1 - z1) * L. Value tb0 ends up in w*.
-		 */
-		wy0 = _mm_sub_pd(_mm_loadu_pd(&t1[0].v), ww0);
-		wy1 = _mm_sub_pd(_mm_loadu_pd(&t1[2].v), ww1);
-		wz0 = _mm_loadu_pd(&tree[0].v);
-		wz1 = _mm_loadu_pd(&tree[2].v);
-		ww0 = _mm_sub_pd(_mm_mul_pd(wy0, wz0), _mm_mul_pd(wy1, wz1));
-		ww1 = _mm_add_pd(_mm_mul_pd(wy0, wz1), _mm_mul_pd(wy1, wz0));
-		ww0 = _mm_add_pd(ww0, _mm_loadu_pd(&t0[0].v));
-		ww1 = _mm_add_pd(ww1, _mm_loadu_pd(&t0[2].v));
-
-		/*
-		 * Second recursive invocation.
-		 */
-		wa = _mm_unpacklo_pd(ww0, ww1);
-		wb = _mm_unpackhi_pd(ww0, ww1);
-		wc = _mm_add_pd(wa, wb);
-		ww0 = _mm_mul_pd(wc, half);
-		wc = _mm_sub_pd(wa, wb);
-		wd = _mm_xor_pd(_mm_permute_pd(wc, 1), neghi);
-		ww1 = _mm_mul_pd(_mm_add_pd(wc, wd), invsqrt8);
-
-		w2.v = _mm_cvtsd_f64(ww1);
-		w3.v = _mm_cvtsd_f64(_mm_permute_pd(ww1, 1));
-		wa = ww1;
-		sigma = tree0[3];
-		si2 = samp(samp_ctx, w2, sigma);
-		si3 = samp(samp_ctx, w3, sigma);
-		ww1 = _mm_set_pd((double)si3, (double)si2);
-		wa = _mm_sub_pd(wa, ww1);
-		wb = _mm_loadu_pd(&tree0[0].v);
-		wc = _mm_mul_pd(wa, wb);
-		wd = _mm_mul_pd(wa, _mm_permute_pd(wb, 1));
-		wa = _mm_unpacklo_pd(wc, wd);
-		wb = _mm_unpackhi_pd(wc, wd);
-		ww0 = _mm_add_pd(ww0, _mm_add_pd(wa, _mm_xor_pd(wb, neglo)));
-		w0.v = _mm_cvtsd_f64(ww0);
-		w1.v = _mm_cvtsd_f64(_mm_permute_pd(ww0, 1));
-		sigma = tree0[2];
-		si0 = samp(samp_ctx, w0, sigma);
-		si1 = samp(samp_ctx, w1, sigma);
-		ww0 = _mm_set_pd((double)si1, (double)si0);
-
-		wc = _mm_mul_pd(
-			_mm_set_pd((double)(si2 + si3), (double)(si2 - si3)),
-			invsqrt2);
-		wa = _mm_add_pd(ww0, wc);
-		wb = _mm_sub_pd(ww0, wc);
-		ww0 = _mm_unpacklo_pd(wa, wb);
-		ww1 = _mm_unpackhi_pd(wa, wb);
-		_mm_storeu_pd(&z0[0].v, ww0);
-		_mm_storeu_pd(&z0[2].v, ww1);
-
+	ffs_frame fr[11];
+	fpr *blk[11];
+	unsigned lev;
+	uint32_t side;
+
+	switch (logn) {
+	case 1:
+		ffSampling_leaf1(samp, samp_ctx, z0, z1, tree, t0, t1);
 		return;
-#else  // yyyAVX2+0
-		fpr x0, x1, y0, y1, w0, w1, w2, w3, sigma;
-		fpr a_re, a_im, b_re, b_im, c_re, c_im;
-
-		tree0 = tree + 4;
-		tree1 = tree + 8;
-
-		/*
-		 * We split t1 into w*, then do the recursive invocation,
-		 * with output in w*. We finally merge back into z1.
-		 */
-		a_re = t1[0];
-		a_im = t1[2];
-		b_re = t1[1];
-		b_im = t1[3];
-		c_re = fpr_add(a_re, b_re);
-		c_im = fpr_add(a_im, b_im);
-		w0 = fpr_half(c_re);
-		w1 = fpr_half(c_im);
-		c_re = fpr_sub(a_re, b_re);
-		c_im = fpr_sub(a_im, b_im);
-		// w2 = fpr_mul(fpr_add(c_re, c_im), fpr_invsqrt8);
-		// w3 = fpr_mul(fpr_sub(c_im, c_re), fpr_invsqrt8);
-		w2 = fpr_half(fpr_sub(fpr_mul(c_re, fpr_invsqrt2), fpr_mul(c_im, fpr_neg(fpr_invsqrt2))));
- 		w3 = fpr_half(fpr_add(fpr_mul(c_re, fpr_neg(fpr_invsqrt2)), fpr_mul(c_im, fpr_invsqrt2)));
-
-
-		x0 = w2;
-		x1 = w3;
-		sigma = tree1[3];
-		w2 = fpr_of(samp(samp_ctx, x0, sigma));
-		w3 = fpr_of(samp(samp_ctx, x1, sigma));
-		a_re = fpr_sub(x0, w2);
-		a_im = fpr_sub(x1, w3);
-		b_re = tree1[0];
-		b_im = tree1[1];
-		c_re = fpr_sub(fpr_mul(a_re, b_re), fpr_mul(a_im, b_im));
-		c_im = fpr_add(fpr_mul(a_re, b_im), fpr_mul(a_im, b_re));
-		x0 = fpr_add(c_re, w0);
-		x1 = fpr_add(c_im, w1);
-		sigma = tree1[2];
-		w0 = fpr_of(samp(samp_ctx, x0, sigma));
-		w1 = fpr_of(samp(samp_ctx, x1, sigma));
-
-		a_re = w0;
-		a_im = w1;
-		b_re = w2;
-		b_im = w3;
-		// c_re = fpr_mul(fpr_sub(b_re, b_im), fpr_invsqrt2);
-		// c_im = fpr_mul(fpr_add(b_re, b_im), fpr_invsqrt2);
-		c_re = fpr_sub(fpr_mul(b_re, fpr_invsqrt2), fpr_mul(b_im, fpr_invsqrt2));
- 		c_im = fpr_add(fpr_mul(b_re, fpr_invsqrt2), fpr_mul(b_im, fpr_invsqrt2));
-
-		z1[0] = w0 = fpr_add(a_re, c_re);
-		z1[2] = w2 = fpr_add(a_im, c_im);
-		z1[1] = w1 = fpr_sub(a_re, c_re);
-		z1[3] = w3 = fpr_sub(a_im, c_im);
+	case 2:
+		ffSampling_leaf2(samp, samp_ctx, z0, z1, tree, t0, t1);
+		return;
+	case 3:
+		ffSampling_leaf3(samp, samp_ctx, z0, z1, tree, t0, t1);
+		return;
+	case 4:
+		ffSampling_leaf4(samp, samp_ctx, z0, z1, tree, t0, t1);
+		return;
+	}
 
+	blk[logn] = tmp;
+	for (lev = logn; lev > 5; lev --) {
+		blk[lev - 1] = blk[lev] + ((size_t)1 << lev);
+	}
+	fr[logn].t0 = t0;
+	fr[logn].t1 = t1;
+	fr[logn].tree = tree;
+	fr[logn].z0 = z0;
+	fr[logn].z1 = z1;
+	lev = logn;
+	side = 0;
+	for (;;) {
 		/*
-		 * Compute tb0 = t0 + (t1 - z1) * L. Value tb0 ends up in w*.
+		 * Go down along the right sub-trees to a leaf kernel. At
+		 * each level, t1 is split into z1 (used as temporary
+		 * storage), which is the target for the right sub-tree.
 		 */
-		w0 = fpr_sub(t1[0], w0);
-		w1 = fpr_sub(t1[1], w1);
-		w2 = fpr_sub(t1[2], w2);
-		w3 = fpr_sub(t1[3], w3);
-
-		a_re = w0;
-		a_im = w2;
-		b_re = tree[0];
-		b_im = tree[2];
-		w0 = fpr_sub(fpr_mul(a_re, b_re), fpr_mul(a_im, b_im));
-		w2 = fpr_add(fpr_mul(a_re, b_im), fpr_mul(a_im, b_re));
-		a_re = w1;
-		a_im = w3;
-		b_re = tree[1];
-		b_im = tree[3];
-		w1 = fpr_sub(fpr_mul(a_re, b_re), fpr_mul(a_im, b_im));
-		w3 = fpr_add(fpr_mul(a_re, b_im), fpr_mul(a_im, b_re));
-
-		w0 = fpr_add(w0, t0[0]);
-		w1 = fpr_add(w1, t0[1]);
-		w2 = fpr_add(w2, t0[2]);
-		w3 = fpr_add(w3, t0[3]);
+		while (lev > 4) {
+			ffs_frame *f, *c;
+			size_t n, hn;
+
+			f = &fr[lev];
+			c = &fr[lev - 1];
+			n = (size_t)1 << lev;
+			hn = n >> 1;
+			Zf(poly_split_fft)(f->z1, f->z1 + hn, f->t1, lev);
+			c->t0 = f->z1;
+			c->t1 = f->z1 + hn;
+			c->tree = f->tree + n + ffLDL_treesize(lev - 1);
+			c->z0 = blk[lev];
+			c->z1 = blk[lev] + hn;
+			lev --;
+		}
+		ffSampling_leaf4(samp, samp_ctx, fr[4].z0, fr[4].z1,
+			fr[4].tree, fr[4].t0, fr[4].t1);
 
 		/*
-		 * Second recursive invocation.
+		 * Go up until we find a level whose left sub-tree was
+		 * not sampled yet.
 		 */
-		a_re = w0;
-		a_im = w2;
-		b_re = w1;
-		b_im = w3;
-		c_re = fpr_add(a_re, b_re);
-		c_im = fpr_add(a_im, b_im);
-		w0 = fpr_half(c_re);
-		w1 = fpr_half(c_im);
-		c_re = fpr_sub(a_re, b_re);
-		c_im = fpr_sub(a_im, b_im);
-		w2 = fpr_mul(fpr_add(c_re, c_im), fpr_invsqrt8);
-		w3 = fpr_mul(fpr_sub(c_im, c_re), fpr_invsqrt8);
-
-		x0 = w2;
-		x1 = w3;
-		sigma = tree0[3];
-		w2 = y0 = fpr_of(samp(samp_ctx, x0, sigma));
-		w3 = y1 = fpr_of(samp(samp_ctx, x1, sigma));
-		a_re = fpr_sub(x0, y0);
-		a_im = fpr_sub(x1, y1);
-		b_re = tree0[0];
-		b_im = tree0[1];
-		c_re = fpr_sub(fpr_mul(a_re, b_re), fpr_mul(a_im, b_im));
-		c_im = fpr_add(fpr_mul(a_re, b_im), fpr_mul(a_im, b_re));
-		x0 = fpr_add(c_re, w0);
-		x1 = fpr_add(c_im, w1);
-		sigma = tree0[2];
-		w0 = fpr_of(samp(samp_ctx, x0, sigma));
-		w1 = fpr_of(samp(samp_ctx, x1, sigma));
-
-		a_re = w0;
-		a_im = w1;
-		b_re = w2;
-		b_im = w3;
-		c_re = fpr_mul(fpr_sub(b_re, b_im), fpr_invsqrt2);
-		c_im = fpr_mul(fpr_add(b_re, b_im), fpr_invsqrt2);
-		z0[0] = fpr_add(a_re, c_re);
-		z0[2] = fpr_add(a_im, c_im);
-		z0[1] = fpr_sub(a_re, c_re);
-		z0[3] = fpr_sub(a_im, c_im);
-
-		return;
-#endif  // yyyAVX2-
-	}
-
-	/*
-	 * Case logn == 1 is reachable only when using Falcon-2 (the
-	 * smallest size for which Falcon is mathematically defined, but
-	 * of course way too insecure to be of any use).
-	 */
-	if (logn == 1) {
-		fpr x0, x1, y0, y1, sigma;
-		fpr a_re, a_im, b_re, b_im, c_re, c_im;
-
-		x0 = t1[0];
-		x1 = t1[1];
-		sigma = tree[3];
-		z1[0] = y0 = fpr_of(samp(samp_ctx, x0, sigma));
-		z1[1] = y1 = fpr_of(samp(samp_ctx, x1, sigma));
-		a_re = fpr_sub(x0, y0);
-		a_im = fpr_sub(x1, y1);
-		b_re = tree[0];
-		b_im = tree[1];
-		c_re = fpr_sub(fpr_mul(a_re, b_re), fpr_mul(a_im, b_im));
-		c_im = fpr_add(fpr_mul(a_re, b_im), fpr_mul(a_im, b_re));
-		x0 = fpr_add(c_re, t0[0]);
-		x1 = fpr_add(c_im, t0[1]);
-		sigma = tree[2];
-		z0[0] = fpr_of(samp(samp_ctx, x0, sigma));
-		z0[1] = fpr_of(samp(samp_ctx, x1, sigma));
-
-		return;
-	}
-
-	/*
-	 * Normal end of recursion is for logn == 0. Since the last
-	 * steps of the recursions were inlined in the blocks above
-	 * (when logn == 1 or 2), this case is not reachable, and is
-	 * retained here only for documentation purposes.
+		for (;;) {
+			ffs_frame *f, *c;
+			size_t n, hn;
+			fpr *b;
+
+			if (++ lev > logn) {
+				return;
+			}
+			f = &fr[lev];
+			c = &fr[lev - 1];
+			n = (size_t)1 << lev;
+			hn = n >> 1;
+			b = blk[lev];
+			if ((side >> lev) & 1) {
+				/*
+				 * Both sub-trees are done: merge into z0.
+				 */
+				Zf(poly_merge_fft)(f->z0, b, b + hn, lev);
+				side &= ~((uint32_t)1 << lev);
+				continue;
+			}
 
-	if (logn == 0) {
-		fpr x0, x1, sigma;
-
-		x0 = t0[0];
-		x1 = t1[0];
-		sigma = tree[0];
-		z0[0] = fpr_of(samp(samp_ctx, x0, sigma));
-		z1[0] = fpr_of(samp(samp_ctx, x1, sigma));
-		return;
+			/*
+			 * The right sub-tree is done: merge its output into
+			 * z1, then compute tb0 = t0 + (t1 - z1) * L into
+			 * the level block, and split it into z0 (used as
+			 * temporary storage) for the left sub-tree.
+			 */
+			Zf(poly_merge_fft)(f->z1, b, b + hn, lev);
+			memcpy(b, f->t1, n * sizeof *f->t1);
+			Zf(poly_sub)(b, f->z1, lev);
+			Zf(poly_mul_fft)(b, f->tree, lev);
+			Zf(poly_add)(b, f->t0, lev);
+			Zf(poly_split_fft)(f->z0, f->z0 + hn, b, lev);
+			c->t0 = f->z0;
+			c->t1 = f->z0 + hn;
+			c->tree = f->tree + n;
+			c->z0 = b;
+			c->z1 = b + hn;
+			side |= (uint32_t)1 << lev;
+			lev --;
+			break;
+		}
 	}
-
-	 */
-
-	/*
-	 * General recursive case (logn >= 3).
-	 */
-
-	n = (size_t)1 << logn;
-	hn = n >> 1;
-	tree0 = tree + n;
-	tree1 = tree + n + ffLDL_treesize(logn - 1);
-
-	/*
-	 * We split t1 into z1 (reused as temporary storage), then do
-	 * the recursive invocation, with output in tmp. We finally
-	 * merge back into z1.
-	 */
-	Zf(poly_split_fft)(z1, z1 + hn, t1, logn);
-	ffSampling_fft(samp, samp_ctx, tmp, tmp + hn,
-		tree1, z1, z1 + hn, logn - 1, tmp + n);
-	Zf(poly_merge_fft)(z1, tmp, tmp + hn, logn);
-
-	/*
-	 * Compute tb0 = t0 + (t1 - z1) * L. Value tb0 ends up in tmp[].
-	 */
-	memcpy(tmp, t1, n * sizeof *t1);
-	Zf(poly_sub)(tmp, z1, logn);
-	Zf(poly_mul_fft)(tmp, tree, logn);
-	Zf(poly_add)(tmp, t0, logn);
-
-	/*
-	 * Second recursive invocation.
-	 */
-	Zf(poly_split_fft)(z0, z0 + hn, tmp, logn);
-	ffSampling_fft(samp, samp_ctx, tmp, tmp + hn,
-		tree0, z0, z0 + hn, logn - 1, tmp + n);
-	Zf(poly_merge_fft)(z0, tmp, tmp + hn, logn);
 }
 
 /*
@@ -774,12 +1032,13 @@ ffSampling_fft(samplerZ samp, void *samp_ctx,
  * computed, and if it is short enough, then s2 is returned into the
  * s2[] buffer, and 1 is returned; otherwise, s2[] is untouched and 0 is
  * returned; the caller should then try again. This function uses an
- * expanded key.
+ * expanded key. On success, if sqnorm is not NULL, the squared norm of
+ * (s1,s2) is written in *sqnorm.
  *
  * tmp[] must have room for at least six polynomials.
  */
 static int
-do_sign_tree(samplerZ samp, void *samp_ctx, int16_t *s2,
+do_sign_tree(samplerZ samp, void *samp_ctx, int16_t *s2, uint32_t *sqnorm,
 	const fpr *restrict expanded_key,
 	const uint16_t *hm,
 	unsigned logn, fpr *restrict tmp)
@@ -816,11 +1075,7 @@ do_sign_tree(samplerZ samp, void *samp_ctx, int16_t *s2,
 	 */
 	Zf(FFT)(t0, logn);
 	ni = fpr_inverse_of_q;
-	memcpy(t1, t0, n * sizeof *t0);
-	Zf(poly_mul_fft)(t1, b01, logn);
-	Zf(poly_mulconst)(t1, fpr_neg(ni), logn);
-	Zf(poly_mul_fft)(t0, b11, logn);
-	Zf(poly_mulconst)(t0, ni, logn);
+	Zf(poly_target_fft)(t0, t1, b01, b11, ni, logn);
 
 	tx = t1 + n;
 	ty = tx + n;
@@ -833,18 +1088,7 @@ do_sign_tree(samplerZ samp, void *samp_ctx, int16_t *s2,
 	/*
 	 * Get the lattice point corresponding to that tiny vector.
 	 */
-	memcpy(t0, tx, n * sizeof *tx);
-	memcpy(t1, ty, n * sizeof *ty);
-	Zf(poly_mul_fft)(tx, b00, logn);
-	Zf(poly_mul_fft)(ty, b10, logn);
-	Zf(poly_add)(tx, ty, logn);
-	memcpy(ty, t0, n * sizeof *t0);
-	Zf(poly_mul_fft)(ty, b01, logn);
-
-	memcpy(t0, tx, n * sizeof *tx);
-	Zf(poly_mul_fft)(t1, b11, logn);
-	Zf(poly_add)(t1, ty, logn);
-
+	Zf(poly_apply_basis_fft)(t0, t1, tx, ty, b00, b01, b10, b11, logn);
 	Zf(iFFT)(t0, logn);
 	Zf(iFFT)(t1, logn);
 
@@ -877,7 +1121,7 @@ do_sign_tree(samplerZ samp, void *samp_ctx, int16_t *s2,
 	for (u = 0; u < n; u ++) {
 		s2tmp[u] = (int16_t)-fpr_rint(t1[u]);
 	}
-	if (Zf(is_short_half)(sqn, s2tmp, logn)) {
+	if (Zf(is_short_half_norm)(sqn, s2tmp, logn, sqnorm)) {
 		memcpy(s2, s2tmp, n * sizeof *s2);
 		memcpy(tmp, s1tmp, n * sizeof *s1tmp);
 		return 1;
@@ -890,18 +1134,19 @@ do_sign_tree(samplerZ samp, void *samp_ctx, int16_t *s2,
  * The s1 vector is not returned. The squared norm of (s1,s2) is
  * computed, and if it is short enough, then s2 is returned into the
  * s2[] buffer, and 1 is returned; otherwise, s2[] is untouched and 0 is
- * returned; the caller should then try again.
+ * returned; the caller should then try again. On success, if sqnorm is
+ * not NULL, the squared norm of (s1,s2) is written in *sqnorm.
  *
  * tmp[] must have room for at least nine polynomials.
  */
 static int
-do_sign_dyn(samplerZ samp, void *samp_ctx, int16_t *s2,
+do_sign_dyn(samplerZ samp, void *samp_ctx, int16_t *s2, uint32_t *sqnorm,
 	const int8_t *restrict f, const int8_t *restrict g,
 	const int8_t *restrict F, const int8_t *restrict G,
 	const uint16_t *hm, unsigned logn, fpr *restrict tmp)
 {
 	size_t n, u;
-	fpr *t0, *t1, *tx, *ty;
+	fpr *t0, *t1, *tx;
 	fpr *b00, *b01, *b10, *b11, *g00, *g01, *g11;
 	fpr ni;
 	uint32_t sqn, ng;
@@ -942,23 +1187,8 @@ do_sign_dyn(samplerZ samp, void *samp_ctx, int16_t *s2,
 	 * must keep b01 and b11 for computing the target vector.
 	 */
 	t0 = b11 + n;
-	t1 = t0 + n;
-
 	memcpy(t0, b01, n * sizeof *b01);
-	Zf(poly_mulselfadj_fft)(t0, logn);    // t0 <- b01*adj(b01)
-
-	memcpy(t1, b00, n * sizeof *b00);
-	Zf(poly_muladj_fft)(t1, b10, logn);   // t1 <- b00*adj(b10)
-	Zf(poly_mulselfadj_fft)(b00, logn);   // b00 <- b00*adj(b00)
-	Zf(poly_add)(b00, t0, logn);      // b00 <- g00
-	memcpy(t0, b01, n * sizeof *b01);
-	Zf(poly_muladj_fft)(b01, b11, logn);  // b01 <- b01*adj(b11)
-	Zf(poly_add)(b01, t1, logn);      // b01 <- g01
-
-	Zf(poly_mulselfadj_fft)(b10, logn);   // b10 <- b10*adj(b10)
-	memcpy(t1, b11, n * sizeof *b11);
-	Zf(poly_mulselfadj_fft)(t1, logn);    // t1 <- b11*adj(b11)
-	Zf(poly_add)(b10, t1, logn);      // b10 <- g11
+	Zf(poly_gram_fft)(b00, b01, b10, b00, b01, b10, b11, logn);
 
 	/*
 	 * We rename variables to make things clearer. The three elements
@@ -993,11 +1223,7 @@ do_sign_dyn(samplerZ samp, void *samp_ctx, int16_t *s2,
 	 */
 	Zf(FFT)(t0, logn);
 	ni = fpr_inverse_of_q;
-	memcpy(t1, t0, n * sizeof *t0);
-	Zf(poly_mul_fft)(t1, b01, logn);
-	Zf(poly_mulconst)(t1, fpr_neg(ni), logn);
-	Zf(poly_mul_fft)(t0, b11, logn);
-	Zf(poly_mulconst)(t0, ni, logn);
+	Zf(poly_target_fft)(t0, t1, b01, b11, ni, logn);
 
 	/*
 	 * b01 and b11 can be discarded, so we move back (t0,t1).
@@ -1012,7 +1238,7 @@ do_sign_dyn(samplerZ samp, void *samp_ctx, int16_t *s2,
 	 * Apply sampling; result is written over (t0,t1).
 	 */
 	ffSampling_fft_dyntree(samp, samp_ctx,
-		t0, t1, g00, g01, g11, logn, logn, t1 + n);
+		t0, t1, g00, g01, g11, logn, t1 + n);
 
 	/*
 	 * We arrange the layout back to:
@@ -1039,22 +1265,11 @@ do_sign_dyn(samplerZ samp, void *samp_ctx, int16_t *s2,
 	Zf(poly_neg)(b01, logn);
 	Zf(poly_neg)(b11, logn);
 	tx = t1 + n;
-	ty = tx + n;
 
 	/*
 	 * Get the lattice point corresponding to that tiny vector.
 	 */
-	memcpy(tx, t0, n * sizeof *t0);
-	memcpy(ty, t1, n * sizeof *t1);
-	Zf(poly_mul_fft)(tx, b00, logn);
-	Zf(poly_mul_fft)(ty, b10, logn);
-	Zf(poly_add)(tx, ty, logn);
-	memcpy(ty, t0, n * sizeof *t0);
-	Zf(poly_mul_fft)(ty, b01, logn);
-
-	memcpy(t0, tx, n * sizeof *tx);
-	Zf(poly_mul_fft)(t1, b11, logn);
-	Zf(poly_add)(t1, ty, logn);
+	Zf(poly_apply_basis_fft)(t0, t1, t0, t1, b00, b01, b10, b11, logn);
 	Zf(iFFT)(t0, logn);
 	Zf(iFFT)(t1, logn);
 
@@ -1084,7 +1299,7 @@ do_sign_dyn(samplerZ samp, void *samp_ctx, int16_t *s2,
 	for (u = 0; u < n; u ++) {
 		s2tmp[u] = (int16_t)-fpr_rint(t1[u]);
 	}
-	if (Zf(is_short_half)(sqn, s2tmp, logn)) {
+	if (Zf(is_short_half_norm)(sqn, s2tmp, logn, sqnorm)) {
 		memcpy(s2, s2tmp, n * sizeof *s2);
 		memcpy(tmp, s1tmp, n * sizeof *s1tmp);
 		return 1;
@@ -1092,6 +1307,64 @@ do_sign_dyn(samplerZ samp, void *samp_ctx, int16_t *s2,
 	return 0;
 }
 
+/*
+ * Reverse cumulative distribution table of the half-Gaussian sampled by
+ * gaussian0_sampler(): row i is 2^72 times the probability of a value
+ * greater than i. Each 72-bit row is split into three 24-bit limbs;
+ * the table is stored transposed (low, middle and high limbs in
+ * separate arrays) and padded with zero rows to a multiple of four, so
+ * that the comparisons of a random value with all rows are done with
+ * vector operations. A zero row is never greater than the random value.
+ */
+#define G0_ROWS   20
+
+static const uint32_t gaussian0_cdt[3][G0_ROWS] = {
+	{
+		 3741698u,  8248194u,  2736639u, 10046180u,  4136815u,
+		 7650655u,  7826148u, 11363290u,  8086568u,   265321u,
+		13644283u,  9111839u,  6138264u, 12545723u,  3104126u,
+		   28824u,      198u,        1u,        0u,        0u
+	},
+	{
+		 3068844u,  1580863u, 13669192u,  4421575u,  7122675u,
+		13063405u, 14505003u, 16768101u,  8444042u, 12844466u,
+		 1232676u,    38047u,      870u,       14u,        0u,
+		       0u,        0u,        0u,        0u,        0u
+	},
+	{
+		10745844u,  5559083u,  2260429u,   708981u,   169348u,
+		   30538u,     4132u,      417u,       31u,        1u,
+		       0u,        0u,        0u,        0u,        0u,
+		       0u,        0u,        0u,        0u,        0u
+	}
+};
+
+/*
+ * Return the number of rows of gaussian0_cdt[] that are greater than
+ * the 72-bit value (lo + 2^64*hi). This is constant-time.
+ */
+static inline int
+gaussian0_cdt_count(uint64_t lo, uint32_t hi)
+{
+	uint32_t v0, v1, v2;
+	size_t u;
+	int z;
+
+	v0 = (uint32_t)lo & 0xFFFFFF;
+	v1 = (uint32_t)(lo >> 24) & 0xFFFFFF;
+	v2 = (uint32_t)(lo >> 48) | (hi << 16);
+	z = 0;
+	for (u = 0; u < G0_ROWS; u ++) {
+		uint32_t cc;
+
+		cc = (v0 - gaussian0_cdt[0][u]) >> 31;
+		cc = (v1 - gaussian0_cdt[1][u] - cc) >> 31;
+		cc = (v2 - gaussian0_cdt[2][u] - cc) >> 31;
+		z += (int)cc;
+	}
+	return z;
+}
+
 /*
  * Sample an integer value along a half-gaussian distribution centered
  * on zero and standard deviation 1.8205, with a precision of 72 bits.
@@ -1235,59 +1508,59 @@ Zf(gaussian0_sampler)(prng *p)
 
 #else // yyyAVX2+0
 
-	static const uint32_t dist[] = {
-		10745844u,  3068844u,  3741698u,
-		 5559083u,  1580863u,  8248194u,
-		 2260429u, 13669192u,  2736639u,
-		  708981u,  4421575u, 10046180u,
-		  169348u,  7122675u,  4136815u,
-		   30538u, 13063405u,  7650655u,
-		    4132u, 14505003u,  7826148u,
-		     417u, 16768101u, 11363290u,
-		      31u,  8444042u,  8086568u,
-		       1u, 12844466u,   265321u,
-		       0u,  1232676u, 13644283u,
-		       0u,    38047u,  9111839u,
-		       0u,      870u,  6138264u,
-		       0u,       14u, 12545723u,
-		       0u,        0u,  3104126u,
-		       0u,        0u,    28824u,
-		       0u,        0u,      198u,
-		       0u,        0u,        1u
-	};
-
-	uint32_t v0, v1, v2, hi;
 	uint64_t lo;
-	size_t u;
-	int z;
+	uint32_t hi;
 
 	/*
-	 * Get a random 72-bit value, into three 24-bit limbs v0..v2.
+	 * Get a random 72-bit value; the sampled value is the number of
+	 * table rows that are greater than it.
 	 */
 	lo = prng_get_u64(p);
 	hi = prng_get_u8(p);
-	v0 = (uint32_t)lo & 0xFFFFFF;
-	v1 = (uint32_t)(lo >> 24) & 0xFFFFFF;
-	v2 = (uint32_t)(lo >> 48) | (hi << 16);
+	return gaussian0_cdt_count(lo, hi);
 
-	/*
-	 * Sampled value is z, such that v0..v2 is lower than the first
-	 * z elements of the table.
-	 */
-	z = 0;
-	for (u = 0; u < (sizeof dist) / sizeof(dist[0]); u += 3) {
-		uint32_t w0, w1, w2, cc;
-
-		w0 = dist[u + 2];
-		w1 = dist[u + 1];
-		w2 = dist[u + 0];
-		cc = (v0 - w0) >> 31;
-		cc = (v1 - w1 - cc) >> 31;
-		cc = (v2 - w2 - cc) >> 31;
-		z += (int)cc;
-	}
 #endif // yyyAVX2-
-    return z;
+}
+
+/* see inner.h */
+TARGET_AVX2
+void
+Zf(gaussian0_sampler_batch)(prng *p, int *z, size_t num)
+{
+	while (num > 0) {
+		size_t u, v, m;
+
+		/*
+		 * gaussian0_sampler() reads 9 bytes at the position given
+		 * by prng_next_u64_pos(); the next prng_u72_run() samples
+		 * all come from the same block.
+		 */
+		u = prng_next_u64_pos(p);
+		m = prng_u72_run(u);
+		if (m > num) {
+			m = num;
+		}
+		for (v = 0; v < m; v ++, u += 9) {
+			uint64_t lo;
+
+#if FALCON_LE && FALCON_UNALIGNED  // yyyLEU+1
+			lo = *(uint64_t *)(p->buf.d + u);
+#else  // yyyLEU+0
+			lo = (uint64_t)p->buf.d[u + 0]
+				| ((uint64_t)p->buf.d[u + 1] << 8)
+				| ((uint64_t)p->buf.d[u + 2] << 16)
+				| ((uint64_t)p->buf.d[u + 3] << 24)
+				| ((uint64_t)p->buf.d[u + 4] << 32)
+				| ((uint64_t)p->buf.d[u + 5] << 40)
+				| ((uint64_t)p->buf.d[u + 6] << 48)
+				| ((uint64_t)p->buf.d[u + 7] << 56);
+#endif  // yyyLEU-
+			z[v] = gaussian0_cdt_count(lo, p->buf.d[u + 8]);
+		}
+		p->ptr = u;
+		z += m;
+		num -= m;
+	}
 }
 
 /* NewBaseSampler: 0을 50% 확률로 reject해서 center를 약간 오른쪽으로 밀기 */
@@ -1465,54 +1738,47 @@ Zf(sampler)(void *ctx, fpr mu, fpr isigma)
 	}
 }
 
+#if FALCON_SAMPLER_STATS
+#define SAMPLER_STAT(spc, name)   ((spc)->stats.name ++)
+
+/* see inner.h */
+void (*Zf(sampler_stats_hook))(const sampler_stats *st) = NULL;
+#else
+#define SAMPLER_STAT(spc, name)   ((void)0)
+#endif
+
 /*
- * NewSamplerZ: numerically stable sampler using NewBaseSampler (new_gaussian0_sampler)
- * and rounding-to-nearest center decomposition.
- *
- * On input mu (center) and isigma = 1/sigma with sigma ∈ [sigma_min, sigma_max],
- * this samples from D_{Z, sigma, mu}.
+ * yplus^2 / (2*sigma0^2) for yplus = 0 to 18 (the range of
+ * new_gaussian0_sampler()), i.e. fpr_mul(fpr_of(yplus * yplus),
+ * fpr_inv_2sqrsigma0), as IEEE-754 binary64 encodings.
+ */
+static const uint64_t new_sampler_ysq[] = {
+	0x0000000000000000u, 0x3FC34F8BC183BBC2u, 0x3FE34F8BC183BBC2u,
+	0x3FF5B97D39B4333Au, 0x40034F8BC183BBC2u, 0x400E2C4A5E5DD55Fu,
+	0x4015B97D39B4333Au, 0x401D91CE0051B781u, 0x40234F8BC183BBC2u,
+	0x402870ACE0EAB9A2u, 0x402E2C4A5E5DD55Fu, 0x403241321CEE877Du,
+	0x4035B97D39B4333Au, 0x40397F06857FEDE6u, 0x403D91CE0051B781u,
+	0x4040F8E9D514C806u, 0x40434F8BC183BBC2u, 0x4045CCCCC575B6F6u,
+	0x404870ACE0EAB9A2u
+};
+
+/*
+ * Rejection-sampling loop of NewSamplerZ, for a center r in [-0.5, 0.5]
+ * and the precomputed dss = 1/(2*sigma^2) and ccs = sigma_min/sigma.
+ * Returned value is the offset y (the sample is s + y).
  */
 TARGET_AVX2
-int
-Zf(new_sampler)(void *ctx, fpr mu, fpr isigma)
+static int
+new_sampler_inner(sampler_context *spc, fpr r, fpr dss, fpr ccs)
 {
-    sampler_context *spc;
-    int s;
-    fpr r, dss, ccs;
-
-    spc = ctx;
-
-    /*
-     * Center decomposition:
-     *   mu = s + r
-     * where s is an integer and r ∈ [-0.5, 0.5).
-     * This uses rounding-to-nearest instead of floor,
-     * as in Algorithm 4 (NewSamplerZ).
-     *
-     * If your fpr layer does not have fpr_rint(), you can emulate
-     * round-to-nearest as:
-     *   s = (int)fpr_floor(fpr_add(mu, fpr_half(fpr_one)));
-     */
-    s = (int)fpr_rint(mu);  /* ⌊mu⌉ */
-    r = fpr_sub(mu, fpr_of(s));
-
-    /*
-     * dss = 1/(2*sigma^2) = 0.5 * (isigma^2).
-     */
-    dss = fpr_half(fpr_sqr(isigma));
-
-    /*
-     * ccs = sigma_min / sigma = sigma_min * isigma.
-     * (same as original sampler)
-     */
-    ccs = fpr_mul(isigma, spc->sigma_min);
+    prng *p;
 
-    /*
-     * Main rejection-sampling loop.
-     */
+    p = &spc->p;
     for (;;) {
         int yplus, y, b;
-        fpr x;
+        fpr x, ysq;
+
+        SAMPLER_STAT(spc, candidates);
 
         /*
          * NewBaseSampler: yplus ≥ 0 with distribution D^+:
@@ -1522,7 +1788,18 @@ Zf(new_sampler)(void *ctx, fpr mu, fpr isigma)
          * Implemented by new_gaussian0_sampler(), which is
          * gaussian0_sampler + "reject 0 with prob 1/2" wrapper.
          */
-        yplus = Zf(new_gaussian0_sampler)(&spc->p);
+#if FALCON_SAMPLER_STATS
+        for (;;) {
+            yplus = Zf(gaussian0_sampler)(p);
+            SAMPLER_STAT(spc, base_draws);
+            if (yplus != 0 || (prng_get_u8(p) & 1)) {
+                break;
+            }
+            SAMPLER_STAT(spc, base_rejected);
+        }
+#else
+        yplus = Zf(new_gaussian0_sampler)(p);
+#endif
 
         /*
          * Draw a random sign: b ∈ {0,1}, sgn ∈ {-1,+1}.
@@ -1531,7 +1808,7 @@ Zf(new_sampler)(void *ctx, fpr mu, fpr isigma)
          * This yields y with distribution D_{Z, σ_max, 1/2}
          * (Lemma 3 in the paper).
          */
-        b = (int)prng_get_u8(&spc->p) & 1;
+        b = (int)prng_get_u8(p) & 1;
         y = ((b << 1) - 1) * yplus;  /* b=0 → -yplus, b=1 → +yplus */
 
         /*
@@ -1548,28 +1825,84 @@ Zf(new_sampler)(void *ctx, fpr mu, fpr isigma)
          *   x = ((y - r)^2)/(2σ^2) - (yplus^2)/(2σ_max^2)
          *
          * Note: σ_max is the σ0 from the original Falcon code, and
-         *       fpr_inv_2sqrsigma0 = 1/(2σ_max^2).
+         *       fpr_inv_2sqrsigma0 = 1/(2σ_max^2). The second term
+         *       is read from new_sampler_ysq[].
          */
+        memcpy(&ysq, &new_sampler_ysq[yplus], sizeof ysq);
         x = fpr_mul(fpr_sqr(fpr_sub(fpr_of(y), r)), dss);
-        x = fpr_sub(x,
-                    fpr_mul(fpr_of(yplus * yplus), fpr_inv_2sqrsigma0));
-
-        if (BerExp(&spc->p, x, ccs)) {
-            /*
-             * NewSamplerZ is centered on r, but the actual center is
-             * mu = s + r, so we return s + y as the final sample.
-             */
-            return s + y;
+        x = fpr_sub(x, ysq);
+
+        if (BerExp(p, x, ccs)) {
+            SAMPLER_STAT(spc, accepted);
+            return y;
         }
     }
 }
 
+/*
+ * NewSamplerZ: numerically stable sampler using NewBaseSampler (new_gaussian0_sampler)
+ * and rounding-to-nearest center decomposition.
+ *
+ * On input mu (center) and isigma = 1/sigma with sigma ∈ [sigma_min, sigma_max],
+ * this samples from D_{Z, sigma, mu}.
+ */
+TARGET_AVX2
+int
+Zf(new_sampler)(void *ctx, fpr mu, fpr isigma)
+{
+    sampler_context *spc;
+    int s;
+    fpr r, dss, ccs;
+
+    spc = ctx;
+
+    /*
+     * Center decomposition:
+     *   mu = s + r
+     * where s is an integer and r ∈ [-0.5, 0.5).
+     * This uses rounding-to-nearest instead of floor,
+     * as in Algorithm 4 (NewSamplerZ).
+     *
+     * If your fpr layer does not have fpr_rint(), you can emulate
+     * round-to-nearest as:
+     *   s = (int)fpr_floor(fpr_add(mu, fpr_half(fpr_one)));
+     */
+    s = (int)fpr_rint(mu);  /* ⌊mu⌉ */
+    r = fpr_sub(mu, fpr_of(s));
+
+    /*
+     * dss = 1/(2*sigma^2) = 0.5 * (isigma^2).
+     */
+    dss = fpr_half(fpr_sqr(isigma));
+
+    /*
+     * ccs = sigma_min / sigma = sigma_min * isigma.
+     * (same as original sampler)
+     */
+    ccs = fpr_mul(isigma, spc->sigma_min);
+
+    /*
+     * NewSamplerZ is centered on r, but the actual center is
+     * mu = s + r, so we return s + y as the final sample.
+     */
+    return s + new_sampler_inner(spc, r, dss, ccs);
+}
 
 /* see inner.h */
 void
 Zf(sign_tree)(int16_t *sig, inner_shake256_context *rng,
 	const fpr *restrict expanded_key,
 	const uint16_t *hm, unsigned logn, uint8_t *tmp)
+{
+	Zf(sign_tree_norm)(sig, NULL, rng, expanded_key, hm, logn, tmp);
+}
+
+/* see inner.h */
+void
+Zf(sign_tree_norm)(int16_t *sig, uint32_t *sqnorm,
+	inner_shake256_context *rng,
+	const fpr *restrict expanded_key,
+	const uint16_t *hm, unsigned logn, uint8_t *tmp)
 {
 	fpr *ftmp;
 
@@ -1588,6 +1921,7 @@ Zf(sign_tree)(int16_t *sig, inner_shake256_context *rng,
 		sampler_context spc;
 		samplerZ samp;
 		void *samp_ctx;
+		int ok;
 
 		/*
 		 * Normal sampling. We use a fast PRNG seeded from our
@@ -1595,6 +1929,9 @@ Zf(sign_tree)(int16_t *sig, inner_shake256_context *rng,
 		 */
 		spc.sigma_min = fpr_sigma_min[logn];
 		Zf(prng_init)(&spc.p, rng);
+#if FALCON_SAMPLER_STATS
+		memset(&spc.stats, 0, sizeof spc.stats);
+#endif
 		//samp = Zf(sampler);
 		samp = Zf(new_sampler);
 		samp_ctx = &spc;
@@ -1602,9 +1939,14 @@ Zf(sign_tree)(int16_t *sig, inner_shake256_context *rng,
 		/*
 		 * Do the actual signature.
 		 */
-		if (do_sign_tree(samp, samp_ctx, sig,
-			expanded_key, hm, logn, ftmp))
-		{
+		ok = do_sign_tree(samp, samp_ctx, sig, sqnorm,
+			expanded_key, hm, logn, ftmp);
+#if FALCON_SAMPLER_STATS
+		if (Zf(sampler_stats_hook) != NULL) {
+			Zf(sampler_stats_hook)(&spc.stats);
+		}
+#endif
+		if (ok) {
 			break;
 		}
 	}
@@ -1616,6 +1958,17 @@ Zf(sign_dyn)(int16_t *sig, inner_shake256_context *rng,
 	const int8_t *restrict f, const int8_t *restrict g,
 	const int8_t *restrict F, const int8_t *restrict G,
 	const uint16_t *hm, unsigned logn, uint8_t *tmp)
+{
+	Zf(sign_dyn_norm)(sig, NULL, rng, f, g, F, G, hm, logn, tmp);
+}
+
+/* see inner.h */
+void
+Zf(sign_dyn_norm)(int16_t *sig, uint32_t *sqnorm,
+	inner_shake256_context *rng,
+	const int8_t *restrict f, const int8_t *restrict g,
+	const int8_t *restrict F, const int8_t *restrict G,
+	const uint16_t *hm, unsigned logn, uint8_t *tmp)
 {
 	fpr *ftmp;
 
@@ -1634,6 +1987,7 @@ Zf(sign_dyn)(int16_t *sig, inner_shake256_context *rng,
 		sampler_context spc;
 		samplerZ samp;
 		void *samp_ctx;
+		int ok;
 
 		/*
 		 * Normal sampling. We use a fast PRNG seeded from our
@@ -1641,6 +1995,9 @@ Zf(sign_dyn)(int16_t *sig, inner_shake256_context *rng,
 		 */
 		spc.sigma_min = fpr_sigma_min[logn];
 		Zf(prng_init)(&spc.p, rng);
+#if FALCON_SAMPLER_STATS
+		memset(&spc.stats, 0, sizeof spc.stats);
+#endif
 		//samp = Zf(sampler);
 		samp = Zf(new_sampler);
 		samp_ctx = &spc;
@@ -1648,10 +2005,44 @@ Zf(sign_dyn)(int16_t *sig, inner_shake256_context *rng,
 		/*
 		 * Do the actual signature.
 		 */
-		if (do_sign_dyn(samp, samp_ctx, sig,
-			f, g, F, G, hm, logn, ftmp))
-		{
+		ok = do_sign_dyn(samp, samp_ctx, sig, sqnorm,
+			f, g, F, G, hm, logn, ftmp);
+#if FALCON_SAMPLER_STATS
+		if (Zf(sampler_stats_hook) != NULL) {
+			Zf(sampler_stats_hook)(&spc.stats);
+		}
+#endif
+		if (ok) {
 			break;
 		}
 	}
-}
\ No newline at end of file
+}
+/*
+ * Adapters for the fp_backend table, which uses opaque pointers for
+ * the expanded key.
+ */
+static void
+backend_expand_privkey(void *expanded_key,
+	const int8_t *f, const int8_t *g, const int8_t *F, const int8_t *G,
+	unsigned logn, uint8_t *tmp)
+{
+	Zf(expand_privkey)((fpr *)expanded_key, f, g, F, G, logn, tmp);
+}
+
+static void
+backend_sign_tree_norm(int16_t *sig, uint32_t *sqnorm,
+	inner_shake256_context *rng, const void *expanded_key,
+	const uint16_t *hm, unsigned logn, uint8_t *tmp)
+{
+	Zf(sign_tree_norm)(sig, sqnorm, rng,
+		(const fpr *)expanded_key, hm, logn, tmp);
+}
+
+/* see inner.h */
+const fp_backend Zf(fp_backend) = {
+	&Zf(new_keygen),
+	&Zf(new_keygen_pool),
+	&backend_expand_privkey,
+	&Zf(sign_dyn_norm),
+	&backend_sign_tree_norm
+};
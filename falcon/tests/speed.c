@@ -0,0 +1,1139 @@
+/*
+ * Speed benchmark code for the Falcon implementation and its
+ * deterministic mode.
+ *
+ * Each benchmark is first calibrated, so that one batch of operations
+ * lasts a small fraction of the time budget; the batch is then run
+ * repeatedly, and the per-operation cost of each run is recorded. The
+ * median, 90th and 99th percentiles are reported, both in nanoseconds
+ * (monotonic clock) and in CPU cycles (time-stamp counter, on x86
+ * only; the TSC runs at a fixed rate, which may differ from the actual
+ * core frequency).
+ *
+ * Usage: speed [ -native ] [ -t seconds ] [ name ... ]
+ *   -native      select the native floating-point code at runtime
+ *                with falcon_fp_select() (FALCON_FP_DISPATCH); this
+ *                affects the external API benchmarks only
+ *   -t seconds   time budget per benchmark (default: 0.5)
+ *   name         run only the benchmarks whose name contains one of
+ *                the provided strings (e.g. "sign" or "det1024")
+ *
+ * Build with -DFALCON_FPNATIVE=1 to measure the native floating-point
+ * implementation instead of the emulated one (see config.h).
+ *
+ * ==========================(LICENSE BEGIN)============================
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * ===========================(LICENSE END)=============================
+ */
+
+#define _POSIX_C_SOURCE   200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../falcon.h"
+#include "../inner.h"
+#include "../deterministic.h"
+
+#if (defined __i386__ || defined __x86_64__) \
+	&& (defined __GNUC__ || defined __clang__)
+#include <x86intrin.h>
+#define HAVE_CYCLES   1
+static inline uint64_t
+cycles(void)
+{
+	return __rdtsc();
+}
+#else
+#define HAVE_CYCLES   0
+static inline uint64_t
+cycles(void)
+{
+	return 0;
+}
+#endif
+
+static uint64_t
+now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void *
+xmalloc(size_t len)
+{
+	void *buf;
+
+	if (len == 0) {
+		return NULL;
+	}
+	buf = malloc(len);
+	if (buf == NULL) {
+		fprintf(stderr, "memory allocation error\n");
+		exit(EXIT_FAILURE);
+	}
+	return buf;
+}
+
+static void
+xfree(void *buf)
+{
+	if (buf != NULL) {
+		free(buf);
+	}
+}
+
+static void
+check_ret(int r, const char *banner)
+{
+	if (r != 0) {
+		fprintf(stderr, "%s: failed (%d)\n", banner, r);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/* ==================================================================== */
+/*
+ * Benchmark driver.
+ */
+
+/*
+ * A benchmark function runs its operation num times over the provided
+ * context. It returns 0 on success, or a (negative) error code.
+ */
+typedef int (*bench_fun)(void *ctx, unsigned long num);
+
+#define MIN_SAMPLES   5
+#define MAX_SAMPLES   201
+
+static double budget = 0.5;
+static int num_filters;
+static char **filters;
+
+static int
+selected(const char *name)
+{
+	int i;
+
+	if (num_filters == 0) {
+		return 1;
+	}
+	for (i = 0; i < num_filters; i ++) {
+		if (strstr(name, filters[i]) != NULL) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int
+cmp_double(const void *a, const void *b)
+{
+	double x, y;
+
+	x = *(const double *)a;
+	y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+static double
+percentile(const double *v, size_t num, double p)
+{
+	return v[(size_t)((double)(num - 1) * p + 0.5)];
+}
+
+static void
+print_value(double x)
+{
+	if (x < 10000.0) {
+		printf(" %10.1f", x);
+	} else {
+		printf(" %10.0f", x);
+	}
+}
+
+static void
+do_bench(const char *name, bench_fun bf, void *ctx)
+{
+	double ns[MAX_SAMPLES], cc[MAX_SAMPLES];
+	unsigned long num;
+	uint64_t target, t, tb;
+	size_t u, num_samples;
+
+	if (!selected(name)) {
+		return;
+	}
+
+	/*
+	 * Calibration (which also warms up caches and branch
+	 * predictors): find the smallest batch size such that a batch
+	 * lasts at least 1/100th of the time budget.
+	 */
+	target = (uint64_t)(budget * 1e9 / 100.0);
+	num = 1;
+	for (;;) {
+		t = now_ns();
+		check_ret(bf(ctx, num), name);
+		t = now_ns() - t;
+		if (t >= target || num >= (1ul << 30)) {
+			break;
+		}
+		if (t < target / 64) {
+			num <<= 4;
+		} else {
+			num <<= 1;
+		}
+	}
+	num_samples = (size_t)(budget * 1e9 / (double)(t + 1));
+	if (num_samples < MIN_SAMPLES) {
+		num_samples = MIN_SAMPLES;
+	} else if (num_samples > MAX_SAMPLES) {
+		num_samples = MAX_SAMPLES;
+	}
+
+	for (u = 0; u < num_samples; u ++) {
+		uint64_t c;
+
+		c = cycles();
+		tb = now_ns();
+		check_ret(bf(ctx, num), name);
+		tb = now_ns() - tb;
+		c = cycles() - c;
+		ns[u] = (double)tb / (double)num;
+		cc[u] = (double)c / (double)num;
+	}
+	qsort(ns, num_samples, sizeof ns[0], cmp_double);
+	qsort(cc, num_samples, sizeof cc[0], cmp_double);
+
+	printf("%-32s", name);
+	print_value(percentile(ns, num_samples, 0.50));
+	print_value(percentile(ns, num_samples, 0.90));
+	print_value(percentile(ns, num_samples, 0.99));
+	if (HAVE_CYCLES) {
+		print_value(percentile(cc, num_samples, 0.50));
+		print_value(percentile(cc, num_samples, 0.90));
+		print_value(percentile(cc, num_samples, 0.99));
+	}
+	printf("   (%lu x %lu)\n", (unsigned long)num_samples, num);
+	fflush(stdout);
+}
+
+/* ==================================================================== */
+/*
+ * Benchmarks over a given degree (external API and inner functions).
+ */
+
+/*
+ * Number of distinct signatures used by the compressed encoding
+ * benchmarks; with a single one, branch predictors learn its values.
+ */
+#define BENCH_ENC_NUM   16
+
+typedef struct {
+	unsigned logn;
+	shake256_context rng;
+	uint8_t *tmp;
+	size_t tmp_len;
+	uint8_t *pk, *sk, *esk, *sig, *sigct;
+	size_t pk_len, sk_len, esk_len, sig_len, sigct_len;
+	uint8_t *pk2, *sk2, *sig2;
+	fpr *f, *f0;
+	uint16_t *h, *hx;
+	int16_t *s2;
+	uint8_t *enc;
+	size_t enc_len[BENCH_ENC_NUM];
+	inner_shake256_context hsc[4];
+	sampler_context spc;
+	fpr mu[16], isigma;
+} bench_context;
+
+static int
+bench_keygen(void *ctx, unsigned long num)
+{
+	bench_context *bc;
+
+	bc = ctx;
+	while (num -- > 0) {
+		int r;
+
+		r = falcon_keygen_make(&bc->rng, bc->logn,
+			bc->sk2, bc->sk_len, bc->pk2, bc->pk_len,
+			bc->tmp, bc->tmp_len);
+		if (r != 0) {
+			return r;
+		}
+	}
+	return 0;
+}
+
+static int
+bench_expand_privkey(void *ctx, unsigned long num)
+{
+	bench_context *bc;
+
+	bc = ctx;
+	while (num -- > 0) {
+		int r;
+
+		r = falcon_expand_privkey(bc->esk, bc->esk_len,
+			bc->sk, bc->sk_len, bc->tmp, bc->tmp_len);
+		if (r != 0) {
+			return r;
+		}
+	}
+	return 0;
+}
+
+static int
+bench_sign_dyn(void *ctx, unsigned long num)
+{
+	bench_context *bc;
+
+	bc = ctx;
+	while (num -- > 0) {
+		size_t sig_len;
+		int r;
+
+		sig_len = FALCON_SIG_COMPRESSED_MAXSIZE(bc->logn);
+		r = falcon_sign_dyn(&bc->rng, bc->sig2, &sig_len,
+			FALCON_SIG_COMPRESSED, bc->sk, bc->sk_len,
+			"data", 4, bc->tmp, bc->tmp_len);
+		if (r != 0) {
+			return r;
+		}
+	}
+	return 0;
+}
+
+static int
+bench_sign_tree(void *ctx, unsigned long num)
+{
+	bench_context *bc;
+
+	bc = ctx;
+	while (num -- > 0) {
+		size_t sig_len;
+		int r;
+
+		sig_len = FALCON_SIG_COMPRESSED_MAXSIZE(bc->logn);
+		r = falcon_sign_tree(&bc->rng, bc->sig2, &sig_len,
+			FALCON_SIG_COMPRESSED, bc->esk,
+			"data", 4, bc->tmp, bc->tmp_len);
+		if (r != 0) {
+			return r;
+		}
+	}
+	return 0;
+}
+
+static int
+bench_verify(void *ctx, unsigned long num)
+{
+	bench_context *bc;
+
+	bc = ctx;
+	while (num -- > 0) {
+		int r;
+
+		r = falcon_verify(bc->sig, bc->sig_len,
+			FALCON_SIG_COMPRESSED, bc->pk, bc->pk_len,
+			"data", 4, bc->tmp, bc->tmp_len);
+		if (r != 0) {
+			return r;
+		}
+	}
+	return 0;
+}
+
+static int
+bench_verify_ct(void *ctx, unsigned long num)
+{
+	bench_context *bc;
+
+	bc = ctx;
+	while (num -- > 0) {
+		int r;
+
+		r = falcon_verify(bc->sigct, bc->sigct_len,
+			FALCON_SIG_CT, bc->pk, bc->pk_len,
+			"data", 4, bc->tmp, bc->tmp_len);
+		if (r != 0) {
+			return r;
+		}
+	}
+	return 0;
+}
+
+/*
+ * The hash-to-point benchmarks restart from a copy of a flipped
+ * SHAKE256 context (about 200 bytes), which is included in the cost.
+ */
+static int
+bench_hash_to_point_vartime(void *ctx, unsigned long num)
+{
+	bench_context *bc;
+
+	bc = ctx;
+	while (num -- > 0) {
+		inner_shake256_context sc;
+
+		sc = bc->hsc[0];
+		Zf(hash_to_point_vartime)(&sc, bc->hx, bc->logn);
+	}
+	return 0;
+}
+
+static int
+bench_hash_to_point_ct(void *ctx, unsigned long num)
+{
+	bench_context *bc;
+
+	bc = ctx;
+	while (num -- > 0) {
+		inner_shake256_context sc;
+
+		sc = bc->hsc[0];
+		Zf(hash_to_point_ct)(&sc, bc->hx, bc->logn, bc->tmp);
+	}
+	return 0;
+}
+
+static int
+bench_hash_to_point_vartime_x4(void *ctx, unsigned long num)
+{
+	bench_context *bc;
+
+	bc = ctx;
+	while (num -- > 0) {
+		inner_shake256_context sc[4];
+
+		memcpy(sc, bc->hsc, sizeof sc);
+		Zf(hash_to_point_vartime_x4)(sc, bc->hx, bc->logn);
+	}
+	return 0;
+}
+
+static int
+bench_hash_to_point_x4(void *ctx, unsigned long num)
+{
+	bench_context *bc;
+
+	bc = ctx;
+	while (num -- > 0) {
+		inner_shake256_context sc[4];
+
+		memcpy(sc, bc->hsc, sizeof sc);
+		Zf(hash_to_point_x4)(sc, bc->hx, bc->logn, bc->tmp);
+	}
+	return 0;
+}
+
+/*
+ * The FFT benchmarks restart from a copy of the source polynomial
+ * (8*2^logn bytes), which is included in the cost; repeated transforms
+ * in place would make the values overflow.
+ */
+static int
+bench_FFT(void *ctx, unsigned long num)
+{
+	bench_context *bc;
+	size_t n;
+
+	bc = ctx;
+	n = (size_t)1 << bc->logn;
+	while (num -- > 0) {
+		memcpy(bc->f, bc->f0, n * sizeof *bc->f);
+		Zf(FFT)(bc->f, bc->logn);
+	}
+	return 0;
+}
+
+static int
+bench_iFFT(void *ctx, unsigned long num)
+{
+	bench_context *bc;
+	size_t n;
+
+	bc = ctx;
+	n = (size_t)1 << bc->logn;
+	while (num -- > 0) {
+		memcpy(bc->f, bc->f0, n * sizeof *bc->f);
+		Zf(iFFT)(bc->f, bc->logn);
+	}
+	return 0;
+}
+
+static int
+bench_mq_NTT(void *ctx, unsigned long num)
+{
+	bench_context *bc;
+
+	bc = ctx;
+	while (num -- > 0) {
+		Zf(mq_NTT)(bc->h, bc->logn);
+	}
+	return 0;
+}
+
+static int
+bench_mq_iNTT(void *ctx, unsigned long num)
+{
+	bench_context *bc;
+
+	bc = ctx;
+	while (num -- > 0) {
+		Zf(mq_iNTT)(bc->h, bc->logn);
+	}
+	return 0;
+}
+
+static int
+bench_comp_encode(void *ctx, unsigned long num)
+{
+	bench_context *bc;
+
+	bc = ctx;
+	while (num -- > 0) {
+		size_t k;
+
+		k = num % BENCH_ENC_NUM;
+		if (Zf(comp_encode)(bc->tmp, bc->tmp_len,
+			bc->s2 + (k << bc->logn), bc->logn) != bc->enc_len[k])
+		{
+			return FALCON_ERR_INTERNAL;
+		}
+	}
+	return 0;
+}
+
+static int
+bench_comp_decode(void *ctx, unsigned long num)
+{
+	bench_context *bc;
+
+	bc = ctx;
+	while (num -- > 0) {
+		size_t k;
+
+		k = num % BENCH_ENC_NUM;
+		if (Zf(comp_decode)((int16_t *)bc->tmp, bc->logn,
+			bc->enc + k * FALCON_SIG_COMPRESSED_MAXSIZE(bc->logn),
+			bc->enc_len[k]) != bc->enc_len[k])
+		{
+			return FALCON_ERR_INTERNAL;
+		}
+	}
+	return 0;
+}
+
+static int
+bench_prng_refill(void *ctx, unsigned long num)
+{
+	bench_context *bc;
+
+	bc = ctx;
+	while (num -- > 0) {
+		Zf(prng_refill)(&bc->spc.p);
+	}
+	return 0;
+}
+
+static int
+bench_gaussian0_sampler(void *ctx, unsigned long num)
+{
+	bench_context *bc;
+	int acc;
+
+	bc = ctx;
+	acc = 0;
+	while (num -- > 0) {
+		acc += Zf(gaussian0_sampler)(&bc->spc.p);
+	}
+	return acc < 0 ? FALCON_ERR_INTERNAL : 0;
+}
+
+static int
+bench_new_gaussian0_sampler(void *ctx, unsigned long num)
+{
+	bench_context *bc;
+	int acc;
+
+	bc = ctx;
+	acc = 0;
+	while (num -- > 0) {
+		acc += Zf(new_gaussian0_sampler)(&bc->spc.p);
+	}
+	return acc < 0 ? FALCON_ERR_INTERNAL : 0;
+}
+
+static int
+bench_gaussian0_sampler_batch_x8(void *ctx, unsigned long num)
+{
+	bench_context *bc;
+	int acc, z[8];
+
+	bc = ctx;
+	acc = 0;
+	while (num -- > 0) {
+		Zf(gaussian0_sampler_batch)(&bc->spc.p, z, 8);
+		acc += z[0] + z[7];
+	}
+	return acc < 0 ? FALCON_ERR_INTERNAL : 0;
+}
+
+static int
+bench_sampler(void *ctx, unsigned long num)
+{
+	bench_context *bc;
+	unsigned k;
+	int acc;
+
+	bc = ctx;
+	acc = 0;
+	for (k = 0; num -- > 0; k ++) {
+		acc ^= Zf(sampler)(&bc->spc, bc->mu[k & 15], bc->isigma);
+	}
+	return acc == 0x7FFFFFFF ? FALCON_ERR_INTERNAL : 0;
+}
+
+static int
+bench_new_sampler(void *ctx, unsigned long num)
+{
+	bench_context *bc;
+	unsigned k;
+	int acc;
+
+	bc = ctx;
+	acc = 0;
+	for (k = 0; num -- > 0; k ++) {
+		acc ^= Zf(new_sampler)(&bc->spc, bc->mu[k & 15], bc->isigma);
+	}
+	return acc == 0x7FFFFFFF ? FALCON_ERR_INTERNAL : 0;
+}
+
+static void
+test_speed_falcon(unsigned logn)
+{
+	bench_context bc;
+	inner_shake256_context isc;
+	size_t n, u, len;
+	char name[64];
+
+	n = (size_t)1 << logn;
+	printf("--- degree %u\n", 1u << logn);
+	fflush(stdout);
+
+	memset(&bc, 0, sizeof bc);
+	bc.logn = logn;
+	shake256_init_prng_from_seed(&bc.rng, "speed", 5);
+	bc.pk_len = FALCON_PUBKEY_SIZE(logn);
+	bc.sk_len = FALCON_PRIVKEY_SIZE(logn);
+	bc.esk_len = FALCON_EXPANDEDKEY_SIZE(logn);
+	bc.tmp_len = FALCON_TMPSIZE_KEYGEN(logn);
+	if (bc.tmp_len < FALCON_TMPSIZE_SIGNDYN(logn)) {
+		bc.tmp_len = FALCON_TMPSIZE_SIGNDYN(logn);
+	}
+	if (bc.tmp_len < FALCON_TMPSIZE_EXPANDPRIV(logn)) {
+		bc.tmp_len = FALCON_TMPSIZE_EXPANDPRIV(logn);
+	}
+	bc.tmp = xmalloc(bc.tmp_len);
+	bc.pk = xmalloc(bc.pk_len);
+	bc.sk = xmalloc(bc.sk_len);
+	bc.esk = xmalloc(bc.esk_len);
+	bc.sig = xmalloc(FALCON_SIG_COMPRESSED_MAXSIZE(logn));
+	bc.pk2 = xmalloc(bc.pk_len);
+	bc.sk2 = xmalloc(bc.sk_len);
+	bc.sig2 = xmalloc(FALCON_SIG_COMPRESSED_MAXSIZE(logn));
+	bc.sigct = xmalloc(FALCON_SIG_CT_SIZE(logn));
+	bc.f = xmalloc(n * sizeof *bc.f);
+	bc.f0 = xmalloc(n * sizeof *bc.f0);
+	bc.h = xmalloc(n * sizeof *bc.h);
+	bc.hx = xmalloc(4 * n * sizeof *bc.hx);
+	bc.s2 = xmalloc(BENCH_ENC_NUM * n * sizeof *bc.s2);
+	bc.enc = xmalloc(BENCH_ENC_NUM * FALCON_SIG_COMPRESSED_MAXSIZE(logn));
+
+	/*
+	 * Key pair, expanded key and signatures for the verification
+	 * and encoding benchmarks.
+	 */
+	check_ret(falcon_keygen_make(&bc.rng, logn, bc.sk, bc.sk_len,
+		bc.pk, bc.pk_len, bc.tmp, bc.tmp_len), "keygen");
+	check_ret(falcon_expand_privkey(bc.esk, bc.esk_len,
+		bc.sk, bc.sk_len, bc.tmp, bc.tmp_len), "expand_privkey");
+	bc.sig_len = FALCON_SIG_COMPRESSED_MAXSIZE(logn);
+	check_ret(falcon_sign_dyn(&bc.rng, bc.sig, &bc.sig_len,
+		FALCON_SIG_COMPRESSED, bc.sk, bc.sk_len, "data", 4,
+		bc.tmp, bc.tmp_len), "sign_dyn");
+	bc.sigct_len = FALCON_SIG_CT_SIZE(logn);
+	check_ret(falcon_sign_dyn(&bc.rng, bc.sigct, &bc.sigct_len,
+		FALCON_SIG_CT, bc.sk, bc.sk_len, "data", 4,
+		bc.tmp, bc.tmp_len), "sign_dyn");
+	for (u = 0; u < BENCH_ENC_NUM; u ++) {
+		size_t sig_len;
+
+		sig_len = FALCON_SIG_COMPRESSED_MAXSIZE(logn);
+		check_ret(falcon_sign_dyn(&bc.rng, bc.sig2, &sig_len,
+			FALCON_SIG_COMPRESSED, bc.sk, bc.sk_len, "data", 4,
+			bc.tmp, bc.tmp_len), "sign_dyn");
+		len = Zf(comp_decode)(bc.s2 + (u << logn), logn,
+			bc.sig2 + 41, sig_len - 41);
+		if (len != sig_len - 41) {
+			check_ret(FALCON_ERR_FORMAT, "comp_decode");
+		}
+		memcpy(bc.enc + u * FALCON_SIG_COMPRESSED_MAXSIZE(logn),
+			bc.sig2 + 41, len);
+		bc.enc_len[u] = len;
+	}
+
+	/*
+	 * Inputs for the inner functions.
+	 */
+	for (u = 0; u < 4; u ++) {
+		uint8_t c;
+
+		c = (uint8_t)u;
+		inner_shake256_init(&bc.hsc[u]);
+		inner_shake256_inject(&bc.hsc[u], &c, 1);
+		inner_shake256_flip(&bc.hsc[u]);
+	}
+	isc = bc.hsc[0];
+	Zf(hash_to_point_vartime)(&isc, bc.h, logn);
+	for (u = 0; u < n; u ++) {
+		bc.f0[u] = fpr_of((int64_t)bc.h[u] - 6144);
+	}
+	inner_shake256_init(&isc);
+	inner_shake256_inject(&isc, (const uint8_t *)"sampler", 7);
+	inner_shake256_flip(&isc);
+	Zf(prng_init)(&bc.spc.p, &isc);
+	bc.spc.sigma_min = fpr_sigma_min[logn];
+#if FALCON_SAMPLER_STATS
+	memset(&bc.spc.stats, 0, sizeof bc.spc.stats);
+#endif
+	for (u = 0; u < 16; u ++) {
+		bc.mu[u] = fpr_div(fpr_of((int64_t)u * 1237 - 9000),
+			fpr_of(97));
+	}
+	bc.isigma = fpr_div(fpr_of(2), fpr_of(3));
+
+#define BENCH(label, fun)   do { \
+		sprintf(name, "%s %u", label, 1u << logn); \
+		do_bench(name, fun, &bc); \
+	} while (0)
+
+	BENCH("keygen", bench_keygen);
+	BENCH("expand_privkey", bench_expand_privkey);
+	BENCH("sign_dyn", bench_sign_dyn);
+	BENCH("sign_tree", bench_sign_tree);
+	BENCH("verify", bench_verify);
+	BENCH("verify_ct", bench_verify_ct);
+	BENCH("hash_to_point_vartime", bench_hash_to_point_vartime);
+	BENCH("hash_to_point_ct", bench_hash_to_point_ct);
+	BENCH("hash_to_point_vartime_x4", bench_hash_to_point_vartime_x4);
+	BENCH("hash_to_point_x4", bench_hash_to_point_x4);
+	BENCH("FFT", bench_FFT);
+	BENCH("iFFT", bench_iFFT);
+	BENCH("mq_NTT", bench_mq_NTT);
+	BENCH("mq_iNTT", bench_mq_iNTT);
+	BENCH("comp_encode", bench_comp_encode);
+	BENCH("comp_decode", bench_comp_decode);
+	BENCH("prng_refill", bench_prng_refill);
+	BENCH("gaussian0_sampler", bench_gaussian0_sampler);
+	BENCH("gaussian0_sampler_batch_x8", bench_gaussian0_sampler_batch_x8);
+	BENCH("new_gaussian0_sampler", bench_new_gaussian0_sampler);
+	BENCH("sampler", bench_sampler);
+	BENCH("new_sampler", bench_new_sampler);
+
+#undef BENCH
+
+#if FALCON_SAMPLER_STATS
+	if (bc.spc.stats.candidates != 0) {
+		printf("sampler stats %u: base rejected %.4f,"
+			" SamplerZ accepted %.4f\n", 1u << logn,
+			(double)bc.spc.stats.base_rejected
+			/ (double)bc.spc.stats.base_draws,
+			(double)bc.spc.stats.accepted
+			/ (double)bc.spc.stats.candidates);
+	}
+#endif
+
+	xfree(bc.tmp);
+	xfree(bc.pk);
+	xfree(bc.sk);
+	xfree(bc.esk);
+	xfree(bc.sig);
+	xfree(bc.pk2);
+	xfree(bc.sk2);
+	xfree(bc.sig2);
+	xfree(bc.sigct);
+	xfree(bc.f);
+	xfree(bc.f0);
+	xfree(bc.h);
+	xfree(bc.hx);
+	xfree(bc.s2);
+	xfree(bc.enc);
+}
+
+/* ==================================================================== */
+/*
+ * Benchmarks for the deterministic mode (det1024).
+ */
+
+#define DET_BATCH   8
+
+typedef struct {
+	shake256_context rng;
+	falcon_det1024_sign_ctx sctx;
+	falcon_det1024_verify_ctx vctx;
+	falcon_det1024_expanded_privkey esk;
+	falcon_det1024_expanded_pubkey epk;
+	uint8_t sk[DET_BATCH][FALCON_DET1024_PRIVKEY_SIZE];
+	uint8_t pk[FALCON_DET1024_PUBKEY_SIZE];
+	uint8_t sig[DET_BATCH][FALCON_DET1024_SIG_COMPRESSED_MAXSIZE];
+	size_t sig_len[DET_BATCH];
+	uint8_t sigct[FALCON_DET1024_SIG_CT_SIZE];
+	uint8_t msg[DET_BATCH][32];
+	size_t msg_len[DET_BATCH];
+	const void *sig_ptr[DET_BATCH], *msg_ptr[DET_BATCH];
+	int results[DET_BATCH];
+	falcon_det1024_vct_result vct[DET_BATCH];
+	uint16_t c[4 * 1024];
+	unsigned ctr;
+} det_context;
+
+static int
+bench_det_keygen(void *ctx, unsigned long num)
+{
+	det_context *dc;
+
+	dc = ctx;
+	while (num -- > 0) {
+		uint8_t sk[FALCON_DET1024_PRIVKEY_SIZE];
+		uint8_t pk[FALCON_DET1024_PUBKEY_SIZE];
+		int r;
+
+		r = falcon_det1024_keygen_ctx(&dc->sctx, &dc->rng, sk, pk);
+		if (r != 0) {
+			return r;
+		}
+	}
+	return 0;
+}
+
+static int
+bench_det_sign(void *ctx, unsigned long num)
+{
+	det_context *dc;
+
+	dc = ctx;
+	while (num -- > 0) {
+		uint8_t sig[FALCON_DET1024_SIG_COMPRESSED_MAXSIZE];
+		size_t sig_len;
+		int r;
+
+		dc->msg[0][0] = (uint8_t)dc->ctr ++;
+		r = falcon_det1024_sign_compressed_ctx(&dc->sctx,
+			sig, &sig_len, NULL, dc->sk[0],
+			dc->msg[0], dc->msg_len[0]);
+		if (r != 0) {
+			return r;
+		}
+	}
+	dc->msg[0][0] = 0;
+	return 0;
+}
+
+static int
+bench_det_sign_tree(void *ctx, unsigned long num)
+{
+	det_context *dc;
+
+	dc = ctx;
+	while (num -- > 0) {
+		uint8_t sig[FALCON_DET1024_SIG_COMPRESSED_MAXSIZE];
+		size_t sig_len;
+		int r;
+
+		dc->msg[0][0] = (uint8_t)dc->ctr ++;
+		r = falcon_det1024_sign_compressed_tree_ctx(&dc->sctx,
+			sig, &sig_len, &dc->esk,
+			dc->msg[0], dc->msg_len[0]);
+		if (r != 0) {
+			return r;
+		}
+	}
+	dc->msg[0][0] = 0;
+	return 0;
+}
+
+static int
+bench_det_vct_eval_batch(void *ctx, unsigned long num)
+{
+	det_context *dc;
+
+	dc = ctx;
+	while (num -- > 0) {
+		int r;
+
+		r = falcon_det1024_vct_eval_batch(dc->vct, dc->sk, DET_BATCH,
+			dc->msg[0], dc->msg_len[0], 0xFFFFFFFF, 0);
+		if (r != 0) {
+			return r;
+		}
+	}
+	return 0;
+}
+
+static int
+bench_det_verify(void *ctx, unsigned long num)
+{
+	det_context *dc;
+
+	dc = ctx;
+	while (num -- > 0) {
+		int r;
+
+		r = falcon_det1024_verify_compressed_ctx(&dc->vctx,
+			dc->sig[0], dc->sig_len[0], dc->pk,
+			dc->msg[0], dc->msg_len[0]);
+		if (r != 0) {
+			return r;
+		}
+	}
+	return 0;
+}
+
+static int
+bench_det_verify_ct(void *ctx, unsigned long num)
+{
+	det_context *dc;
+
+	dc = ctx;
+	while (num -- > 0) {
+		int r;
+
+		r = falcon_det1024_verify_ct_ctx(&dc->vctx,
+			dc->sigct, dc->pk, dc->msg[0], dc->msg_len[0]);
+		if (r != 0) {
+			return r;
+		}
+	}
+	return 0;
+}
+
+static int
+bench_det_verify_expanded(void *ctx, unsigned long num)
+{
+	det_context *dc;
+
+	dc = ctx;
+	while (num -- > 0) {
+		int r;
+
+		r = falcon_det1024_verify_compressed_expanded(
+			dc->sig[0], dc->sig_len[0], &dc->epk,
+			dc->msg[0], dc->msg_len[0]);
+		if (r != 0) {
+			return r;
+		}
+	}
+	return 0;
+}
+
+static int
+bench_det_verify_batch(void *ctx, unsigned long num)
+{
+	det_context *dc;
+
+	dc = ctx;
+	while (num -- > 0) {
+		int r;
+
+		r = falcon_det1024_verify_batch_expanded(dc->results,
+			dc->sig_ptr, dc->sig_len, &dc->epk,
+			dc->msg_ptr, dc->msg_len, DET_BATCH);
+		if (r != 0) {
+			return r;
+		}
+	}
+	return 0;
+}
+
+static int
+bench_det_hash_to_point(void *ctx, unsigned long num)
+{
+	det_context *dc;
+
+	dc = ctx;
+	while (num -- > 0) {
+		falcon_det1024_hash_to_point_coeffs(dc->c,
+			dc->msg[0], dc->msg_len[0],
+			FALCON_DET1024_CURRENT_SALT_VERSION);
+	}
+	return 0;
+}
+
+static int
+bench_det_hash_to_point_x4(void *ctx, unsigned long num)
+{
+	det_context *dc;
+
+	dc = ctx;
+	while (num -- > 0) {
+		falcon_det1024_hash_to_point_coeffs_x4(dc->c,
+			dc->msg_ptr, dc->msg_len,
+			FALCON_DET1024_CURRENT_SALT_VERSION);
+	}
+	return 0;
+}
+
+static void
+test_speed_det1024(void)
+{
+	det_context *dc;
+	size_t u;
+
+	printf("--- det1024\n");
+	fflush(stdout);
+
+	dc = xmalloc(sizeof *dc);
+	memset(dc, 0, sizeof *dc);
+	shake256_init_prng_from_seed(&dc->rng, "speed det1024", 13);
+	/*
+	 * Keys are generated in reverse order, so that pk[] ends up
+	 * being the public key for sk[0] (used for all signatures).
+	 */
+	for (u = DET_BATCH; u -- > 0;) {
+		check_ret(falcon_det1024_keygen_ctx(&dc->sctx, &dc->rng,
+			dc->sk[u], dc->pk), "det1024 keygen");
+	}
+	check_ret(falcon_det1024_expand_privkey(&dc->esk, dc->sk[0]),
+		"det1024 expand_privkey");
+	check_ret(falcon_det1024_expand_pubkey(&dc->epk, dc->pk),
+		"det1024 expand_pubkey");
+	for (u = 0; u < DET_BATCH; u ++) {
+		dc->msg_len[u] = sizeof dc->msg[u];
+		memset(dc->msg[u], (int)u, dc->msg_len[u]);
+		check_ret(falcon_det1024_sign_compressed_ctx(&dc->sctx,
+			dc->sig[u], &dc->sig_len[u], NULL, dc->sk[0],
+			dc->msg[u], dc->msg_len[u]), "det1024 sign");
+		dc->sig_ptr[u] = dc->sig[u];
+		dc->msg_ptr[u] = dc->msg[u];
+	}
+	check_ret(falcon_det1024_convert_compressed_to_ct(dc->sigct,
+		dc->sig[0], dc->sig_len[0]), "det1024 convert");
+
+	do_bench("det1024 keygen", bench_det_keygen, dc);
+	do_bench("det1024 sign", bench_det_sign, dc);
+	do_bench("det1024 sign_tree", bench_det_sign_tree, dc);
+	do_bench("det1024 vct_eval_batch x8", bench_det_vct_eval_batch, dc);
+	do_bench("det1024 verify", bench_det_verify, dc);
+	do_bench("det1024 verify_ct", bench_det_verify_ct, dc);
+	do_bench("det1024 verify_expanded", bench_det_verify_expanded, dc);
+	do_bench("det1024 verify_batch x8", bench_det_verify_batch, dc);
+	do_bench("det1024 hash_to_point", bench_det_hash_to_point, dc);
+	do_bench("det1024 hash_to_point_x4", bench_det_hash_to_point_x4, dc);
+
+	xfree(dc);
+}
+
+/* ==================================================================== */
+
+static void
+usage(void)
+{
+	fprintf(stderr,
+"usage: speed [ -native ] [ -t seconds ] [ name ... ]\n"
+"  -native      select the native floating-point code at runtime\n"
+"               with falcon_fp_select() (FALCON_FP_DISPATCH); this\n"
+"               affects the external API benchmarks only\n"
+"  -t seconds   time budget per benchmark (default: 0.5)\n"
+"  name         run only the benchmarks whose name contains one of\n"
+"               the provided strings (e.g. \"sign\" or \"det1024\")\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+	unsigned oldcw, logn;
+	int i, native;
+
+	native = 0;
+	for (i = 1; i < argc; i ++) {
+		if (strcmp(argv[i], "-native") == 0) {
+			native = 1;
+		} else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+			budget = atof(argv[++ i]);
+			if (budget <= 0.0) {
+				fprintf(stderr, "invalid time budget\n");
+				return EXIT_FAILURE;
+			}
+		} else if (argv[i][0] == '-') {
+			usage();
+			return EXIT_FAILURE;
+		} else {
+			break;
+		}
+	}
+	num_filters = argc - i;
+	filters = argv + i;
+
+	if (native && !FALCON_FPNATIVE) {
+		int r;
+
+		r = falcon_fp_select(FALCON_FP_NATIVE);
+		if (r != 0) {
+			fprintf(stderr, "cannot select native FP (err=%d)\n", r);
+			return EXIT_FAILURE;
+		}
+	}
+
+	oldcw = set_fpu_cw(2);
+	printf("FP implementation: %s\n",
+		FALCON_FPNATIVE ? "native (FALCON_FPNATIVE)"
+		: falcon_fp_selected() == FALCON_FP_NATIVE
+		? "native (runtime dispatch; inner functions are emulated)"
+		: "emulated (FALCON_FPEMU)");
+	printf("time budget per benchmark: %.2f s\n", budget);
+	printf("%-32s %32s", "", "---------- ns/op ----------");
+	if (HAVE_CYCLES) {
+		printf(" %32s", "------ TSC cycles/op ------");
+	}
+	printf("\n%-32s %10s %10s %10s", "", "median", "p90", "p99");
+	if (HAVE_CYCLES) {
+		printf(" %10s %10s %10s", "median", "p90", "p99");
+	}
+	printf("\n");
+	fflush(stdout);
+
+	for (logn = 8; logn <= 10; logn ++) {
+		test_speed_falcon(logn);
+	}
+	test_speed_det1024();
+
+	set_fpu_cw(oldcw);
+	return 0;
+}
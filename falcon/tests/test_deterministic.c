@@ -0,0 +1,812 @@
+/*
+ * Tests for the deterministic mode (det1024).
+ *
+ * The regression digest below covers key pairs and signatures
+ * (compressed and CT) produced from fixed seeds. It was computed with
+ * this implementation, and any deviation indicates a loss of
+ * determinism: the same private key and message must always yield the
+ * same signature, whatever the CPU features used at runtime and the
+ * optimizations applied to the code. This holds for the emulated FP
+ * implementation (FALCON_FPEMU) only, which the deterministic mode
+ * requires (see config.h); native FP builds (FALCON_FPNATIVE) do
+ * produce different signatures, so there the digest is only compared
+ * for information.
+ *
+ * ==========================(LICENSE BEGIN)============================
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * ===========================(LICENSE END)=============================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../falcon.h"
+#include "../inner.h"
+#include "../deterministic.h"
+
+#if FALCON_THREADS
+#include <pthread.h>
+#endif
+
+#define NUM_KEYS   4
+#define NUM_MSGS   8
+
+static void *
+xmalloc(size_t len)
+{
+	void *buf;
+
+	if (len == 0) {
+		return NULL;
+	}
+	buf = malloc(len);
+	if (buf == NULL) {
+		fprintf(stderr, "memory allocation error\n");
+		exit(EXIT_FAILURE);
+	}
+	return buf;
+}
+
+static void
+xfree(void *buf)
+{
+	if (buf != NULL) {
+		free(buf);
+	}
+}
+
+static void
+print_hex(const char *name, const void *data, size_t len)
+{
+	const uint8_t *buf;
+	size_t u;
+
+	buf = data;
+	fprintf(stderr, "%s = ", name);
+	for (u = 0; u < len; u ++) {
+		fprintf(stderr, "%02x", buf[u]);
+	}
+	fprintf(stderr, "\n");
+}
+
+static void
+check_eq(const void *a, const void *b, size_t len, const char *banner)
+{
+	if (memcmp(a, b, len) == 0) {
+		return;
+	}
+	fprintf(stderr, "%s: wrong value:\n", banner);
+	print_hex("a", a, len);
+	print_hex("b", b, len);
+	exit(EXIT_FAILURE);
+}
+
+static void
+check_ret(int r, int expected, const char *banner)
+{
+	if (r != expected) {
+		fprintf(stderr, "%s: returned %d (expected %d)\n",
+			banner, r, expected);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/*
+ * Test keys and messages. Message j has length 13*j bytes (message 0
+ * is empty).
+ */
+static uint8_t privkeys[NUM_KEYS][FALCON_DET1024_PRIVKEY_SIZE];
+static uint8_t pubkeys[NUM_KEYS][FALCON_DET1024_PUBKEY_SIZE];
+static uint8_t msgs[NUM_MSGS][13 * NUM_MSGS];
+static size_t msg_lens[NUM_MSGS];
+static uint8_t sigs[NUM_KEYS][NUM_MSGS][FALCON_DET1024_SIG_COMPRESSED_MAXSIZE];
+static size_t sig_lens[NUM_KEYS][NUM_MSGS];
+
+static void
+make_keys(void)
+{
+	falcon_det1024_sign_ctx *ctx;
+	size_t i, j;
+
+	printf("Key generation: ");
+	fflush(stdout);
+	ctx = xmalloc(sizeof *ctx);
+	for (i = 0; i < NUM_KEYS; i ++) {
+		shake256_context rng;
+		char seed[32];
+		int r;
+
+		sprintf(seed, "test_deterministic key %u", (unsigned)i);
+		shake256_init_prng_from_seed(&rng, seed, strlen(seed));
+		r = falcon_det1024_keygen_ctx(ctx, &rng,
+			privkeys[i], pubkeys[i]);
+		check_ret(r, 0, "keygen");
+		printf(".");
+		fflush(stdout);
+	}
+	for (j = 0; j < NUM_MSGS; j ++) {
+		size_t u;
+
+		msg_lens[j] = 13 * j;
+		for (u = 0; u < msg_lens[j]; u ++) {
+			msgs[j][u] = (uint8_t)(j * 31 + u * 7);
+		}
+	}
+	xfree(ctx);
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+/* ==================================================================== */
+
+static const char *const KAT_DET1024_DIGEST =
+	"8e53883b61b178fe7aef1fff081dee310e2b7c2834ccbbe8db2b4856fb8a668f";
+
+static void
+test_sign_verify(void)
+{
+	shake256_context dig;
+	falcon_det1024_sign_ctx *sctx;
+	falcon_det1024_verify_ctx *vctx;
+	falcon_det1024_expanded_privkey *esk;
+	struct {
+		uint8_t pad;
+		falcon_det1024_expanded_privkey esk;
+	} *eskc;
+	falcon_det1024_expanded_pubkey *epk;
+	uint8_t out[32], ref[32];
+	size_t i, j, u;
+
+	printf("Sign/verify: ");
+	fflush(stdout);
+
+	sctx = xmalloc(sizeof *sctx);
+	vctx = xmalloc(sizeof *vctx);
+	esk = xmalloc(sizeof *esk);
+	eskc = xmalloc(sizeof *eskc);
+	epk = xmalloc(sizeof *epk);
+	shake256_init(&dig);
+	for (i = 0; i < NUM_KEYS; i ++) {
+		check_ret(falcon_det1024_expand_privkey(esk, privkeys[i]), 0,
+			"expand_privkey");
+		check_ret(falcon_det1024_expand_pubkey(epk, pubkeys[i]), 0,
+			"expand_pubkey");
+		shake256_inject(&dig, privkeys[i], FALCON_DET1024_PRIVKEY_SIZE);
+		shake256_inject(&dig, pubkeys[i], FALCON_DET1024_PUBKEY_SIZE);
+
+		for (j = 0; j < NUM_MSGS; j ++) {
+			uint8_t sig[FALCON_DET1024_SIG_COMPRESSED_MAXSIZE];
+			uint8_t sig_ct[FALCON_DET1024_SIG_CT_SIZE];
+			uint8_t *s;
+			size_t sig_len, len;
+			uint32_t sqnorm, sqnorm2;
+			int r;
+
+			s = sigs[i][j];
+			r = falcon_det1024_sign_compressed(s, &sig_lens[i][j],
+				privkeys[i], msgs[j], msg_lens[j]);
+			check_ret(r, 0, "sign_compressed");
+			sig_len = sig_lens[i][j];
+			check_ret(s[0], FALCON_DET1024_SIG_COMPRESSED_HEADER,
+				"compressed header");
+			check_ret(falcon_det1024_get_salt_version(s),
+				FALCON_DET1024_CURRENT_SALT_VERSION,
+				"salt version");
+
+			/*
+			 * All signing variants produce the same signature.
+			 */
+			len = sizeof sig;
+			r = falcon_det1024_sign_compressed_ctx(sctx,
+				sig, &len, &sqnorm,
+				privkeys[i], msgs[j], msg_lens[j]);
+			check_ret(r, 0, "sign_compressed_ctx");
+			check_ret((int)len, (int)sig_len, "sign_compressed_ctx");
+			check_eq(sig, s, sig_len, "sign_compressed_ctx");
+
+			r = falcon_det1024_sign_compressed_with_norm(
+				sig, &len, &sqnorm2,
+				privkeys[i], msgs[j], msg_lens[j]);
+			check_ret(r, 0, "sign_compressed_with_norm");
+			check_eq(sig, s, sig_len, "sign_compressed_with_norm");
+			check_ret((int)sqnorm2, (int)sqnorm, "sqnorm");
+
+			r = falcon_det1024_sign_compressed_tree(sig, &len,
+				esk, msgs[j], msg_lens[j]);
+			check_ret(r, 0, "sign_compressed_tree");
+			check_ret((int)len, (int)sig_len, "sign_compressed_tree");
+			check_eq(sig, s, sig_len, "sign_compressed_tree");
+
+			r = falcon_det1024_sign_compressed_tree_ctx(sctx,
+				sig, &len, esk, msgs[j], msg_lens[j]);
+			check_ret(r, 0, "sign_compressed_tree_ctx");
+			check_eq(sig, s, sig_len, "sign_compressed_tree_ctx");
+
+			r = falcon_det1024_sign_compressed_tree_with_norm_ctx(sctx,
+				sig, &len, &sqnorm2, esk, msgs[j], msg_lens[j]);
+			check_ret(r, 0, "sign_compressed_tree_with_norm_ctx");
+			check_eq(sig, s, sig_len, "sign_compressed_tree_with_norm_ctx");
+			check_ret((int)sqnorm2, (int)sqnorm, "tree sqnorm");
+
+			/*
+			 * A copy of the expanded key, at an address with a
+			 * different offset, signs the same way.
+			 */
+			memcpy(&eskc->esk, esk, sizeof *esk);
+			r = falcon_det1024_sign_compressed_tree(sig, &len,
+				&eskc->esk, msgs[j], msg_lens[j]);
+			check_ret(r, 0, "sign_compressed_tree (copy)");
+			check_eq(sig, s, sig_len, "sign_compressed_tree (copy)");
+
+			/*
+			 * Verification, in all variants.
+			 */
+			check_ret(falcon_det1024_verify_compressed(s, sig_len,
+				pubkeys[i], msgs[j], msg_lens[j]), 0,
+				"verify_compressed");
+			check_ret(falcon_det1024_verify_compressed_ctx(vctx,
+				s, sig_len, pubkeys[i], msgs[j], msg_lens[j]),
+				0, "verify_compressed_ctx");
+			check_ret(falcon_det1024_verify_compressed_expanded(
+				s, sig_len, epk, msgs[j], msg_lens[j]), 0,
+				"verify_compressed_expanded");
+
+			r = falcon_det1024_convert_compressed_to_ct(sig_ct,
+				s, sig_len);
+			check_ret(r, 0, "convert_compressed_to_ct");
+			check_ret(sig_ct[0], FALCON_DET1024_SIG_CT_HEADER,
+				"CT header");
+			check_ret(falcon_det1024_verify_ct(sig_ct,
+				pubkeys[i], msgs[j], msg_lens[j]), 0,
+				"verify_ct");
+			check_ret(falcon_det1024_verify_ct_ctx(vctx, sig_ct,
+				pubkeys[i], msgs[j], msg_lens[j]), 0,
+				"verify_ct_ctx");
+			check_ret(falcon_det1024_verify_ct_expanded(sig_ct,
+				epk, msgs[j], msg_lens[j]), 0,
+				"verify_ct_expanded");
+
+			/*
+			 * Altered messages and signatures are rejected.
+			 */
+			if (msg_lens[j] > 0) {
+				msgs[j][0] ^= 0x01;
+				check_ret(falcon_det1024_verify_compressed(
+					s, sig_len, pubkeys[i],
+					msgs[j], msg_lens[j]),
+					FALCON_ERR_BADSIG, "verify altered msg");
+				msgs[j][0] ^= 0x01;
+			}
+			check_ret(falcon_det1024_verify_compressed(s, sig_len,
+				pubkeys[(i + 1) % NUM_KEYS],
+				msgs[j], msg_lens[j]),
+				FALCON_ERR_BADSIG, "verify wrong key");
+			s[1] ^= 0x01;
+			check_ret(falcon_det1024_verify_compressed(s, sig_len,
+				pubkeys[i], msgs[j], msg_lens[j]),
+				FALCON_ERR_BADSIG, "verify salt version");
+			s[1] ^= 0x01;
+			s[sig_len - 1] ^= 0x10;
+			if (falcon_det1024_verify_compressed(s, sig_len,
+				pubkeys[i], msgs[j], msg_lens[j]) == 0)
+			{
+				fprintf(stderr, "altered signature accepted\n");
+				exit(EXIT_FAILURE);
+			}
+			s[sig_len - 1] ^= 0x10;
+
+			shake256_inject(&dig, s, sig_len);
+			shake256_inject(&dig, sig_ct, sizeof sig_ct);
+		}
+		printf(".");
+		fflush(stdout);
+	}
+
+	shake256_flip(&dig);
+	shake256_extract(&dig, out, sizeof out);
+	for (u = 0; u < sizeof ref; u ++) {
+		unsigned x;
+
+		sscanf(KAT_DET1024_DIGEST + 2 * u, "%2x", &x);
+		ref[u] = (uint8_t)x;
+	}
+	if (memcmp(out, ref, sizeof out) != 0) {
+#if FALCON_FPEMU
+		fprintf(stderr, "det1024 digest mismatch\n");
+		print_hex("expected", ref, sizeof ref);
+		print_hex("computed", out, sizeof out);
+		exit(EXIT_FAILURE);
+#else
+		printf(" (digest differs from FPEMU reference)");
+#endif
+	}
+	printf(".");
+	fflush(stdout);
+
+	xfree(sctx);
+	xfree(vctx);
+	xfree(esk);
+	xfree(eskc);
+	xfree(epk);
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+/* ==================================================================== */
+
+static void
+test_coeffs(void)
+{
+	uint16_t h[1024], c[4 * 1024], c2[1024];
+	int16_t s1[1024], s2[1024];
+	uint8_t sig_ct[FALCON_DET1024_SIG_CT_SIZE];
+	const void *data[4];
+	size_t data_lens[4];
+	size_t i, j, u;
+
+	printf("Coefficients: ");
+	fflush(stdout);
+
+	for (i = 0; i < NUM_KEYS; i ++) {
+		check_ret(falcon_det1024_pubkey_coeffs(h, pubkeys[i]), 0,
+			"pubkey_coeffs");
+		for (j = 0; j < NUM_MSGS; j ++) {
+			uint32_t sqn, sqnorm;
+			size_t len;
+
+			falcon_det1024_hash_to_point_coeffs(c, msgs[j],
+				msg_lens[j], FALCON_DET1024_CURRENT_SALT_VERSION);
+			check_ret(falcon_det1024_convert_compressed_to_ct(
+				sig_ct, sigs[i][j], sig_lens[i][j]), 0,
+				"convert_compressed_to_ct");
+			check_ret(falcon_det1024_s2_coeffs(s2, sig_ct), 0,
+				"s2_coeffs");
+			check_ret(falcon_det1024_s1_coeffs(s1, h, c, s2), 0,
+				"s1_coeffs");
+
+			/*
+			 * The norm reported by the signer is the norm of
+			 * (s1,s2) as recovered by a verifier.
+			 */
+			sqn = 0;
+			for (u = 0; u < 1024; u ++) {
+				sqn += (uint32_t)((int32_t)s1[u] * s1[u]);
+				sqn += (uint32_t)((int32_t)s2[u] * s2[u]);
+			}
+			check_ret(falcon_det1024_sign_compressed_with_norm(
+				sig_ct, &len, &sqnorm, privkeys[i],
+				msgs[j], msg_lens[j]), 0,
+				"sign_compressed_with_norm");
+			check_ret((int)sqnorm, (int)sqn, "signer sqnorm");
+		}
+		printf(".");
+		fflush(stdout);
+	}
+
+	/*
+	 * Four-way hashing matches one-way hashing.
+	 */
+	for (j = 0; j + 4 <= NUM_MSGS; j ++) {
+		for (u = 0; u < 4; u ++) {
+			data[u] = msgs[j + u];
+			data_lens[u] = msg_lens[j + u];
+		}
+		falcon_det1024_hash_to_point_coeffs_x4(c, data, data_lens,
+			FALCON_DET1024_CURRENT_SALT_VERSION);
+		for (u = 0; u < 4; u ++) {
+			falcon_det1024_hash_to_point_coeffs(c2, data[u],
+				data_lens[u], FALCON_DET1024_CURRENT_SALT_VERSION);
+			check_eq(c + u * 1024, c2, sizeof c2,
+				"hash_to_point_coeffs_x4");
+		}
+	}
+	printf(".");
+	fflush(stdout);
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+/* ==================================================================== */
+
+static void
+test_batch(void)
+{
+	falcon_det1024_expanded_pubkey *epk;
+	falcon_det1024_vct_result *res;
+	const void *sp[NUM_MSGS], *dp[NUM_MSGS];
+	size_t sl[NUM_MSGS], dl[NUM_MSGS];
+	int results[NUM_MSGS];
+	uint32_t threshold;
+	size_t i, j;
+	unsigned nthreads;
+
+	printf("Batches: ");
+	fflush(stdout);
+
+	/*
+	 * Batch verification, with one wrong message.
+	 */
+	epk = xmalloc(sizeof *epk);
+	check_ret(falcon_det1024_expand_pubkey(epk, pubkeys[0]), 0,
+		"expand_pubkey");
+	for (j = 0; j < NUM_MSGS; j ++) {
+		sp[j] = sigs[0][j];
+		sl[j] = sig_lens[0][j];
+		dp[j] = msgs[j];
+		dl[j] = msg_lens[j];
+	}
+	check_ret(falcon_det1024_verify_batch(results, sp, sl, pubkeys[0],
+		dp, dl, NUM_MSGS), 0, "verify_batch");
+	check_ret(falcon_det1024_verify_batch_expanded(results, sp, sl, epk,
+		dp, dl, NUM_MSGS), 0, "verify_batch_expanded");
+	dp[5] = msgs[6];
+	dl[5] = msg_lens[6];
+	check_ret(falcon_det1024_verify_batch_expanded(results, sp, sl, epk,
+		dp, dl, NUM_MSGS), FALCON_ERR_BADSIG, "verify_batch_expanded");
+	for (j = 0; j < NUM_MSGS; j ++) {
+		check_ret(results[j], j == 5 ? FALCON_ERR_BADSIG : 0,
+			"verify_batch_expanded result");
+	}
+	xfree(epk);
+	printf(".");
+	fflush(stdout);
+
+	/*
+	 * VCT evaluation: the norm of the signature with the first key
+	 * is used as threshold, so that exactly the keys whose norm is
+	 * strictly lower are selected. Results do not depend on the
+	 * number of threads.
+	 */
+	res = xmalloc(NUM_KEYS * sizeof *res);
+	for (nthreads = 1; nthreads <= 3; nthreads ++) {
+		uint8_t sig[FALCON_DET1024_SIG_COMPRESSED_MAXSIZE];
+		size_t sig_len;
+		uint32_t sqnorm;
+		int selected;
+
+		check_ret(falcon_det1024_vct_eval(sig, &sig_len, &threshold,
+			&selected, privkeys[0], msgs[3], msg_lens[3], 0), 0,
+			"vct_eval");
+		check_ret(selected, 0, "vct_eval selected");
+		check_ret(falcon_det1024_vct_eval_batch(res, privkeys,
+			NUM_KEYS, msgs[3], msg_lens[3], threshold, nthreads), 0,
+			"vct_eval_batch");
+		for (i = 0; i < NUM_KEYS; i ++) {
+			check_ret(res[i].status, 0, "vct_eval_batch status");
+			check_ret(falcon_det1024_vct_eval(sig, &sig_len,
+				&sqnorm, &selected, privkeys[i],
+				msgs[3], msg_lens[3], threshold), 0,
+				"vct_eval");
+			check_ret(selected, sqnorm < threshold,
+				"vct_eval selected");
+			check_ret(res[i].selected, selected,
+				"vct_eval_batch selected");
+			check_ret((int)res[i].sqnorm, (int)sqnorm,
+				"vct_eval_batch sqnorm");
+			check_ret((int)res[i].sig_len, (int)sig_lens[i][3],
+				"vct_eval_batch sig_len");
+			check_eq(res[i].sig, sigs[i][3], sig_lens[i][3],
+				"vct_eval_batch sig");
+		}
+		printf(".");
+		fflush(stdout);
+	}
+	xfree(res);
+
+	/*
+	 * Parallel key generation yields the keys of make_keys(), in
+	 * seed order, whatever the number of threads.
+	 */
+	for (nthreads = 1; nthreads <= 3; nthreads ++) {
+		uint8_t (*sk)[FALCON_DET1024_PRIVKEY_SIZE];
+		uint8_t (*pk)[FALCON_DET1024_PUBKEY_SIZE];
+		char seeds[NUM_KEYS][32];
+		const void *seedp[NUM_KEYS];
+		size_t seedl[NUM_KEYS];
+		int status[NUM_KEYS];
+
+		sk = xmalloc(NUM_KEYS * sizeof *sk);
+		pk = xmalloc(NUM_KEYS * sizeof *pk);
+		for (i = 0; i < NUM_KEYS; i ++) {
+			sprintf(seeds[i], "test_deterministic key %u",
+				(unsigned)i);
+			seedp[i] = seeds[i];
+			seedl[i] = strlen(seeds[i]);
+		}
+		check_ret(falcon_det1024_keygen_batch(sk, pk, status,
+			seedp, seedl, NUM_KEYS, nthreads), 0, "keygen_batch");
+		for (i = 0; i < NUM_KEYS; i ++) {
+			check_ret(status[i], 0, "keygen_batch status");
+			check_eq(sk[i], privkeys[i], sizeof sk[i],
+				"keygen_batch privkey");
+			check_eq(pk[i], pubkeys[i], sizeof pk[i],
+				"keygen_batch pubkey");
+		}
+		xfree(sk);
+		xfree(pk);
+		printf(".");
+		fflush(stdout);
+	}
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+/* ==================================================================== */
+
+/*
+ * Test thread pools for falcon_keygen_make_pool(). The sequential pool
+ * runs the tasks in reverse order; the POSIX threads pool starts one
+ * thread per task (except task 0, which runs in the calling thread).
+ */
+static void
+pool_run_reverse(void *pool, void (*task)(void *arg, unsigned idx),
+	void *arg, unsigned count)
+{
+	(void)pool;
+	while (count -- > 0) {
+		task(arg, count);
+	}
+}
+
+#if FALCON_THREADS
+typedef struct {
+	void (*task)(void *arg, unsigned idx);
+	void *arg;
+	unsigned idx;
+} pool_thread;
+
+static void *
+pool_thread_main(void *arg)
+{
+	pool_thread *pt;
+
+	pt = arg;
+	pt->task(pt->arg, pt->idx);
+	return NULL;
+}
+
+static void
+pool_run_pthread(void *pool, void (*task)(void *arg, unsigned idx),
+	void *arg, unsigned count)
+{
+	pthread_t th[8];
+	pool_thread pt[8];
+	unsigned i;
+
+	(void)pool;
+	if (count > 8) {
+		fprintf(stderr, "pool_run_pthread: too many tasks\n");
+		exit(EXIT_FAILURE);
+	}
+	for (i = 1; i < count; i ++) {
+		pt[i].task = task;
+		pt[i].arg = arg;
+		pt[i].idx = i;
+		if (pthread_create(&th[i], NULL, pool_thread_main, &pt[i]) != 0) {
+			fprintf(stderr, "pthread_create failed\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	task(arg, 0);
+	for (i = 1; i < count; i ++) {
+		pthread_join(th[i], NULL);
+	}
+}
+#endif
+
+/*
+ * Key generation with a thread pool yields the same keys as without,
+ * for all degrees and whatever the number of tasks.
+ */
+static void
+test_keygen_pool(void)
+{
+	static const unsigned task_counts[] = { 2, 3, 5 };
+	falcon_thread_pool pools[2];
+	size_t num_pools, i, j;
+	uint8_t *tmp;
+	size_t tmp_len;
+	unsigned logn;
+
+	printf("Keygen pool: ");
+	fflush(stdout);
+
+	num_pools = 0;
+	pools[num_pools].run = pool_run_reverse;
+	pools[num_pools].pool = NULL;
+	num_pools ++;
+#if FALCON_THREADS
+	pools[num_pools].run = pool_run_pthread;
+	pools[num_pools].pool = NULL;
+	num_pools ++;
+#endif
+
+	tmp_len = FALCON_TMPSIZE_KEYGEN_POOL(10, 5);
+	tmp = xmalloc(tmp_len);
+	for (logn = 1; logn <= 10; logn ++) {
+		uint8_t sk[FALCON_PRIVKEY_SIZE(10)], pk[FALCON_PUBKEY_SIZE(10)];
+		uint8_t sk2[FALCON_PRIVKEY_SIZE(10)], pk2[FALCON_PUBKEY_SIZE(10)];
+		size_t sk_len, pk_len;
+		shake256_context rng;
+
+		sk_len = FALCON_PRIVKEY_SIZE(logn);
+		pk_len = FALCON_PUBKEY_SIZE(logn);
+		shake256_init_prng_from_seed(&rng, "keygen pool", 11);
+		check_ret(falcon_keygen_make(&rng, logn, sk, sk_len,
+			pk, pk_len, tmp, FALCON_TMPSIZE_KEYGEN(logn)),
+			0, "keygen_make");
+		for (i = 0; i < num_pools; i ++) {
+			for (j = 0; j < sizeof task_counts / sizeof task_counts[0];
+				j ++)
+			{
+				pools[i].nthreads = task_counts[j];
+				shake256_init_prng_from_seed(&rng,
+					"keygen pool", 11);
+				check_ret(falcon_keygen_make_pool(&rng, logn,
+					sk2, sk_len, pk2, pk_len, tmp,
+					FALCON_TMPSIZE_KEYGEN_POOL(logn,
+					task_counts[j]), &pools[i]),
+					0, "keygen_make_pool");
+				check_eq(sk, sk2, sk_len, "keygen_pool privkey");
+				check_eq(pk, pk2, pk_len, "keygen_pool pubkey");
+			}
+		}
+		pools[0].nthreads = 2;
+		check_ret(falcon_keygen_make_pool(&rng, logn, sk2, sk_len,
+			pk2, pk_len, tmp, FALCON_TMPSIZE_KEYGEN_POOL(logn, 2) - 1,
+			&pools[0]), FALCON_ERR_SIZE, "keygen_make_pool size");
+		printf(".");
+		fflush(stdout);
+	}
+
+	/*
+	 * det1024 wrapper: same keys as make_keys().
+	 */
+	for (i = 0; i < NUM_KEYS; i ++) {
+		uint8_t sk[FALCON_DET1024_PRIVKEY_SIZE];
+		uint8_t pk[FALCON_DET1024_PUBKEY_SIZE];
+		shake256_context rng;
+		char seed[32];
+
+		sprintf(seed, "test_deterministic key %u", (unsigned)i);
+		shake256_init_prng_from_seed(&rng, seed, strlen(seed));
+		pools[num_pools - 1].nthreads = 3;
+		check_ret(falcon_det1024_keygen_pool(&pools[num_pools - 1],
+			tmp, FALCON_DET1024_TMPSIZE_KEYGEN_POOL(3),
+			&rng, sk, pk), 0, "det1024_keygen_pool");
+		check_eq(sk, privkeys[i], sizeof sk, "det1024_keygen_pool privkey");
+		check_eq(pk, pubkeys[i], sizeof pk, "det1024_keygen_pool pubkey");
+	}
+	xfree(tmp);
+	printf(".");
+	fflush(stdout);
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+/* ==================================================================== */
+
+/*
+ * If the native floating-point code can be selected at runtime, check
+ * that it computes exactly the same keys and signatures as the default
+ * code (this must run after test_sign_verify(), which fills sigs[]).
+ */
+static void
+test_fp_dispatch(void)
+{
+	falcon_det1024_sign_ctx *ctx;
+	falcon_det1024_expanded_privkey *esk;
+	int dfl, other, r;
+	size_t i, j;
+
+	printf("FP dispatch: ");
+	fflush(stdout);
+
+	dfl = falcon_fp_selected();
+	check_ret(falcon_fp_select(-1), FALCON_ERR_BADARG, "fp_select(-1)");
+	check_ret(falcon_fp_select(dfl), 0, "fp_select(default)");
+	other = dfl == FALCON_FP_EMULATED
+		? FALCON_FP_NATIVE : FALCON_FP_EMULATED;
+	r = falcon_fp_select(other);
+	if (r == FALCON_ERR_BADARG) {
+		check_ret(falcon_fp_selected(), dfl, "fp_selected");
+		printf("(not available) done.\n");
+		fflush(stdout);
+		return;
+	}
+	check_ret(r, 0, "fp_select");
+	check_ret(falcon_fp_selected(), other, "fp_selected");
+
+	ctx = xmalloc(sizeof *ctx);
+	esk = xmalloc(sizeof *esk);
+	for (i = 0; i < NUM_KEYS; i ++) {
+		uint8_t sk[FALCON_DET1024_PRIVKEY_SIZE];
+		uint8_t pk[FALCON_DET1024_PUBKEY_SIZE];
+		shake256_context rng;
+		char seed[32];
+
+		sprintf(seed, "test_deterministic key %u", (unsigned)i);
+		shake256_init_prng_from_seed(&rng, seed, strlen(seed));
+		check_ret(falcon_det1024_keygen_ctx(ctx, &rng, sk, pk), 0,
+			"keygen");
+		check_eq(sk, privkeys[i], sizeof sk, "dispatch privkey");
+		check_eq(pk, pubkeys[i], sizeof pk, "dispatch pubkey");
+
+		/*
+		 * Expanded keys are interchangeable between the two
+		 * implementations: expand with one, sign with the other.
+		 */
+		check_ret(falcon_fp_select(dfl), 0, "fp_select(default)");
+		check_ret(falcon_det1024_expand_privkey(esk, privkeys[i]), 0,
+			"expand_privkey");
+		check_ret(falcon_fp_select(other), 0, "fp_select");
+
+		for (j = 0; j < NUM_MSGS; j ++) {
+			uint8_t sig[FALCON_DET1024_SIG_COMPRESSED_MAXSIZE];
+			size_t len;
+
+			len = sizeof sig;
+			r = falcon_det1024_sign_compressed(sig, &len,
+				privkeys[i], msgs[j], msg_lens[j]);
+			check_ret(r, 0, "sign_compressed");
+			check_ret((int)len, (int)sig_lens[i][j],
+				"dispatch sig_len");
+			check_eq(sig, sigs[i][j], len, "dispatch sign");
+
+			len = sizeof sig;
+			r = falcon_det1024_sign_compressed_tree(sig, &len,
+				esk, msgs[j], msg_lens[j]);
+			check_ret(r, 0, "sign_compressed_tree");
+			check_ret((int)len, (int)sig_lens[i][j],
+				"dispatch sig_len");
+			check_eq(sig, sigs[i][j], len, "dispatch sign_tree");
+		}
+		printf(".");
+		fflush(stdout);
+	}
+	check_ret(falcon_fp_select(dfl), 0, "fp_select(default)");
+	xfree(ctx);
+	xfree(esk);
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+/* ==================================================================== */
+
+int
+main(void)
+{
+	printf("FP implementation: %s\n",
+		FALCON_FPEMU ? "emulated (FALCON_FPEMU)"
+		: "native (FALCON_FPNATIVE)");
+	make_keys();
+	test_sign_verify();
+	test_coeffs();
+	test_batch();
+	test_keygen_pool();
+	test_fp_dispatch();
+	return 0;
+}
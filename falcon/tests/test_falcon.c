@@ -0,0 +1,1570 @@
+/*
+ * Unit tests for the Falcon implementation (inner and external API).
+ *
+ * Besides the functional checks (round trips, equivalence of the
+ * alternate implementations of a primitive, sign/verify), some tests
+ * compare a SHAKE256 digest of a long output against a reference
+ * value. These references were computed with this implementation;
+ * they make sure that optimized or vectorized versions of the PRNG,
+ * the samplers and the FFT stay bit-for-bit identical with the code
+ * they replace (which is required by the deterministic mode). They
+ * must hold for both FALCON_FPEMU and FALCON_FPNATIVE builds.
+ *
+ * ==========================(LICENSE BEGIN)============================
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * ===========================(LICENSE END)=============================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../falcon.h"
+#include "../inner.h"
+
+static void *
+xmalloc(size_t len)
+{
+	void *buf;
+
+	if (len == 0) {
+		return NULL;
+	}
+	buf = malloc(len);
+	if (buf == NULL) {
+		fprintf(stderr, "memory allocation error\n");
+		exit(EXIT_FAILURE);
+	}
+	return buf;
+}
+
+static void
+xfree(void *buf)
+{
+	if (buf != NULL) {
+		free(buf);
+	}
+}
+
+static size_t
+hextobin(uint8_t *buf, size_t max_len, const char *src)
+{
+	size_t u;
+	int acc, z;
+
+	u = 0;
+	acc = 0;
+	z = 0;
+	for (;;) {
+		int c;
+
+		c = *src ++;
+		if (c == 0) {
+			if (z) {
+				fprintf(stderr, "Lone hex nibble\n");
+				exit(EXIT_FAILURE);
+			}
+			return u;
+		}
+		if (c >= '0' && c <= '9') {
+			c -= '0';
+		} else if (c >= 'A' && c <= 'F') {
+			c -= ('A' - 10);
+		} else if (c >= 'a' && c <= 'f') {
+			c -= ('a' - 10);
+		} else if (c == ' ' || c == ':') {
+			continue;
+		} else {
+			fprintf(stderr, "Not an hex digit: U+%04X\n",
+				(unsigned)c);
+			exit(EXIT_FAILURE);
+		}
+		if (z) {
+			if (u >= max_len) {
+				fprintf(stderr, "Hex string too long\n");
+				exit(EXIT_FAILURE);
+			}
+			buf[u ++] = (uint8_t)((acc << 4) + c);
+		} else {
+			acc = c;
+		}
+		z = !z;
+	}
+}
+
+static void
+print_hex(const char *name, const void *data, size_t len)
+{
+	const uint8_t *buf;
+	size_t u;
+
+	buf = data;
+	fprintf(stderr, "%s = ", name);
+	for (u = 0; u < len; u ++) {
+		fprintf(stderr, "%02x", buf[u]);
+	}
+	fprintf(stderr, "\n");
+}
+
+static void
+check_eq(const void *a, const void *b, size_t len, const char *banner)
+{
+	size_t u;
+
+	if (memcmp(a, b, len) == 0) {
+		return;
+	}
+	fprintf(stderr, "%s: wrong value:\n", banner);
+	fprintf(stderr, "a: ");
+	for (u = 0; u < len; u ++) {
+		fprintf(stderr, "%02x", ((const unsigned char *)a)[u]);
+	}
+	fprintf(stderr, "\n");
+	fprintf(stderr, "b: ");
+	for (u = 0; u < len; u ++) {
+		fprintf(stderr, "%02x", ((const unsigned char *)b)[u]);
+	}
+	fprintf(stderr, "\n");
+	exit(EXIT_FAILURE);
+}
+
+static void
+check(int cond, const char *banner)
+{
+	if (!cond) {
+		fprintf(stderr, "%s: check failed\n", banner);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/*
+ * Finalize the SHAKE256 context sc (in input mode) and compare its
+ * first 32 output bytes with the hexadecimal reference value.
+ */
+static void
+check_digest(inner_shake256_context *sc, const char *ref, const char *banner)
+{
+	uint8_t out[32], tmp[32];
+
+	inner_shake256_flip(sc);
+	inner_shake256_extract(sc, out, sizeof out);
+	if (hextobin(tmp, sizeof tmp, ref) != sizeof tmp
+		|| memcmp(out, tmp, sizeof out) != 0)
+	{
+		fprintf(stderr, "%s: digest mismatch\n", banner);
+		print_hex("expected", tmp, sizeof tmp);
+		print_hex("computed", out, sizeof out);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/*
+ * Initialize sc as a flipped SHAKE256 context over the provided string
+ * (used as a deterministic seed by the tests).
+ */
+static void
+seed_shake(inner_shake256_context *sc, const char *seed, unsigned ctr)
+{
+	uint8_t c[4];
+
+	c[0] = (uint8_t)ctr;
+	c[1] = (uint8_t)(ctr >> 8);
+	c[2] = (uint8_t)(ctr >> 16);
+	c[3] = (uint8_t)(ctr >> 24);
+	inner_shake256_init(sc);
+	inner_shake256_inject(sc, (const uint8_t *)seed, strlen(seed));
+	inner_shake256_inject(sc, c, sizeof c);
+	inner_shake256_flip(sc);
+}
+
+/* ==================================================================== */
+
+static const struct {
+	const char *in;
+	const char *out;
+} KAT_SHAKE256[] = {
+	{
+		"",
+		"46b9dd2b0ba88d13233b3feb743eeb243fcd52ea62b81b82b50c27646ed5762f"
+	},
+	{
+		"616263",
+		"483366601360a8771c6863080cc4114d8db44530f8f1e1ee4f94ea37e78b5739"
+	},
+	{ NULL, NULL }
+};
+
+static void
+test_SHAKE256(void)
+{
+	inner_shake256_context sc, sc4[4];
+	uint8_t in[512], out[4 * 1000], ref[1000];
+	size_t u, v;
+
+	printf("Test SHAKE256: ");
+	fflush(stdout);
+
+	for (u = 0; KAT_SHAKE256[u].in != NULL; u ++) {
+		size_t len;
+
+		len = hextobin(in, sizeof in, KAT_SHAKE256[u].in);
+		hextobin(ref, sizeof ref, KAT_SHAKE256[u].out);
+		inner_shake256_init(&sc);
+		inner_shake256_inject(&sc, in, len);
+		inner_shake256_flip(&sc);
+		inner_shake256_extract(&sc, out, 32);
+		check_eq(out, ref, 32, "KAT SHAKE256");
+		printf(".");
+		fflush(stdout);
+	}
+
+	/*
+	 * Injection and extraction in small chunks must not change the
+	 * output.
+	 */
+	for (u = 0; u < sizeof in; u ++) {
+		in[u] = (uint8_t)(u * 7 + 3);
+	}
+	inner_shake256_init(&sc);
+	inner_shake256_inject(&sc, in, sizeof in);
+	inner_shake256_flip(&sc);
+	inner_shake256_extract(&sc, ref, sizeof ref);
+	for (v = 1; v < 200; v += 17) {
+		inner_shake256_init(&sc);
+		for (u = 0; u < sizeof in; u += v) {
+			inner_shake256_inject(&sc, in + u,
+				(sizeof in - u) < v ? (sizeof in - u) : v);
+		}
+		inner_shake256_flip(&sc);
+		for (u = 0; u < sizeof ref; u += v) {
+			inner_shake256_extract(&sc, out + u,
+				(sizeof ref - u) < v ? (sizeof ref - u) : v);
+		}
+		check_eq(out, ref, sizeof ref, "SHAKE256 chunks");
+	}
+	printf(".");
+	fflush(stdout);
+
+	/*
+	 * The four-way extraction must match four single extractions.
+	 */
+	for (u = 0; u < 4; u ++) {
+		seed_shake(&sc4[u], "shake_x4", (unsigned)u);
+	}
+	inner_shake256_extract_x4(sc4, out, 1000);
+	for (u = 0; u < 4; u ++) {
+		seed_shake(&sc, "shake_x4", (unsigned)u);
+		inner_shake256_extract(&sc, ref, 1000);
+		check_eq(out + u * 1000, ref, 1000, "SHAKE256 x4");
+	}
+	printf(".");
+	fflush(stdout);
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+/* ==================================================================== */
+
+static void
+test_codec(void)
+{
+	inner_shake256_context rng;
+	prng p;
+	unsigned logn;
+	uint8_t *buf;
+	uint16_t *h, *h2;
+	int16_t *s, *s2;
+	int8_t *f, *f2;
+
+	printf("Test codec: ");
+	fflush(stdout);
+
+	buf = xmalloc(4096);
+	h = xmalloc(2 * 1024);
+	h2 = xmalloc(2 * 1024);
+	s = xmalloc(2 * 1024);
+	s2 = xmalloc(2 * 1024);
+	f = xmalloc(1024);
+	f2 = xmalloc(1024);
+	seed_shake(&rng, "codec", 0);
+	Zf(prng_init)(&p, &rng);
+	for (logn = 1; logn <= 10; logn ++) {
+		size_t n, u, len, len2;
+		unsigned bits;
+		int lim;
+
+		n = (size_t)1 << logn;
+
+		for (u = 0; u < n; u ++) {
+			h[u] = (uint16_t)(prng_get_u64(&p) % 12289);
+		}
+		len = Zf(modq_encode)(buf, 4096, h, logn);
+		check(len != 0, "modq_encode");
+		len2 = Zf(modq_decode)(h2, logn, buf, len);
+		check(len2 == len, "modq_decode length");
+		check_eq(h, h2, n * sizeof *h, "modq round trip");
+
+		bits = Zf(max_fg_bits)[logn];
+		lim = (1 << (bits - 1)) - 1;
+		for (u = 0; u < n; u ++) {
+			f[u] = (int8_t)((int)(prng_get_u64(&p)
+				% (uint64_t)(2 * lim + 1)) - lim);
+		}
+		len = Zf(trim_i8_encode)(buf, 4096, f, logn, bits);
+		check(len != 0, "trim_i8_encode");
+		len2 = Zf(trim_i8_decode)(f2, logn, bits, buf, len);
+		check(len2 == len, "trim_i8_decode length");
+		check_eq(f, f2, n, "trim_i8 round trip");
+
+		/*
+		 * Compressed encoding, with values in the range used by
+		 * signatures: mostly small, with a few large ones.
+		 */
+		for (u = 0; u < n; u ++) {
+			uint64_t r;
+
+			r = prng_get_u64(&p);
+			if ((r & 0xFF) == 0) {
+				s[u] = (int16_t)((int)((r >> 8) % 4095) - 2047);
+			} else {
+				s[u] = (int16_t)((int)((r >> 8) % 401) - 200);
+			}
+		}
+		len = Zf(comp_encode)(buf, 4096, s, logn);
+		check(len != 0, "comp_encode");
+		len2 = Zf(comp_decode)(s2, logn, buf, len);
+		check(len2 == len, "comp_decode length");
+		check_eq(s, s2, n * sizeof *s, "comp round trip");
+		check(Zf(comp_decode)(s2, logn, buf, len - 1) == 0,
+			"comp_decode truncated");
+
+		/*
+		 * -2048 and values beyond 2047 cannot be encoded.
+		 */
+		s[n - 1] = -2048;
+		check(Zf(comp_encode)(buf, 4096, s, logn) == 0,
+			"comp_encode out of range");
+
+		printf(".");
+		fflush(stdout);
+	}
+	xfree(buf);
+	xfree(h);
+	xfree(h2);
+	xfree(s);
+	xfree(s2);
+	xfree(f);
+	xfree(f2);
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+/*
+ * Reference bit-by-bit implementation of the compressed encoding, used
+ * to check the optimized comp_encode() and comp_decode().
+ */
+static size_t
+comp_encode_ref(void *out, size_t max_out_len,
+	const int16_t *x, unsigned logn)
+{
+	uint8_t *buf;
+	size_t n, u, v;
+	uint32_t acc;
+	unsigned acc_len;
+
+	n = (size_t)1 << logn;
+	buf = out;
+	for (u = 0; u < n; u ++) {
+		if (x[u] < -2047 || x[u] > +2047) {
+			return 0;
+		}
+	}
+	acc = 0;
+	acc_len = 0;
+	v = 0;
+	for (u = 0; u < n; u ++) {
+		int t;
+		unsigned w;
+
+		acc <<= 1;
+		t = x[u];
+		if (t < 0) {
+			t = -t;
+			acc |= 1;
+		}
+		w = (unsigned)t;
+		acc <<= 7;
+		acc |= w & 127u;
+		w >>= 7;
+		acc_len += 8;
+		acc <<= (w + 1);
+		acc |= 1;
+		acc_len += w + 1;
+		while (acc_len >= 8) {
+			acc_len -= 8;
+			if (buf != NULL) {
+				if (v >= max_out_len) {
+					return 0;
+				}
+				buf[v] = (uint8_t)(acc >> acc_len);
+			}
+			v ++;
+		}
+	}
+	if (acc_len > 0) {
+		if (buf != NULL) {
+			if (v >= max_out_len) {
+				return 0;
+			}
+			buf[v] = (uint8_t)(acc << (8 - acc_len));
+		}
+		v ++;
+	}
+	return v;
+}
+
+static size_t
+comp_decode_ref(int16_t *x, unsigned logn,
+	const void *in, size_t max_in_len)
+{
+	const uint8_t *buf;
+	size_t n, u, v;
+	uint32_t acc;
+	unsigned acc_len;
+
+	n = (size_t)1 << logn;
+	buf = in;
+	acc = 0;
+	acc_len = 0;
+	v = 0;
+	for (u = 0; u < n; u ++) {
+		unsigned b, s, m;
+
+		if (v >= max_in_len) {
+			return 0;
+		}
+		acc = (acc << 8) | (uint32_t)buf[v ++];
+		b = acc >> acc_len;
+		s = b & 128;
+		m = b & 127;
+		for (;;) {
+			if (acc_len == 0) {
+				if (v >= max_in_len) {
+					return 0;
+				}
+				acc = (acc << 8) | (uint32_t)buf[v ++];
+				acc_len = 8;
+			}
+			acc_len --;
+			if (((acc >> acc_len) & 1) != 0) {
+				break;
+			}
+			m += 128;
+			if (m > 2047) {
+				return 0;
+			}
+		}
+		if (s && m == 0) {
+			return 0;
+		}
+		x[u] = (int16_t)(s ? -(int)m : (int)m);
+	}
+	if ((acc & ((1u << acc_len) - 1u)) != 0) {
+		return 0;
+	}
+	return v;
+}
+
+/*
+ * Compare comp_encode() and comp_decode() with the reference code, on
+ * valid encodings and on corrupted, truncated and random inputs: both
+ * decoders must accept and reject the same inputs, with the same
+ * length and values.
+ */
+static void
+test_comp_fuzz(void)
+{
+	inner_shake256_context rng;
+	prng p;
+	unsigned logn;
+	uint8_t *buf, *buf2;
+	int16_t *s, *s2, *s3;
+
+	printf("Test comp fuzz: ");
+	fflush(stdout);
+
+	buf = xmalloc(4096);
+	buf2 = xmalloc(4096);
+	s = xmalloc(2 * 1024);
+	s2 = xmalloc(2 * 1024);
+	s3 = xmalloc(2 * 1024);
+	seed_shake(&rng, "comp fuzz", 0);
+	Zf(prng_init)(&p, &rng);
+	for (logn = 1; logn <= 10; logn ++) {
+		size_t n, u;
+		int i;
+
+		n = (size_t)1 << logn;
+		for (i = 0; i < 300; i ++) {
+			size_t len, len2, len3, k;
+			unsigned mode;
+			uint64_t r;
+			int valid;
+
+			/*
+			 * Values: mostly small, with a few large ones and
+			 * the extremes.
+			 */
+			mode = (unsigned)(prng_get_u64(&p) % 3);
+			for (u = 0; u < n; u ++) {
+				r = prng_get_u64(&p);
+				if ((r & 0x3F) == 0) {
+					s[u] = (r & 0x40) ? -2047 : 2047;
+				} else if ((r & 0x3F) < 4 || mode == 2) {
+					s[u] = (int16_t)((int)((r >> 8) % 4095)
+						- 2047);
+				} else if (mode == 0) {
+					s[u] = (int16_t)((int)((r >> 8) % 401)
+						- 200);
+				} else {
+					s[u] = (int16_t)((int)((r >> 8) % 31)
+						- 15);
+				}
+			}
+			len = comp_encode_ref(buf, 4096, s, logn);
+			check(len != 0, "comp_encode_ref");
+			check(Zf(comp_encode)(NULL, 0, s, logn) == len,
+				"comp_encode length");
+			check(Zf(comp_encode)(buf2, len, s, logn) == len
+				&& memcmp(buf, buf2, len) == 0, "comp_encode");
+			memset(buf2, 0xA5, len + 8);
+			check(Zf(comp_encode)(buf2, 4096, s, logn) == len
+				&& memcmp(buf, buf2, len) == 0, "comp_encode");
+			for (k = len; k < len + 8; k ++) {
+				check(buf2[k] == 0xA5, "comp_encode overwrite");
+			}
+			k = (size_t)(prng_get_u64(&p) % len);
+			check(Zf(comp_encode)(buf2, k, s, logn) == 0,
+				"comp_encode short");
+
+			/*
+			 * Corrupt the encoding: flip some bits, replace it
+			 * with random bytes, or leave it as is; then decode
+			 * with a random length, and random bytes after the
+			 * encoded data.
+			 */
+			memcpy(buf2, buf, len);
+			for (k = len; k < len + 8; k ++) {
+				buf2[k] = (uint8_t)prng_get_u64(&p);
+			}
+			r = prng_get_u64(&p);
+			valid = (r & 3) == 0;
+			switch (r & 3) {
+			case 0:
+				break;
+			case 1:
+				for (k = 0; k <= ((r >> 2) & 3); k ++) {
+					size_t j;
+
+					j = (size_t)(prng_get_u64(&p) % (len << 3));
+					buf2[j >> 3] ^= (uint8_t)(0x80 >> (j & 7));
+				}
+				break;
+			case 2:
+				/* unused bits of the last byte */
+				buf2[len - 1] ^= (uint8_t)((r >> 8) & 0xFF);
+				break;
+			default:
+				for (k = 0; k < len; k ++) {
+					buf2[k] = (uint8_t)prng_get_u64(&p);
+				}
+				break;
+			}
+			r = prng_get_u64(&p);
+			if (r & 1) {
+				k = len - (len < 4 ? len : 4)
+					+ (size_t)((r >> 1) % 9);
+			} else {
+				k = (size_t)((r >> 1) % (len + 9));
+			}
+			len2 = comp_decode_ref(s2, logn, buf2, k);
+			len3 = Zf(comp_decode)(s3, logn, buf2, k);
+			check(len2 == len3, "comp_decode fuzz length");
+			if (len2 != 0) {
+				check_eq(s2, s3, n * sizeof *s2,
+					"comp_decode fuzz values");
+			}
+			if (valid && k >= len) {
+				check(len3 == len && memcmp(s, s3,
+					n * sizeof *s) == 0,
+					"comp_decode valid");
+			}
+		}
+		printf(".");
+		fflush(stdout);
+	}
+	xfree(buf);
+	xfree(buf2);
+	xfree(s);
+	xfree(s2);
+	xfree(s3);
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+/* ==================================================================== */
+
+static void
+test_NTT(void)
+{
+	inner_shake256_context rng;
+	prng p;
+	unsigned logn;
+	uint16_t a[1024], b[1024], c[1024], d[1024];
+
+	printf("Test NTT: ");
+	fflush(stdout);
+
+	seed_shake(&rng, "ntt", 0);
+	Zf(prng_init)(&p, &rng);
+	for (logn = 1; logn <= 10; logn ++) {
+		size_t n, u, v;
+
+		n = (size_t)1 << logn;
+		for (u = 0; u < n; u ++) {
+			a[u] = (uint16_t)(prng_get_u64(&p) % 12289);
+			b[u] = (uint16_t)(prng_get_u64(&p) % 12289);
+		}
+
+		/*
+		 * NTT followed by inverse NTT is the identity.
+		 */
+		memcpy(c, a, n * sizeof *a);
+		Zf(mq_NTT)(c, logn);
+		for (u = 0; u < n; u ++) {
+			check(c[u] < 12289, "NTT range");
+		}
+		Zf(mq_iNTT)(c, logn);
+		check_eq(a, c, n * sizeof *a, "NTT round trip");
+
+		/*
+		 * Product modulo X^n+1, against the schoolbook product.
+		 * The Montgomery multiplication divides by R = 2^16 mod q,
+		 * which we compensate by multiplying b by R = 4091 first.
+		 */
+		memset(d, 0, sizeof d);
+		for (u = 0; u < n; u ++) {
+			for (v = 0; v < n; v ++) {
+				uint32_t z;
+				size_t k;
+
+				z = ((uint32_t)a[u] * (uint32_t)b[v]) % 12289;
+				k = u + v;
+				if (k >= n) {
+					k -= n;
+					z = (12289 - z) % 12289;
+				}
+				d[k] = (uint16_t)((d[k] + z) % 12289);
+			}
+		}
+		memcpy(c, a, n * sizeof *a);
+		for (u = 0; u < n; u ++) {
+			b[u] = (uint16_t)(((uint32_t)b[u] * 4091) % 12289);
+		}
+		Zf(mq_NTT)(c, logn);
+		Zf(mq_NTT)(b, logn);
+		Zf(mq_poly_montymul_ntt)(c, b, logn);
+		Zf(mq_iNTT)(c, logn);
+		check_eq(c, d, n * sizeof *c, "NTT product");
+
+		printf(".");
+		fflush(stdout);
+	}
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+/* ==================================================================== */
+
+/*
+ * Reference: SHAKE256 over the FFT and inverse FFT of fixed integer
+ * polynomials, for logn = 1 to 10.
+ */
+static const char *const KAT_FFT_DIGEST =
+	"d86692ce2524664d090530e5a37450fd94713572e40b42da4571dbf5f7735b80";
+
+/*
+ * Inject n floating-point values into sc, each as its IEEE-754 binary
+ * representation (64-bit, little-endian); this is the same for the
+ * emulated and the native implementations.
+ */
+static void
+inject_fpr(inner_shake256_context *sc, const fpr *f, size_t n)
+{
+	size_t u;
+
+	for (u = 0; u < n; u ++) {
+		uint64_t x;
+		uint8_t buf[8];
+		int k;
+
+		memcpy(&x, &f[u], sizeof x);
+		for (k = 0; k < 8; k ++) {
+			buf[k] = (uint8_t)(x >> (8 * k));
+		}
+		inner_shake256_inject(sc, buf, sizeof buf);
+	}
+}
+
+static void
+test_FFT(void)
+{
+	inner_shake256_context rng, dig;
+	prng p;
+	unsigned logn;
+	fpr *a, *b, *c;
+	int32_t x[1024];
+
+	printf("Test FFT: ");
+	fflush(stdout);
+
+	a = xmalloc(1024 * sizeof *a);
+	b = xmalloc(1024 * sizeof *b);
+	c = xmalloc(1024 * sizeof *c);
+	seed_shake(&rng, "fft", 0);
+	Zf(prng_init)(&p, &rng);
+	inner_shake256_init(&dig);
+	for (logn = 1; logn <= 10; logn ++) {
+		size_t n, u;
+
+		n = (size_t)1 << logn;
+		for (u = 0; u < n; u ++) {
+			x[u] = (int32_t)(prng_get_u64(&p) % 4001) - 2000;
+			a[u] = fpr_of(x[u]);
+			b[u] = fpr_of((int64_t)(prng_get_u64(&p) % 257) - 128);
+		}
+
+		/*
+		 * FFT followed by inverse FFT yields back the original
+		 * polynomial (up to rounding).
+		 */
+		memcpy(c, a, n * sizeof *a);
+		Zf(FFT)(c, logn);
+		inject_fpr(&dig, c, n);
+		Zf(iFFT)(c, logn);
+		inject_fpr(&dig, c, n);
+		for (u = 0; u < n; u ++) {
+			check(fpr_rint(c[u]) == x[u], "FFT round trip");
+		}
+
+		/*
+		 * Products in FFT representation are products modulo
+		 * X^n+1; check against the schoolbook product for the
+		 * first coefficient.
+		 */
+		if (logn >= 2) {
+			int64_t z;
+
+			memcpy(c, a, n * sizeof *a);
+			Zf(FFT)(c, logn);
+			Zf(FFT)(b, logn);
+			Zf(poly_mul_fft)(c, b, logn);
+			Zf(iFFT)(c, logn);
+			Zf(iFFT)(b, logn);
+			z = (int64_t)x[0] * fpr_rint(b[0]);
+			for (u = 1; u < n; u ++) {
+				z -= (int64_t)x[u] * fpr_rint(b[n - u]);
+			}
+			check(fpr_rint(c[0]) == z, "FFT product");
+		}
+
+		printf(".");
+		fflush(stdout);
+	}
+	check_digest(&dig, KAT_FFT_DIGEST, "FFT digest");
+	xfree(a);
+	xfree(b);
+	xfree(c);
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+/* ==================================================================== */
+
+/*
+ * Random operand for the batched FP operations: mostly values with
+ * exponents in a range wide enough to exercise all alignment shifts
+ * in additions, with some zeros, opposite values and equal exponents.
+ */
+static fpr
+rand_fpr_operand(prng *p, const fpr *prev)
+{
+	uint64_t r, x;
+	unsigned e;
+	fpr f;
+
+	r = prng_get_u64(p);
+	switch (r & 7) {
+	case 0:
+		x = (r >> 3) & ((uint64_t)1 << 63);
+		break;
+	case 1:
+		memcpy(&x, prev, sizeof x);
+		x ^= (uint64_t)1 << 63;
+		break;
+	case 2:
+		memcpy(&x, prev, sizeof x);
+		x ^= (prng_get_u64(p) & 0xFF) | ((r >> 8) & ((uint64_t)1 << 63));
+		break;
+	default:
+		e = 1023 - 80 + (unsigned)((r >> 3) % 161);
+		x = (prng_get_u64(p) & (((uint64_t)1 << 52) - 1))
+			| ((uint64_t)e << 52) | (r & ((uint64_t)1 << 63));
+		break;
+	}
+	memcpy(&f, &x, sizeof f);
+	return f;
+}
+
+static void
+test_fpr_vec(void)
+{
+	inner_shake256_context rng;
+	prng p;
+	fpr a[1003], b[1003], d[1003], e[1003];
+	size_t n, u;
+	int i;
+
+	printf("Test FP batch: ");
+	fflush(stdout);
+
+	seed_shake(&rng, "fpr_vec", 0);
+	Zf(prng_init)(&p, &rng);
+	for (i = 0; i < 20; i ++) {
+		fpr x;
+
+		n = (size_t)(prng_get_u64(&p) % 1004);
+		a[0] = rand_fpr_operand(&p, &a[0]);
+		b[0] = rand_fpr_operand(&p, &a[0]);
+		for (u = 1; u < n; u ++) {
+			a[u] = rand_fpr_operand(&p, &b[u - 1]);
+			b[u] = rand_fpr_operand(&p, &a[u]);
+		}
+		x = rand_fpr_operand(&p, &a[0]);
+
+		fpr_add_vec(d, a, b, n);
+		for (u = 0; u < n; u ++) {
+			e[u] = fpr_add(a[u], b[u]);
+		}
+		check_eq(d, e, n * sizeof *d, "fpr_add_vec");
+		fpr_sub_vec(d, a, b, n);
+		for (u = 0; u < n; u ++) {
+			e[u] = fpr_sub(a[u], b[u]);
+		}
+		check_eq(d, e, n * sizeof *d, "fpr_sub_vec");
+		fpr_mul_vec(d, a, b, n);
+		for (u = 0; u < n; u ++) {
+			e[u] = fpr_mul(a[u], b[u]);
+		}
+		check_eq(d, e, n * sizeof *d, "fpr_mul_vec");
+		fpr_mulconst_vec(d, a, x, n);
+		for (u = 0; u < n; u ++) {
+			e[u] = fpr_mul(a[u], x);
+		}
+		check_eq(d, e, n * sizeof *d, "fpr_mulconst_vec");
+
+		/*
+		 * In-place operation.
+		 */
+		for (u = 0; u < n; u ++) {
+			e[u] = fpr_sub(fpr_add(a[u], b[u]), b[u]);
+		}
+		fpr_add_vec(a, a, b, n);
+		fpr_sub_vec(a, a, b, n);
+		check_eq(a, e, n * sizeof *a, "fpr_add_vec in place");
+
+		printf(".");
+		fflush(stdout);
+	}
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+/*
+ * The fused kernels used by signing must return exactly what the
+ * corresponding sequences of elementary operations return.
+ */
+static void
+test_fused_fft(void)
+{
+	inner_shake256_context rng;
+	prng p;
+	unsigned logn;
+	fpr *buf, *b00, *b01, *b10, *b11, *g00, *g01, *g11;
+	fpr *t0, *t1, *e0, *e1, *e2;
+
+	printf("Test fused FFT: ");
+	fflush(stdout);
+
+	buf = xmalloc(12 * 1024 * sizeof *buf);
+	seed_shake(&rng, "fused_fft", 0);
+	Zf(prng_init)(&p, &rng);
+	for (logn = 1; logn <= 10; logn ++) {
+		size_t n, u;
+		fpr ni;
+
+		n = (size_t)1 << logn;
+		b00 = buf;
+		b01 = b00 + n;
+		b10 = b01 + n;
+		b11 = b10 + n;
+		g00 = b11 + n;
+		g01 = g00 + n;
+		g11 = g01 + n;
+		t0 = g11 + n;
+		t1 = t0 + n;
+		e0 = t1 + n;
+		e1 = e0 + n;
+		e2 = e1 + n;
+		for (u = 0; u < 4 * n; u ++) {
+			b00[u] = fpr_of((int64_t)(prng_get_u64(&p) % 257) - 128);
+		}
+		for (u = 0; u < n; u ++) {
+			t0[u] = fpr_of((int64_t)(prng_get_u64(&p) % 12289));
+		}
+		Zf(FFT)(b00, logn);
+		Zf(FFT)(b01, logn);
+		Zf(FFT)(b10, logn);
+		Zf(FFT)(b11, logn);
+		Zf(FFT)(t0, logn);
+
+		/*
+		 * Gram matrix, into distinct arrays and in place.
+		 */
+		Zf(poly_gram_fft)(g00, g01, g11, b00, b01, b10, b11, logn);
+		memcpy(e0, b00, n * sizeof *b00);
+		Zf(poly_mulselfadj_fft)(e0, logn);
+		memcpy(e1, b01, n * sizeof *b01);
+		Zf(poly_mulselfadj_fft)(e1, logn);
+		Zf(poly_add)(e0, e1, logn);
+		check_eq(g00, e0, n * sizeof *g00, "gram g00");
+		memcpy(e0, b00, n * sizeof *b00);
+		Zf(poly_muladj_fft)(e0, b10, logn);
+		memcpy(e1, b01, n * sizeof *b01);
+		Zf(poly_muladj_fft)(e1, b11, logn);
+		Zf(poly_add)(e0, e1, logn);
+		check_eq(g01, e0, n * sizeof *g01, "gram g01");
+		memcpy(e0, b10, n * sizeof *b10);
+		Zf(poly_mulselfadj_fft)(e0, logn);
+		memcpy(e1, b11, n * sizeof *b11);
+		Zf(poly_mulselfadj_fft)(e1, logn);
+		Zf(poly_add)(e0, e1, logn);
+		check_eq(g11, e0, n * sizeof *g11, "gram g11");
+		memcpy(e0, b00, 3 * n * sizeof *b00);
+		Zf(poly_gram_fft)(e0, e1, e2, e0, e1, e2, b11, logn);
+		check_eq(e0, g00, 3 * n * sizeof *g00, "gram in place");
+
+		/*
+		 * Target vector.
+		 */
+		ni = fpr_inverse_of_q;
+		memcpy(e0, t0, n * sizeof *t0);
+		memcpy(e1, t0, n * sizeof *t0);
+		Zf(poly_mul_fft)(e1, b01, logn);
+		Zf(poly_mulconst)(e1, fpr_neg(ni), logn);
+		Zf(poly_mul_fft)(e0, b11, logn);
+		Zf(poly_mulconst)(e0, ni, logn);
+		Zf(poly_target_fft)(t0, t1, b01, b11, ni, logn);
+		check_eq(t0, e0, n * sizeof *t0, "target t0");
+		check_eq(t1, e1, n * sizeof *t1, "target t1");
+
+		/*
+		 * Lattice point, into distinct arrays and in place.
+		 */
+		memcpy(e0, t0, n * sizeof *t0);
+		memcpy(e1, t1, n * sizeof *t1);
+		Zf(poly_mul_fft)(e0, b00, logn);
+		Zf(poly_mul_fft)(e1, b10, logn);
+		Zf(poly_add)(e0, e1, logn);
+		memcpy(e1, t1, n * sizeof *t1);
+		Zf(poly_mul_fft)(e1, b11, logn);
+		memcpy(e2, t0, n * sizeof *t0);
+		Zf(poly_mul_fft)(e2, b01, logn);
+		Zf(poly_add)(e1, e2, logn);
+		Zf(poly_apply_basis_fft)(g00, g01, t0, t1,
+			b00, b01, b10, b11, logn);
+		check_eq(g00, e0, n * sizeof *g00, "basis d0");
+		check_eq(g01, e1, n * sizeof *g01, "basis d1");
+		Zf(poly_apply_basis_fft)(t0, t1, t0, t1,
+			b00, b01, b10, b11, logn);
+		check_eq(t0, e0, n * sizeof *t0, "basis d0 in place");
+		check_eq(t1, e1, n * sizeof *t1, "basis d1 in place");
+
+		printf(".");
+		fflush(stdout);
+	}
+	xfree(buf);
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+/* ==================================================================== */
+
+static void
+test_hash_to_point(void)
+{
+	inner_shake256_context sc[4], sc2;
+	unsigned logn;
+	uint16_t *x, *y;
+	uint8_t *tmp;
+
+	printf("Test hash-to-point: ");
+	fflush(stdout);
+
+	x = xmalloc(4 * 1024 * sizeof *x);
+	y = xmalloc(1024 * sizeof *y);
+	tmp = xmalloc(8 * 1024);
+	for (logn = 1; logn <= 10; logn ++) {
+		size_t n;
+		unsigned ctr;
+
+		n = (size_t)1 << logn;
+		for (ctr = 0; ctr < 20; ctr ++) {
+			size_t u;
+
+			/*
+			 * Constant-time and variable-time versions must
+			 * agree.
+			 */
+			seed_shake(&sc2, "hash_to_point", ctr);
+			Zf(hash_to_point_ct)(&sc2, x, logn, tmp);
+			seed_shake(&sc2, "hash_to_point", ctr);
+			Zf(hash_to_point_vartime)(&sc2, y, logn);
+			check_eq(x, y, n * sizeof *x, "hash_to_point ct/vartime");
+
+			/*
+			 * Four-way versions must match the one-way
+			 * versions.
+			 */
+			for (u = 0; u < 4; u ++) {
+				seed_shake(&sc[u], "hash_to_point",
+					ctr + (unsigned)u);
+			}
+			Zf(hash_to_point_x4)(sc, x, logn, tmp);
+			for (u = 0; u < 4; u ++) {
+				seed_shake(&sc2, "hash_to_point",
+					ctr + (unsigned)u);
+				Zf(hash_to_point_vartime)(&sc2, y, logn);
+				check_eq(x + u * n, y, n * sizeof *x,
+					"hash_to_point_x4");
+			}
+			for (u = 0; u < 4; u ++) {
+				seed_shake(&sc[u], "hash_to_point",
+					ctr + (unsigned)u);
+			}
+			Zf(hash_to_point_vartime_x4)(sc, x, logn);
+			for (u = 0; u < 4; u ++) {
+				seed_shake(&sc2, "hash_to_point",
+					ctr + (unsigned)u);
+				Zf(hash_to_point_vartime)(&sc2, y, logn);
+				check_eq(x + u * n, y, n * sizeof *x,
+					"hash_to_point_vartime_x4");
+			}
+		}
+		printf(".");
+		fflush(stdout);
+	}
+	xfree(x);
+	xfree(y);
+	xfree(tmp);
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+/* ==================================================================== */
+
+/*
+ * Reference: SHAKE256 over 65536 bytes of PRNG output, obtained with
+ * prng_get_bytes(), prng_get_u64() and prng_get_u8().
+ */
+static const char *const KAT_PRNG_DIGEST =
+	"1a7642c68a7abeb4bc85a3bb39a0515c77176abd2c532c6f99777c7524609e2a";
+
+static void
+test_PRNG(void)
+{
+	inner_shake256_context rng, dig;
+	prng p;
+	uint8_t buf[4096];
+	size_t u, v;
+
+	printf("Test PRNG: ");
+	fflush(stdout);
+
+	seed_shake(&rng, "prng", 0);
+	Zf(prng_init)(&p, &rng);
+	inner_shake256_init(&dig);
+	for (u = 0; u < 8; u ++) {
+		Zf(prng_get_bytes)(&p, buf, sizeof buf);
+		inner_shake256_inject(&dig, buf, sizeof buf);
+	}
+	for (u = 0; u < 4; u ++) {
+		for (v = 0; v < sizeof buf; v += 8) {
+			uint64_t x;
+			int k;
+
+			x = prng_get_u64(&p);
+			for (k = 0; k < 8; k ++) {
+				buf[v + k] = (uint8_t)(x >> (8 * k));
+			}
+		}
+		inner_shake256_inject(&dig, buf, sizeof buf);
+	}
+	for (u = 0; u < 4; u ++) {
+		for (v = 0; v < sizeof buf; v ++) {
+			buf[v] = (uint8_t)prng_get_u8(&p);
+		}
+		inner_shake256_inject(&dig, buf, sizeof buf);
+	}
+	check_digest(&dig, KAT_PRNG_DIGEST, "PRNG digest");
+	printf(".");
+	fflush(stdout);
+
+	/*
+	 * All refill implementations available on this CPU produce the
+	 * same output and next state as the portable code.
+	 */
+	for (u = 0; u < 32; u ++) {
+		prng p0, p1;
+		int impl;
+
+		seed_shake(&rng, "prng refill", (unsigned)u);
+		Zf(prng_init)(&p0, &rng);
+		if (u & 1) {
+			/* counter carry into the high word */
+			memset(p0.state.d + 48, 0xFF, 8);
+			p0.state.d[48] = (uint8_t)(0xFC - u);
+		}
+		p1 = p0;
+		check(Zf(prng_refill_using)(&p0, PRNG_REFILL_PORTABLE),
+			"portable refill");
+		for (impl = PRNG_REFILL_AVX2; impl <= PRNG_REFILL_AVX512;
+			impl ++)
+		{
+			prng p2;
+
+			p2 = p1;
+			if (!Zf(prng_refill_using)(&p2, impl)) {
+				continue;
+			}
+			check(memcmp(p0.buf.d, p2.buf.d, sizeof p0.buf.d) == 0
+				&& memcmp(p0.state.d, p2.state.d, 56) == 0
+				&& p2.ptr == 0, "refill implementation");
+		}
+	}
+	printf(".");
+	fflush(stdout);
+
+	/*
+	 * Block k of a refill is the first block of a refill from the
+	 * state with the counter advanced by 8*k: the stream is that of
+	 * successive refills of a single block, for any FALCON_PRNG_BLOCKS.
+	 */
+	for (u = 0; u < 8; u ++) {
+		prng p0, p1;
+		uint64_t cc;
+		size_t k;
+
+		seed_shake(&rng, "prng blocks", (unsigned)u);
+		Zf(prng_init)(&p0, &rng);
+		if (u & 1) {
+			memset(p0.state.d + 48, 0xFF, 4);
+			p0.state.d[48] = (uint8_t)(0xF0 - u);
+		}
+		cc = *(uint64_t *)(p0.state.d + 48);
+		p1 = p0;
+		Zf(prng_refill)(&p0);
+		check(*(uint64_t *)(p0.state.d + 48)
+			== cc + 8 * FALCON_PRNG_BLOCKS, "refill counter");
+		for (k = 0; k < FALCON_PRNG_BLOCKS; k ++) {
+			prng p2;
+
+			p2 = p1;
+			*(uint64_t *)(p2.state.d + 48) = cc + 8 * k;
+			Zf(prng_refill)(&p2);
+			check(memcmp(p0.buf.d + (k << 9), p2.buf.d, 512) == 0,
+				"refill block");
+		}
+	}
+	printf(".");
+	fflush(stdout);
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+/* ==================================================================== */
+
+/*
+ * Reference: SHAKE256 over the outputs of the base sampler and of
+ * SamplerZ, for a fixed seed and a fixed sequence of (mu, sigma).
+ */
+static const char *const KAT_SAMPLER_DIGEST =
+	"b14a4675a7ec9ce9cf1f1a04d12aeb8d3ca22697efe6fafbb7b74d5f39de6142";
+
+#define SAMPLER_NUM   100000
+
+static void
+test_sampler(void)
+{
+	inner_shake256_context rng, dig;
+	sampler_context spc;
+	prng p, p2;
+	fpr mu, isigma, fmu;
+	int bz[100];
+	long sum, sum2;
+	double mean, var;
+	int i, k;
+	uint8_t buf[2];
+
+	printf("Test samplers: ");
+	fflush(stdout);
+
+	inner_shake256_init(&dig);
+
+	/*
+	 * Base sampler: half-Gaussian, values in 0..18.
+	 */
+	seed_shake(&rng, "sampler", 0);
+	Zf(prng_init)(&p, &rng);
+	for (i = 0; i < SAMPLER_NUM; i ++) {
+		int z;
+
+		z = Zf(gaussian0_sampler)(&p);
+		check(z >= 0 && z <= 18, "gaussian0_sampler range");
+		buf[0] = (uint8_t)z;
+		inner_shake256_inject(&dig, buf, 1);
+	}
+	printf(".");
+	fflush(stdout);
+
+	/*
+	 * Batched base sampler: same output and PRNG state as successive
+	 * calls to gaussian0_sampler(), over many buffer refills.
+	 */
+	seed_shake(&rng, "sampler", 2);
+	Zf(prng_init)(&p, &rng);
+	p2 = p;
+	for (k = 1; k <= 100; k ++) {
+		Zf(gaussian0_sampler_batch)(&p2, bz, (size_t)k);
+		for (i = 0; i < k; i ++) {
+			check(bz[i] == Zf(gaussian0_sampler)(&p),
+				"gaussian0_sampler_batch");
+		}
+		check(p.ptr == p2.ptr
+			&& memcmp(p.buf.d, p2.buf.d, sizeof p.buf.d) == 0
+			&& memcmp(p.state.d, p2.state.d,
+				sizeof p.state.d) == 0,
+			"gaussian0_sampler_batch PRNG state");
+	}
+	printf(".");
+	fflush(stdout);
+
+	/*
+	 * SamplerZ with sigma = 1.5 and centre mu = 1/4: check the
+	 * mean and variance of the output.
+	 */
+	seed_shake(&rng, "sampler", 1);
+	Zf(prng_init)(&spc.p, &rng);
+	spc.sigma_min = fpr_sigma_min[10];
+	mu = fpr_div(fpr_of(1), fpr_of(4));
+	isigma = fpr_div(fpr_of(2), fpr_of(3));
+	sum = 0;
+	sum2 = 0;
+	for (i = 0; i < SAMPLER_NUM; i ++) {
+		int z;
+
+		z = Zf(sampler)(&spc, mu, isigma);
+		sum += z;
+		sum2 += (long)z * z;
+		buf[0] = (uint8_t)z;
+		buf[1] = (uint8_t)(z >> 8);
+		inner_shake256_inject(&dig, buf, 2);
+	}
+	mean = (double)sum / SAMPLER_NUM;
+	var = (double)sum2 / SAMPLER_NUM - mean * mean;
+	if (mean < 0.25 - 0.03 || mean > 0.25 + 0.03
+		|| var < 2.25 * 0.95 || var > 2.25 * 1.05)
+	{
+		fprintf(stderr, "SamplerZ: mean = %.4f, variance = %.4f\n",
+			mean, var);
+		exit(EXIT_FAILURE);
+	}
+	printf(".");
+	fflush(stdout);
+
+	/*
+	 * SamplerZ over a range of centres and standard deviations
+	 * (as used in ffSampling), for the digest only.
+	 */
+	for (k = 0; k < 64; k ++) {
+		fmu = fpr_div(fpr_of(k * 37 - 1000), fpr_of(17));
+		isigma = fpr_div(fpr_of(1000), fpr_of(1300 + 8 * k));
+		for (i = 0; i < 256; i ++) {
+			int z;
+
+			z = Zf(sampler)(&spc, fmu, isigma);
+			buf[0] = (uint8_t)z;
+			buf[1] = (uint8_t)(z >> 8);
+			inner_shake256_inject(&dig, buf, 2);
+		}
+	}
+	check_digest(&dig, KAT_SAMPLER_DIGEST, "sampler digest");
+	printf(".");
+	fflush(stdout);
+
+#if FALCON_SAMPLER_STATS
+	/*
+	 * Sampler statistics: each new_sampler() call accepts exactly
+	 * one candidate, and each candidate uses one base sample that
+	 * was not rejected.
+	 */
+	seed_shake(&rng, "sampler_stats", 0);
+	Zf(prng_init)(&spc.p, &rng);
+	memset(&spc.stats, 0, sizeof spc.stats);
+	for (i = 0; i < 256; i ++) {
+		fmu = fpr_div(fpr_of(i * 53 - 5000), fpr_of(13));
+		isigma = fpr_div(fpr_of(1000), fpr_of(1300 + 40 * (i / 3)));
+		(void)Zf(new_sampler)(&spc, fmu, isigma);
+	}
+	check(spc.stats.accepted == 256
+		&& spc.stats.candidates
+			== spc.stats.base_draws - spc.stats.base_rejected
+		&& spc.stats.accepted <= spc.stats.candidates,
+		"sampler stats");
+#endif
+	printf(".");
+	fflush(stdout);
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+/* ==================================================================== */
+
+/*
+ * Reference: SHAKE256 over the (f, g, F, G, h) key elements obtained
+ * with new_keygen() from fixed seeds, for logn = 1 to 10. This covers
+ * the NTRU solver (big integers and NTT modulo small primes), including
+ * its AVX2 code when FALCON_AVX2_RUNTIME is used.
+ */
+static const char *const KAT_KEYGEN_DIGEST =
+	"076ab2cd57629b545bde8d6df0c3ffd47893a086cee444301944bc5fe0dc4a86";
+
+static void
+test_keygen(void)
+{
+	inner_shake256_context rng, dig;
+	unsigned logn;
+	int8_t f[1024], g[1024], F[1024], G[1024];
+	uint16_t h[1024];
+	uint8_t *tmp;
+
+	printf("Test keygen: ");
+	fflush(stdout);
+
+	tmp = xmalloc(FALCON_KEYGEN_TEMP_10);
+	inner_shake256_init(&dig);
+	for (logn = 1; logn <= 10; logn ++) {
+		size_t n, u;
+		uint8_t buf[2048];
+
+		n = (size_t)1 << logn;
+		seed_shake(&rng, "keygen", logn);
+		Zf(new_keygen)(&rng, f, g, F, G, h, logn, tmp);
+		inner_shake256_inject(&dig, (const uint8_t *)f, n);
+		inner_shake256_inject(&dig, (const uint8_t *)g, n);
+		inner_shake256_inject(&dig, (const uint8_t *)F, n);
+		inner_shake256_inject(&dig, (const uint8_t *)G, n);
+		for (u = 0; u < n; u ++) {
+			buf[(u << 1) + 0] = (uint8_t)h[u];
+			buf[(u << 1) + 1] = (uint8_t)(h[u] >> 8);
+		}
+		inner_shake256_inject(&dig, buf, n << 1);
+		printf(".");
+		fflush(stdout);
+	}
+	check_digest(&dig, KAT_KEYGEN_DIGEST, "keygen digest");
+	xfree(tmp);
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+/* ==================================================================== */
+
+static void
+test_sign_inner(unsigned logn)
+{
+	shake256_context rng;
+	size_t pk_len, sk_len, sig_max, tmp_len, ek_len;
+	uint8_t *pk, *pk2, *sk, *sig, *sig2, *tmp, *ek;
+	int sig_type;
+	unsigned ctr;
+	int r;
+
+	pk_len = FALCON_PUBKEY_SIZE(logn);
+	sk_len = FALCON_PRIVKEY_SIZE(logn);
+	sig_max = FALCON_SIG_COMPRESSED_MAXSIZE(logn);
+	if (sig_max < FALCON_SIG_CT_SIZE(logn)) {
+		sig_max = FALCON_SIG_CT_SIZE(logn);
+	}
+	tmp_len = FALCON_TMPSIZE_KEYGEN(logn);
+	if (tmp_len < FALCON_TMPSIZE_SIGNDYN(logn)) {
+		tmp_len = FALCON_TMPSIZE_SIGNDYN(logn);
+	}
+	if (tmp_len < FALCON_TMPSIZE_EXPANDPRIV(logn)) {
+		tmp_len = FALCON_TMPSIZE_EXPANDPRIV(logn);
+	}
+	ek_len = FALCON_EXPANDEDKEY_SIZE(logn);
+	pk = xmalloc(pk_len);
+	pk2 = xmalloc(pk_len);
+	sk = xmalloc(sk_len);
+	sig = xmalloc(sig_max);
+	sig2 = xmalloc(sig_max);
+	tmp = xmalloc(tmp_len);
+	ek = xmalloc(ek_len);
+
+	shake256_init_prng_from_seed(&rng, "test_sign", 9);
+	r = falcon_keygen_make(&rng, logn, sk, sk_len, pk, pk_len,
+		tmp, tmp_len);
+	check(r == 0, "keygen");
+	check(falcon_get_logn(pk, pk_len) == (int)logn, "get_logn");
+	r = falcon_make_public(pk2, pk_len, sk, sk_len, tmp, tmp_len);
+	check(r == 0, "make_public");
+	check_eq(pk, pk2, pk_len, "make_public");
+	r = falcon_expand_privkey(ek, ek_len, sk, sk_len, tmp, tmp_len);
+	check(r == 0, "expand_privkey");
+
+	for (sig_type = FALCON_SIG_COMPRESSED;
+		sig_type <= FALCON_SIG_CT; sig_type ++)
+	{
+		for (ctr = 0; ctr < 4; ctr ++) {
+			uint8_t msg[8];
+			size_t sig_len, sig2_len;
+
+			memcpy(msg, "message", 7);
+			msg[7] = (uint8_t)ctr;
+
+			/*
+			 * Dynamic and tree signing consume the same
+			 * randomness and yield the same signature.
+			 */
+			sig_len = sig_max;
+			shake256_init_prng_from_seed(&rng, msg, sizeof msg);
+			r = falcon_sign_dyn(&rng, sig, &sig_len, sig_type,
+				sk, sk_len, msg, sizeof msg, tmp, tmp_len);
+			check(r == 0, "sign_dyn");
+			sig2_len = sig_max;
+			shake256_init_prng_from_seed(&rng, msg, sizeof msg);
+			r = falcon_sign_tree(&rng, sig2, &sig2_len, sig_type,
+				ek, msg, sizeof msg, tmp, tmp_len);
+			check(r == 0, "sign_tree");
+			check(sig_len == sig2_len, "sign_tree length");
+			check_eq(sig, sig2, sig_len, "sign_tree/sign_dyn");
+
+			r = falcon_verify(sig, sig_len, sig_type,
+				pk, pk_len, msg, sizeof msg, tmp, tmp_len);
+			check(r == 0, "verify");
+
+			msg[0] ^= 0x01;
+			r = falcon_verify(sig, sig_len, sig_type,
+				pk, pk_len, msg, sizeof msg, tmp, tmp_len);
+			check(r == FALCON_ERR_BADSIG, "verify wrong message");
+			msg[0] ^= 0x01;
+
+			sig[sig_len - 1] ^= 0x20;
+			r = falcon_verify(sig, sig_len, sig_type,
+				pk, pk_len, msg, sizeof msg, tmp, tmp_len);
+			check(r != 0, "verify altered signature");
+		}
+	}
+
+	xfree(pk);
+	xfree(pk2);
+	xfree(sk);
+	xfree(sig);
+	xfree(sig2);
+	xfree(tmp);
+	xfree(ek);
+}
+
+static void
+test_sign(void)
+{
+	unsigned logn;
+
+	printf("Test sign/verify: ");
+	fflush(stdout);
+	for (logn = 1; logn <= 10; logn ++) {
+		test_sign_inner(logn);
+		printf(".");
+		fflush(stdout);
+	}
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+/* ==================================================================== */
+
+int
+main(void)
+{
+	unsigned oldcw;
+
+	oldcw = set_fpu_cw(2);
+	printf("FP implementation: %s\n",
+		FALCON_FPEMU ? "emulated (FALCON_FPEMU)"
+		: "native (FALCON_FPNATIVE)");
+	test_SHAKE256();
+	test_codec();
+	test_comp_fuzz();
+	test_NTT();
+	test_FFT();
+	test_fpr_vec();
+	test_fused_fft();
+	test_hash_to_point();
+	test_PRNG();
+	test_sampler();
+	test_keygen();
+	test_sign();
+	set_fpu_cw(oldcw);
+	return 0;
+}
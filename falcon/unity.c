@@ -0,0 +1,37 @@
+/*
+ * Single translation unit build of the Falcon core ("unity" build).
+ *
+ * This file includes all the internal implementation files, so that the
+ * compiler sees the floating-point routines (fpr.c) along with their
+ * callers in the FFT, key pair generation and signature code, and may
+ * inline them without link-time optimization. It is compiled only with
+ * FALCON_UNITY=1 (see the "all_unity" Makefile target), in which case the
+ * individual object files must not be linked; otherwise, it compiles
+ * to nothing.
+ *
+ * This file is distributed under the same MIT license terms as the
+ * rest of the Falcon implementation (see the other source files).
+ */
+
+#include "config.h"
+
+#if defined FALCON_UNITY && FALCON_UNITY
+
+#include "codec.c"
+#include "common.c"
+#include "fpr.c"
+#include "fft.c"
+#include "keygen.c"
+#include "rng.c"
+#include "shake.c"
+#include "sign.c"
+#include "vrfy.c"
+
+#else
+
+/*
+ * ISO C forbids empty translation units.
+ */
+typedef int unity_dummy;
+
+#endif
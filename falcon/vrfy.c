@@ -498,6 +498,307 @@ mq_div_12289(uint32_t x, uint32_t y)
 	return mq_montymul(y18, x);
 }
 
+#if FALCON_AVX2_RUNTIME
+/*
+ * AVX2 implementations of the NTT and of the element-wise operations,
+ * over 16 lanes of 16 bits. Every lane computes exactly what the
+ * scalar functions above compute (values are kept in the 0..q-1
+ * range throughout), so results are bit-exact with the portable code.
+ *
+ * These functions require n >= 32 (logn >= 5) for the NTT, and
+ * n >= 16 (logn >= 4) for the element-wise operations.
+ */
+
+/*
+ * Montgomery multiplication over 16 lanes: x*y/R mod q. The 32-bit
+ * product is split into its low and high halves; the Montgomery
+ * correction m*q is added to the high half, and the carry from the
+ * low halves is 1 unless x*y is a multiple of 2^16 (since m*q is
+ * chosen so that both low halves sum to 0 mod 2^16).
+ */
+TARGET_AVX2_RUNTIME
+static inline __m256i
+mq_montymul_x16(__m256i x, __m256i y)
+{
+	__m256i lo, hi, m, c;
+
+	lo = _mm256_mullo_epi16(x, y);
+	hi = _mm256_mulhi_epu16(x, y);
+	m = _mm256_mullo_epi16(lo, _mm256_set1_epi16(Q0I));
+	m = _mm256_mulhi_epu16(m, _mm256_set1_epi16(Q));
+	c = _mm256_add_epi16(
+		_mm256_cmpeq_epi16(lo, _mm256_setzero_si256()),
+		_mm256_set1_epi16(1));
+	hi = _mm256_add_epi16(_mm256_add_epi16(hi, m), c);
+	return _mm256_min_epu16(hi, _mm256_sub_epi16(hi, _mm256_set1_epi16(Q)));
+}
+
+/*
+ * Addition modulo q over 16 lanes (operands in 0..q-1).
+ */
+TARGET_AVX2_RUNTIME
+static inline __m256i
+mq_add_x16(__m256i x, __m256i y)
+{
+	__m256i d;
+
+	d = _mm256_add_epi16(x, y);
+	return _mm256_min_epu16(d, _mm256_sub_epi16(d, _mm256_set1_epi16(Q)));
+}
+
+/*
+ * Subtraction modulo q over 16 lanes (operands in 0..q-1). If x < y,
+ * then x - y wraps around to a value of at least 2^16 - q, while
+ * x - y + q is the correct (small) result.
+ */
+TARGET_AVX2_RUNTIME
+static inline __m256i
+mq_sub_x16(__m256i x, __m256i y)
+{
+	__m256i d;
+
+	d = _mm256_sub_epi16(x, y);
+	return _mm256_min_epu16(d, _mm256_add_epi16(d, _mm256_set1_epi16(Q)));
+}
+
+/*
+ * One layer of butterflies: (u, v) -> (u + v*s, u - v*s) for the
+ * forward NTT, (u, v) -> (u + v, (u - v)*s) for the inverse NTT.
+ */
+TARGET_AVX2_RUNTIME
+static inline void
+mq_bfly_x16(__m256i *u, __m256i *v, __m256i s, int inverse)
+{
+	__m256i x, y;
+
+	x = *u;
+	y = *v;
+	if (inverse) {
+		*u = mq_add_x16(x, y);
+		*v = mq_montymul_x16(mq_sub_x16(x, y), s);
+	} else {
+		y = mq_montymul_x16(y, s);
+		*u = mq_add_x16(x, y);
+		*v = mq_sub_x16(x, y);
+	}
+}
+
+/*
+ * Apply one layer of butterflies where the two halves of each group
+ * are ht elements apart, with ht <= 8, and the group twiddle factors
+ * are tw[0], tw[1],... (one per group of 2*ht elements). Elements are
+ * processed by blocks of 32: the two halves of the groups in the block
+ * are gathered into two vectors with in-register shuffles, and the
+ * twiddle factors are laid out to match.
+ */
+TARGET_AVX2_RUNTIME
+static void
+mq_NTT_small_avx2(uint16_t *a, size_t n, size_t ht,
+	const uint16_t *tw, int inverse)
+{
+	size_t k;
+
+	for (k = 0; k < n; k += 32, tw += 16 / ht) {
+		__m256i x, y, u, v, s;
+
+		x = _mm256_loadu_si256((const __m256i *)(a + k));
+		y = _mm256_loadu_si256((const __m256i *)(a + k + 16));
+		switch (ht) {
+		case 8:
+			/*
+			 * One group per vector (128-bit halves):
+			 * x = [g0u | g0v], y = [g1u | g1v].
+			 */
+			u = _mm256_permute2x128_si256(x, y, 0x20);
+			v = _mm256_permute2x128_si256(x, y, 0x31);
+			s = _mm256_inserti128_si256(
+				_mm256_castsi128_si256(_mm_set1_epi16((short)tw[0])),
+				_mm_set1_epi16((short)tw[1]), 1);
+			mq_bfly_x16(&u, &v, s, inverse);
+			x = _mm256_permute2x128_si256(u, v, 0x20);
+			y = _mm256_permute2x128_si256(u, v, 0x31);
+			break;
+		case 4:
+			/*
+			 * x = [g0u g0v | g1u g1v], y = [g2u g2v | g3u g3v]
+			 * (64-bit halves).
+			 */
+			u = _mm256_unpacklo_epi64(x, y);
+			v = _mm256_unpackhi_epi64(x, y);
+			s = _mm256_setr_epi64x(
+				(long long)(tw[0] * 0x0001000100010001ull),
+				(long long)(tw[2] * 0x0001000100010001ull),
+				(long long)(tw[1] * 0x0001000100010001ull),
+				(long long)(tw[3] * 0x0001000100010001ull));
+			mq_bfly_x16(&u, &v, s, inverse);
+			x = _mm256_unpacklo_epi64(u, v);
+			y = _mm256_unpackhi_epi64(u, v);
+			break;
+		case 2:
+			/*
+			 * 32-bit halves; after swapping the two middle
+			 * dwords of each 128-bit lane, x holds
+			 * [g0u g1u g0v g1v | g2u g3u g2v g3v].
+			 */
+			x = _mm256_shuffle_epi32(x, 0xD8);
+			y = _mm256_shuffle_epi32(y, 0xD8);
+			u = _mm256_unpacklo_epi64(x, y);
+			v = _mm256_unpackhi_epi64(x, y);
+			s = _mm256_setr_epi32(
+				(int)(tw[0] * 0x00010001u), (int)(tw[1] * 0x00010001u),
+				(int)(tw[4] * 0x00010001u), (int)(tw[5] * 0x00010001u),
+				(int)(tw[2] * 0x00010001u), (int)(tw[3] * 0x00010001u),
+				(int)(tw[6] * 0x00010001u), (int)(tw[7] * 0x00010001u));
+			mq_bfly_x16(&u, &v, s, inverse);
+			x = _mm256_shuffle_epi32(_mm256_unpacklo_epi64(u, v), 0xD8);
+			y = _mm256_shuffle_epi32(_mm256_unpackhi_epi64(u, v), 0xD8);
+			break;
+		default:
+			/*
+			 * 16-bit halves: even words are the u values, odd
+			 * words the v values. Packing yields groups
+			 * [0-3 8-11 | 4-7 12-15], and the twiddle factors
+			 * are permuted accordingly.
+			 */
+			u = _mm256_packus_epi32(
+				_mm256_and_si256(x, _mm256_set1_epi32(0xFFFF)),
+				_mm256_and_si256(y, _mm256_set1_epi32(0xFFFF)));
+			v = _mm256_packus_epi32(
+				_mm256_srli_epi32(x, 16), _mm256_srli_epi32(y, 16));
+			s = _mm256_permute4x64_epi64(
+				_mm256_loadu_si256((const __m256i *)tw), 0xD8);
+			mq_bfly_x16(&u, &v, s, inverse);
+			x = _mm256_unpacklo_epi16(u, v);
+			y = _mm256_unpackhi_epi16(u, v);
+			break;
+		}
+		_mm256_storeu_si256((__m256i *)(a + k), x);
+		_mm256_storeu_si256((__m256i *)(a + k + 16), y);
+	}
+}
+
+/*
+ * Apply one layer of butterflies where the two halves of each group
+ * are ht elements apart, with ht >= 16 (a multiple of 16); each group
+ * uses a single twiddle factor, broadcast to all lanes.
+ */
+TARGET_AVX2_RUNTIME
+static void
+mq_NTT_large_avx2(uint16_t *a, size_t n, size_t ht,
+	const uint16_t *tw, int inverse)
+{
+	size_t j1;
+
+	for (j1 = 0; j1 < n; j1 += ht << 1, tw ++) {
+		__m256i s;
+		size_t j;
+
+		s = _mm256_set1_epi16((short)*tw);
+		for (j = j1; j < j1 + ht; j += 16) {
+			__m256i u, v;
+
+			u = _mm256_loadu_si256((const __m256i *)(a + j));
+			v = _mm256_loadu_si256((const __m256i *)(a + j + ht));
+			mq_bfly_x16(&u, &v, s, inverse);
+			_mm256_storeu_si256((__m256i *)(a + j), u);
+			_mm256_storeu_si256((__m256i *)(a + j + ht), v);
+		}
+	}
+}
+
+/*
+ * Multiply all elements by the constant c (Montgomery multiplication).
+ */
+TARGET_AVX2_RUNTIME
+static void
+mq_poly_montymul_const_avx2(uint16_t *f, uint32_t c, size_t n)
+{
+	__m256i cc;
+	size_t u;
+
+	cc = _mm256_set1_epi16((short)c);
+	for (u = 0; u < n; u += 16) {
+		__m256i x;
+
+		x = _mm256_loadu_si256((const __m256i *)(f + u));
+		_mm256_storeu_si256((__m256i *)(f + u),
+			mq_montymul_x16(x, cc));
+	}
+}
+
+TARGET_AVX2_RUNTIME
+static void
+mq_NTT_avx2(uint16_t *a, unsigned logn)
+{
+	size_t n, ht, m;
+
+	n = (size_t)1 << logn;
+	for (m = 1, ht = n >> 1; ht >= 1; m <<= 1, ht >>= 1) {
+		if (ht >= 16) {
+			mq_NTT_large_avx2(a, n, ht, GMb + m, 0);
+		} else {
+			mq_NTT_small_avx2(a, n, ht, GMb + m, 0);
+		}
+	}
+}
+
+TARGET_AVX2_RUNTIME
+static void
+mq_iNTT_avx2(uint16_t *a, unsigned logn)
+{
+	size_t n, t, hm;
+	uint32_t ni;
+
+	n = (size_t)1 << logn;
+	for (t = 1, hm = n >> 1; hm >= 1; t <<= 1, hm >>= 1) {
+		if (t >= 16) {
+			mq_NTT_large_avx2(a, n, t, iGMb + hm, 1);
+		} else {
+			mq_NTT_small_avx2(a, n, t, iGMb + hm, 1);
+		}
+	}
+
+	/*
+	 * Divide by n, as in mq_iNTT().
+	 */
+	ni = R;
+	for (t = n; t > 1; t >>= 1) {
+		ni = mq_rshift1(ni);
+	}
+	mq_poly_montymul_const_avx2(a, ni, n);
+}
+
+TARGET_AVX2_RUNTIME
+static void
+mq_poly_montymul_ntt_avx2(uint16_t *f, const uint16_t *g, size_t n)
+{
+	size_t u;
+
+	for (u = 0; u < n; u += 16) {
+		__m256i x, y;
+
+		x = _mm256_loadu_si256((const __m256i *)(f + u));
+		y = _mm256_loadu_si256((const __m256i *)(g + u));
+		_mm256_storeu_si256((__m256i *)(f + u), mq_montymul_x16(x, y));
+	}
+}
+
+TARGET_AVX2_RUNTIME
+static void
+mq_poly_sub_avx2(uint16_t *f, const uint16_t *g, size_t n)
+{
+	size_t u;
+
+	for (u = 0; u < n; u += 16) {
+		__m256i x, y;
+
+		x = _mm256_loadu_si256((const __m256i *)(f + u));
+		y = _mm256_loadu_si256((const __m256i *)(g + u));
+		_mm256_storeu_si256((__m256i *)(f + u), mq_sub_x16(x, y));
+	}
+}
+#endif
+
 /*
  * Compute NTT on a ring element.
  */
@@ -506,6 +807,13 @@ mq_NTT(uint16_t *a, unsigned logn)
 {
 	size_t n, t, m;
 
+#if FALCON_AVX2_RUNTIME
+	if (logn >= 5 && cpu_has_avx2()) {
+		mq_NTT_avx2(a, logn);
+		return;
+	}
+#endif
+
 	n = (size_t)1 << logn;
 	t = n;
 	for (m = 1; m < n; m <<= 1) {
@@ -540,6 +848,13 @@ mq_iNTT(uint16_t *a, unsigned logn)
 	size_t n, t, m;
 	uint32_t ni;
 
+#if FALCON_AVX2_RUNTIME
+	if (logn >= 5 && cpu_has_avx2()) {
+		mq_iNTT_avx2(a, logn);
+		return;
+	}
+#endif
+
 	n = (size_t)1 << logn;
 	t = 1;
 	m = n;
@@ -596,6 +911,12 @@ mq_poly_tomonty(uint16_t *f, unsigned logn)
 	size_t u, n;
 
 	n = (size_t)1 << logn;
+#if FALCON_AVX2_RUNTIME
+	if (logn >= 4 && cpu_has_avx2()) {
+		mq_poly_montymul_const_avx2(f, R2, n);
+		return;
+	}
+#endif
 	for (u = 0; u < n; u ++) {
 		f[u] = (uint16_t)mq_montymul(f[u], R2);
 	}
@@ -611,6 +932,12 @@ mq_poly_montymul_ntt(uint16_t *f, const uint16_t *g, unsigned logn)
 	size_t u, n;
 
 	n = (size_t)1 << logn;
+#if FALCON_AVX2_RUNTIME
+	if (logn >= 4 && cpu_has_avx2()) {
+		mq_poly_montymul_ntt_avx2(f, g, n);
+		return;
+	}
+#endif
 	for (u = 0; u < n; u ++) {
 		f[u] = (uint16_t)mq_montymul(f[u], g[u]);
 	}
@@ -625,6 +952,12 @@ mq_poly_sub(uint16_t *f, const uint16_t *g, unsigned logn)
 	size_t u, n;
 
 	n = (size_t)1 << logn;
+#if FALCON_AVX2_RUNTIME
+	if (logn >= 4 && cpu_has_avx2()) {
+		mq_poly_sub_avx2(f, g, n);
+		return;
+	}
+#endif
 	for (u = 0; u < n; u ++) {
 		f[u] = (uint16_t)mq_sub(f[u], g[u]);
 	}
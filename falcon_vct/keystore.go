@@ -0,0 +1,227 @@
+//go:build unix
+
+package vct
+
+import (
+	"crypto/rand"
+	"crypto/sha256"
+	"encoding/binary"
+	"errors"
+	"falcon_vct/falcon"
+	"fmt"
+	"os"
+	"sync"
+	"sync/atomic"
+	"syscall"
+	"unsafe"
+)
+
+// 키 저장소 파일 형식 (고정 크기 레코드, 노드 id로 인덱스)
+//
+//	header (4096 bytes): magic, version, nodes, record size, expanded key size,
+//	                     byte order marker, master seed (32 bytes)
+//	record i (header + i*recordSize): state (uint32), public key, private key,
+//	                     expanded private key (ffLDL tree)
+//
+// 확장 키는 native byte order의 double 값과 주소 정렬에 의존하므로, 같은
+// 아키텍처에서 만든 파일만 열 수 있다 (byte order marker / 크기로 확인).
+const (
+	ksMagic        = "FVCTKEYS"
+	ksVersion      = 2
+	ksHeaderSize   = 4096
+	ksMarker       = 0x01020304
+	ksRecordReady  = 1
+	ksPubOffset    = 64
+	ksPrivOffset   = ksPubOffset + falcon.PublicKeySize
+	ksExpOffset    = (ksPrivOffset + falcon.PrivateKeySize + 63) &^ 63
+	ksExpandedSize = int(unsafe.Sizeof(falcon.ExpandedPrivateKey{}))
+	ksRecordSize   = (ksExpOffset + ksExpandedSize + 4095) &^ 4095
+)
+
+var (
+	ErrKeyStoreFormat = errors.New("falcon key store: incompatible or corrupted file")
+	ErrKeyStoreSeed   = errors.New("falcon key store: master seed does not match")
+	ErrKeyStoreRange  = errors.New("falcon key store: node id out of range")
+	ErrKeyStoreClosed = errors.New("falcon key store: closed")
+)
+
+// KeyStore: 노드별 Falcon 키 (공개키, 개인키, 확장 개인키)를 저장하는
+// 메모리 매핑 파일. 키는 처음 사용될 때 master seed에서 유도한 노드 seed로
+// 생성되어 기록되고, 이후 라운드에서는 keygen 없이 그대로 사용된다.
+// 한 파일은 한 프로세스에서만 열어야 한다.
+type KeyStore struct {
+	f      *os.File
+	data   []byte
+	nodes  int
+	master [32]byte
+	locks  []sync.Mutex
+}
+
+// StoredKey: 저장소 레코드를 직접 가리키는 키 (복사 없음).
+// KeyStore.Close 이후에는 사용할 수 없다.
+type StoredKey struct {
+	Public   *falcon.PublicKey
+	Private  *falcon.PrivateKey
+	Expanded *falcon.ExpandedPrivateKey
+}
+
+// OpenKeyStore opens the key store at path, creating it if needed, with room
+// for at least nodes keys (node ids 0..nodes-1); an existing smaller store is
+// extended. masterSeed selects the keys of a new store (nil means a random
+// master seed); for an existing store it must be nil or match.
+func OpenKeyStore(path string, nodes int, masterSeed []byte) (*KeyStore, error) {
+	if nodes <= 0 {
+		return nil, ErrKeyStoreRange
+	}
+	f, err := os.OpenFile(path, os.O_RDWR|os.O_CREATE, 0600)
+	if err != nil {
+		return nil, err
+	}
+	ks, err := openKeyStore(f, nodes, masterSeed)
+	if err != nil {
+		f.Close()
+		return nil, err
+	}
+	return ks, nil
+}
+
+func openKeyStore(f *os.File, nodes int, masterSeed []byte) (*KeyStore, error) {
+	fi, err := f.Stat()
+	if err != nil {
+		return nil, err
+	}
+
+	ks := &KeyStore{f: f}
+	hdr := make([]byte, ksHeaderSize)
+	if fi.Size() == 0 {
+		// 새 저장소: master seed 결정
+		if masterSeed == nil {
+			if _, err := rand.Read(ks.master[:]); err != nil {
+				return nil, err
+			}
+		} else {
+			ks.master = sha256.Sum256(masterSeed)
+		}
+	} else {
+		if fi.Size() < ksHeaderSize {
+			return nil, ErrKeyStoreFormat
+		}
+		if _, err := f.ReadAt(hdr, 0); err != nil {
+			return nil, err
+		}
+		if string(hdr[0:8]) != ksMagic ||
+			binary.NativeEndian.Uint32(hdr[8:]) != ksVersion ||
+			binary.NativeEndian.Uint32(hdr[16:]) != uint32(ksRecordSize) ||
+			binary.NativeEndian.Uint32(hdr[20:]) != uint32(ksExpandedSize) ||
+			binary.NativeEndian.Uint32(hdr[24:]) != ksMarker {
+			return nil, ErrKeyStoreFormat
+		}
+		copy(ks.master[:], hdr[32:64])
+		if masterSeed != nil && sha256.Sum256(masterSeed) != ks.master {
+			return nil, ErrKeyStoreSeed
+		}
+		stored := int(binary.NativeEndian.Uint32(hdr[12:]))
+		if fi.Size() < int64(ksHeaderSize)+int64(stored)*int64(ksRecordSize) {
+			return nil, ErrKeyStoreFormat
+		}
+		if stored > nodes {
+			nodes = stored
+		}
+	}
+
+	size := int64(ksHeaderSize) + int64(nodes)*int64(ksRecordSize)
+	if fi.Size() < size {
+		// 레코드 영역은 0으로 채워짐 (state = 비어 있음)
+		if err := f.Truncate(size); err != nil {
+			return nil, err
+		}
+		copy(hdr[0:8], ksMagic)
+		binary.NativeEndian.PutUint32(hdr[8:], ksVersion)
+		binary.NativeEndian.PutUint32(hdr[12:], uint32(nodes))
+		binary.NativeEndian.PutUint32(hdr[16:], uint32(ksRecordSize))
+		binary.NativeEndian.PutUint32(hdr[20:], uint32(ksExpandedSize))
+		binary.NativeEndian.PutUint32(hdr[24:], ksMarker)
+		copy(hdr[32:64], ks.master[:])
+		if _, err := f.WriteAt(hdr, 0); err != nil {
+			return nil, err
+		}
+	}
+
+	data, err := syscall.Mmap(int(f.Fd()), 0, int(size), syscall.PROT_READ|syscall.PROT_WRITE, syscall.MAP_SHARED)
+	if err != nil {
+		return nil, fmt.Errorf("falcon key store: mmap: %w", err)
+	}
+	ks.data = data
+	ks.nodes = nodes
+	ks.locks = make([]sync.Mutex, nodes)
+	return ks, nil
+}
+
+// Nodes returns the number of node ids the store has room for.
+func (ks *KeyStore) Nodes() int {
+	return ks.nodes
+}
+
+// NodeSeed returns the seed from which the key of node id is generated.
+func (ks *KeyStore) NodeSeed(id int) []byte {
+	var buf [8]byte
+	binary.LittleEndian.PutUint64(buf[:], uint64(id))
+	h := sha256.New()
+	h.Write(ks.master[:])
+	h.Write([]byte("falcon_vct node key"))
+	h.Write(buf[:])
+	return h.Sum(nil)
+}
+
+// Key returns the key of node id, generating and recording it on first use.
+// It is safe for concurrent use.
+func (ks *KeyStore) Key(id int) (StoredKey, error) {
+	if ks.data == nil {
+		return StoredKey{}, ErrKeyStoreClosed
+	}
+	if id < 0 || id >= ks.nodes {
+		return StoredKey{}, ErrKeyStoreRange
+	}
+	rec := ks.data[ksHeaderSize+id*ksRecordSize:][:ksRecordSize]
+	state := (*uint32)(unsafe.Pointer(&rec[0]))
+	key := StoredKey{
+		Public:   (*falcon.PublicKey)(unsafe.Pointer(&rec[ksPubOffset])),
+		Private:  (*falcon.PrivateKey)(unsafe.Pointer(&rec[ksPrivOffset])),
+		Expanded: (*falcon.ExpandedPrivateKey)(unsafe.Pointer(&rec[ksExpOffset])),
+	}
+	if atomic.LoadUint32(state) == ksRecordReady {
+		return key, nil
+	}
+
+	ks.locks[id].Lock()
+	defer ks.locks[id].Unlock()
+	if atomic.LoadUint32(state) == ksRecordReady {
+		return key, nil
+	}
+	pk, sk, err := falcon.GenerateKey(ks.NodeSeed(id))
+	if err != nil {
+		return StoredKey{}, err
+	}
+	*key.Public = pk
+	*key.Private = sk
+	if err := key.Private.ExpandInto(key.Expanded); err != nil {
+		return StoredKey{}, err
+	}
+	// 레코드 내용을 모두 쓴 뒤에 ready 표시
+	atomic.StoreUint32(state, ksRecordReady)
+	return key, nil
+}
+
+// Close unmaps and closes the store; keys returned by Key must not be used
+// afterwards.
+func (ks *KeyStore) Close() error {
+	if ks.data == nil {
+		return ErrKeyStoreClosed
+	}
+	err := syscall.Munmap(ks.data)
+	ks.data = nil
+	if cerr := ks.f.Close(); err == nil {
+		err = cerr
+	}
+	return err
+}
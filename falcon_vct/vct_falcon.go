@@ -2,7 +2,6 @@ package vct
 
 import (
 	"crypto/rand"
-	"crypto/sha256"
 	"encoding/hex"
 	"falcon_vct/falcon"
 	"fmt"
@@ -34,31 +33,6 @@ type Nodes struct {
     exe_time string
 }
 
-func Prove(PublicKey, PrivateKey, m []byte) (pi, hash []byte, err error) {
-    // 1. 서명 생성 (에러는 무시하지 말자)
-    sig, err := sk.SignCompressed(m)
-    if err != nil {
-        return nil, nil, err
-    }
-
-    // 2. 서명에 SHA-256 적용해서 "압축" (32바이트 해시)
-    sum := sha256.Sum256(sig) // [32]byte
-
-    // 3. pi = 서명, hash = 서명 해시
-    return sig, sum[:], nil
-}
-
-// Verify: pi가 유효한지 확인
-func Verify(PublicKey, PrivateKey, pi []byte) (bool, error) {
-    // pi = 서명 (compressed signature)
-    if err := pk.Verify(pi, m); err != nil {
-        // 검증 실패
-        return false, err
-    }
-    // 검증 성공
-    return true, nil
-}
-
 // 내부 공용 함수: seed가 nil이면 랜덤, 아니면 주어진 seed 사용
 func performFalconVCT(id int, msg []byte, nthreshold uint32, seed []byte) Nodes {
     startTime := time.Now()
@@ -73,41 +47,85 @@ func performFalconVCT(id int, msg []byte, nthreshold uint32, seed []byte) Nodes
 
     pk, sk, _ := falcon.GenerateKey(seed)
 
-    sig, _ := sk.SignCompressed(msg)
-    err := pk.Verify(sig, msg)
+    // 서명 + norm + 임계값 판정을 한 번의 cgo 호출로 처리
+    // (s1을 다시 계산하지 않고 서명기가 가진 s1/s2로 norm 계산)
+    res, _ := sk.VCTEval(msg, nthreshold)
 
-    var verify_res string
-    if err == nil {
-        verify_res = "success"
-    } else {
-        verify_res = "failed"
-    }
+    return makeNode(id, pk, msg, res, time.Since(startTime), true)
+}
 
-    enc_sig := hex.EncodeToString(sig)
+// 키 저장소의 키로 VCT 평가: keygen 없이 확장 키로 서명 + norm만 계산
+// (자기 서명의 검증도 생략 -> vrfy_res는 "skipped")
+func performFalconVCTStored(ks *KeyStore, id int, msg []byte, nthreshold uint32) Nodes {
+    startTime := time.Now()
 
-    sigCT, _ := sig.ConvertToCT()
-    s2, _ := sigCT.S2Coefficients()
-    h, _ := pk.Coefficients()
+    key, err := ks.Key(id)
+    if err != nil {
+        res := falcon.VCTResult{Err: err}
+        return makeNode(id, falcon.PublicKey{}, msg, res, time.Since(startTime), false)
+    }
+    res, _ := key.Expanded.VCTEval(msg, nthreshold)
 
-    c := falcon.HashToPointCoefficients(msg, sigCT.SaltVersion())
-    s1, _ := falcon.S1Coefficients(h, c, s2)
+    return makeNode(id, *key.Public, msg, res, time.Since(startTime), false)
+}
 
-    norm := norm_s(s1, s2, log1024)
+// 여러 노드의 VCT를 한 번에 평가 (C 쪽 worker pool 사용)
+// seeds[i]가 nil이면 해당 노드는 랜덤 seed 사용
+func performFalconVCTBatch(ids []int, msg []byte, nthreshold uint32, seeds [][]byte, workers int) []Nodes {
+    startTime := time.Now()
 
-    var VCT_res bool
-    if norm < nthreshold {
-        VCT_res = true
-    } else {
-        VCT_res = false
+    nodeSeeds := make([][]byte, len(ids))
+    for i := range ids {
+        var seed []byte
+        if i < len(seeds) {
+            seed = seeds[i]
+        }
+        if len(seed) == 0 {
+            seed = make([]byte, 64)
+            if _, err := rand.Read(seed); err != nil {
+                panic(err)
+            }
+        }
+        nodeSeeds[i] = seed
+    }
+
+    // keygen도 C 쪽 worker pool에서 병렬로 (seed별 결과는 동일)
+    pks, sks, err := falcon.GenerateKeysParallel(nodeSeeds)
+    if err != nil {
+        panic(err)
     }
 
+    results, _ := falcon.VCTEvalBatch(sks, msg, nthreshold, workers)
+
+    // 배치 전체 실행 시간을 각 노드에 기록
     elapsedTime := time.Since(startTime)
+    nodes := make([]Nodes, len(ids))
+    for i, id := range ids {
+        nodes[i] = makeNode(id, pks[i], msg, results[i], elapsedTime, true)
+    }
+    return nodes
+}
+
+func makeNode(id int, pk falcon.PublicKey, msg []byte, res falcon.VCTResult, elapsedTime time.Duration, verify bool) Nodes {
+    err := res.Err
+    if err == nil && verify {
+        err = pk.Verify(res.Signature, msg)
+    }
+
+    var verify_res string
+    if err != nil {
+        verify_res = "failed"
+    } else if verify {
+        verify_res = "success"
+    } else {
+        verify_res = "skipped"
+    }
 
     return Nodes{
         id:       fmt.Sprintf("node_%d", id),
-        pi:       enc_sig,
-        norm:     int(norm),
-        VCT_res:  VCT_res,
+        pi:       hex.EncodeToString(res.Signature),
+        norm:     int(res.Norm),
+        VCT_res:  res.Selected,
         vrfy_res: verify_res,
         exe_time: elapsedTime.String(),
     }
@@ -120,6 +138,16 @@ func PerformFalconVCT(id int, msg []byte, nthreshold uint32) Nodes {
     return performFalconVCT(id, msg, nthreshold, nil)
 }
 
+// 저장된 키로 평가 (매 라운드 keygen 대신 OpenKeyStore로 연 저장소 사용)
+func PerformFalconVCTStored(ks *KeyStore, id int, msg []byte, nthreshold uint32) Nodes {
+    return performFalconVCTStored(ks, id, msg, nthreshold)
+}
+
+// 라운드의 모든 노드를 한 번에 평가 (workers가 0이면 CPU 수만큼)
+func PerformFalconVCTBatch(ids []int, msg []byte, nthreshold uint32, workers int) []Nodes {
+    return performFalconVCTBatch(ids, msg, nthreshold, nil, workers)
+}
+
 // norm_s는 기존 그대로 두면 됨
 func norm_s(s1, s2 [1024]int16, logn uint) uint32 {
     n := 1 << logn
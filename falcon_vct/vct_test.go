@@ -1,22 +1,20 @@
 package vct
 
 import (
+	"encoding/binary"
 	"fmt"
+	"path/filepath"
 	"reflect"
 	"testing"
 	"time"
 )
 
-type Nodes struct {
-	id       string
-	pi       string
-	norm     int
-	VCT_res  bool
-	vrfy_res string
-	exe_time string
+func VCTtest(howmany int, message string, probability uint8, verbose bool) ([]int, time.Duration) {
+	return vctTestSeeded(howmany, message, probability, verbose, nil)
 }
 
-func VCTtest(howmany int, message string, probability uint8, verbose bool) ([]int, time.Duration) {
+// seeds[i]가 nil이면 해당 노드는 랜덤 seed 사용
+func vctTestSeeded(howmany int, message string, probability uint8, verbose bool, seeds [][]byte) ([]int, time.Duration) {
 	var msg []byte
 	msg = []byte(message)
 	nodeSet := make([]Nodes, howmany)
@@ -25,7 +23,11 @@ func VCTtest(howmany int, message string, probability uint8, verbose bool) ([]in
 
 	totalTime := time.Now()
 	for i := 0; i < howmany; i++ {
-		nodeSet[i] = PerformFalconVCT(i, msg, nthreshold)
+		var seed []byte
+		if i < len(seeds) {
+			seed = seeds[i]
+		}
+		nodeSet[i] = performFalconVCT(i, msg, nthreshold, seed)
 		if nodeSet[i].VCT_res {
 			winVCT = append(winVCT, i)
 		}
@@ -51,14 +53,23 @@ func VCTtest(howmany int, message string, probability uint8, verbose bool) ([]in
 	return winVCT, avgElapsedTime
 }
 
+// 테스트용 64바이트 seed (v를 반복해서 채움)
+func makeSeed(v uint64) []byte {
+	seed := make([]byte, 64)
+	for i := 0; i < len(seed); i += 8 {
+		binary.LittleEndian.PutUint64(seed[i:], v)
+	}
+	return seed
+}
+
 // 같은 seed / 메시지 / 확률 -> 동일 결과
 func TestDeterministicSingle(t *testing.T) {
 	msg := []byte("deterministic")
 	nth := Prob[1].norm_bound // 10%
 
 	seed := makeSeed(42)
-	n1 := PerformFalconVCT(0, msg, nth, seed)
-	n2 := PerformFalconVCT(0, msg, nth, seed)
+	n1 := performFalconVCT(0, msg, nth, seed)
+	n2 := performFalconVCT(0, msg, nth, seed)
 
 	// 실행시간 문자열만 제거 후 비교
 	n1.exe_time, n2.exe_time = "", ""
@@ -74,10 +85,54 @@ func TestDeterministicBatch(t *testing.T) {
 		seeds[i] = makeSeed(uint64(100 + i))
 	}
 
-	win1, _ := VCTtest(howmany, "batch-test", 10, false, seeds)
-	win2, _ := VCTtest(howmany, "batch-test", 10, false, seeds)
+	win1, _ := vctTestSeeded(howmany, "batch-test", 10, false, seeds)
+	win2, _ := vctTestSeeded(howmany, "batch-test", 10, false, seeds)
 
 	if !reflect.DeepEqual(win1, win2) {
 		t.Fatalf("winner set differs: %v vs %v", win1, win2)
 	}
 }
+
+// 저장소 키로 계산한 결과 = 같은 seed로 keygen 후 계산한 결과,
+// 저장소를 다시 열어도 같은 키 사용
+func TestKeyStoreStored(t *testing.T) {
+	msg := []byte("keystore")
+	nth := Prob[1].norm_bound // 10%
+	path := filepath.Join(t.TempDir(), "keys.db")
+
+	ks, err := OpenKeyStore(path, 3, []byte("keystore master seed"))
+	if err != nil {
+		t.Fatalf("OpenKeyStore: %v", err)
+	}
+	first := make([]Nodes, 3)
+	for id := 0; id < 3; id++ {
+		first[id] = PerformFalconVCTStored(ks, id, msg, nth)
+		ref := performFalconVCT(id, msg, nth, ks.NodeSeed(id))
+		if first[id].pi != ref.pi || first[id].norm != ref.norm || first[id].VCT_res != ref.VCT_res {
+			t.Fatalf("stored key result differs for node %d", id)
+		}
+	}
+	if n := PerformFalconVCTStored(ks, 3, msg, nth); n.vrfy_res != "failed" {
+		t.Fatalf("out of range node id accepted")
+	}
+	ks.Close()
+
+	ks, err = OpenKeyStore(path, 4, nil)
+	if err != nil {
+		t.Fatalf("reopen: %v", err)
+	}
+	defer ks.Close()
+	for id := 0; id < 3; id++ {
+		n := PerformFalconVCTStored(ks, id, msg, nth)
+		n.exe_time, first[id].exe_time = "", ""
+		if !reflect.DeepEqual(n, first[id]) {
+			t.Fatalf("reopened store gives a different result for node %d", id)
+		}
+	}
+	if _, err := ks.Key(3); err != nil {
+		t.Fatalf("extended store: %v", err)
+	}
+	if _, err := OpenKeyStore(path, 1, []byte("other")); err != ErrKeyStoreSeed {
+		t.Fatalf("master seed mismatch not detected: %v", err)
+	}
+}